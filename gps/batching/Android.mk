@@ -22,7 +22,10 @@ LOCAL_SHARED_LIBRARIES := \
 
 LOCAL_SRC_FILES += \
     location_batching.cpp \
-    BatchingAdapter.cpp
+    BatchingAdapter.cpp \
+    BatchedLocationBuffer.cpp \
+    TripOdometer.cpp \
+    BatchedLocationSink.cpp
 
 LOCAL_HEADER_LIBRARIES := \
     libgps.utils_headers \
@@ -35,5 +38,28 @@ LOCAL_PRELINK_MODULE := false
 LOCAL_CFLAGS += $(GNSS_CFLAGS)
 include $(BUILD_SHARED_LIBRARY)
 
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := batch_replay
+LOCAL_SANITIZE += $(GNSS_SANITIZE)
+LOCAL_VENDOR_MODULE := true
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_SHARED_LIBRARIES := \
+    liblog \
+    libbatching
+
+LOCAL_SRC_FILES := \
+    batch_replay.cpp
+
+LOCAL_HEADER_LIBRARIES := \
+    libgps.utils_headers \
+    libloc_core_headers \
+    libloc_pla_headers \
+    liblocation_api_headers
+
+LOCAL_CFLAGS += $(GNSS_CFLAGS)
+include $(BUILD_EXECUTABLE)
+
 endif # not BUILD_TINY_ANDROID
 endif # BOARD_VENDOR_QCOM_GPS_LOC_API_HARDWARE
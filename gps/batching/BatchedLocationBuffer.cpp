@@ -0,0 +1,256 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <BatchedLocationBuffer.h>
+#include <math.h>
+#include <string.h>
+
+// field scales of the encoding
+#define ENCODE_DEGREES_SCALE     (1e7)
+#define ENCODE_METERS_SCALE      (100.0)
+#define ENCODE_ANGLE_SCALE       (100.0)
+#define ENCODE_FIELDS            (13)
+
+void
+BatchedLocationBuffer::setCapacity(size_t capacity)
+{
+    if (capacity == mTimestamp.size()) {
+        return;
+    }
+    // unroll what is kept to the front of the new columns
+    size_t keep = (mSize < capacity) ? mSize : capacity;
+    std::vector<Location> kept(keep);
+    getLocations(mSize - keep, keep, kept.data());
+
+    mTimestamp.assign(capacity, 0);
+    mFlags.assign(capacity, 0);
+    mLatitude.assign(capacity, 0);
+    mLongitude.assign(capacity, 0);
+    mAltitude.assign(capacity, 0);
+    mSpeed.assign(capacity, 0);
+    mBearing.assign(capacity, 0);
+    mAccuracy.assign(capacity, 0);
+    mVerticalAccuracy.assign(capacity, 0);
+    mSpeedAccuracy.assign(capacity, 0);
+    mBearingAccuracy.assign(capacity, 0);
+    mTechMask.assign(capacity, 0);
+    mSpoofMask.assign(capacity, 0);
+    mHead = 0;
+    mSize = 0;
+    append(kept.data(), keep);
+}
+
+void
+BatchedLocationBuffer::append(const Location* locations, size_t count)
+{
+    size_t capacity = mTimestamp.size();
+    if (0 == capacity || NULL == locations) {
+        return;
+    }
+    // only the newest capacity fixes would survive anyway
+    if (count > capacity) {
+        locations += count - capacity;
+        count = capacity;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        size_t s;
+        if (mSize < capacity) {
+            s = slot(mSize++);
+        } else {
+            s = mHead;
+            mHead = (mHead + 1 == capacity) ? 0 : mHead + 1;
+        }
+        const Location& location = locations[i];
+        mTimestamp[s] = location.timestamp;
+        mFlags[s] = location.flags;
+        mLatitude[s] = location.latitude;
+        mLongitude[s] = location.longitude;
+        mAltitude[s] = location.altitude;
+        mSpeed[s] = location.speed;
+        mBearing[s] = location.bearing;
+        mAccuracy[s] = location.accuracy;
+        mVerticalAccuracy[s] = location.verticalAccuracy;
+        mSpeedAccuracy[s] = location.speedAccuracy;
+        mBearingAccuracy[s] = location.bearingAccuracy;
+        mTechMask[s] = location.techMask;
+        mSpoofMask[s] = location.spoofMask;
+    }
+}
+
+void
+BatchedLocationBuffer::getLocation(size_t i, Location& location) const
+{
+    size_t s = slot(i);
+    memset(&location, 0, sizeof(Location));
+    location.size = sizeof(Location);
+    location.timestamp = mTimestamp[s];
+    location.flags = mFlags[s];
+    location.latitude = mLatitude[s];
+    location.longitude = mLongitude[s];
+    location.altitude = mAltitude[s];
+    location.speed = mSpeed[s];
+    location.bearing = mBearing[s];
+    location.accuracy = mAccuracy[s];
+    location.verticalAccuracy = mVerticalAccuracy[s];
+    location.speedAccuracy = mSpeedAccuracy[s];
+    location.bearingAccuracy = mBearingAccuracy[s];
+    location.techMask = mTechMask[s];
+    location.spoofMask = mSpoofMask[s];
+}
+
+size_t
+BatchedLocationBuffer::getLocations(size_t first, size_t count, Location* locations) const
+{
+    if (first >= mSize || NULL == locations) {
+        return 0;
+    }
+    if (count > mSize - first) {
+        count = mSize - first;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        getLocation(first + i, locations[i]);
+    }
+    return count;
+}
+
+static inline void putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+static inline bool getVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (data >= end) {
+            return false;
+        }
+        uint8_t byte = *data++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (0 == (byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline uint64_t zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// the quantized fields of a fix, in encoding order
+static void quantize(const Location& location, int64_t fields[ENCODE_FIELDS])
+{
+    fields[0] = (int64_t)location.timestamp;
+    fields[1] = location.flags;
+    fields[2] = llround(location.latitude * ENCODE_DEGREES_SCALE);
+    fields[3] = llround(location.longitude * ENCODE_DEGREES_SCALE);
+    fields[4] = llround(location.altitude * ENCODE_METERS_SCALE);
+    fields[5] = llround(location.speed * ENCODE_METERS_SCALE);
+    fields[6] = llround(location.bearing * ENCODE_ANGLE_SCALE);
+    fields[7] = llround(location.accuracy * ENCODE_METERS_SCALE);
+    fields[8] = llround(location.verticalAccuracy * ENCODE_METERS_SCALE);
+    fields[9] = llround(location.speedAccuracy * ENCODE_METERS_SCALE);
+    fields[10] = llround(location.bearingAccuracy * ENCODE_ANGLE_SCALE);
+    fields[11] = location.techMask;
+    fields[12] = location.spoofMask;
+}
+
+size_t
+BatchedLocationBuffer::encode(size_t first, size_t count, std::vector<uint8_t>& out) const
+{
+    if (first >= mSize) {
+        count = 0;
+    } else if (count > mSize - first) {
+        count = mSize - first;
+    }
+    putVarint(out, count);
+
+    int64_t previous[ENCODE_FIELDS] = {0};
+    int64_t fields[ENCODE_FIELDS];
+    Location location;
+    for (size_t i = 0; i < count; ++i) {
+        getLocation(first + i, location);
+        quantize(location, fields);
+        for (int f = 0; f < ENCODE_FIELDS; ++f) {
+            putVarint(out, zigzag(fields[f] - previous[f]));
+            previous[f] = fields[f];
+        }
+    }
+    return count;
+}
+
+bool
+BatchedLocationBuffer::decode(const uint8_t* data, size_t length,
+        std::vector<Location>& locations)
+{
+    const uint8_t* end = data + length;
+    uint64_t count = 0;
+    if (NULL == data || !getVarint(data, end, count)) {
+        return false;
+    }
+
+    int64_t fields[ENCODE_FIELDS] = {0};
+    for (uint64_t i = 0; i < count; ++i) {
+        for (int f = 0; f < ENCODE_FIELDS; ++f) {
+            uint64_t delta;
+            if (!getVarint(data, end, delta)) {
+                return false;
+            }
+            fields[f] += unzigzag(delta);
+        }
+        Location location;
+        memset(&location, 0, sizeof(Location));
+        location.size = sizeof(Location);
+        location.timestamp = (uint64_t)fields[0];
+        location.flags = (LocationFlagsMask)fields[1];
+        location.latitude = fields[2] / ENCODE_DEGREES_SCALE;
+        location.longitude = fields[3] / ENCODE_DEGREES_SCALE;
+        location.altitude = fields[4] / ENCODE_METERS_SCALE;
+        location.speed = fields[5] / ENCODE_METERS_SCALE;
+        location.bearing = fields[6] / ENCODE_ANGLE_SCALE;
+        location.accuracy = fields[7] / ENCODE_METERS_SCALE;
+        location.verticalAccuracy = fields[8] / ENCODE_METERS_SCALE;
+        location.speedAccuracy = fields[9] / ENCODE_METERS_SCALE;
+        location.bearingAccuracy = fields[10] / ENCODE_ANGLE_SCALE;
+        location.techMask = (LocationTechnologyMask)fields[11];
+        location.spoofMask = (LocationSpoofMask)fields[12];
+        locations.push_back(location);
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef BATCHED_LOCATION_BUFFER_H
+#define BATCHED_LOCATION_BUFFER_H
+
+#include <LocationDataTypes.h>
+#include <stdint.h>
+#include <vector>
+
+// Ring of the most recent batched fixes, kept column by column so that code
+// looking at one field (timestamps, positions, ...) walks contiguous memory.
+// Once full, appending drops the oldest fixes. Index 0 is the oldest fix.
+//
+// encode() packs a range of fixes for long trips: every field is stored as a
+// zigzag varint delta against the previous fix, quantized to 1e-7 degrees for
+// latitude and longitude, and to centimeters, cm/s or 1/100 degree for the
+// others. decode() gives back Locations within that quantization.
+class BatchedLocationBuffer {
+public:
+    inline BatchedLocationBuffer() : mHead(0), mSize(0) {}
+
+    // keeps the newest fixes that fit in the new capacity
+    void setCapacity(size_t capacity);
+    inline size_t capacity() const { return mTimestamp.size(); }
+    inline size_t size() const { return mSize; }
+    inline bool empty() const { return 0 == mSize; }
+    inline void clear() { mHead = 0; mSize = 0; }
+
+    void append(const Location* locations, size_t count);
+
+    inline uint64_t getTimestamp(size_t i) const { return mTimestamp[slot(i)]; }
+    inline double getLatitude(size_t i) const { return mLatitude[slot(i)]; }
+    inline double getLongitude(size_t i) const { return mLongitude[slot(i)]; }
+    inline float getAccuracy(size_t i) const { return mAccuracy[slot(i)]; }
+    inline LocationFlagsMask getFlags(size_t i) const { return mFlags[slot(i)]; }
+    void getLocation(size_t i, Location& location) const;
+    // copies count fixes from first on into locations; returns the number copied
+    size_t getLocations(size_t first, size_t count, Location* locations) const;
+
+    size_t encode(size_t first, size_t count, std::vector<uint8_t>& out) const;
+    static bool decode(const uint8_t* data, size_t length, std::vector<Location>& locations);
+
+private:
+    inline size_t slot(size_t i) const {
+        size_t s = mHead + i;
+        return (s >= mTimestamp.size()) ? s - mTimestamp.size() : s;
+    }
+
+    size_t mHead;       // slot of the oldest fix
+    size_t mSize;
+    std::vector<uint64_t> mTimestamp;
+    std::vector<LocationFlagsMask> mFlags;
+    std::vector<double> mLatitude;
+    std::vector<double> mLongitude;
+    std::vector<double> mAltitude;
+    std::vector<float> mSpeed;
+    std::vector<float> mBearing;
+    std::vector<float> mAccuracy;
+    std::vector<float> mVerticalAccuracy;
+    std::vector<float> mSpeedAccuracy;
+    std::vector<float> mBearingAccuracy;
+    std::vector<LocationTechnologyMask> mTechMask;
+    std::vector<LocationSpoofMask> mSpoofMask;
+};
+
+#endif /* BATCHED_LOCATION_BUFFER_H */
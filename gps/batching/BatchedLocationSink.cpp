@@ -0,0 +1,286 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <BatchedLocationSink.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <log_util.h>
+
+BatchedLocationSink::BatchedLocationSink() :
+    mFd(-1),
+    mIsFifo(false),
+    mFormat(FORMAT_BINARY),
+    mSyncPolicy(SYNC_NONE),
+    mMaxBuffered(0),
+    mPendingBytes(0),
+    mPendingOffset(0),
+    mDirty(false),
+    mDroppedBatches(0)
+{
+}
+
+bool
+BatchedLocationSink::open(const char* path, Format format, SyncPolicy syncPolicy,
+        size_t maxBuffered)
+{
+    close();
+    if (NULL == path || '\0' == path[0]) {
+        return false;
+    }
+    mPath = path;
+    mFormat = format;
+    mSyncPolicy = syncPolicy;
+    mMaxBuffered = maxBuffered;
+    // a FIFO without a reader yet is not an error, it is opened on a later write
+    if (!openFd() && !mIsFifo) {
+        mPath.clear();
+        return false;
+    }
+    return true;
+}
+
+void
+BatchedLocationSink::close()
+{
+    if (mFd >= 0) {
+        drain();
+        if (mDirty && SYNC_NONE != mSyncPolicy) {
+            sync();
+        }
+    }
+    closeFd();
+    mPath.clear();
+    mPending.clear();
+    mPendingBytes = 0;
+    mPendingOffset = 0;
+}
+
+bool
+BatchedLocationSink::openFd()
+{
+    struct stat st;
+    mIsFifo = (0 == stat(mPath.c_str(), &st) && S_ISFIFO(st.st_mode));
+    if (mIsFifo) {
+        // fails with ENXIO as long as nobody reads the other end
+        mFd = ::open(mPath.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    } else {
+        mFd = ::open(mPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC,
+                     0640);
+    }
+    if (mFd < 0) {
+        if (ENXIO != errno) {
+            LOC_LOGE("%s]: open %s failed, errno %d", __func__, mPath.c_str(), errno);
+        }
+        return false;
+    }
+
+    // a new stream needs its header, unless the file already has one
+    if (FORMAT_BINARY == mFormat && (mIsFifo || 0 == lseek(mFd, 0, SEEK_END))) {
+        std::vector<uint8_t> header(8, 0);
+        memcpy(header.data(), BATCHED_LOCATION_SINK_MAGIC, 4);
+        header[4] = BATCHED_LOCATION_SINK_VERSION;
+        mPending.push_front(header);
+        mPendingBytes += header.size();
+    }
+    LOC_LOGD("%s]: exporting batched locations to %s", __func__, mPath.c_str());
+    return true;
+}
+
+void
+BatchedLocationSink::closeFd()
+{
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+    mDirty = false;
+}
+
+void
+BatchedLocationSink::write(const BatchedLocationBuffer& locations, size_t first, size_t count)
+{
+    if (!isOpen() || 0 == count) {
+        return;
+    }
+
+    std::vector<uint8_t> frame;
+    if (FORMAT_BINARY == mFormat) {
+        frame.resize(4);
+        locations.encode(first, count, frame);
+        uint32_t length = frame.size() - 4;
+        for (int i = 0; i < 4; ++i) {
+            frame[i] = (uint8_t)(length >> (8 * i));
+        }
+    } else {
+        char line[256];
+        Location location;
+        for (size_t i = first; i < first + count && i < locations.size(); ++i) {
+            locations.getLocation(i, location);
+            size_t length = formatText(location, line, sizeof(line));
+            frame.insert(frame.end(), line, line + length);
+        }
+    }
+    enqueue(frame);
+    drain();
+    if (SYNC_BATCH == mSyncPolicy && mPending.empty()) {
+        sync();
+    }
+}
+
+void
+BatchedLocationSink::flush()
+{
+    if (!isOpen()) {
+        return;
+    }
+    drain();
+    if (SYNC_NONE != mSyncPolicy) {
+        sync();
+    }
+}
+
+void
+BatchedLocationSink::enqueue(std::vector<uint8_t>& frame)
+{
+    if (frame.size() > mMaxBuffered) {
+        ++mDroppedBatches;
+        LOC_LOGW("%s]: batch of %zu bytes over the %zu bytes export buffer, dropped",
+                 __func__, frame.size(), mMaxBuffered);
+        return;
+    }
+    // the front frame may be partly written, dropping it would break the stream
+    while (mPendingBytes + frame.size() > mMaxBuffered) {
+        auto victim = mPending.begin();
+        if (mPendingOffset > 0) {
+            ++victim;
+        }
+        if (mPending.end() == victim) {
+            ++mDroppedBatches;
+            return;
+        }
+        mPendingBytes -= victim->size();
+        mPending.erase(victim);
+        ++mDroppedBatches;
+    }
+    if (mDroppedBatches > 0) {
+        LOC_LOGW("%s]: %u batches dropped so far, %s is not keeping up",
+                 __func__, mDroppedBatches, mPath.c_str());
+    }
+    mPendingBytes += frame.size();
+    mPending.push_back(std::move(frame));
+}
+
+void
+BatchedLocationSink::drain()
+{
+    if (mFd < 0 && !openFd()) {
+        return;
+    }
+
+    // a FIFO whose reader went away raises SIGPIPE, keep it off this thread
+    // and take the pending signal back before restoring the mask
+    sigset_t pipeSet, oldSet;
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+
+    bool broken = false;
+    while (!mPending.empty()) {
+        const std::vector<uint8_t>& front = mPending.front();
+        ssize_t n = ::write(mFd, front.data() + mPendingOffset, front.size() - mPendingOffset);
+        if (n < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            broken = (EAGAIN != errno && EWOULDBLOCK != errno);
+            if (broken) {
+                LOC_LOGE("%s]: write %s failed, errno %d", __func__, mPath.c_str(), errno);
+            }
+            break;
+        }
+        mDirty = true;
+        mPendingOffset += n;
+        if (mPendingOffset == front.size()) {
+            mPendingBytes -= front.size();
+            mPending.pop_front();
+            mPendingOffset = 0;
+        }
+    }
+
+    if (broken && mIsFifo) {
+        struct timespec zero = {0, 0};
+        sigtimedwait(&pipeSet, NULL, &zero);
+    }
+    pthread_sigmask(SIG_SETMASK, &oldSet, NULL);
+
+    if (broken) {
+        // start over with the next reader; the half written frame went to the old one
+        if (mPendingOffset > 0) {
+            mPendingBytes -= mPending.front().size();
+            mPending.pop_front();
+            mPendingOffset = 0;
+        }
+        closeFd();
+    }
+}
+
+void
+BatchedLocationSink::sync()
+{
+    if (mFd >= 0 && mDirty && !mIsFifo) {
+        if (0 != fdatasync(mFd)) {
+            LOC_LOGE("%s]: fdatasync %s failed, errno %d", __func__, mPath.c_str(), errno);
+        }
+    }
+    mDirty = false;
+}
+
+size_t
+BatchedLocationSink::formatText(const Location& location, char* buf, size_t size)
+{
+    int length = snprintf(buf, size, "$PQBLC,%" PRIu64 ",%X,%.7f,%.7f,%.2f,%.2f,%.2f,%.2f",
+                          location.timestamp, location.flags,
+                          location.latitude, location.longitude, location.altitude,
+                          location.speed, location.bearing, location.accuracy);
+    if (length < 0 || (size_t)length + 6 > size) {
+        return 0;
+    }
+    uint8_t checksum = 0;
+    for (int i = 1; i < length; ++i) {
+        checksum ^= (uint8_t)buf[i];
+    }
+    length += snprintf(buf + length, size - length, "*%02X\r\n", checksum);
+    return length;
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef BATCHED_LOCATION_SINK_H
+#define BATCHED_LOCATION_SINK_H
+
+#include <BatchedLocationBuffer.h>
+#include <stdint.h>
+#include <string>
+#include <deque>
+#include <vector>
+
+#define BATCHED_LOCATION_SINK_MAGIC   "BLOC"
+#define BATCHED_LOCATION_SINK_VERSION 1
+
+// Streams batched fixes to a regular file or a FIFO, for loggers that have no
+// location client of their own.
+//
+// FORMAT_BINARY starts the stream with the magic and a version byte padded to
+// 8 bytes, followed by one frame per batch: a little endian uint32 length and
+// the BatchedLocationBuffer::encode() bytes. FORMAT_TEXT writes one
+// NMEA-like sentence per fix:
+//   $PQBLC,<timestamp ms>,<flags hex>,<lat>,<lon>,<alt>,<speed>,<bearing>,<accuracy>*<checksum>
+//
+// Writes never block the caller: what the file or FIFO does not take right
+// away is kept, up to the buffer size, and the oldest whole batches are
+// dropped beyond it. A FIFO without a reader just accumulates; a new reader
+// gets a fresh stream header.
+class BatchedLocationSink {
+public:
+    enum Format {
+        FORMAT_BINARY = 0,
+        FORMAT_TEXT = 1,
+    };
+    enum SyncPolicy {
+        SYNC_NONE = 0,      // leave it to the kernel
+        SYNC_BATCH = 1,     // fdatasync once every batch is written out
+        SYNC_FLUSH = 2,     // fdatasync on flush() only
+    };
+
+    BatchedLocationSink();
+    inline ~BatchedLocationSink() { close(); }
+
+    bool open(const char* path, Format format, SyncPolicy syncPolicy, size_t maxBuffered);
+    void close();
+    inline bool isOpen() const { return !mPath.empty(); }
+    inline uint32_t getDroppedBatches() const { return mDroppedBatches; }
+
+    void write(const BatchedLocationBuffer& locations, size_t first, size_t count);
+    void flush();
+
+    static size_t formatText(const Location& location, char* buf, size_t size);
+
+private:
+    bool openFd();
+    void closeFd();
+    void enqueue(std::vector<uint8_t>& frame);
+    void drain();
+    void sync();
+
+    std::string mPath;
+    int mFd;
+    bool mIsFifo;
+    Format mFormat;
+    SyncPolicy mSyncPolicy;
+    size_t mMaxBuffered;
+    std::deque<std::vector<uint8_t>> mPending;
+    size_t mPendingBytes;
+    size_t mPendingOffset;      // bytes of the front frame already written
+    bool mDirty;                // written since the last sync
+    uint32_t mDroppedBatches;
+};
+
+#endif /* BATCHED_LOCATION_SINK_H */
@@ -33,6 +33,7 @@
 #include <log_util.h>
 #include <LocContext.h>
 #include <BatchingAdapter.h>
+#include <algorithm>
 
 using namespace loc_core;
 
@@ -47,6 +48,9 @@ BatchingAdapter::BatchingAdapter() :
     mOngoingTripTBFInterval(0),
     mTripWithOngoingTBFDropped(false),
     mTripWithOngoingTripDistanceDropped(false),
+    mTripOdometerEnabled(false),
+    mTripOdometerActive(false),
+    mOngoingTripOdometerOnStart(0),
     mBatchingTimeout(0),
     mBatchingAccuracy(1),
     mBatchSize(0),
@@ -72,22 +76,36 @@ BatchingAdapter::readConfigCommand()
             uint32_t batchingAccuracy = 0;
             uint32_t batchSize = 0;
             uint32_t tripBatchSize = 0;
+            uint32_t apTripOdometer = 0;
+            char exportPath[LOC_MAX_PARAM_STRING];
+            uint32_t exportFormat = BatchedLocationSink::FORMAT_BINARY;
+            uint32_t exportSync = BatchedLocationSink::SYNC_NONE;
+            uint32_t exportBufferSize = 0;
+            memset(exportPath, 0, sizeof(exportPath));
             static const loc_param_s_type flp_conf_param_table[] =
             {
                 {"BATCH_SIZE", &batchSize, NULL, 'n'},
                 {"OUTDOOR_TRIP_BATCH_SIZE", &tripBatchSize, NULL, 'n'},
                 {"BATCH_SESSION_TIMEOUT", &batchingTimeout, NULL, 'n'},
                 {"ACCURACY", &batchingAccuracy, NULL, 'n'},
+                {"AP_TRIP_ODOMETER", &apTripOdometer, NULL, 'n'},
+                {"BATCH_EXPORT_PATH", &exportPath, NULL, 's'},
+                {"BATCH_EXPORT_FORMAT", &exportFormat, NULL, 'n'},
+                {"BATCH_EXPORT_FSYNC", &exportSync, NULL, 'n'},
+                {"BATCH_EXPORT_BUFFER_SIZE", &exportBufferSize, NULL, 'n'},
             };
             UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
 
-            LOC_LOGD("%s]: batchSize %u tripBatchSize %u batchingAccuracy %u batchingTimeout %u ",
-                     __func__, batchSize, tripBatchSize, batchingAccuracy, batchingTimeout);
+            LOC_LOGD("%s]: batchSize %u tripBatchSize %u batchingAccuracy %u batchingTimeout %u "
+                     "apTripOdometer %u", __func__, batchSize, tripBatchSize, batchingAccuracy,
+                     batchingTimeout, apTripOdometer);
 
              mAdapter.setBatchSize(batchSize);
              mAdapter.setTripBatchSize(tripBatchSize);
              mAdapter.setBatchingTimeout(batchingTimeout);
              mAdapter.setBatchingAccuracy(batchingAccuracy);
+             mAdapter.setTripOdometerEnabled(0 != apTripOdometer);
+             mAdapter.setBatchExport(exportPath, exportFormat, exportSync, exportBufferSize);
         }
     };
 
@@ -95,6 +113,29 @@ BatchingAdapter::readConfigCommand()
 
 }
 
+void
+BatchingAdapter::setBatchExport(const char* path, uint32_t format, uint32_t syncPolicy,
+        uint32_t bufferSize)
+{
+    if (nullptr == path || '\0' == path[0]) {
+        mBatchedLocationSink.close();
+        updateBatchedLocationsCapacity();
+        return;
+    }
+    if (0 == bufferSize) {
+        bufferSize = 64 * 1024;
+    }
+    if (!mBatchedLocationSink.open(path,
+            (BatchedLocationSink::FORMAT_TEXT == format) ?
+            BatchedLocationSink::FORMAT_TEXT : BatchedLocationSink::FORMAT_BINARY,
+            (syncPolicy > BatchedLocationSink::SYNC_FLUSH) ?
+            BatchedLocationSink::SYNC_NONE : (BatchedLocationSink::SyncPolicy)syncPolicy,
+            bufferSize)) {
+        LOC_LOGE("%s]: cannot export batched locations to %s", __func__, path);
+    }
+    updateBatchedLocationsCapacity();
+}
+
 void
 BatchingAdapter::setConfigCommand()
 {
@@ -234,6 +275,7 @@ BatchingAdapter::restartSessions()
 
         }
 
+        mOngoingTripOdometerOnStart = mTripOdometer.getDistance();
         mLocApi->startOutdoorTripBatching(mOngoingTripDistance, mOngoingTripTBFInterval,
                 getBatchingTimeout(), new LocApiResponse(*getContext(), [this] (LocationError err) {
             if (LOCATION_ERROR_SUCCESS != err) {
@@ -572,12 +614,16 @@ BatchingAdapter::getBatchedLocationsCommand(LocationAPI* client, uint32_t id, si
                             new LocApiResponse(*mAdapter.getContext(),
                             [&mAdapter = mAdapter, mSessionId = mSessionId,
                             mClient = mClient] (LocationError err) {
+                        // the locations pulled by this request have all been reported
+                        mAdapter.mBatchedLocationSink.flush();
                         mAdapter.reportResponse(mClient, err, mSessionId);
                     }));
                 } else {
                     mApi.getBatchedLocations(mCount, new LocApiResponse(*mAdapter.getContext(),
                             [&mAdapter = mAdapter, mSessionId = mSessionId,
                             mClient = mClient] (LocationError err) {
+                        // the locations pulled by this request have all been reported
+                        mAdapter.mBatchedLocationSink.flush();
                         mAdapter.reportResponse(mClient, err, mSessionId);
                     }));
                 }
@@ -631,11 +677,34 @@ BatchingAdapter::reportLocationsEvent(const Location* locations, size_t count,
     sendMsg(new MsgReportLocations(*this, locations, count, batchingMode));
 }
 
+void
+BatchingAdapter::updateBatchedLocationsCapacity()
+{
+    // the export is the only reader, without it the fixes are not kept
+    mBatchedLocations.setCapacity(mBatchedLocationSink.isOpen() ?
+                                  std::max(mBatchSize, mTripBatchSize) : 0);
+}
+
 void
 BatchingAdapter::reportLocations(Location* locations, size_t count, BatchingMode batchingMode)
 {
     BatchingOptions batchOptions = {sizeof(BatchingOptions), batchingMode};
 
+    if (mBatchedLocationSink.isOpen()) {
+        if (count > mBatchedLocations.capacity()) {
+            // flp.conf has no batch size, or the modem batched more than it
+            mBatchedLocations.setCapacity(count);
+        }
+        mBatchedLocations.append(locations, count);
+        size_t exported = std::min(count, mBatchedLocations.size());
+        mBatchedLocationSink.write(mBatchedLocations,
+                                   mBatchedLocations.size() - exported, exported);
+    }
+    if (mTripOdometerActive) {
+        updateTripOdometer(locations, count);
+    }
+
+    // every client gets the same read only array
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.batchingCb) {
             it->second.batchingCb(count, locations, batchOptions);
@@ -660,6 +729,25 @@ BatchingAdapter::reportCompletedTripsEvent(uint32_t accumulated_distance)
         }
         inline virtual void proc() const {
 
+            if (mAdapter.mTripOdometerEnabled) {
+                // the modem trip is over, the odometer decides which sessions are.
+                // It has only seen the batches delivered so far, so pull what the
+                // modem still holds of the trip first; those locations are all
+                // reported by the time the response comes
+                mAdapter.mLocApi->getBatchedTripLocations(mAdapter.mTripBatchSize, 0,
+                        new LocApiResponse(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter] (LocationError err) {
+                    if (LOCATION_ERROR_SUCCESS != err) {
+                        LOC_LOGE("%s] pending trip locations not fetched, err %u",
+                                 __func__, err);
+                    }
+                    mAdapter.mBatchedLocationSink.flush();
+                    mAdapter.mTripWithOngoingTripDistanceDropped = true;
+                    mAdapter.completeTripsOnOdometer(true);
+                }));
+                return;
+            }
+
             // Check if any trips are completed
             std::list<uint32_t> completedTripsList;
             completedTripsList.clear();
@@ -761,7 +849,12 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
         saveBatchingSession(client, sessionId, batchingOptions);
 
         mTripSessions[sessionId] = { 0, 0, 0, batchingOptions.minDistance,
-                batchingOptions.minInterval};
+                batchingOptions.minInterval, 0};
+        if (mTripOdometerEnabled) {
+            mTripOdometer.reset();
+            mOngoingTripOdometerOnStart = 0;
+            mTripOdometerActive = true;
+        }
         mLocApi->startOutdoorTripBatching(batchingOptions.minDistance,
                 batchingOptions.minInterval, getBatchingTimeout(), new LocApiResponse(*getContext(),
                 [this, client, sessionId, batchingOptions] (LocationError err) {
@@ -773,6 +866,7 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
             } else {
                 eraseBatchingSession(client, sessionId);
                 mTripSessions.erase(sessionId);
+                mTripOdometerActive = false;
                 // if we fail to start batching and we have already registered batch full event
                 // we need to undo that since no sessions are now interested in batch full event
                 if (0 == autoReportBatchingSessionsCount()) {
@@ -782,6 +876,44 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
             }
             reportResponse(client, err, sessionId);
         }));
+    } else if (mTripOdometerEnabled) {
+        // the odometer already knows how far the ongoing trip got
+        uint32_t odometer = mTripOdometer.getDistance();
+        mTripSessions[sessionId] = { 0, 0, 0, batchingOptions.minDistance,
+                batchingOptions.minInterval, odometer};
+        LOC_LOGD("%s] New Trip started ...", __func__);
+        printTripReport();
+
+        uint32_t travelled = odometer - mOngoingTripOdometerOnStart;
+        uint32_t ongoingTripDistance = (mOngoingTripDistance > travelled) ?
+                mOngoingTripDistance - travelled : 0;
+        uint32_t ongoingTripInterval = mOngoingTripTBFInterval;
+        bool needsRestart = false;
+        if (batchingOptions.minDistance < ongoingTripDistance) {
+            ongoingTripDistance = batchingOptions.minDistance;
+            needsRestart = true;
+        }
+        if (batchingOptions.minInterval < ongoingTripInterval) {
+            ongoingTripInterval = batchingOptions.minInterval;
+            needsRestart = true;
+        }
+        if (needsRestart) {
+            mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
+                    getBatchingTimeout(), new LocApiResponse(*getContext(),
+                    [this, client, sessionId, odometer, ongoingTripDistance,
+                    ongoingTripInterval] (LocationError err) {
+                if (err == LOCATION_ERROR_SUCCESS) {
+                    mOngoingTripDistance = ongoingTripDistance;
+                    mOngoingTripTBFInterval = ongoingTripInterval;
+                    mOngoingTripOdometerOnStart = odometer;
+                } else {
+                    LOC_LOGE("%s] New Trip restart failed!", __func__);
+                }
+                reportResponse(client, err, sessionId);
+            }));
+        } else {
+            reportResponse(client, LOCATION_ERROR_SUCCESS, sessionId);
+        }
     } else {
         // query accumulated distance
         mLocApi->queryAccumulatedTripDistance(
@@ -803,7 +935,7 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
             numOfBatchedPositions = data.numOfBatchedPositions;
             TripSessionStatus newTripSession = { accumulatedDistanceOngoingBatch, 0, 0,
                                                  batchingOptions.minDistance,
-                                                 batchingOptions.minInterval};
+                                                 batchingOptions.minInterval, 0};
             if (err != LOCATION_ERROR_SUCCESS) {
                 // unable to query accumulated distance, assume remaining distance in
                 // ongoing batch is mongoingTripDistance.
@@ -893,7 +1025,7 @@ BatchingAdapter::stopTripBatchingMultiplexCommon(LocationError err, LocationAPI*
         mTripWithOngoingTBFDropped = true;
     }
 
-    if (tripSess.tripDistance == mOngoingTripDistance) {
+    if (!mTripOdometerEnabled && tripSess.tripDistance == mOngoingTripDistance) {
         // trip with ongoing trip distance is stopped
         mTripWithOngoingTripDistanceDropped = true;
     }
@@ -903,6 +1035,7 @@ BatchingAdapter::stopTripBatchingMultiplexCommon(LocationError err, LocationAPI*
     if (mTripSessions.size() == 0) {
         mOngoingTripDistance = 0;
         mOngoingTripTBFInterval = 0;
+        mTripOdometerActive = false;
     } else {
         restartTripBatching(true);
     }
@@ -934,6 +1067,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
                                                [] (LocationError /*err*/) {}));
         mOngoingTripDistance = 0;
         mOngoingTripTBFInterval = 0;
+        mTripOdometerActive = false;
         // unregister for batch full event if there are no more
         // batching session that is interested in batch full event
         if (0 == autoReportBatchingSessionsCount()) {
@@ -946,6 +1080,11 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
     // record the min trip distance and min tbf interval of all ongoing sessions
     for (auto itt = mTripSessions.begin(); itt != mTripSessions.end(); itt++) {
 
+        if (mTripOdometerEnabled) {
+            TripSessionStatus &tripSess = itt->second;
+            tripSess.accumulatedDistanceThisTrip = std::min(tripSess.tripDistance,
+                    mTripOdometer.getDistance() - tripSess.odometerOnStart);
+        }
         TripSessionStatus tripSessStatus = itt->second;
 
         if ((minRemainingDistance == 0) ||
@@ -961,6 +1100,11 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
         }
     }
 
+    if (mTripOdometerEnabled) {
+        restartTripBatchingOnOdometer(minRemainingDistance, minTBFInterval);
+        return;
+    }
+
     mLocApi->queryAccumulatedTripDistance(
             new LocApiResponseData<LocApiBatchData>(*getContext(),
             [this, queryAccumulatedDistance, minRemainingDistance, minTBFInterval, accDist,
@@ -1048,3 +1192,138 @@ BatchingAdapter::printTripReport()
         }
     }
 }
+
+void
+BatchingAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
+        const GpsLocationExtended& /*locationExtended*/,
+        enum loc_sess_status status,
+        LocPosTechMask /*techMask*/,
+        GnssDataNotification* /*pDataNotify*/,
+        int /*msInWeek*/)
+{
+    // on the LocApi thread only the atomic flag is read, to skip the message
+    // when no trip is on; the adapter thread checks it again before it counts
+    if (!mTripOdometerActive.load() || LOC_SESS_SUCCESS != status ||
+            !(LOC_GPS_LOCATION_HAS_LAT_LONG & ulpLocation.gpsLocation.flags)) {
+        return;
+    }
+
+    struct MsgTripOdometerFix : public LocMsg {
+        BatchingAdapter& mAdapter;
+        Location mLocation;
+        inline MsgTripOdometerFix(BatchingAdapter& adapter,
+                                  const Location& location) :
+            LocMsg(),
+            mAdapter(adapter),
+            mLocation(location) {}
+        inline virtual void proc() const {
+            if (mAdapter.mTripOdometerActive) {
+                mAdapter.updateTripOdometer(&mLocation, 1);
+            }
+        }
+    };
+
+    Location location;
+    memset(&location, 0, sizeof(Location));
+    location.size = sizeof(Location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT;
+    location.latitude = ulpLocation.gpsLocation.latitude;
+    location.longitude = ulpLocation.gpsLocation.longitude;
+    if (LOC_GPS_LOCATION_HAS_ACCURACY & ulpLocation.gpsLocation.flags) {
+        location.flags |= LOCATION_HAS_ACCURACY_BIT;
+        location.accuracy = ulpLocation.gpsLocation.accuracy;
+    }
+    location.timestamp = ulpLocation.gpsLocation.timestamp;
+
+    sendMsg(new MsgTripOdometerFix(*this, location));
+}
+
+void
+BatchingAdapter::updateTripOdometer(const Location* locations, size_t count)
+{
+    // tracking and batched fixes may both be seen; the odometer keeps only
+    // the ones newer than what it already counted
+    bool moved = false;
+    for (size_t i = 0; i < count; ++i) {
+        moved = mTripOdometer.addLocation(locations[i]) || moved;
+    }
+    if (moved) {
+        completeTripsOnOdometer(false);
+    }
+}
+
+void
+BatchingAdapter::completeTripsOnOdometer(bool modemTripCompleted)
+{
+    uint32_t odometer = mTripOdometer.getDistance();
+    std::list<uint32_t> completedTripsList;
+
+    for (auto itt = mTripSessions.begin(); itt != mTripSessions.end();) {
+        TripSessionStatus &tripSession = itt->second;
+
+        tripSession.accumulatedDistanceThisTrip = odometer - tripSession.odometerOnStart;
+        if (tripSession.tripDistance <= tripSession.accumulatedDistanceThisTrip) {
+            completedTripsList.push_back(itt->first);
+            if (tripSession.tripTBFInterval == mOngoingTripTBFInterval) {
+                mTripWithOngoingTBFDropped = true;
+            }
+            itt = mTripSessions.erase(itt);
+        } else {
+            itt++;
+        }
+    }
+
+    if (completedTripsList.size() > 0) {
+        reportBatchStatusChange(BATCHING_STATUS_TRIP_COMPLETED, completedTripsList);
+    }
+    if (completedTripsList.size() > 0 || modemTripCompleted) {
+        restartTripBatching(false);
+    } else {
+        printTripReport();
+    }
+}
+
+void
+BatchingAdapter::restartTripBatchingOnOdometer(uint32_t minRemainingDistance,
+        uint32_t minTBFInterval)
+{
+    uint32_t odometer = mTripOdometer.getDistance();
+    uint32_t travelled = odometer - mOngoingTripOdometerOnStart;
+    uint32_t ongoingTripDistance = (mOngoingTripDistance > travelled) ?
+            mOngoingTripDistance - travelled : 0;
+    uint32_t ongoingTripInterval = mOngoingTripTBFInterval;
+    bool needsRestart = false;
+
+    // sessions ending on the AP leave the modem trip distance as it is, it only
+    // needs to come down for a shorter trip, or be renewed once the modem
+    // reported its own trip done
+    if (mTripWithOngoingTripDistanceDropped ||
+            minRemainingDistance < ongoingTripDistance) {
+        ongoingTripDistance = minRemainingDistance;
+        needsRestart = true;
+    }
+
+    if ((minTBFInterval < ongoingTripInterval) ||
+            ((minTBFInterval != ongoingTripInterval) && mTripWithOngoingTBFDropped)) {
+        ongoingTripInterval = minTBFInterval;
+        needsRestart = true;
+    }
+
+    if (needsRestart) {
+        mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
+                getBatchingTimeout(), new LocApiResponse(*getContext(),
+                [this, odometer, ongoingTripDistance, ongoingTripInterval]
+                (LocationError err) {
+            if (err == LOCATION_ERROR_SUCCESS) {
+                mOngoingTripDistance = ongoingTripDistance;
+                mOngoingTripTBFInterval = ongoingTripInterval;
+                mOngoingTripOdometerOnStart = odometer;
+                mTripWithOngoingTripDistanceDropped = false;
+                mTripWithOngoingTBFDropped = false;
+            }
+            printTripReport();
+        }));
+    } else {
+        printTripReport();
+    }
+}
@@ -32,7 +32,11 @@
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
+#include <BatchedLocationBuffer.h>
+#include <BatchedLocationSink.h>
+#include <TripOdometer.h>
 #include <map>
+#include <atomic>
 
 using namespace loc_core;
 
@@ -45,6 +49,7 @@ class BatchingAdapter : public LocAdapterBase {
         uint32_t accumulatedDistanceOnTripRestart;
         uint32_t tripDistance;
         uint32_t tripTBFInterval;
+        uint32_t odometerOnStart;
     } TripSessionStatus;
     typedef std::map<uint32_t, TripSessionStatus> TripSessionStatusMap;
     typedef std::map<LocationSessionKey, BatchingOptions> BatchingSessionMap;
@@ -74,12 +79,29 @@ class BatchingAdapter : public LocAdapterBase {
                              uint32_t numbatchedPos = 0);
     void printTripReport();
 
+    /* ==== TRIP ODOMETER ================================================================== */
+    // when enabled, trip distance is accounted for on the AP instead of being
+    // queried from the modem, which is then only restarted to tighten its
+    // trip distance or TBF interval
+    TripOdometer mTripOdometer;
+    bool mTripOdometerEnabled;
+    std::atomic<bool> mTripOdometerActive; //checked from the QMI thread on every fix
+    uint32_t mOngoingTripOdometerOnStart; //odometer when the modem trip last (re)started
+    void updateTripOdometer(const Location* locations, size_t count);
+    void completeTripsOnOdometer(bool modemTripCompleted);
+    void restartTripBatchingOnOdometer(uint32_t minRemainingDistance, uint32_t minTBFInterval);
+
     /* ==== CONFIGURATION ================================================================== */
     uint32_t mBatchingTimeout;
     uint32_t mBatchingAccuracy;
     size_t mBatchSize;
     size_t mTripBatchSize;
 
+    /* ==== BATCHED LOCATIONS ============================================================== */
+    BatchedLocationBuffer mBatchedLocations; //last reported fixes for the export, if there is one
+    void updateBatchedLocationsCapacity();
+    BatchedLocationSink mBatchedLocationSink; //optional export of every batched fix
+
 protected:
 
     /* ==== CLIENT ========================================================================= */
@@ -128,6 +150,12 @@ public:
             BatchingMode batchingMode);
     void reportCompletedTripsEvent(uint32_t accumulatedDistance);
     void reportBatchStatusChangeEvent(BatchingStatus batchStatus);
+    virtual void reportPositionEvent(const UlpLocation& location,
+                                     const GpsLocationExtended& locationExtended,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask techMask,
+                                     GnssDataNotification* pDataNotify = nullptr,
+                                     int msInWeek = -1);
     /* ======== UTILITIES ================================================================== */
     void reportLocations(Location* locations, size_t count, BatchingMode batchingMode);
     void reportBatchStatusChange(BatchingStatus batchStatus,
@@ -138,14 +166,23 @@ public:
     void readConfigCommand();
     void setConfigCommand();
     /* ======== UTILITIES ================================================================== */
-    void setBatchSize(size_t batchSize) { mBatchSize = batchSize; }
+    void setBatchSize(size_t batchSize) {
+        mBatchSize = batchSize;
+        updateBatchedLocationsCapacity();
+    }
     size_t getBatchSize() { return mBatchSize; }
-    void setTripBatchSize(size_t batchSize) { mTripBatchSize = batchSize; }
+    void setTripBatchSize(size_t batchSize) {
+        mTripBatchSize = batchSize;
+        updateBatchedLocationsCapacity();
+    }
     size_t getTripBatchSize() { return mTripBatchSize; }
     void setBatchingTimeout(uint32_t batchingTimeout) { mBatchingTimeout = batchingTimeout; }
     uint32_t getBatchingTimeout() { return mBatchingTimeout; }
     void setBatchingAccuracy(uint32_t accuracy) { mBatchingAccuracy = accuracy; }
     uint32_t getBatchingAccuracy() { return mBatchingAccuracy; }
+    void setTripOdometerEnabled(bool enabled) { mTripOdometerEnabled = enabled; }
+    void setBatchExport(const char* path, uint32_t format, uint32_t syncPolicy,
+                        uint32_t bufferSize);
 
 };
 
@@ -0,0 +1,100 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <TripOdometer.h>
+#include <loc_geo.h>
+
+// consecutive rejected jumps after which the anchor itself is suspect
+#define TRIP_ODOMETER_MAX_REJECTED_JUMPS 3
+
+TripOdometer::TripOdometer(float maxAccuracy, float maxSpeed) :
+    mMaxAccuracy(maxAccuracy),
+    mMaxSpeed(maxSpeed),
+    mDistance(0),
+    mHasAnchor(false),
+    mAnchorLatitude(0),
+    mAnchorLongitude(0),
+    mAnchorAccuracy(0),
+    mAnchorTimestamp(0),
+    mLastTimestamp(0),
+    mRejectedJumps(0)
+{
+}
+
+void
+TripOdometer::reset()
+{
+    mDistance = 0;
+    mHasAnchor = false;
+    mLastTimestamp = 0;
+    mRejectedJumps = 0;
+}
+
+bool
+TripOdometer::addLocation(const Location& location)
+{
+    if (!(LOCATION_HAS_LAT_LONG_BIT & location.flags) ||
+            location.timestamp <= mLastTimestamp) {
+        return false;
+    }
+    float accuracy = (LOCATION_HAS_ACCURACY_BIT & location.flags) ? location.accuracy : 0;
+    if (accuracy > mMaxAccuracy) {
+        return false;
+    }
+    mLastTimestamp = location.timestamp;
+
+    bool moved = false;
+    if (mHasAnchor) {
+        double distance = loc_geo_distance(mAnchorLatitude, mAnchorLongitude,
+                                           location.latitude, location.longitude);
+        double seconds = (location.timestamp - mAnchorTimestamp) / 1000.0;
+        if (distance > mMaxSpeed * seconds) {
+            if (++mRejectedJumps < TRIP_ODOMETER_MAX_REJECTED_JUMPS) {
+                return false;
+            }
+            // the anchor was the outlier, start over from this fix
+        } else {
+            // keep the anchor until the movement clears the noise, so slow
+            // movement still adds up
+            if (distance <= (accuracy > mAnchorAccuracy ? accuracy : mAnchorAccuracy)) {
+                mRejectedJumps = 0;
+                return false;
+            }
+            mDistance += distance;
+            moved = true;
+        }
+    }
+
+    mHasAnchor = true;
+    mAnchorLatitude = location.latitude;
+    mAnchorLongitude = location.longitude;
+    mAnchorAccuracy = accuracy;
+    mAnchorTimestamp = location.timestamp;
+    mRejectedJumps = 0;
+    return moved;
+}
@@ -0,0 +1,66 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef TRIP_ODOMETER_H
+#define TRIP_ODOMETER_H
+
+#include <LocationDataTypes.h>
+#include <stdint.h>
+
+// Distance travelled, integrated on the AP from the fixes the adapter sees,
+// so that trip sessions can be accounted for without asking the modem.
+//
+// A fix only moves the odometer once it is farther from the last counted fix
+// than either of their accuracies, so a device sitting still does not gain
+// distance from position noise. Fixes worse than the accuracy limit, fixes
+// not newer than the last one seen, and jumps faster than the speed limit
+// are dropped; a run of rejected jumps means the last counted fix was the
+// bad one, so the odometer re-anchors on the next fix.
+class TripOdometer {
+public:
+    TripOdometer(float maxAccuracy = 50.0f, float maxSpeed = 90.0f);
+
+    // returns true if the fix added distance
+    bool addLocation(const Location& location);
+    inline uint32_t getDistance() const { return (uint32_t)mDistance; }
+    void reset();
+
+private:
+    float mMaxAccuracy;         // meters
+    float mMaxSpeed;            // meters per second
+    double mDistance;
+    bool mHasAnchor;
+    double mAnchorLatitude;
+    double mAnchorLongitude;
+    float mAnchorAccuracy;
+    uint64_t mAnchorTimestamp;
+    uint64_t mLastTimestamp;
+    uint32_t mRejectedJumps;
+};
+
+#endif /* TRIP_ODOMETER_H */
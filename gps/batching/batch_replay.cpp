@@ -0,0 +1,166 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <BatchedLocationBuffer.h>
+#include <BatchedLocationSink.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+// Reads back what BatchedLocationSink exported, from a file, a FIFO or stdin,
+// and prints one line per fix. With -r the fixes are printed at the pace
+// they were recorded at, -s scales that pace.
+
+static double sSpeed = 0;      // 0: as fast as possible
+static uint64_t sPrevTimestamp = 0;
+
+static void replay(const Location& location)
+{
+    if (sSpeed > 0 && 0 != sPrevTimestamp && location.timestamp > sPrevTimestamp) {
+        uint64_t waitUs = (location.timestamp - sPrevTimestamp) * 1000 / sSpeed;
+        fflush(stdout);
+        usleep(waitUs);
+    }
+    sPrevTimestamp = location.timestamp;
+
+    char line[256];
+    size_t length = BatchedLocationSink::formatText(location, line, sizeof(line));
+    fwrite(line, 1, length, stdout);
+}
+
+static bool readFully(FILE* in, uint8_t* buf, size_t length)
+{
+    return length == fread(buf, 1, length, in);
+}
+
+static int replayBinary(FILE* in)
+{
+    std::vector<uint8_t> frame;
+    std::vector<Location> locations;
+    uint8_t header[8];
+    uint8_t lengthBytes[4];
+    size_t batches = 0;
+
+    while (readFully(in, lengthBytes, sizeof(lengthBytes))) {
+        // a FIFO writer that came back starts a new stream
+        if (0 == memcmp(lengthBytes, BATCHED_LOCATION_SINK_MAGIC, 4)) {
+            if (!readFully(in, header, 4)) {
+                break;
+            }
+            continue;
+        }
+        uint32_t length = lengthBytes[0] | (lengthBytes[1] << 8) |
+                          (lengthBytes[2] << 16) | ((uint32_t)lengthBytes[3] << 24);
+        frame.resize(length);
+        if (!readFully(in, frame.data(), length)) {
+            fprintf(stderr, "truncated batch %zu\n", batches);
+            return 1;
+        }
+        locations.clear();
+        if (!BatchedLocationBuffer::decode(frame.data(), length, locations)) {
+            fprintf(stderr, "corrupt batch %zu\n", batches);
+            return 1;
+        }
+        for (auto& location : locations) {
+            replay(location);
+        }
+        ++batches;
+    }
+    return 0;
+}
+
+static int replayText(FILE* in)
+{
+    char line[256];
+    while (NULL != fgets(line, sizeof(line), in)) {
+        Location location;
+        memset(&location, 0, sizeof(Location));
+        location.size = sizeof(Location);
+        unsigned int flags = 0;
+        unsigned int checksum = 0;
+        int fields = sscanf(line, "$PQBLC,%" SCNu64 ",%X,%lf,%lf,%lf,%f,%f,%f*%X",
+                            &location.timestamp, &flags, &location.latitude,
+                            &location.longitude, &location.altitude, &location.speed,
+                            &location.bearing, &location.accuracy, &checksum);
+        char* star = strchr(line, '*');
+        uint8_t sum = 0;
+        for (char* c = line + 1; NULL != star && c < star; ++c) {
+            sum ^= (uint8_t)*c;
+        }
+        if (9 != fields || sum != checksum) {
+            fprintf(stderr, "skipping bad sentence: %s", line);
+            continue;
+        }
+        location.flags = (LocationFlagsMask)flags;
+        replay(location);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "rs:"))) {
+        switch (opt) {
+        case 'r':
+            sSpeed = 1;
+            break;
+        case 's':
+            sSpeed = atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-r] [-s speed] [file|-]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    FILE* in = stdin;
+    if (optind < argc && 0 != strcmp(argv[optind], "-")) {
+        in = fopen(argv[optind], "rb");
+        if (NULL == in) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    // binary streams start with the magic, anything else is read as text
+    int first = fgetc(in);
+    if (EOF == first) {
+        return 0;
+    }
+    ungetc(first, in);
+    int ret = ('$' == first) ? replayText(in) : replayBinary(in);
+    fflush(stdout);
+    if (stdin != in) {
+        fclose(in);
+    }
+    return ret;
+}
@@ -0,0 +1,315 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <BatchedLocationBuffer.h>
+#include <loc_test_util.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Runs BatchedLocationBuffer on synthetic trips: the ring wrapping around
+// its end as batches are appended, capacity changes, and the encode() /
+// decode() round trip that batch_replay reads back from disk, over ranges
+// that wrap around the ring, with negative deltas, and cut short or
+// corrupted. The exit status is the number of failed checks.
+//
+// usage: batched_location_buffer_test
+
+#define TEST_TIME_MS        1600000000000ULL
+#define TEST_FIXES          500
+#define TEST_CAPACITY       64
+
+static uint32_t sSeed = 1;
+
+static double randomUnit()
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return (sSeed >> 8) / (double)(1 << 24);
+}
+
+// a random walk that crosses the antimeridian, climbs and descends, and
+// now and then steps back in time, so every field sees negative deltas
+static void makeTrip(std::vector<Location>& trip)
+{
+    trip.resize(TEST_FIXES);
+    double latitude = -33.8;
+    double longitude = 179.98;
+    double altitude = 40.0;
+    uint64_t timestamp = TEST_TIME_MS;
+    for (size_t i = 0; i < trip.size(); i++) {
+        Location& location = trip[i];
+        memset(&location, 0, sizeof(location));
+        location.size = sizeof(location);
+        location.flags = LOCATION_HAS_LAT_LONG_BIT | LOCATION_HAS_ALTITUDE_BIT |
+                         LOCATION_HAS_SPEED_BIT | LOCATION_HAS_BEARING_BIT |
+                         LOCATION_HAS_ACCURACY_BIT;
+        if (i % 7 != 0) {
+            location.flags |= LOCATION_HAS_VERTICAL_ACCURACY_BIT |
+                              LOCATION_HAS_SPEED_ACCURACY_BIT |
+                              LOCATION_HAS_BEARING_ACCURACY_BIT;
+        }
+        timestamp = (i % 50 == 49) ? timestamp - 300 : timestamp + 1000;
+        latitude += (randomUnit() - 0.5) * 1e-3;
+        longitude += randomUnit() * 2e-4;
+        if (longitude >= 180.0) {
+            longitude -= 360.0;
+        }
+        altitude += (randomUnit() - 0.5) * 20.0;
+        location.timestamp = timestamp;
+        location.latitude = latitude;
+        location.longitude = longitude;
+        location.altitude = altitude;
+        location.speed = (float)(randomUnit() * 30.0);
+        location.bearing = (float)(randomUnit() * 360.0);
+        location.accuracy = (float)(randomUnit() * 50.0);
+        location.verticalAccuracy = (float)(randomUnit() * 80.0);
+        location.speedAccuracy = (float)(randomUnit() * 2.0);
+        location.bearingAccuracy = (float)(randomUnit() * 10.0);
+        location.techMask = (randomUnit() < 0.5) ? LOCATION_TECHNOLOGY_GNSS_BIT :
+                            LOCATION_TECHNOLOGY_GNSS_BIT | LOCATION_TECHNOLOGY_SENSORS_BIT;
+        location.spoofMask = (i % 11 == 0) ? LOCATION_POSTION_SPOOFED : 0;
+    }
+}
+
+static bool sameFix(const Location& a, const Location& b)
+{
+    return a.timestamp == b.timestamp && a.flags == b.flags &&
+           a.latitude == b.latitude && a.longitude == b.longitude &&
+           a.altitude == b.altitude && a.speed == b.speed && a.bearing == b.bearing &&
+           a.accuracy == b.accuracy && a.verticalAccuracy == b.verticalAccuracy &&
+           a.speedAccuracy == b.speedAccuracy && a.bearingAccuracy == b.bearingAccuracy &&
+           a.techMask == b.techMask && a.spoofMask == b.spoofMask;
+}
+
+// within the quantization of encode(): 1e-7 degrees, cm, cm/s, 1/100 degree
+static bool decodedFix(const Location& decoded, const Location& fix)
+{
+    return decoded.size == sizeof(Location) &&
+           decoded.timestamp == fix.timestamp && decoded.flags == fix.flags &&
+           fabs(decoded.latitude - fix.latitude) <= 0.5e-7 + 1e-12 &&
+           fabs(decoded.longitude - fix.longitude) <= 0.5e-7 + 1e-12 &&
+           fabs(decoded.altitude - fix.altitude) <= 0.005 + 1e-9 &&
+           fabs(decoded.speed - fix.speed) <= 0.005f + 1e-5f &&
+           fabs(decoded.bearing - fix.bearing) <= 0.005f + 1e-4f &&
+           fabs(decoded.accuracy - fix.accuracy) <= 0.005f + 1e-5f &&
+           fabs(decoded.verticalAccuracy - fix.verticalAccuracy) <= 0.005f + 1e-5f &&
+           fabs(decoded.speedAccuracy - fix.speedAccuracy) <= 0.005f + 1e-5f &&
+           fabs(decoded.bearingAccuracy - fix.bearingAccuracy) <= 0.005f + 1e-5f &&
+           decoded.techMask == fix.techMask && decoded.spoofMask == fix.spoofMask;
+}
+
+// the ring holds fixes [first, first + size) of the trip, oldest first
+static bool holds(const BatchedLocationBuffer& buffer, const std::vector<Location>& trip,
+                  size_t first, size_t size)
+{
+    if (buffer.size() != size) {
+        return false;
+    }
+    Location location;
+    for (size_t i = 0; i < size; i++) {
+        buffer.getLocation(i, location);
+        if (!sameFix(location, trip[first + i]) ||
+                buffer.getTimestamp(i) != trip[first + i].timestamp ||
+                buffer.getLatitude(i) != trip[first + i].latitude) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool roundTrip(const BatchedLocationBuffer& buffer, size_t first, size_t count,
+                      const std::vector<Location>& trip, size_t tripFirst, size_t expected)
+{
+    std::vector<uint8_t> encoded;
+    std::vector<Location> decoded;
+    if (buffer.encode(first, count, encoded) != expected ||
+            !BatchedLocationBuffer::decode(encoded.data(), encoded.size(), decoded) ||
+            decoded.size() != expected) {
+        return false;
+    }
+    for (size_t i = 0; i < expected; i++) {
+        if (!decodedFix(decoded[i], trip[tripFirst + i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ==== RING =========================================================================== */
+
+static void testRing(const std::vector<Location>& trip)
+{
+    BatchedLocationBuffer buffer;
+    buffer.append(trip.data(), 10);
+    expectTrue("ring without a capacity keeps nothing", buffer.empty());
+
+    buffer.setCapacity(TEST_CAPACITY);
+    buffer.append(trip.data(), 10);
+    expectTrue("ring keeps a batch that fits", holds(buffer, trip, 0, 10));
+
+    // batches of uneven sizes wrap the ring around its end over and over
+    size_t appended = 10;
+    bool wraps = true;
+    for (size_t batch = 1; appended + batch <= 300; batch += 7) {
+        buffer.append(&trip[appended], batch);
+        appended += batch;
+        size_t size = std::min(appended, (size_t)TEST_CAPACITY);
+        wraps = wraps && holds(buffer, trip, appended - size, size);
+    }
+    expectTrue("ring keeps the newest fixes as it wraps", wraps);
+
+    buffer.append(&trip[appended], 3 * TEST_CAPACITY + 5);
+    appended += 3 * TEST_CAPACITY + 5;
+    expectTrue("ring keeps the newest of a batch larger than itself",
+               holds(buffer, trip, appended - TEST_CAPACITY, TEST_CAPACITY));
+
+    std::vector<Location> copied(TEST_CAPACITY);
+    bool copiedAgrees = buffer.getLocations(TEST_CAPACITY - 5, 20, copied.data()) == 5;
+    for (size_t i = 0; i < 5; i++) {
+        copiedAgrees = copiedAgrees && sameFix(copied[i], trip[appended - 5 + i]);
+    }
+    expectTrue("ring getLocations stops at the newest fix", copiedAgrees &&
+               0 == buffer.getLocations(TEST_CAPACITY, 1, copied.data()));
+
+    buffer.setCapacity(TEST_CAPACITY / 2);
+    expectTrue("ring shrinking keeps the newest fixes",
+               holds(buffer, trip, appended - TEST_CAPACITY / 2, TEST_CAPACITY / 2));
+    buffer.setCapacity(TEST_CAPACITY * 2);
+    buffer.append(&trip[appended], 10);
+    appended += 10;
+    expectTrue("ring growing keeps all fixes",
+               holds(buffer, trip, appended - TEST_CAPACITY / 2 - 10, TEST_CAPACITY / 2 + 10));
+
+    buffer.clear();
+    expectTrue("ring clear empties it", buffer.empty() &&
+               buffer.capacity() == TEST_CAPACITY * 2);
+}
+
+/* ==== ROUND TRIP ===================================================================== */
+
+static void testRoundTrip(const std::vector<Location>& trip)
+{
+    BatchedLocationBuffer all;
+    all.setCapacity(trip.size());
+    all.append(trip.data(), trip.size());
+    expectTrue("round trip a whole trip", roundTrip(all, 0, trip.size(), trip, 0, trip.size()));
+
+    // the head of a ring that wrapped is in the middle of its columns
+    BatchedLocationBuffer ring;
+    ring.setCapacity(TEST_CAPACITY);
+    size_t appended = 0;
+    for (size_t batch = 13; appended + batch <= 250; appended += batch) {
+        ring.append(&trip[appended], batch);
+    }
+    size_t oldest = appended - TEST_CAPACITY;
+    expectTrue("round trip a wrapped ring",
+               roundTrip(ring, 0, TEST_CAPACITY, trip, oldest, TEST_CAPACITY));
+    bool ranges = true;
+    for (size_t first = 0; first < TEST_CAPACITY; first += 5) {
+        for (size_t count = 1; first + count <= TEST_CAPACITY; count += 9) {
+            ranges = ranges && roundTrip(ring, first, count, trip, oldest + first, count);
+        }
+    }
+    expectTrue("round trip ranges across the wrap", ranges);
+
+    expectTrue("round trip a range past the newest fix is cut",
+               roundTrip(ring, TEST_CAPACITY - 4, 100, trip, oldest + TEST_CAPACITY - 4, 4));
+    expectTrue("round trip nothing from past the end",
+               roundTrip(ring, TEST_CAPACITY, 10, trip, 0, 0) &&
+               roundTrip(ring, 0, 0, trip, 0, 0));
+
+    // decode appends, so frames read one after the other add up
+    std::vector<uint8_t> frame;
+    std::vector<Location> decoded;
+    ring.encode(0, 10, frame);
+    bool appends = BatchedLocationBuffer::decode(frame.data(), frame.size(), decoded);
+    frame.clear();
+    ring.encode(10, 10, frame);
+    appends = appends && BatchedLocationBuffer::decode(frame.data(), frame.size(), decoded) &&
+              decoded.size() == 20 && decodedFix(decoded[15], trip[oldest + 15]);
+    expectTrue("round trip decode appends", appends);
+
+    // even with the accuracies all noise, the deltas take under half the structs
+    std::vector<uint8_t> encoded;
+    all.encode(0, trip.size(), encoded);
+    expectTrue("round trip encodes smaller than the fixes",
+               encoded.size() * 2 < trip.size() * sizeof(Location));
+}
+
+/* ==== BROKEN INPUT =================================================================== */
+
+static void testBrokenInput(const std::vector<Location>& trip)
+{
+    BatchedLocationBuffer buffer;
+    buffer.setCapacity(TEST_CAPACITY);
+    buffer.append(trip.data(), TEST_CAPACITY);
+    std::vector<uint8_t> encoded;
+    buffer.encode(0, 20, encoded);
+
+    std::vector<Location> decoded;
+    bool truncated = true;
+    for (size_t length = 0; length < encoded.size(); length++) {
+        decoded.clear();
+        truncated = truncated &&
+                !BatchedLocationBuffer::decode(encoded.data(), length, decoded) &&
+                decoded.size() <= 20;
+    }
+    expectTrue("broken every truncation fails", truncated);
+    expectTrue("broken no data fails", !BatchedLocationBuffer::decode(NULL, 10, decoded));
+
+    // a count larger than the frame runs out of data rather than past it
+    std::vector<uint8_t> counted(encoded);
+    counted[0] = 21;
+    decoded.clear();
+    expectTrue("broken a count too large fails",
+               !BatchedLocationBuffer::decode(counted.data(), counted.size(), decoded) &&
+               decoded.size() == 20);
+
+    // a varint that never ends is not read beyond ten bytes
+    std::vector<uint8_t> endless(16, 0x80);
+    endless.push_back(0);
+    expectTrue("broken an overlong varint fails",
+               !BatchedLocationBuffer::decode(endless.data(), endless.size(), decoded));
+
+    uint8_t none = 0;
+    decoded.clear();
+    expectTrue("broken an empty frame decodes to no fixes",
+               BatchedLocationBuffer::decode(&none, 1, decoded) && decoded.empty());
+}
+
+int main()
+{
+    std::vector<Location> trip;
+    makeTrip(trip);
+    testRing(trip);
+    testRoundTrip(trip);
+    testBrokenInput(trip);
+    return testResult();
+}
@@ -0,0 +1,285 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <TripOdometer.h>
+#include <loc_geo.h>
+#include <loc_test_util.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Runs TripOdometer on synthetic fixes: a device sitting still with noisy
+// positions, steady drives and walks, a single outlier, a bad first fix
+// that only a re-anchor gets rid of, fixes worse than the accuracy limit,
+// and timestamps that go back or repeat. The exit status is the number of
+// failed checks.
+//
+// usage: trip_odometer_test
+
+#define TEST_LATITUDE       48.85
+#define TEST_LONGITUDE      2.35
+#define TEST_TIME_MS        1600000000000ULL
+#define TEST_ACCURACY       10.0f
+#define TEST_FIXES          100
+// TripOdometer rejects jumps up to that many times before it re-anchors
+#define TEST_REJECTED_JUMPS 3
+
+static uint32_t sSeed = 1;
+
+static double randomUnit()
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return (sSeed >> 8) / (double)(1 << 24);
+}
+
+// meters north and east of the test point, which is near enough flat here
+static Location makeFix(uint64_t ms, double north, double east, float accuracy)
+{
+    Location location;
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT | LOCATION_HAS_ACCURACY_BIT;
+    location.timestamp = TEST_TIME_MS + ms;
+    location.latitude = TEST_LATITUDE + LOC_GEO_RAD_TO_DEG(north / LOC_GEO_EARTH_RADIUS_M);
+    location.longitude = TEST_LONGITUDE + LOC_GEO_RAD_TO_DEG(
+            east / (LOC_GEO_EARTH_RADIUS_M * cos(LOC_GEO_DEG_TO_RAD(TEST_LATITUDE))));
+    location.accuracy = accuracy;
+    return location;
+}
+
+// a fix a second along a drive north at speed
+static Location driveFix(size_t i, double speed)
+{
+    return makeFix(i * 1000, speed * i, 0.0, TEST_ACCURACY);
+}
+
+/* ==== STILL ========================================================================== */
+
+static void testStill()
+{
+    // every fix within half the accuracy of the true position, so any two
+    // are within the accuracy of each other
+    TripOdometer odometer;
+    bool neverMoved = true;
+    for (size_t i = 0; i < 10 * TEST_FIXES; i++) {
+        double radius = randomUnit() * TEST_ACCURACY / 2;
+        double angle = randomUnit() * 2 * M_PI;
+        neverMoved = !odometer.addLocation(makeFix(i * 1000, radius * cos(angle),
+                                                   radius * sin(angle), TEST_ACCURACY)) &&
+                     neverMoved;
+    }
+    expectTrue("still jitter adds no distance", neverMoved && 0 == odometer.getDistance());
+
+    // the deadband is the larger accuracy of the two fixes
+    TripOdometer coarse;
+    coarse.addLocation(makeFix(0, 0.0, 0.0, 40.0f));
+    expectTrue("still within the anchor accuracy adds nothing",
+               !coarse.addLocation(makeFix(1000, 30.0, 0.0, 5.0f)) &&
+               0 == coarse.getDistance());
+    expectTrue("still beyond the accuracy adds the distance",
+               coarse.addLocation(makeFix(2000, 45.0, 0.0, 5.0f)) &&
+               abs((int)coarse.getDistance() - 45) <= 1);
+}
+
+/* ==== MOVING ========================================================================= */
+
+static void testMoving()
+{
+    TripOdometer drive;
+    bool everyFix = true;
+    drive.addLocation(driveFix(0, 15.0));
+    for (size_t i = 1; i < TEST_FIXES; i++) {
+        everyFix = drive.addLocation(driveFix(i, 15.0)) && everyFix;
+    }
+    expectTrue("moving a drive counts every fix", everyFix);
+    expectTrue("moving a drive adds its length",
+               abs((int)drive.getDistance() - 15 * (TEST_FIXES - 1)) <= 1);
+
+    // at 1 m/s a fix a second is inside the deadband, the anchor waits for
+    // the movement to clear it and the distance still adds up
+    TripOdometer walk;
+    for (size_t i = 0; i < TEST_FIXES; i++) {
+        walk.addLocation(makeFix(i * 1000, 1.0 * i, 0.0, 5.0f));
+    }
+    expectTrue("moving a slow walk adds up",
+               walk.getDistance() <= TEST_FIXES - 1 &&
+               walk.getDistance() + 6 >= TEST_FIXES - 1);
+
+    // 100 m/s is over the default 90 m/s limit
+    TripOdometer fast;
+    fast.addLocation(makeFix(0, 0.0, 0.0, TEST_ACCURACY));
+    expectTrue("moving faster than the limit is a jump",
+               !fast.addLocation(makeFix(1000, 100.0, 0.0, TEST_ACCURACY)) &&
+               0 == fast.getDistance());
+    TripOdometer plane(50.0f, 300.0f);
+    plane.addLocation(makeFix(0, 0.0, 0.0, TEST_ACCURACY));
+    expectTrue("moving the speed limit is configurable",
+               plane.addLocation(makeFix(1000, 100.0, 0.0, TEST_ACCURACY)) &&
+               abs((int)plane.getDistance() - 100) <= 1);
+}
+
+/* ==== OUTLIERS ======================================================================= */
+
+static void testOutliers()
+{
+    // one fix 5 km off mid drive is dropped, the next one goes on from the
+    // anchor before it
+    TripOdometer single;
+    bool outlierDropped = true;
+    for (size_t i = 0; i < TEST_FIXES; i++) {
+        Location fix = driveFix(i, 15.0);
+        if (TEST_FIXES / 2 == i) {
+            fix = makeFix(i * 1000, 15.0 * i, 5000.0, TEST_ACCURACY);
+            outlierDropped = !single.addLocation(fix);
+        } else {
+            single.addLocation(fix);
+        }
+    }
+    expectTrue("outlier single is dropped", outlierDropped &&
+               abs((int)single.getDistance() - 15 * (TEST_FIXES - 1)) <= 1);
+
+    // two outliers in a row are still dropped
+    TripOdometer twice;
+    for (size_t i = 0; i < TEST_FIXES; i++) {
+        bool outlier = (i == 40 || i == 41);
+        twice.addLocation(outlier ? makeFix(i * 1000, 15.0 * i, -5000.0, TEST_ACCURACY) :
+                          driveFix(i, 15.0));
+    }
+    expectTrue("outlier pair is dropped",
+               abs((int)twice.getDistance() - 15 * (TEST_FIXES - 1)) <= 1);
+
+    // a first fix 10 km off makes every real fix a jump, until the run of
+    // rejections re-anchors on the track; the 10 km never count
+    TripOdometer anchored;
+    anchored.addLocation(makeFix(0, 10000.0, 0.0, TEST_ACCURACY));
+    bool rejected = true;
+    for (size_t i = 1; i < TEST_REJECTED_JUMPS; i++) {
+        rejected = !anchored.addLocation(driveFix(i, 15.0)) && rejected;
+    }
+    expectTrue("outlier anchor rejects the first jumps", rejected &&
+               0 == anchored.getDistance());
+    expectTrue("outlier anchor re-anchors without adding the jump",
+               !anchored.addLocation(driveFix(TEST_REJECTED_JUMPS, 15.0)) &&
+               0 == anchored.getDistance());
+    for (size_t i = TEST_REJECTED_JUMPS + 1; i < TEST_FIXES; i++) {
+        anchored.addLocation(driveFix(i, 15.0));
+    }
+    expectTrue("outlier anchor counts the track after it",
+               abs((int)anchored.getDistance() -
+                   15 * (int)(TEST_FIXES - 1 - TEST_REJECTED_JUMPS)) <= 1);
+
+    // a counted fix in between starts the count of jumps over, so outliers
+    // every other fix never re-anchor
+    TripOdometer interrupted;
+    for (size_t i = 0; i <= 4 * TEST_REJECTED_JUMPS; i++) {
+        interrupted.addLocation((i % 2) ? makeFix(i * 1000, 15.0 * i, 8000.0, TEST_ACCURACY) :
+                                driveFix(i, 15.0));
+    }
+    expectTrue("outlier count starts over after a counted fix",
+               abs((int)interrupted.getDistance() - 15 * 4 * TEST_REJECTED_JUMPS) <= 1);
+
+    // and so does a fix in the deadband; the outliers alone would make up
+    // a few runs here, on either side of a device sitting still, far enough
+    // to stay jumps from the anchor that has not moved since the first fix
+    TripOdometer still;
+    for (size_t i = 0; i <= 4 * TEST_REJECTED_JUMPS + 2; i++) {
+        double north = (i % 2) ? ((i % 4 == 1) ? 5000.0 : -5000.0) : 0.0;
+        still.addLocation(makeFix(i * 1000, north, 0.0, TEST_ACCURACY));
+    }
+    expectTrue("outlier count starts over after a fix in the deadband",
+               still.addLocation(makeFix((4 * TEST_REJECTED_JUMPS + 3) * 1000, 15.0, 0.0,
+                                         TEST_ACCURACY)) &&
+               abs((int)still.getDistance() - 15) <= 1);
+}
+
+/* ==== DROPPED ======================================================================== */
+
+static void testDropped()
+{
+    // fixes worse than the accuracy limit never move or anchor the odometer,
+    // even off by more than their accuracy and within the speed limit
+    TripOdometer coarse;
+    bool coarseDropped = true;
+    for (size_t i = 0; i < TEST_FIXES; i++) {
+        if (i % 2) {
+            coarseDropped = !coarse.addLocation(makeFix(i * 1000, 15.0 * i, 70.0, 60.0f)) &&
+                            coarseDropped;
+        } else {
+            coarse.addLocation(driveFix(i, 15.0));
+        }
+    }
+    expectTrue("dropped fixes over the accuracy limit", coarseDropped &&
+               abs((int)coarse.getDistance() - 15 * (TEST_FIXES - 2)) <= 1);
+
+    Location noPosition = driveFix(TEST_FIXES, 15.0);
+    noPosition.flags = LOCATION_HAS_ACCURACY_BIT;
+    uint32_t before = coarse.getDistance();
+    expectTrue("dropped fixes without a position",
+               !coarse.addLocation(noPosition) && before == coarse.getDistance());
+
+    // fixes not newer than the last one seen, older ones or ones at the same
+    // time, are dropped before they are looked at, so even far ones do not
+    // count as jumps
+    TripOdometer ordered;
+    for (size_t i = 0; i < TEST_FIXES; i++) {
+        ordered.addLocation(driveFix(i, 15.0));
+        if (i > 0 && 0 == i % 10) {
+            for (size_t j = 0; j < TEST_REJECTED_JUMPS; j++) {
+                ordered.addLocation(makeFix((i - j % 2) * 1000, 15.0 * i, 9000.0,
+                                            TEST_ACCURACY));
+            }
+            ordered.addLocation(makeFix(i * 1000, 15.0 * i + 100.0, 0.0, TEST_ACCURACY));
+        }
+    }
+    expectTrue("dropped fixes out of order",
+               abs((int)ordered.getDistance() - 15 * (TEST_FIXES - 1)) <= 1);
+
+    // a fix older than a dropped one is still dropped
+    TripOdometer stale;
+    stale.addLocation(driveFix(0, 15.0));
+    stale.addLocation(driveFix(10, 15.0));
+    expectTrue("dropped a fix older than the last one seen",
+               !stale.addLocation(driveFix(5, 15.0)) &&
+               abs((int)stale.getDistance() - 150) <= 1);
+
+    stale.reset();
+    expectTrue("dropped nothing after a reset",
+               0 == stale.getDistance() && !stale.addLocation(driveFix(1, 15.0)) &&
+               stale.addLocation(driveFix(2, 15.0)) &&
+               abs((int)stale.getDistance() - 15) <= 1);
+}
+
+int main()
+{
+    testStill();
+    testMoving();
+    testOutliers();
+    testDropped();
+    return testResult();
+}
@@ -22,6 +22,7 @@ LOCAL_SHARED_LIBRARIES := \
 
 LOCAL_SRC_FILES += \
     LocApiBase.cpp \
+    LocApiTrace.cpp \
     LocAdapterBase.cpp \
     ContextBase.cpp \
     LocContext.cpp \
@@ -42,6 +42,7 @@ namespace loc_core {
 
 #define SLL_LOC_API_LIB_NAME "libsynergy_loc_api.so"
 #define LOC_APIV2_0_LIB_NAME "libloc_api_v02.so"
+#define LOC_API_SIM_LIB_NAME "libloc_api_sim.so"
 #define IS_SS5_HW_ENABLED  1
 
 loc_gps_cfg_s_type ContextBase::mGps_conf {};
@@ -293,12 +294,35 @@ LocApiBase* ContextBase::createLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask)
         }
     }
 
+    // without a modem, use the simulator if it is installed
+    if (NULL == locApi) {
+        void *handle = dlopen(LOC_API_SIM_LIB_NAME, RTLD_NOW);
+        if (NULL != handle) {
+            getLocApi_t* getter = (getLocApi_t*) dlsym(handle, "getLocApi");
+            if (NULL != getter) {
+                LOC_LOGD("%s:%d]: using %s", __func__, __LINE__, LOC_API_SIM_LIB_NAME);
+                locApi = (*getter)(exMask, this);
+            }
+        }
+    }
+
     // locApi could still be NULL at this time
     // we would then create a dummy one
     if (NULL == locApi) {
         locApi = new LocApiBase(exMask, this);
     }
 
+    // the gps.conf items are only read later, take the trace file directly
+    char traceFile[LOC_MAX_PARAM_STRING] = {0};
+    const loc_param_s_type trace_conf_param_table[] =
+    {
+        {"LOC_API_TRACE_FILE", &traceFile, NULL, 's'},
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, trace_conf_param_table);
+    if ('\0' != traceFile[0]) {
+        locApi->startTrace(traceFile);
+    }
+
     return locApi;
 }
 
@@ -36,6 +36,9 @@
 #include <LocAdapterBase.h>
 #include <log_util.h>
 #include <LocContext.h>
+#include <LocApiTrace.h>
+#include <atomic>
+#include <unordered_map>
 
 namespace loc_core {
 
@@ -274,6 +277,58 @@ void LocApiBase::removeAdapter(LocAdapterBase* adapter)
     }
 }
 
+// Trace writers of the LocApis being recorded, kept out of LocApiBase so that
+// its layout stays the one the prebuilt LocApi backends are built against
+static pthread_mutex_t sTraceWritersLock = PTHREAD_MUTEX_INITIALIZER;
+static std::unordered_map<const LocApiBase*, LocApiTraceWriter*> sTraceWriters;
+// lets the upward calls skip the lookup while nothing is recorded
+static std::atomic<size_t> sTraceWritersCount(0);
+
+static LocApiTraceWriter* getTraceWriter(const LocApiBase* locApi)
+{
+    if (0 == sTraceWritersCount.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    LocApiTraceWriter* writer = nullptr;
+    pthread_mutex_lock(&sTraceWritersLock);
+    auto it = sTraceWriters.find(locApi);
+    if (it != sTraceWriters.end()) {
+        writer = it->second;
+    }
+    pthread_mutex_unlock(&sTraceWritersLock);
+    return writer;
+}
+
+bool LocApiBase::startTrace(const char* path)
+{
+    pthread_mutex_lock(&sTraceWritersLock);
+    auto it = sTraceWriters.find(this);
+    if (it == sTraceWriters.end()) {
+        LocApiTraceWriter* writer = LocApiTraceWriter::create(path);
+        if (nullptr != writer) {
+            it = sTraceWriters.emplace(this, writer).first;
+            sTraceWritersCount.store(sTraceWriters.size());
+        }
+    }
+    bool started = (it != sTraceWriters.end());
+    pthread_mutex_unlock(&sTraceWritersLock);
+    return started;
+}
+
+// the destructor of a prebuilt backend has the old LocApiBase destructor
+// inlined and does not get here; LocApis live as long as the process anyway
+void LocApiBase::stopTrace()
+{
+    pthread_mutex_lock(&sTraceWritersLock);
+    auto it = sTraceWriters.find(this);
+    if (it != sTraceWriters.end()) {
+        delete it->second;
+        sTraceWriters.erase(it);
+        sTraceWritersCount.store(sTraceWriters.size());
+    }
+    pthread_mutex_unlock(&sTraceWritersLock);
+}
+
 void LocApiBase::updateEvtMask()
 {
     sendMsg(new LocOpenMsg(this));
@@ -341,6 +396,11 @@ void LocApiBase::reportPosition(UlpLocation& location,
              locationExtended.gnss_sv_used_ids.bds_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.gal_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.qzss_sv_used_ids_mask);
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordPosition(location, locationExtended, status,
+                                     loc_technology_mask, pDataNotify, msInWeek);
+    }
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(
         mLocAdapters[i]->reportPositionEvent(location, locationExtended,
@@ -429,6 +489,10 @@ void LocApiBase::reportSv(GnssSvNotification& svNotify)
             svNotify.gnssSvs[i].carrierFrequencyHz,
             svNotify.gnssSvs[i].gnssSvOptionsMask);
     }
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordSv(svNotify);
+    }
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(
         mLocAdapters[i]->reportSvEvent(svNotify)
@@ -453,18 +517,30 @@ void LocApiBase::reportSvEphemeris(GnssSvEphemerisReport & svEphemeris)
 
 void LocApiBase::reportStatus(LocGpsStatusValue status)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordStatus(status);
+    }
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportStatus(status));
 }
 
 void LocApiBase::reportData(GnssDataNotification& dataNotify, int msInWeek)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordData(dataNotify, msInWeek);
+    }
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportDataEvent(dataNotify, msInWeek));
 }
 
 void LocApiBase::reportNmea(const char* nmea, int length)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordNmea(nmea, length);
+    }
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportNmeaEvent(nmea, length));
 }
@@ -533,6 +609,10 @@ LocApiProxyBase* LocApiBase :: getLocApiProxy()
 
 void LocApiBase::reportGnssMeasurements(GnssMeasurements& gnssMeasurements, int msInWeek)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordMeasurements(gnssMeasurements, msInWeek);
+    }
     // loop through adapters, and deliver to all adapters.
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportGnssMeasurementsEvent(gnssMeasurements, msInWeek));
 }
@@ -562,34 +642,58 @@ void LocApiBase::reportGnssSvTypeConfig(const GnssSvTypeConfig& config)
 void LocApiBase::geofenceBreach(size_t count, uint32_t* hwIds, Location& location,
                                 GeofenceBreachType breachType, uint64_t timestamp)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordGeofenceBreach(count, hwIds, location, breachType, timestamp);
+    }
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->geofenceBreachEvent(count, hwIds, location, breachType,
                                                             timestamp));
 }
 
 void LocApiBase::geofenceStatus(GeofenceStatusAvailable available)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordGeofenceStatus(available);
+    }
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->geofenceStatusEvent(available));
 }
 
 void LocApiBase::reportDBTPosition(UlpLocation &location, GpsLocationExtended &locationExtended,
                                    enum loc_sess_status status, LocPosTechMask loc_technology_mask)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordDBTPosition(location, locationExtended, status, loc_technology_mask);
+    }
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportPositionEvent(location, locationExtended, status,
                                                             loc_technology_mask));
 }
 
 void LocApiBase::reportLocations(Location* locations, size_t count, BatchingMode batchingMode)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordLocations(locations, count, batchingMode);
+    }
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportLocationsEvent(locations, count, batchingMode));
 }
 
 void LocApiBase::reportCompletedTrips(uint32_t accumulated_distance)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordCompletedTrips(accumulated_distance);
+    }
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportCompletedTripsEvent(accumulated_distance));
 }
 
 void LocApiBase::handleBatchStatusEvent(BatchingStatus batchStatus)
 {
+    LocApiTraceWriter* traceWriter = getTraceWriter(this);
+    if (nullptr != traceWriter) {
+        traceWriter->recordBatchStatus(batchStatus);
+    }
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportBatchStatusChangeEvent(batchStatus));
 }
 
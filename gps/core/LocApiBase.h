@@ -110,6 +110,7 @@ class LocApiBase {
     static MsgTask* mMsgTask;
     static volatile int32_t mMsgTaskRefCount;
     LocAdapterBase* mLocAdapters[MAX_ADAPTERS];
+    void stopTrace();
 
 protected:
     ContextBase *mContext;
@@ -123,6 +124,7 @@ protected:
     LocApiBase(LOC_API_ADAPTER_EVENT_MASK_T excludedMask,
                ContextBase* context = NULL);
     inline virtual ~LocApiBase() {
+        stopTrace();
         android_atomic_dec(&mMsgTaskRefCount);
         if (nullptr != mMsgTask && 0 == mMsgTaskRefCount) {
             mMsgTask->destroy();
@@ -157,6 +159,9 @@ public:
 
     void addAdapter(LocAdapterBase* adapter);
     void removeAdapter(LocAdapterBase* adapter);
+    // records the upward events below into a LocApiTrace file from now on;
+    // to be called before the LocApi is opened
+    bool startTrace(const char* path);
 
     // upward calls
     void handleEngineUpEvent();
@@ -0,0 +1,699 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_LocApiTrace"
+
+#include <LocApiTrace.h>
+#include <LocApiBase.h>
+#include <log_util.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#define LOC_API_TRACE_HAND_OFF_SIZE (32 * 1024)
+#define LOC_API_TRACE_HAND_OFF_NS   1000000000ULL
+// shorter runs of zeros stay in the literal
+#define LOC_API_TRACE_MIN_ZERO_RUN  4
+#define LOC_API_TRACE_MAX_PAYLOAD   (16 * 1024 * 1024)
+
+namespace loc_core {
+
+// the LocThread deletes its runnable, so it only points at the writer
+class LocApiTraceRunnable : public LocRunnable {
+    LocApiTraceWriter& mWriter;
+public:
+    inline LocApiTraceRunnable(LocApiTraceWriter& writer) : mWriter(writer) {}
+    virtual bool run() override {
+        return mWriter.write();
+    }
+};
+
+static uint64_t traceNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline size_t tracePad(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
+
+static void putVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+static bool getVarint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < size; shift += 7) {
+        uint8_t byte = data[pos++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// literal length, literal bytes, zero run length; repeated
+static void encodeZeroRuns(const std::vector<uint8_t>& in, std::vector<uint8_t>& out)
+{
+    size_t size = in.size();
+    size_t i = 0;
+    while (i < size) {
+        size_t literal = i;
+        size_t zeros = 0;
+        while (i < size) {
+            if (0 != in[i]) {
+                i++;
+                continue;
+            }
+            size_t end = i;
+            while (end < size && 0 == in[end]) {
+                end++;
+            }
+            if (end - i >= LOC_API_TRACE_MIN_ZERO_RUN || end == size) {
+                zeros = end - i;
+                break;
+            }
+            i = end;
+        }
+        putVarint(out, i - literal);
+        out.insert(out.end(), in.begin() + literal, in.begin() + i);
+        putVarint(out, zeros);
+        i += zeros;
+    }
+}
+
+static bool decodeZeroRuns(const uint8_t* in, size_t inSize, uint8_t* out, size_t outSize)
+{
+    size_t pos = 0;
+    size_t written = 0;
+    while (written < outSize) {
+        uint64_t literal = 0;
+        uint64_t zeros = 0;
+        if (!getVarint(in, inSize, pos, literal) ||
+                literal > inSize - pos || literal > outSize - written) {
+            return false;
+        }
+        memcpy(out + written, in + pos, literal);
+        pos += literal;
+        written += literal;
+        if (!getVarint(in, inSize, pos, zeros) || zeros > outSize - written) {
+            return false;
+        }
+        memset(out + written, 0, zeros);
+        written += zeros;
+    }
+    return pos == inSize;
+}
+
+/* ==== WRITER ============================================================================= */
+
+LocApiTraceWriter* LocApiTraceWriter::create(const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if (NULL == file) {
+        LOC_LOGE("%s]: can not create %s: %s", __func__, path, strerror(errno));
+        return NULL;
+    }
+
+    LocApiTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = LOC_API_TRACE_MAGIC;
+    header.version = LOC_API_TRACE_VERSION;
+    header.ulpLocationSize = sizeof(UlpLocation);
+    header.locationExtendedSize = sizeof(GpsLocationExtended);
+    header.locationSize = sizeof(Location);
+    header.svNotificationSize = sizeof(GnssSvNotification);
+    header.dataNotificationSize = sizeof(GnssDataNotification);
+    header.measurementsSize = sizeof(GnssMeasurements);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    header.startTimeMs = (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    if (1 != fwrite(&header, sizeof(header), 1, file)) {
+        LOC_LOGE("%s]: can not write %s: %s", __func__, path, strerror(errno));
+        fclose(file);
+        return NULL;
+    }
+    LocApiTraceWriter* writer = new LocApiTraceWriter(file);
+    LocApiTraceRunnable* runnable = new LocApiTraceRunnable(*writer);
+    if (!writer->mThread.start("LocApiTrace", runnable)) {
+        LOC_LOGE("%s]: can not start the writer thread for %s", __func__, path);
+        delete runnable;
+        delete writer;
+        return NULL;
+    }
+    LOC_LOGI("%s]: tracing LocApi events to %s", __func__, path);
+    return writer;
+}
+
+LocApiTraceWriter::LocApiTraceWriter(FILE* file) :
+    mFile(file),
+    mHandedOff(false),
+    mStopping(false),
+    mLastEventNs(traceNowNs()),
+    mLastHandOffNs(mLastEventNs)
+{
+    pthread_mutex_init(&mMutex, NULL);
+    pthread_cond_init(&mCond, NULL);
+    mBuffer.reserve(LOC_API_TRACE_HAND_OFF_SIZE + 4096);
+    mWriting.reserve(LOC_API_TRACE_HAND_OFF_SIZE + 4096);
+}
+
+LocApiTraceWriter::~LocApiTraceWriter()
+{
+    flush();
+    pthread_mutex_lock(&mMutex);
+    mStopping = true;
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mMutex);
+    mThread.stop();
+    fclose(mFile);
+    pthread_cond_destroy(&mCond);
+    pthread_mutex_destroy(&mMutex);
+}
+
+void LocApiTraceWriter::record(LocApiTraceEvent event,
+                               const LocApiTraceField* fields, size_t count)
+{
+    uint64_t nowNs = traceNowNs();
+    pthread_mutex_lock(&mMutex);
+
+    mPayload.clear();
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* data = (const uint8_t*)fields[i].data;
+        if (NULL != data) {
+            mPayload.insert(mPayload.end(), data, data + fields[i].size);
+        }
+        mPayload.resize(tracePad(mPayload.size()), 0);
+    }
+    mEncoded.clear();
+    encodeZeroRuns(mPayload, mEncoded);
+
+    mBuffer.push_back((uint8_t)event);
+    putVarint(mBuffer, nowNs - mLastEventNs);
+    putVarint(mBuffer, mPayload.size());
+    putVarint(mBuffer, mEncoded.size());
+    mBuffer.insert(mBuffer.end(), mEncoded.begin(), mEncoded.end());
+    mLastEventNs = nowNs;
+
+    if (mBuffer.size() >= LOC_API_TRACE_HAND_OFF_SIZE ||
+            nowNs - mLastHandOffNs >= LOC_API_TRACE_HAND_OFF_NS) {
+        handOffLocked(nowNs);
+    }
+    pthread_mutex_unlock(&mMutex);
+}
+
+void LocApiTraceWriter::flush()
+{
+    pthread_mutex_lock(&mMutex);
+    // the writer may still be busy with the buffer before
+    while (mHandedOff) {
+        pthread_cond_wait(&mCond, &mMutex);
+    }
+    handOffLocked(traceNowNs());
+    while (mHandedOff) {
+        pthread_cond_wait(&mCond, &mMutex);
+    }
+    pthread_mutex_unlock(&mMutex);
+}
+
+// a no-op while the writer is busy, record() hands the buffer off later
+void LocApiTraceWriter::handOffLocked(uint64_t nowNs)
+{
+    if (!mHandedOff && !mBuffer.empty()) {
+        // the swap gives the buffer back the capacity of the one written before
+        mWriting.swap(mBuffer);
+        mHandedOff = true;
+        pthread_cond_broadcast(&mCond);
+        mLastHandOffNs = nowNs;
+    }
+}
+
+bool LocApiTraceWriter::write()
+{
+    pthread_mutex_lock(&mMutex);
+    while (!mHandedOff && !mStopping) {
+        pthread_cond_wait(&mCond, &mMutex);
+    }
+    if (!mHandedOff) {
+        pthread_mutex_unlock(&mMutex);
+        return false;
+    }
+    pthread_mutex_unlock(&mMutex);
+
+    if (1 != fwrite(mWriting.data(), mWriting.size(), 1, mFile) || 0 != fflush(mFile)) {
+        LOC_LOGE("%s]: %zu bytes lost: %s", __func__, mWriting.size(), strerror(errno));
+    }
+    mWriting.clear();
+
+    pthread_mutex_lock(&mMutex);
+    mHandedOff = false;
+    // wakes flush()
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mMutex);
+    return true;
+}
+
+void LocApiTraceWriter::recordPosition(const UlpLocation& location,
+                                       const GpsLocationExtended& locationExtended,
+                                       enum loc_sess_status status, LocPosTechMask techMask,
+                                       const GnssDataNotification* pDataNotify, int msInWeek)
+{
+    int32_t traceStatus = status;
+    int32_t traceMsInWeek = msInWeek;
+    uint8_t hasData = (NULL != pDataNotify);
+    const LocApiTraceField fields[] = {
+        {&location, sizeof(location)},
+        {&locationExtended, sizeof(locationExtended)},
+        {&traceStatus, sizeof(traceStatus)},
+        {&techMask, sizeof(techMask)},
+        {&traceMsInWeek, sizeof(traceMsInWeek)},
+        {&hasData, sizeof(hasData)},
+        {pDataNotify, hasData ? sizeof(*pDataNotify) : 0}
+    };
+    record(LOC_API_TRACE_POSITION, fields);
+}
+
+void LocApiTraceWriter::recordDBTPosition(const UlpLocation& location,
+                                          const GpsLocationExtended& locationExtended,
+                                          enum loc_sess_status status, LocPosTechMask techMask)
+{
+    int32_t traceStatus = status;
+    const LocApiTraceField fields[] = {
+        {&location, sizeof(location)},
+        {&locationExtended, sizeof(locationExtended)},
+        {&traceStatus, sizeof(traceStatus)},
+        {&techMask, sizeof(techMask)}
+    };
+    record(LOC_API_TRACE_DBT_POSITION, fields);
+}
+
+void LocApiTraceWriter::recordSv(const GnssSvNotification& svNotify)
+{
+    const LocApiTraceField fields[] = {{&svNotify, sizeof(svNotify)}};
+    record(LOC_API_TRACE_SV, fields);
+}
+
+void LocApiTraceWriter::recordStatus(LocGpsStatusValue status)
+{
+    const LocApiTraceField fields[] = {{&status, sizeof(status)}};
+    record(LOC_API_TRACE_STATUS, fields);
+}
+
+void LocApiTraceWriter::recordNmea(const char* nmea, int length)
+{
+    int32_t traceLength = (NULL != nmea && length > 0) ? length : 0;
+    char terminator = '\0';
+    const LocApiTraceField fields[] = {
+        {&traceLength, sizeof(traceLength)},
+        {nmea, (size_t)traceLength},
+        {&terminator, sizeof(terminator)}
+    };
+    record(LOC_API_TRACE_NMEA, fields);
+}
+
+void LocApiTraceWriter::recordData(const GnssDataNotification& dataNotify, int msInWeek)
+{
+    int32_t traceMsInWeek = msInWeek;
+    const LocApiTraceField fields[] = {
+        {&dataNotify, sizeof(dataNotify)},
+        {&traceMsInWeek, sizeof(traceMsInWeek)}
+    };
+    record(LOC_API_TRACE_DATA, fields);
+}
+
+void LocApiTraceWriter::recordMeasurements(const GnssMeasurements& gnssMeasurements,
+                                           int msInWeek)
+{
+    int32_t traceMsInWeek = msInWeek;
+    const LocApiTraceField fields[] = {
+        {&gnssMeasurements, sizeof(gnssMeasurements)},
+        {&traceMsInWeek, sizeof(traceMsInWeek)}
+    };
+    record(LOC_API_TRACE_MEASUREMENTS, fields);
+}
+
+void LocApiTraceWriter::recordGeofenceBreach(size_t count, const uint32_t* hwIds,
+                                             const Location& location,
+                                             GeofenceBreachType breachType,
+                                             uint64_t timestamp)
+{
+    uint64_t traceCount = (NULL != hwIds) ? count : 0;
+    int32_t traceBreachType = breachType;
+    const LocApiTraceField fields[] = {
+        {&traceCount, sizeof(traceCount)},
+        {hwIds, traceCount * sizeof(uint32_t)},
+        {&location, sizeof(location)},
+        {&traceBreachType, sizeof(traceBreachType)},
+        {&timestamp, sizeof(timestamp)}
+    };
+    record(LOC_API_TRACE_GEOFENCE_BREACH, fields);
+}
+
+void LocApiTraceWriter::recordGeofenceStatus(GeofenceStatusAvailable available)
+{
+    int32_t traceAvailable = available;
+    const LocApiTraceField fields[] = {{&traceAvailable, sizeof(traceAvailable)}};
+    record(LOC_API_TRACE_GEOFENCE_STATUS, fields);
+}
+
+void LocApiTraceWriter::recordLocations(const Location* locations, size_t count,
+                                        BatchingMode batchingMode)
+{
+    uint64_t traceCount = (NULL != locations) ? count : 0;
+    int32_t traceBatchingMode = batchingMode;
+    const LocApiTraceField fields[] = {
+        {&traceCount, sizeof(traceCount)},
+        {locations, traceCount * sizeof(Location)},
+        {&traceBatchingMode, sizeof(traceBatchingMode)}
+    };
+    record(LOC_API_TRACE_LOCATIONS, fields);
+}
+
+void LocApiTraceWriter::recordCompletedTrips(uint32_t accumulatedDistance)
+{
+    const LocApiTraceField fields[] = {{&accumulatedDistance, sizeof(accumulatedDistance)}};
+    record(LOC_API_TRACE_COMPLETED_TRIPS, fields);
+}
+
+void LocApiTraceWriter::recordBatchStatus(BatchingStatus batchStatus)
+{
+    int32_t traceBatchStatus = batchStatus;
+    const LocApiTraceField fields[] = {{&traceBatchStatus, sizeof(traceBatchStatus)}};
+    record(LOC_API_TRACE_BATCH_STATUS, fields);
+}
+
+/* ==== READER ============================================================================= */
+
+// walks the fields of a decoded payload in the order they were recorded
+class LocApiTraceCursor {
+    uint8_t* mData;
+    size_t mSize;
+    size_t mPos;
+public:
+    inline LocApiTraceCursor(uint8_t* data, size_t size) :
+        mData(data), mSize(size), mPos(0) {}
+    // NULL when the payload is too short
+    template <typename T>
+    inline T* get(size_t count = 1) {
+        size_t size = sizeof(T) * count;
+        if (count > mSize / sizeof(T) || size > mSize - mPos) {
+            return NULL;
+        }
+        T* field = reinterpret_cast<T*>(mData + mPos);
+        mPos += tracePad(size);
+        return field;
+    }
+};
+
+LocApiTraceReader::LocApiTraceReader() :
+    mPos(0),
+    mEvent(LOC_API_TRACE_NONE),
+    mTimeNs(0),
+    mPayloadSize(0)
+{
+}
+
+bool LocApiTraceReader::open(const char* path)
+{
+    mFile.clear();
+    FILE* file = fopen(path, "rb");
+    if (NULL == file) {
+        LOC_LOGE("%s]: can not open %s: %s", __func__, path, strerror(errno));
+        return false;
+    }
+    uint8_t chunk[64 * 1024];
+    size_t length = 0;
+    while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        mFile.insert(mFile.end(), chunk, chunk + length);
+    }
+    fclose(file);
+
+    LocApiTraceHeader header;
+    if (mFile.size() < sizeof(header)) {
+        LOC_LOGE("%s]: %s is not a LocApi trace", __func__, path);
+        return false;
+    }
+    memcpy(&header, mFile.data(), sizeof(header));
+    if (LOC_API_TRACE_MAGIC != header.magic || LOC_API_TRACE_VERSION != header.version) {
+        LOC_LOGE("%s]: %s is not a LocApi trace of version %d",
+                 __func__, path, LOC_API_TRACE_VERSION);
+        return false;
+    }
+    if (sizeof(UlpLocation) != header.ulpLocationSize ||
+            sizeof(GpsLocationExtended) != header.locationExtendedSize ||
+            sizeof(Location) != header.locationSize ||
+            sizeof(GnssSvNotification) != header.svNotificationSize ||
+            sizeof(GnssDataNotification) != header.dataNotificationSize ||
+            sizeof(GnssMeasurements) != header.measurementsSize) {
+        LOC_LOGE("%s]: %s was recorded with different structs", __func__, path);
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+bool LocApiTraceReader::next()
+{
+    const uint8_t* data = mFile.data();
+    size_t size = mFile.size();
+    uint64_t deltaNs = 0;
+    uint64_t payloadSize = 0;
+    uint64_t encodedSize = 0;
+
+    mEvent = LOC_API_TRACE_NONE;
+    if (mPos >= size) {
+        return false;
+    }
+    uint8_t event = data[mPos++];
+    if (LOC_API_TRACE_NONE == event || event >= LOC_API_TRACE_EVENT_MAX ||
+            !getVarint(data, size, mPos, deltaNs) ||
+            !getVarint(data, size, mPos, payloadSize) ||
+            !getVarint(data, size, mPos, encodedSize) ||
+            encodedSize > size - mPos || payloadSize > LOC_API_TRACE_MAX_PAYLOAD) {
+        LOC_LOGE("%s]: broken record at %zu", __func__, mPos);
+        mPos = size;
+        return false;
+    }
+    mPayload.resize((payloadSize + 7) / 8);
+    if (!decodeZeroRuns(data + mPos, encodedSize, (uint8_t*)mPayload.data(), payloadSize)) {
+        LOC_LOGE("%s]: broken payload at %zu", __func__, mPos);
+        mPos = size;
+        return false;
+    }
+    mPos += encodedSize;
+    mPayloadSize = payloadSize;
+    mTimeNs += deltaNs;
+    mEvent = (LocApiTraceEvent)event;
+    return true;
+}
+
+uint64_t LocApiTraceReader::nmeaKey(const char* nmea, size_t length)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; NULL != nmea && i < length; i++) {
+        hash = (hash ^ (uint8_t)nmea[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t LocApiTraceReader::key() const
+{
+    LocApiTraceCursor cursor((uint8_t*)mPayload.data(), mPayloadSize);
+    switch (mEvent) {
+    case LOC_API_TRACE_POSITION:
+    case LOC_API_TRACE_DBT_POSITION: {
+        UlpLocation* location = cursor.get<UlpLocation>();
+        return (NULL != location) ? (uint64_t)location->gpsLocation.timestamp : 0;
+    }
+    case LOC_API_TRACE_NMEA: {
+        int32_t* length = cursor.get<int32_t>();
+        char* nmea = (NULL != length) ? cursor.get<char>(*length) : NULL;
+        return (NULL != nmea) ? nmeaKey(nmea, *length) : 0;
+    }
+    case LOC_API_TRACE_MEASUREMENTS: {
+        GnssMeasurements* measurements = cursor.get<GnssMeasurements>();
+        return (NULL != measurements) ?
+                (uint64_t)measurements->gnssMeasNotification.clock.timeNs : 0;
+    }
+    case LOC_API_TRACE_GEOFENCE_BREACH: {
+        uint64_t* count = cursor.get<uint64_t>();
+        if (NULL == count || NULL == cursor.get<uint32_t>(*count) ||
+                NULL == cursor.get<Location>() || NULL == cursor.get<int32_t>()) {
+            return 0;
+        }
+        uint64_t* timestamp = cursor.get<uint64_t>();
+        return (NULL != timestamp) ? *timestamp : 0;
+    }
+    case LOC_API_TRACE_LOCATIONS: {
+        uint64_t* count = cursor.get<uint64_t>();
+        Location* locations = (NULL != count) ? cursor.get<Location>(*count) : NULL;
+        return (NULL != locations && *count > 0) ? locations[0].timestamp : 0;
+    }
+    default:
+        return 0;
+    }
+}
+
+bool LocApiTraceReader::deliver(LocApiBase& locApi)
+{
+    LocApiTraceCursor cursor((uint8_t*)mPayload.data(), mPayloadSize);
+    switch (mEvent) {
+    case LOC_API_TRACE_POSITION:
+    case LOC_API_TRACE_DBT_POSITION: {
+        UlpLocation* location = cursor.get<UlpLocation>();
+        GpsLocationExtended* locationExtended = cursor.get<GpsLocationExtended>();
+        int32_t* status = cursor.get<int32_t>();
+        LocPosTechMask* techMask = cursor.get<LocPosTechMask>();
+        if (NULL == location || NULL == locationExtended || NULL == status ||
+                NULL == techMask) {
+            return false;
+        }
+        if (LOC_API_TRACE_DBT_POSITION == mEvent) {
+            locApi.reportDBTPosition(*location, *locationExtended,
+                                     (enum loc_sess_status)*status, *techMask);
+            return true;
+        }
+        int32_t* msInWeek = cursor.get<int32_t>();
+        uint8_t* hasData = cursor.get<uint8_t>();
+        GnssDataNotification* dataNotify = NULL;
+        if (NULL == msInWeek || NULL == hasData ||
+                (*hasData && NULL == (dataNotify = cursor.get<GnssDataNotification>()))) {
+            return false;
+        }
+        locApi.reportPosition(*location, *locationExtended, (enum loc_sess_status)*status,
+                              *techMask, dataNotify, *msInWeek);
+        return true;
+    }
+    case LOC_API_TRACE_SV: {
+        GnssSvNotification* svNotify = cursor.get<GnssSvNotification>();
+        if (NULL == svNotify) {
+            return false;
+        }
+        locApi.reportSv(*svNotify);
+        return true;
+    }
+    case LOC_API_TRACE_STATUS: {
+        LocGpsStatusValue* status = cursor.get<LocGpsStatusValue>();
+        if (NULL == status) {
+            return false;
+        }
+        locApi.reportStatus(*status);
+        return true;
+    }
+    case LOC_API_TRACE_NMEA: {
+        int32_t* length = cursor.get<int32_t>();
+        char* nmea = (NULL != length) ? cursor.get<char>(*length + 1) : NULL;
+        if (NULL == nmea || '\0' != nmea[*length]) {
+            return false;
+        }
+        locApi.reportNmea(nmea, *length);
+        return true;
+    }
+    case LOC_API_TRACE_DATA: {
+        GnssDataNotification* dataNotify = cursor.get<GnssDataNotification>();
+        int32_t* msInWeek = cursor.get<int32_t>();
+        if (NULL == dataNotify || NULL == msInWeek) {
+            return false;
+        }
+        locApi.reportData(*dataNotify, *msInWeek);
+        return true;
+    }
+    case LOC_API_TRACE_MEASUREMENTS: {
+        GnssMeasurements* measurements = cursor.get<GnssMeasurements>();
+        int32_t* msInWeek = cursor.get<int32_t>();
+        if (NULL == measurements || NULL == msInWeek) {
+            return false;
+        }
+        locApi.reportGnssMeasurements(*measurements, *msInWeek);
+        return true;
+    }
+    case LOC_API_TRACE_GEOFENCE_BREACH: {
+        uint64_t* count = cursor.get<uint64_t>();
+        uint32_t* hwIds = (NULL != count) ? cursor.get<uint32_t>(*count) : NULL;
+        Location* location = cursor.get<Location>();
+        int32_t* breachType = cursor.get<int32_t>();
+        uint64_t* timestamp = cursor.get<uint64_t>();
+        if (NULL == hwIds || NULL == location || NULL == breachType || NULL == timestamp) {
+            return false;
+        }
+        locApi.geofenceBreach(*count, hwIds, *location,
+                              (GeofenceBreachType)*breachType, *timestamp);
+        return true;
+    }
+    case LOC_API_TRACE_GEOFENCE_STATUS: {
+        int32_t* available = cursor.get<int32_t>();
+        if (NULL == available) {
+            return false;
+        }
+        locApi.geofenceStatus((GeofenceStatusAvailable)*available);
+        return true;
+    }
+    case LOC_API_TRACE_LOCATIONS: {
+        uint64_t* count = cursor.get<uint64_t>();
+        Location* locations = (NULL != count) ? cursor.get<Location>(*count) : NULL;
+        int32_t* batchingMode = cursor.get<int32_t>();
+        if (NULL == locations || NULL == batchingMode) {
+            return false;
+        }
+        locApi.reportLocations(locations, *count, (BatchingMode)*batchingMode);
+        return true;
+    }
+    case LOC_API_TRACE_COMPLETED_TRIPS: {
+        uint32_t* accumulatedDistance = cursor.get<uint32_t>();
+        if (NULL == accumulatedDistance) {
+            return false;
+        }
+        locApi.reportCompletedTrips(*accumulatedDistance);
+        return true;
+    }
+    case LOC_API_TRACE_BATCH_STATUS: {
+        int32_t* batchStatus = cursor.get<int32_t>();
+        if (NULL == batchStatus) {
+            return false;
+        }
+        locApi.handleBatchStatusEvent((BatchingStatus)*batchStatus);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+} // namespace loc_core
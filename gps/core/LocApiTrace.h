@@ -0,0 +1,190 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef LOC_API_TRACE_H
+#define LOC_API_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <vector>
+#include <gps_extended.h>
+#include <LocationAPI.h>
+#include <LocThread.h>
+
+namespace loc_core {
+
+class LocApiBase;
+
+// Binary trace of the events a LocApiBase delivers to the adapters, for
+// replaying a device session on a workstation.
+//
+// The file starts with a LocApiTraceHeader, followed by one record per
+// event: the event byte, then as varints the nanoseconds since the previous
+// record, or since the trace was started for the first one (CLOCK_MONOTONIC),
+// the payload length and the encoded length, then the encoded payload. The
+// payload is the arguments of the upward call, each padded to 8 bytes, with
+// runs of zero bytes squeezed out; the reports are mostly unused array
+// slots, a measurement report shrinks from tens of KB to a few hundred
+// bytes. Structs go in as they are in memory, so a trace only replays on
+// the ABI it was recorded on; the header holds the struct sizes to catch a
+// mismatch.
+typedef enum {
+    LOC_API_TRACE_NONE = 0,
+    LOC_API_TRACE_POSITION,         // reportPosition
+    LOC_API_TRACE_DBT_POSITION,     // reportDBTPosition
+    LOC_API_TRACE_SV,               // reportSv
+    LOC_API_TRACE_STATUS,           // reportStatus
+    LOC_API_TRACE_NMEA,             // reportNmea
+    LOC_API_TRACE_DATA,             // reportData
+    LOC_API_TRACE_MEASUREMENTS,     // reportGnssMeasurements
+    LOC_API_TRACE_GEOFENCE_BREACH,  // geofenceBreach
+    LOC_API_TRACE_GEOFENCE_STATUS,  // geofenceStatus
+    LOC_API_TRACE_LOCATIONS,        // reportLocations
+    LOC_API_TRACE_COMPLETED_TRIPS,  // reportCompletedTrips
+    LOC_API_TRACE_BATCH_STATUS,     // handleBatchStatusEvent
+    LOC_API_TRACE_EVENT_MAX
+} LocApiTraceEvent;
+
+#define LOC_API_TRACE_MAGIC     0x5254414C  // "LATR"
+#define LOC_API_TRACE_VERSION   1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ulpLocationSize;
+    uint32_t locationExtendedSize;
+    uint32_t locationSize;
+    uint32_t svNotificationSize;
+    uint32_t dataNotificationSize;
+    uint32_t measurementsSize;
+    uint64_t startTimeMs;           // wall clock, for the record only
+} LocApiTraceHeader;
+
+// one argument of an upward call
+typedef struct {
+    const void* data;
+    size_t size;
+} LocApiTraceField;
+
+// Records the events of one LocApiBase. record() is called on the thread
+// the modem reports on; it only encodes into a buffer, which is handed to a
+// writer thread of its own once it holds 32 KB, or with the first event a
+// second after the previous hand-off. The reporting thread never waits for
+// the file: while the writer is still busy with the previous buffer, the
+// events go on into the current one and it is handed off with a later event.
+class LocApiTraceWriter {
+public:
+    // NULL if the file can not be created
+    static LocApiTraceWriter* create(const char* path);
+    ~LocApiTraceWriter();
+
+    void recordPosition(const UlpLocation& location,
+                        const GpsLocationExtended& locationExtended,
+                        enum loc_sess_status status, LocPosTechMask techMask,
+                        const GnssDataNotification* pDataNotify, int msInWeek);
+    void recordDBTPosition(const UlpLocation& location,
+                           const GpsLocationExtended& locationExtended,
+                           enum loc_sess_status status, LocPosTechMask techMask);
+    void recordSv(const GnssSvNotification& svNotify);
+    void recordStatus(LocGpsStatusValue status);
+    void recordNmea(const char* nmea, int length);
+    void recordData(const GnssDataNotification& dataNotify, int msInWeek);
+    void recordMeasurements(const GnssMeasurements& gnssMeasurements, int msInWeek);
+    void recordGeofenceBreach(size_t count, const uint32_t* hwIds, const Location& location,
+                              GeofenceBreachType breachType, uint64_t timestamp);
+    void recordGeofenceStatus(GeofenceStatusAvailable available);
+    void recordLocations(const Location* locations, size_t count, BatchingMode batchingMode);
+    void recordCompletedTrips(uint32_t accumulatedDistance);
+    void recordBatchStatus(BatchingStatus batchStatus);
+    // returns once all recorded so far is in the file
+    void flush();
+
+    // one handed off buffer to the file, on the writer thread; false once stopping
+    bool write();
+
+private:
+    LocApiTraceWriter(FILE* file);
+    template <size_t N>
+    inline void record(LocApiTraceEvent event, const LocApiTraceField (&fields)[N]) {
+        record(event, fields, N);
+    }
+    void record(LocApiTraceEvent event, const LocApiTraceField* fields, size_t count);
+    void handOffLocked(uint64_t nowNs);
+
+    pthread_mutex_t mMutex;
+    pthread_cond_t mCond;
+    FILE* mFile;
+    std::vector<uint8_t> mPayload;
+    std::vector<uint8_t> mEncoded;
+    std::vector<uint8_t> mBuffer;
+    std::vector<uint8_t> mWriting;  // the writer thread's alone while mHandedOff
+    bool mHandedOff;
+    bool mStopping;
+    uint64_t mLastEventNs;
+    uint64_t mLastHandOffNs;
+    LocThread mThread;
+};
+
+// Reads a trace back and delivers its events to a LocApiBase, through the
+// same upward calls they were recorded from.
+class LocApiTraceReader {
+public:
+    LocApiTraceReader();
+
+    // reads the whole file, false if it is not a trace of this ABI
+    bool open(const char* path);
+    inline void rewind() { mPos = sizeof(LocApiTraceHeader); mTimeNs = 0; }
+
+    // steps to the next event, false at the end or on a broken record
+    bool next();
+    inline LocApiTraceEvent event() const { return mEvent; }
+    // nanoseconds since the first event of the trace
+    inline uint64_t timeNs() const { return mTimeNs; }
+    // identifies the event in what the adapters pass on to clients: the fix
+    // time for positions, batches and breaches, the clock time for
+    // measurements, a hash of the sentence for NMEA; 0 for the others
+    uint64_t key() const;
+    static uint64_t nmeaKey(const char* nmea, size_t length);
+
+    // calls the upward method of locApi the event came from
+    bool deliver(LocApiBase& locApi);
+
+private:
+    std::vector<uint8_t> mFile;
+    size_t mPos;
+    LocApiTraceEvent mEvent;
+    uint64_t mTimeNs;
+    std::vector<uint64_t> mPayload;     // 8 byte aligned, as the fields are
+    size_t mPayloadSize;
+};
+
+} // namespace loc_core
+
+#endif /* LOC_API_TRACE_H */
@@ -45,10 +45,57 @@ COUT SystemStatusOsObserver::containerTransfer(CINT& inContainer) {
     return outContainer;
 }
 
-SystemStatusOsObserver::~SystemStatusOsObserver() {
-    // Close data-item library handle
-    DataItemsFactoryProxy::closeDataItemLibraryHandle();
+DataItemPool::~DataItemPool() {
+    clear();
+    pthread_mutex_destroy(&mMutex);
+}
+
+IDataItemCore* DataItemPool::obtain(DataItemId id) {
+    IDataItemCore* dataItem = nullptr;
+    if (id > INVALID_DATA_ITEM_ID && id < MAX_DATA_ITEM_ID_1_1) {
+        pthread_mutex_lock(&mMutex);
+        if (!mFreeItems[id].empty()) {
+            dataItem = mFreeItems[id].back();
+            mFreeItems[id].pop_back();
+        }
+        pthread_mutex_unlock(&mMutex);
+    }
+    if (nullptr == dataItem) {
+        dataItem = DataItemsFactoryProxy::createNewDataItem(id);
+    }
+    return dataItem;
+}
+
+void DataItemPool::recycle(IDataItemCore* dataItem) {
+    if (nullptr != dataItem) {
+        DataItemId id = dataItem->getId();
+        bool recycled = false;
+        if (id > INVALID_DATA_ITEM_ID && id < MAX_DATA_ITEM_ID_1_1) {
+            pthread_mutex_lock(&mMutex);
+            if (mFreeItems[id].size() < MAX_FREE_ITEMS_PER_ID) {
+                mFreeItems[id].push_back(dataItem);
+                recycled = true;
+            }
+            pthread_mutex_unlock(&mMutex);
+        }
+        if (!recycled) {
+            delete dataItem;
+        }
+    }
+}
 
+void DataItemPool::clear() {
+    pthread_mutex_lock(&mMutex);
+    for (auto& freeItems : mFreeItems) {
+        for (auto dataItem : freeItems) {
+            delete dataItem;
+        }
+        freeItems.clear();
+    }
+    pthread_mutex_unlock(&mMutex);
+}
+
+SystemStatusOsObserver::~SystemStatusOsObserver() {
     // Destroy cache
     for (auto each : mDataItemCache) {
         if (nullptr != each.second) {
@@ -57,6 +104,10 @@ SystemStatusOsObserver::~SystemStatusOsObserver() {
     }
 
     mDataItemCache.clear();
+    mDataItemPool.clear();
+
+    // Close data-item library handle, after all the data items it created are gone
+    DataItemsFactoryProxy::closeDataItemLibraryHandle();
 }
 
 void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscriptionObj)
@@ -103,7 +154,8 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
         void proc() const {
             unordered_set<DataItemId> dataItemsToSubscribe(0);
             mParent->mDataItemToClients.add(mDataItemSet, {mClient}, &dataItemsToSubscribe);
-            mParent->mClientToDataItems.add(mClient, mDataItemSet);
+            mParent->mClientToDataItems.add(mClient,
+                                            ClientToDataItems::toValSet(mDataItemSet));
 
             mParent->sendCachedDataItems(mDataItemSet, mClient);
 
@@ -150,27 +202,26 @@ void SystemStatusOsObserver::updateSubscription(
             unordered_set<DataItemId> dataItemsToSubscribe(0);
             unordered_set<DataItemId> dataItemsToUnsubscribe(0);
             unordered_set<IDataItemObserver*> clients({mClient});
-            // below removes clients from all entries keyed with the return of the
-            // mClientToDataItems.update() call. If leaving an empty set of clients as the
-            // result, the entire entry will be removed. dataItemsToUnsubscribe will be
+            // this call updates <IDataItemObserver*, DataItemId> map; removes
+            // the DataItemId's that are not new to the client from newDataItems;
+            // and returns a set of DataItemId's that are no longer used by client.
+            DataItemIdSet newDataItems(ClientToDataItems::toValSet(mDataItemSet));
+            DataItemIdSet goneDataItems(
+                    mParent->mClientToDataItems.update(mClient, newDataItems));
+            // below removes clients from all entries keyed with the unused set of
+            // DataItemId's. If leaving an empty set of clients as the result, the
+            // entire entry will be removed. dataItemsToUnsubscribe will be
             // populated to keep the keys of the removed entries.
             mParent->mDataItemToClients.trimOrRemove(
-                    // this call updates <IDataItemObserver*, DataItemId> map; removes
-                    // the DataItemId's that are not new to the clietn from mDataItemSet;
-                    // and returns a set of mDataItemSet's that are no longer used by client.
-                    // This unused set of mDataItemSet's is passed to trimOrRemove method of
-                    // <DataItemId, IDataItemObserver*> map to remove the client from the
-                    // corresponding entries, and gets a set of the entries that are
-                    // removed from the <DataItemId, IDataItemObserver*> map as a result.
-                    mParent->mClientToDataItems.update(mClient,
-                                                       (unordered_set<DataItemId>&)mDataItemSet),
+                    ClientToDataItems::toUnorderedSet(goneDataItems),
                     clients, &dataItemsToUnsubscribe, nullptr);
             // below adds mClient to <DataItemId, IDataItemObserver*> map, and populates
             // new keys added to that map, which are DataItemIds to be subscribed.
-            mParent->mDataItemToClients.add(mDataItemSet, clients, &dataItemsToSubscribe);
+            mParent->mDataItemToClients.add(ClientToDataItems::toUnorderedSet(newDataItems),
+                                            clients, &dataItemsToSubscribe);
 
             // Send First Response
-            mParent->sendCachedDataItems(mDataItemSet, mClient);
+            mParent->sendCachedDataItems(newDataItems, mClient);
 
             if (nullptr != mParent->mContext.mSubscriptionObj) {
                 // Send subscription set to framework
@@ -219,13 +270,15 @@ void SystemStatusOsObserver::unsubscribe(
                 mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsUnusedByClient(0);
+            DataItemIdSet dataItemsUnusedByClient;
             unordered_set<IDataItemObserver*> clientToRemove(0);
-            mParent->mClientToDataItems.trimOrRemove({mClient}, mDataItemSet,  &clientToRemove,
-                                                     &dataItemsUnusedByClient);
+            mParent->mClientToDataItems.trimOrRemove({mClient},
+                                                     ClientToDataItems::toValSet(mDataItemSet),
+                                                     &clientToRemove, &dataItemsUnusedByClient);
             unordered_set<DataItemId> dataItemsToUnsubscribe(0);
-            mParent->mDataItemToClients.trimOrRemove(dataItemsUnusedByClient, {mClient},
-                                                     &dataItemsToUnsubscribe, nullptr);
+            mParent->mDataItemToClients.trimOrRemove(
+                    ClientToDataItems::toUnorderedSet(dataItemsUnusedByClient), {mClient},
+                    &dataItemsToUnsubscribe, nullptr);
 
             if (nullptr != mParent->mContext.mSubscriptionObj && !dataItemsToUnsubscribe.empty()) {
                 LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
@@ -258,12 +311,13 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
                 mParent(parent), mClient(client) {}
 
         void proc() const {
-            unordered_set<DataItemId> diByClient = mParent->mClientToDataItems.getValSet(mClient);
-            if (!diByClient.empty()) {
+            DataItemIdSet diByClient = mParent->mClientToDataItems.getValSet(mClient);
+            if (diByClient.any()) {
                 unordered_set<DataItemId> dataItemsToUnsubscribe;
                 mParent->mClientToDataItems.remove(mClient);
-                mParent->mDataItemToClients.trimOrRemove(diByClient, {mClient},
-                                                         &dataItemsToUnsubscribe, nullptr);
+                mParent->mDataItemToClients.trimOrRemove(
+                        ClientToDataItems::toUnorderedSet(diByClient), {mClient},
+                        &dataItemsToUnsubscribe, nullptr);
 
                 if (!dataItemsToUnsubscribe.empty() &&
                     nullptr != mParent->mContext.mSubscriptionObj) {
@@ -300,51 +354,56 @@ void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
                 mParent(parent), mDiVec(std::move(v)) {}
 
         inline virtual ~HandleNotify() {
+            // items taken into the cache are nullptr here
             for (auto item : mDiVec) {
-                delete item;
+                mParent->mDataItemPool.recycle(item);
             }
         }
 
         void proc() const {
             // Update Cache with received data items and prepare
-            // list of data items to be sent.
-            unordered_set<DataItemId> dataItemIdsToBeSent(0);
-            for (auto item : mDiVec) {
-                if (mParent->updateCache(item)) {
-                    dataItemIdsToBeSent.insert(item->getId());
+            // set of data items to be sent.
+            DataItemIdSet dataItemIdsToBeSent;
+            for (auto& item : mDiVec) {
+                DataItemId id = item->getId();
+                if (mParent->updateCache(item) && ClientToDataItems::isValidVal(id)) {
+                    dataItemIdsToBeSent.set(id);
                 }
             }
 
-            // Send data item to all subscribed clients
-            unordered_set<IDataItemObserver*> clientSet(0);
-            for (auto each : dataItemIdsToBeSent) {
-                auto clients = mParent->mDataItemToClients.getValSetPtr(each);
-                if (nullptr != clients) {
-                    clientSet.insert(clients->begin(), clients->end());
-                }
+            if (dataItemIdsToBeSent.none()) {
+                return;
             }
 
-            for (auto client : clientSet) {
-                unordered_set<DataItemId> dataItemIdsForThisClient(
-                        mParent->mClientToDataItems.getValSet(client));
-                for (auto itr = dataItemIdsForThisClient.begin();
-                        itr != dataItemIdsForThisClient.end(); ) {
-                    if (dataItemIdsToBeSent.find(*itr) == dataItemIdsToBeSent.end()) {
-                        itr = dataItemIdsForThisClient.erase(itr);
-                    } else {
-                        itr++;
+            // Send data item to all subscribed clients. Only the clients
+            // subscribed to an updated id are visited. A client is notified
+            // at the lowest updated id it subscribes to, i.e. when none of
+            // the ids already visited in this batch are in its set.
+            DataItemIdSet visitedIds;
+            for (int id = 0; id < MAX_DATA_ITEM_ID_1_1; id++) {
+                if (!dataItemIdsToBeSent.test(id)) {
+                    continue;
+                }
+                auto clients = mParent->mDataItemToClients.getValSetPtr((DataItemId)id);
+                if (nullptr != clients) {
+                    for (auto client : *clients) {
+                        auto dataItemIds = mParent->mClientToDataItems.getValSetPtr(client);
+                        if (nullptr != dataItemIds && (*dataItemIds & visitedIds).none()) {
+                            mParent->sendCachedDataItems(
+                                    *dataItemIds & dataItemIdsToBeSent, client);
+                        }
                     }
                 }
-
-                mParent->sendCachedDataItems(dataItemIdsForThisClient, client);
+                visitedIds.set(id);
             }
         }
         SystemStatusOsObserver* mParent;
-        const vector<IDataItemCore*> mDiVec;
+        mutable vector<IDataItemCore*> mDiVec;
     };
 
     if (!dlist.empty()) {
-        vector<IDataItemCore*> dataItemVec(dlist.size());
+        vector<IDataItemCore*> dataItemVec;
+        dataItemVec.reserve(dlist.size());
 
         for (auto each : dlist) {
             IF_LOC_LOGD {
@@ -353,7 +412,7 @@ void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
                 LOC_LOGD("notify: DataItem In Value:%s", dv.c_str());
             }
 
-            IDataItemCore* di = DataItemsFactoryProxy::createNewDataItem(each->getId());
+            IDataItemCore* di = mDataItemPool.obtain(each->getId());
             if (nullptr == di) {
                 LOC_LOGw("Unable to create dataitem:%d", each->getId());
                 continue;
@@ -538,7 +597,41 @@ void SystemStatusOsObserver::sendCachedDataItems(
     }
 }
 
-bool SystemStatusOsObserver::updateCache(IDataItemCore* d)
+void SystemStatusOsObserver::sendCachedDataItems(
+        const DataItemIdSet& s, IDataItemObserver* to)
+{
+    if (nullptr == to) {
+        LOC_LOGv("client pointer is NULL.");
+    } else if (s.any()) {
+        string clientName;
+        to->getName(clientName);
+        list<IDataItemCore*> dataItems(0);
+
+        for (int id = 0; id < MAX_DATA_ITEM_ID_1_1; id++) {
+            if (!s.test(id)) {
+                continue;
+            }
+            auto citer = mDataItemCache.find((DataItemId)id);
+            if (citer != mDataItemCache.end()) {
+                IF_LOC_LOGI {
+                    string dv;
+                    citer->second->stringify(dv);
+                    LOC_LOGI("DataItem: %s >> %s", dv.c_str(), clientName.c_str());
+                }
+                dataItems.push_front(citer->second);
+            }
+        }
+
+        if (dataItems.empty()) {
+            LOC_LOGv("No items to notify.");
+        } else {
+            to->notify(dataItems);
+        }
+    }
+}
+
+// If *d* is taken into the cache, the caller's pointer is set to nullptr.
+bool SystemStatusOsObserver::updateCache(IDataItemCore*& d)
 {
     bool dataItemUpdated = false;
 
@@ -548,23 +641,20 @@ bool SystemStatusOsObserver::updateCache(IDataItemCore* d)
     // So it has to be true to proceed.
     if (nullptr != d && mSystemStatus->eventDataItemNotify(d)) {
         auto citer = mDataItemCache.find(d->getId());
+        DataItemId id = d->getId();
         if (citer == mDataItemCache.end()) {
-            // New data item; not found in cache
-            IDataItemCore* dataitem = DataItemsFactoryProxy::createNewDataItem(d->getId());
-            if (nullptr != dataitem) {
-                // Copy the contents of the data item
-                dataitem->copy(d);
-                // Insert in mDataItemCache
-                mDataItemCache.insert(std::make_pair(d->getId(), dataitem));
-                dataItemUpdated = true;
-            }
+            // New data item; not found in cache. It was already copied
+            // in notify(), so take it over instead of copying it again.
+            mDataItemCache.insert(std::make_pair(id, d));
+            d = nullptr;
+            dataItemUpdated = true;
         } else {
             // Found in cache; Update cache if necessary
             citer->second->copy(d, &dataItemUpdated);
         }
 
         if (dataItemUpdated) {
-            LOC_LOGV("DataItem:%d updated:%d", d->getId(), dataItemUpdated);
+            LOC_LOGV("DataItem:%d updated:%d", id, dataItemUpdated);
         }
     }
 
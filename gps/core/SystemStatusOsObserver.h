@@ -56,7 +56,9 @@ class IDataItemCore;
 class SystemStatus;
 class SystemStatusOsObserver;
 typedef map<IDataItemObserver*, list<DataItemId>> ObserverReqCache;
-typedef LocUnorderedSetMap<IDataItemObserver*, DataItemId> ClientToDataItems;
+// DataItemIds are small and dense, so the per client sets are bitsets
+typedef LocBitSetMap<IDataItemObserver*, DataItemId, MAX_DATA_ITEM_ID_1_1> ClientToDataItems;
+typedef ClientToDataItems::ValSet DataItemIdSet;
 typedef LocUnorderedSetMap<DataItemId, IDataItemObserver*> DataItemToClients;
 typedef unordered_map<DataItemId, IDataItemCore*> DataItemIdToCore;
 typedef unordered_map<DataItemId, int> DataItemIdToInt;
@@ -72,6 +74,24 @@ struct ObserverContext {
             mMsgTask(msgTask), mSSObserver(observer) {}
 };
 
+// Recycles the data items that carry notify() data over to the MsgTask
+// thread, so a burst of updates of the same DataItemId does not go through
+// the data item library allocator for each of them. obtain() may be called
+// from any thread, recycle() from the MsgTask thread.
+class DataItemPool {
+public:
+    inline DataItemPool() { pthread_mutex_init(&mMutex, nullptr); }
+    ~DataItemPool();
+    IDataItemCore* obtain(DataItemId id);
+    void recycle(IDataItemCore* dataItem);
+    void clear();
+
+private:
+    static const size_t MAX_FREE_ITEMS_PER_ID = 4;
+    pthread_mutex_t mMutex;
+    vector<IDataItemCore*> mFreeItems[MAX_DATA_ITEM_ID_1_1];
+};
+
 // Clients wanting to get data from OS/Framework would need to
 // subscribe with OSObserver using IDataItemSubscription interface.
 // Such clients would need to implement IDataItemObserver interface
@@ -146,6 +166,7 @@ private:
     ClientToDataItems                                mClientToDataItems;
     DataItemToClients                                mDataItemToClients;
     DataItemIdToCore                                 mDataItemCache;
+    DataItemPool                                     mDataItemPool;
     DataItemIdToInt                                  mActiveRequestCount;
 
     // Cache the subscribe and requestData till subscription obj is obtained
@@ -160,7 +181,8 @@ private:
 
     // Helpers
     void sendCachedDataItems(const unordered_set<DataItemId>& s, IDataItemObserver* to);
-    bool updateCache(IDataItemCore* d);
+    void sendCachedDataItems(const DataItemIdSet& s, IDataItemObserver* to);
+    bool updateCache(IDataItemCore*& d);
     inline void logMe(const unordered_set<DataItemId>& l) {
         IF_LOC_LOGD {
             for (auto id : l) {
@@ -0,0 +1,298 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <SystemStatus.h>
+#include <SystemStatusOsObserver.h>
+#include <DataItemsFactoryProxy.h>
+#include <MsgTask.h>
+#include <loc_test_util.h>
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <unordered_set>
+
+using namespace loc_core;
+
+// Times SystemStatusOsObserver::notify() on bursts of network info and RIL
+// cell info updates, alternating, each delivered to all the subscribers.
+// The data item library is replaced with the concrete items below, so that
+// the data items created for the observer can be counted. For each burst
+// size it prints the cpu time per update on the notifying thread and on the
+// MsgTask thread, the time until the last subscriber got the burst, the data
+// items created per update and the distinct data item instances the
+// subscribers got per burst.
+//
+// usage: loc_dataitem_bench [-c clients] [-b bursts]
+//   -c  subscribed clients, 10 by default
+//   -b  bursts per burst size, 200 by default
+
+// how long to wait for a burst to reach all the subscribers
+#define BENCH_TIMEOUT_MS    5000
+
+static std::atomic<uint64_t> sCreated(0);
+static std::atomic<uint64_t> sDelivered(0);
+// MsgTask thread cpu time at the last delivery
+static std::atomic<uint64_t> sMsgTaskCpuNs(0);
+// only touched by the MsgTask thread while a burst is delivered
+static std::unordered_set<IDataItemCore*> sInstances;
+
+class BenchNetworkInfo : public NetworkInfoDataItemBase {
+public:
+    inline BenchNetworkInfo() :
+            NetworkInfoDataItemBase(TYPE_WIFI, TYPE_WIFI, "WIFI", "", false, false, false,
+                                    NETWORK_HANDLE_UNKNOWN) {}
+    virtual int32_t copy(IDataItemCore* src, bool* dataItemCopied = nullptr) {
+        BenchNetworkInfo* s = static_cast<BenchNetworkInfo*>(src);
+        bool updated = (mConnected != s->mConnected || mType != s->mType ||
+                        mNetworkHandle != s->mNetworkHandle);
+        mAllTypes = s->mAllTypes;
+        mType = s->mType;
+        mTypeName = s->mTypeName;
+        mSubTypeName = s->mSubTypeName;
+        mAvailable = s->mAvailable;
+        mConnected = s->mConnected;
+        mRoaming = s->mRoaming;
+        mNetworkHandle = s->mNetworkHandle;
+        memcpy(mAllNetworkHandles, s->mAllNetworkHandles, sizeof(mAllNetworkHandles));
+        if (nullptr != dataItemCopied) {
+            *dataItemCopied = updated;
+        }
+        return 0;
+    }
+};
+
+typedef struct {
+    uint32_t cellId;
+    int32_t rssi;
+} BenchCell;
+
+class BenchCellInfo : public RilCellInfoDataItemBase {
+public:
+    virtual int32_t copy(IDataItemCore* src, bool* dataItemCopied = nullptr) {
+        BenchCellInfo* s = static_cast<BenchCellInfo*>(src);
+        bool updated = false;
+        if (nullptr != s->mData) {
+            if (nullptr == mData) {
+                mData = calloc(1, sizeof(BenchCell));
+            }
+            updated = (0 != memcmp(mData, s->mData, sizeof(BenchCell)));
+            memcpy(mData, s->mData, sizeof(BenchCell));
+        }
+        if (nullptr != dataItemCopied) {
+            *dataItemCopied = updated;
+        }
+        return 0;
+    }
+    // what SystemStatus keeps of it in its report cache
+    virtual void setPeerData(RilCellInfoDataItemBase& peer) const {
+        if (nullptr != mData) {
+            peer.mData = malloc(sizeof(BenchCell));
+            memcpy(peer.mData, mData, sizeof(BenchCell));
+        }
+    }
+    inline void set(uint32_t cellId, int32_t rssi) {
+        if (nullptr == mData) {
+            mData = calloc(1, sizeof(BenchCell));
+        }
+        ((BenchCell*)mData)->cellId = cellId;
+        ((BenchCell*)mData)->rssi = rssi;
+    }
+};
+
+static IDataItemCore* benchDataItem(DataItemId id)
+{
+    IDataItemCore* dataItem = nullptr;
+    switch (id) {
+    case NETWORKINFO_DATA_ITEM_ID:
+        dataItem = new BenchNetworkInfo();
+        break;
+    case RILCELLINFO_DATA_ITEM_ID:
+        dataItem = new BenchCellInfo();
+        break;
+    default:
+        break;
+    }
+    if (nullptr != dataItem) {
+        sCreated++;
+    }
+    return dataItem;
+}
+
+class BenchClient : public IDataItemObserver {
+public:
+    virtual void getName(string& name) { name = "BenchClient"; }
+    virtual void notify(const std::list<IDataItemCore*>& dlist) {
+        for (auto item : dlist) {
+            sInstances.insert(item);
+        }
+        sMsgTaskCpuNs = threadCpuNs();
+        sDelivered += dlist.size();
+    }
+};
+
+// waits for the deliveries of everything notified so far
+static bool waitDelivered(uint64_t expected)
+{
+    uint64_t deadlineNs = monotonicNs() + BENCH_TIMEOUT_MS * 1000000ULL;
+    while (sDelivered.load() < expected) {
+        if (monotonicNs() > deadlineNs) {
+            return false;
+        }
+        sched_yield();
+    }
+    return true;
+}
+
+typedef struct {
+    double notifyNs;
+    double msgTaskNs;
+    double burstUs;
+    double created;
+    double instances;
+    double delivered;
+    bool timedOut;
+} BurstResult;
+
+static BurstResult runBursts(IOsObserver* osObserver, int clients, int burst, int bursts,
+                             uint32_t& seq)
+{
+    BenchNetworkInfo network;
+    BenchCellInfo cell;
+    std::list<IDataItemCore*> networkList = {&network};
+    std::list<IDataItemCore*> cellList = {&cell};
+    BurstResult result = {};
+    uint64_t notifyNs = 0, msgTaskNs = 0, burstNs = 0, created = 0, instances = 0;
+    uint64_t delivered = 0;
+
+    for (int b = 0; b < bursts; b++) {
+        uint64_t expected = sDelivered.load() + (uint64_t)burst * clients;
+        uint64_t createdStart = sCreated.load();
+        uint64_t deliveredStart = sDelivered.load();
+        sInstances.clear();
+        uint64_t msgTaskStartNs = sMsgTaskCpuNs.load();
+        uint64_t wallStartNs = monotonicNs();
+        uint64_t threadStartNs = threadCpuNs();
+        for (int i = 0; i < burst; i++) {
+            seq++;
+            if (seq & 1) {
+                // connect and disconnect the same network in turn
+                network.mConnected = (seq & 2);
+                network.mAvailable = network.mConnected;
+                network.mNetworkHandle = 100;
+                osObserver->notify(networkList);
+            } else {
+                cell.set(seq, -60 - (int32_t)(seq % 40));
+                osObserver->notify(cellList);
+            }
+        }
+        notifyNs += threadCpuNs() - threadStartNs;
+        if (!waitDelivered(expected)) {
+            result.timedOut = true;
+            break;
+        }
+        burstNs += monotonicNs() - wallStartNs;
+        msgTaskNs += sMsgTaskCpuNs.load() - msgTaskStartNs;
+        created += sCreated.load() - createdStart;
+        delivered += sDelivered.load() - deliveredStart;
+        instances += sInstances.size();
+    }
+
+    double updates = (double)burst * bursts;
+    result.notifyNs = notifyNs / updates;
+    result.msgTaskNs = msgTaskNs / updates;
+    result.burstUs = burstNs / 1000.0 / bursts;
+    result.created = created / updates;
+    result.instances = (double)instances / bursts;
+    result.delivered = delivered / updates;
+    return result;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-c clients] [-b bursts]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    int clients = 10;
+    int bursts = 200;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "c:b:"))) {
+        switch (opt) {
+        case 'c':
+            clients = atoi(optarg);
+            break;
+        case 'b':
+            bursts = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (clients <= 0 || bursts <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    DataItemsFactoryProxy::getConcreteDIFunc = benchDataItem;
+    MsgTask* msgTask = new MsgTask("loc_dataitem_bench");
+    SystemStatus* systemStatus = SystemStatus::getInstance(msgTask);
+    if (nullptr == systemStatus) {
+        fprintf(stderr, "no SystemStatus\n");
+        return 1;
+    }
+    IOsObserver* osObserver = systemStatus->getOsObserver();
+
+    std::vector<BenchClient> benchClients(clients);
+    std::list<DataItemId> ids = {NETWORKINFO_DATA_ITEM_ID, RILCELLINFO_DATA_ITEM_ID};
+    for (auto& client : benchClients) {
+        osObserver->subscribe(ids, &client);
+    }
+
+    uint32_t seq = 0;
+    // fills the cache and the pool
+    runBursts(osObserver, clients, 64, 4, seq);
+
+    static const int burstSizes[] = {1, 8, 64, 512};
+    printf("%-6s %12s %12s %12s %12s %12s %12s\n", "burst", "notify ns", "msgtask ns",
+           "burst us", "created", "instances", "delivered");
+    for (auto burst : burstSizes) {
+        BurstResult r = runBursts(osObserver, clients, burst, bursts, seq);
+        if (r.timedOut) {
+            printf("%-6d timed out, the subscribers did not get all the updates\n", burst);
+            return 1;
+        }
+        printf("%-6d %12.1f %12.1f %12.1f %12.3f %12.3f %12.1f\n", burst, r.notifyNs, r.msgTaskNs,
+               r.burstUs, r.created, r.instances, r.delivered);
+    }
+    return 0;
+}
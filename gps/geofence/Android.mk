@@ -14,6 +14,9 @@ LOCAL_MODULE_TAGS := optional
 
 LOCAL_SRC_FILES:= \
     GeofenceAdapter.cpp \
+    GeofenceSpatialIndex.cpp \
+    GeofenceSoftwareEngine.cpp \
+    GeofenceSnapshot.cpp \
     location_geofence.cpp
 
 LOCAL_SHARED_LIBRARIES := \
@@ -32,6 +32,14 @@
 #include "loc_log.h"
 #include <log_util.h>
 #include <string>
+#include <algorithm>
+#include <memory>
+
+// geofences per batched LocApi call
+static const size_t GEOFENCE_BATCH_SIZE = 64;
+// how long clients have to add again the geofences of a previous run of the
+// process before these are removed from the modem
+#define GEOFENCE_ORPHAN_TIMEOUT_MS (60 * 1000)
 
 using namespace loc_core;
 
@@ -42,9 +50,13 @@ GeofenceAdapter::GeofenceAdapter() :
                         NULL,
                         LocContext::mLocationHalName,
                         false),
-                    true /*isMaster*/)
+                    true /*isMaster*/),
+    mOrphanTimer(this)
 {
+    mNextSoftwareHwId = SOFTWARE_GEOFENCE_HWID_BIT;
+    mSoftwareEngineActive = false;
     LOC_LOGD("%s]: Constructor", __func__);
+    readSnapshotCommand();
 }
 
 void
@@ -58,13 +70,20 @@ GeofenceAdapter::stopClientSessions(LocationAPI* client)
         GeofenceKey key(it->first);
         if (client == key.client) {
             it = mGeofenceIds.erase(it);
-            mLocApi->removeGeofence(hwId, key.id,
+            removeGeofence(hwId, key.id,
                     new LocApiResponse(*getContext(),
                     [this, hwId] (LocationError err) {
                 if (LOCATION_ERROR_SUCCESS == err) {
                     auto it2 = mGeofences.find(hwId);
                     if (it2 != mGeofences.end()) {
                         mGeofences.erase(it2);
+                        mGeofenceIndex.remove(hwId);
+                        removeBreachTarget(hwId);
+                        mSnapshot.remove(hwId);
+                        if (isSoftwareGeofence(hwId)) {
+                            mSoftwareEngine.remove(hwId);
+                            updateSoftwareEngineActive();
+                        }
                     } else {
                         LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
                     }
@@ -125,6 +144,11 @@ GeofenceAdapter::handleEngineUpEvent()
             LocMsg(),
             mAdapter(adapter) {}
         virtual void proc() const {
+            // capabilities are only known already if this is an SSR, which
+            // took all the geofences of a previous run with it
+            if (mAdapter.isEngineCapabilitiesKnown()) {
+                mAdapter.dropGeofenceOrphans();
+            }
             mAdapter.setEngineCapabilitiesKnown(true);
             mAdapter.broadcastCapabilities(mAdapter.getCapabilities());
             mAdapter.restartGeofences();
@@ -148,9 +172,23 @@ GeofenceAdapter::restartGeofences()
     GeofencesMap oldGeofences(mGeofences);
     mGeofences.clear();
     mGeofenceIds.clear();
+    mGeofenceIndex.clear();
+    mBreachTargets.clear();
+    mSlotClients.clear();
+    mSlotGeofences.clear();
 
     for (auto it = oldGeofences.begin(); it != oldGeofences.end(); it++) {
         GeofenceObject object = it->second;
+        if (isSoftwareGeofence(it->first)) {
+            // evaluated on the AP, so the engine restart leaves these as they are
+            mGeofences[it->first] = object;
+            mGeofenceIds[object.key] = it->first;
+            mGeofenceIndex.add(it->first, object.latitude, object.longitude, object.radius);
+            addBreachTarget(it->first, object.key);
+            continue;
+        }
+        // saved again under the hwId the engine gives it now
+        mSnapshot.remove(it->first);
         GeofenceOption options = {sizeof(GeofenceOption),
                                    object.breachMask,
                                    object.responsiveness,
@@ -170,6 +208,12 @@ GeofenceAdapter::restartGeofences()
                             new LocApiResponse(*getContext(), [] (LocationError /*err*/) {}));
                 }
                 saveGeofenceItem(object.key.client, object.key.id, data.hwId, options, info);
+            } else if (LOCATION_ERROR_GEOFENCES_AT_MAX == err) {
+                uint32_t hwId = addSoftwareGeofence(object.key.client, object.key.id,
+                                                    options, info);
+                if (true == object.paused) {
+                    pauseGeofenceItem(hwId);
+                }
             }
         }));
     }
@@ -238,39 +282,40 @@ GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, Geofence
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
-            for (size_t i=0; i < mCount; ++i) {
-                if (NULL == mIds || NULL == mOptions || NULL == mInfos) {
+            if (NULL == mOptions || NULL == mInfos) {
+                for (size_t i=0; i < mCount; ++i) {
                     errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
-                } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                            [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
-                            mOptions = mOptions, mInfos = mInfos, mIds = mIds, &mApi = mApi,
-                            errs, i] (LocationError /*err*/) {
-                        mApi.addGeofence(mIds[i], mOptions[i], mInfos[i],
-                        new LocApiResponseData<LocApiGeofenceData>(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mOptions = mOptions, mClient = mClient,
-                        mCount = mCount, mIds = mIds, mInfos = mInfos, errs, i]
-                        (LocationError err, LocApiGeofenceData data) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                mAdapter.saveGeofenceItem(mClient,
-                                mIds[i],
-                                data.hwId,
-                                mOptions[i],
-                                mInfos[i]);
-                            }
-                            errs[i] = err;
-
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                                delete[] mOptions;
-                                delete[] mInfos;
-                            }
-                        }));
-                    }));
                 }
+                mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                delete[] errs;
+                delete[] mIds;
+                delete[] mOptions;
+                delete[] mInfos;
+                return;
+            }
+            // Send aggregated response once the last chunk is back and cleanup
+            auto pending = std::make_shared<size_t>(
+                    (mCount + GEOFENCE_BATCH_SIZE - 1) / GEOFENCE_BATCH_SIZE);
+            auto chunkDone = [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
+                    mIds = mIds, mOptions = mOptions, mInfos = mInfos,
+                    errs, pending] () {
+                if (0 == --(*pending)) {
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
+                    delete[] mOptions;
+                    delete[] mInfos;
+                }
+            };
+            for (size_t i=0; i < mCount; i += GEOFENCE_BATCH_SIZE) {
+                size_t n = std::min(mCount - i, GEOFENCE_BATCH_SIZE);
+                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, mClient = mClient, mIds = mIds,
+                        mOptions = mOptions, mInfos = mInfos, errs, i, n, chunkDone]
+                        (LocationError /*err*/) {
+                    mAdapter.addGeofences(mClient, n, mIds + i, mOptions + i, mInfos + i,
+                                          errs + i, chunkDone);
+                }));
             }
         }
     };
@@ -343,37 +388,30 @@ GeofenceAdapter::removeGeofencesCommand(LocationAPI* client, size_t count, uint3
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
-            for (size_t i=0; i < mCount; ++i) {
+            // Send aggregated response once the last chunk is back and cleanup
+            auto pending = std::make_shared<size_t>(
+                    (mCount + GEOFENCE_BATCH_SIZE - 1) / GEOFENCE_BATCH_SIZE);
+            auto chunkDone = [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
+                    mIds = mIds, errs, pending] () {
+                if (0 == --(*pending)) {
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
+                }
+            };
+            for (size_t i=0; i < mCount; i += GEOFENCE_BATCH_SIZE) {
+                size_t n = std::min(mCount - i, GEOFENCE_BATCH_SIZE);
                 mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError /*err*/) {
-                    uint32_t hwId = 0;
-                    errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.removeGeofence(hwId, mIds[i],
-                        new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                mAdapter.removeGeofenceItem(hwId);
-                            }
-                            errs[i] = err;
-
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                            }
-                        }));
-                    } else {
-                        // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
-                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                            delete[] errs;
-                            delete[] mIds;
-                        }
-                    }
+                        [&mAdapter = mAdapter, mClient = mClient, mIds = mIds,
+                        errs, i, n, chunkDone] (LocationError /*err*/) {
+                    mAdapter.applyToGeofences(mClient, n, mIds + i, errs + i,
+                            [&mAdapter = mAdapter] (size_t count, const uint32_t* hwIds,
+                            const uint32_t* clientIds, const size_t* /*indexes*/,
+                            LocApiCollectiveResponse* adapterResponse) {
+                        mAdapter.removeModemGeofences(count, hwIds, clientIds, adapterResponse);
+                    }, [&mAdapter = mAdapter] (uint32_t hwId, size_t /*index*/) {
+                        mAdapter.removeGeofenceItem(hwId);
+                    }, chunkDone);
                 }));
             }
         }
@@ -419,36 +457,30 @@ GeofenceAdapter::pauseGeofencesCommand(LocationAPI* client, size_t count, uint32
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
-            for (size_t i=0; i < mCount; ++i) {
+            // Send aggregated response once the last chunk is back and cleanup
+            auto pending = std::make_shared<size_t>(
+                    (mCount + GEOFENCE_BATCH_SIZE - 1) / GEOFENCE_BATCH_SIZE);
+            auto chunkDone = [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
+                    mIds = mIds, errs, pending] () {
+                if (0 == --(*pending)) {
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
+                }
+            };
+            for (size_t i=0; i < mCount; i += GEOFENCE_BATCH_SIZE) {
+                size_t n = std::min(mCount - i, GEOFENCE_BATCH_SIZE);
                 mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError /*err*/) {
-                    uint32_t hwId = 0;
-                    errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.pauseGeofence(hwId, mIds[i], new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        hwId, errs, i] (LocationError err ) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                mAdapter.pauseGeofenceItem(hwId);
-                            }
-                            errs[i] = err;
-
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                            }
-                        }));
-                    } else {
-                        // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
-                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                            delete[] errs;
-                            delete[] mIds;
-                        }
-                    }
+                        [&mAdapter = mAdapter, mClient = mClient, mIds = mIds,
+                        errs, i, n, chunkDone] (LocationError /*err*/) {
+                    mAdapter.applyToGeofences(mClient, n, mIds + i, errs + i,
+                            [&mAdapter = mAdapter] (size_t count, const uint32_t* hwIds,
+                            const uint32_t* clientIds, const size_t* /*indexes*/,
+                            LocApiCollectiveResponse* adapterResponse) {
+                        mAdapter.pauseModemGeofences(count, hwIds, clientIds, adapterResponse);
+                    }, [&mAdapter = mAdapter] (uint32_t hwId, size_t /*index*/) {
+                        mAdapter.pauseGeofenceItem(hwId);
+                    }, chunkDone);
                 }));
             }
         }
@@ -494,37 +526,30 @@ GeofenceAdapter::resumeGeofencesCommand(LocationAPI* client, size_t count, uint3
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
-            for (size_t i=0; i < mCount; ++i) {
+            // Send aggregated response once the last chunk is back and cleanup
+            auto pending = std::make_shared<size_t>(
+                    (mCount + GEOFENCE_BATCH_SIZE - 1) / GEOFENCE_BATCH_SIZE);
+            auto chunkDone = [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
+                    mIds = mIds, errs, pending] () {
+                if (0 == --(*pending)) {
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
+                }
+            };
+            for (size_t i=0; i < mCount; i += GEOFENCE_BATCH_SIZE) {
+                size_t n = std::min(mCount - i, GEOFENCE_BATCH_SIZE);
                 mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                        [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                        &mApi = mApi, errs, i] (LocationError /*err*/) {
-                    uint32_t hwId = 0;
-                    errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                    if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.resumeGeofence(hwId, mIds[i],
-                                new LocApiResponse(*mAdapter.getContext(),
-                                [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, hwId,
-                                errs, mIds = mIds, i] (LocationError err ) {
-                            if (LOCATION_ERROR_SUCCESS == err) {
-                                errs[i] = err;
-
-                                mAdapter.resumeGeofenceItem(hwId);
-                                // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
-                                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                    delete[] errs;
-                                    delete[] mIds;
-                                }
-                            }
-                        }));
-                    } else {
-                        // Send aggregated response on last item and cleanup
-                        if (i == mCount-1) {
-                            mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                            delete[] errs;
-                            delete[] mIds;
-                        }
-                    }
+                        [&mAdapter = mAdapter, mClient = mClient, mIds = mIds,
+                        errs, i, n, chunkDone] (LocationError /*err*/) {
+                    mAdapter.applyToGeofences(mClient, n, mIds + i, errs + i,
+                            [&mAdapter = mAdapter] (size_t count, const uint32_t* hwIds,
+                            const uint32_t* clientIds, const size_t* /*indexes*/,
+                            LocApiCollectiveResponse* adapterResponse) {
+                        mAdapter.resumeModemGeofences(count, hwIds, clientIds, adapterResponse);
+                    }, [&mAdapter = mAdapter] (uint32_t hwId, size_t /*index*/) {
+                        mAdapter.resumeGeofenceItem(hwId);
+                    }, chunkDone);
                 }));
             }
         }
@@ -574,45 +599,47 @@ GeofenceAdapter::modifyGeofencesCommand(LocationAPI* client, size_t count, uint3
                 LOC_LOGE("%s]: new failed to allocate errs", __func__);
                 return;
             }
-            for (size_t i=0; i < mCount; ++i) {
-                if (NULL == mIds || NULL == mOptions) {
+            if (NULL == mOptions) {
+                for (size_t i=0; i < mCount; ++i) {
                     errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
-                } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
-                            [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
-                            &mApi = mApi, mOptions = mOptions, errs, i] (LocationError /*err*/) {
-                        uint32_t hwId = 0;
-                        errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
-                        if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                            mApi.modifyGeofence(hwId, mIds[i], mOptions[i],
-                                    new LocApiResponse(*mAdapter.getContext(),
-                                    [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
-                                    mIds = mIds, mOptions = mOptions, hwId, errs, i]
-                                    (LocationError err ) {
-                                if (LOCATION_ERROR_SUCCESS == err) {
-                                    errs[i] = err;
-
-                                    mAdapter.modifyGeofenceItem(hwId, mOptions[i]);
-                                }
-                                // Send aggregated response on last item and cleanup
-                                if (i == mCount-1) {
-                                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                    delete[] errs;
-                                    delete[] mIds;
-                                    delete[] mOptions;
-                                }
-                            }));
-                        } else {
-                            // Send aggregated response on last item and cleanup
-                            if (i == mCount-1) {
-                                mAdapter.reportResponse(mClient, mCount, errs, mIds);
-                                delete[] errs;
-                                delete[] mIds;
-                                delete[] mOptions;
-                            }
-                        }
-                    }));
                 }
+                mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                delete[] errs;
+                delete[] mIds;
+                return;
+            }
+            // Send aggregated response once the last chunk is back and cleanup
+            auto pending = std::make_shared<size_t>(
+                    (mCount + GEOFENCE_BATCH_SIZE - 1) / GEOFENCE_BATCH_SIZE);
+            auto chunkDone = [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
+                    mIds = mIds, mOptions = mOptions, errs, pending] () {
+                if (0 == --(*pending)) {
+                    mAdapter.reportResponse(mClient, mCount, errs, mIds);
+                    delete[] errs;
+                    delete[] mIds;
+                    delete[] mOptions;
+                }
+            };
+            for (size_t i=0; i < mCount; i += GEOFENCE_BATCH_SIZE) {
+                size_t n = std::min(mCount - i, GEOFENCE_BATCH_SIZE);
+                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                        [&mAdapter = mAdapter, mClient = mClient, mIds = mIds,
+                        mOptions = mOptions, errs, i, n, chunkDone] (LocationError /*err*/) {
+                    GeofenceOption* options = mOptions + i;
+                    mAdapter.applyToGeofences(mClient, n, mIds + i, errs + i,
+                            [&mAdapter = mAdapter, options] (size_t count, const uint32_t* hwIds,
+                            const uint32_t* clientIds, const size_t* indexes,
+                            LocApiCollectiveResponse* adapterResponse) {
+                        std::vector<GeofenceOption> modemOptions(count);
+                        for (size_t j=0; j < count; ++j) {
+                            modemOptions[j] = options[indexes[j]];
+                        }
+                        mAdapter.modifyModemGeofences(count, hwIds, clientIds,
+                                                      modemOptions.data(), adapterResponse);
+                    }, [&mAdapter = mAdapter, options] (uint32_t hwId, size_t index) {
+                        mAdapter.modifyGeofenceItem(hwId, options[index]);
+                    }, chunkDone);
+                }));
             }
         }
     };
@@ -657,6 +684,14 @@ GeofenceAdapter::saveGeofenceItem(LocationAPI* client, uint32_t clientId, uint32
                              false};
     mGeofences[hwId] = object;
     mGeofenceIds[key] = hwId;
+    mGeofenceIndex.add(hwId, info.latitude, info.longitude, info.radius);
+    addBreachTarget(hwId, key);
+    if (isSoftwareGeofence(hwId)) {
+        mSoftwareEngine.add(hwId, options, info);
+        updateSoftwareEngineActive();
+    } else {
+        saveSnapshotItem(hwId);
+    }
     dump();
 }
 
@@ -675,6 +710,13 @@ GeofenceAdapter::removeGeofenceItem(uint32_t hwId)
             auto it2 = mGeofences.find(hwId);
             if (it2 != mGeofences.end()) {
                 mGeofences.erase(it2);
+                mGeofenceIndex.remove(hwId);
+                removeBreachTarget(hwId);
+                mSnapshot.remove(hwId);
+                if (isSoftwareGeofence(hwId)) {
+                    mSoftwareEngine.remove(hwId);
+                    updateSoftwareEngineActive();
+                }
                 dump();
             } else {
                 LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
@@ -691,6 +733,11 @@ GeofenceAdapter::pauseGeofenceItem(uint32_t hwId)
     auto it = mGeofences.find(hwId);
     if (it != mGeofences.end()) {
         it->second.paused = true;
+        if (isSoftwareGeofence(hwId)) {
+            mSoftwareEngine.pause(hwId);
+        } else {
+            saveSnapshotItem(hwId);
+        }
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to pause not found. hwId %u", __func__, hwId);
@@ -703,6 +750,11 @@ GeofenceAdapter::resumeGeofenceItem(uint32_t hwId)
     auto it = mGeofences.find(hwId);
     if (it != mGeofences.end()) {
         it->second.paused = false;
+        if (isSoftwareGeofence(hwId)) {
+            mSoftwareEngine.resume(hwId);
+        } else {
+            saveSnapshotItem(hwId);
+        }
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to resume not found. hwId %u", __func__, hwId);
@@ -717,12 +769,430 @@ GeofenceAdapter::modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options
         it->second.breachMask = options.breachTypeMask;
         it->second.responsiveness = options.responsiveness;
         it->second.dwellTime = options.dwellTime;
+        if (isSoftwareGeofence(hwId)) {
+            mSoftwareEngine.modify(hwId, options);
+        } else {
+            saveSnapshotItem(hwId);
+        }
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to modify not found. hwId %u", __func__, hwId);
     }
 }
 
+void
+GeofenceAdapter::readSnapshotCommand()
+{
+    struct MsgReadSnapshot : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        inline MsgReadSnapshot(GeofenceAdapter& adapter) :
+            LocMsg(),
+            mAdapter(adapter) {}
+        inline virtual void proc() const {
+            char snapshotFile[LOC_MAX_PARAM_STRING] = {0};
+            static const loc_param_s_type gps_conf_param_table[] =
+            {
+                {"GEOFENCE_SNAPSHOT_FILE", &snapshotFile, NULL, 's'},
+            };
+            UTIL_READ_CONF(LOC_PATH_GPS_CONF, gps_conf_param_table);
+
+            if ('\0' == snapshotFile[0] || !mAdapter.mSnapshot.open(snapshotFile)) {
+                return;
+            }
+            for (auto& it : mAdapter.mSnapshot.getGeofences()) {
+                const GeofenceSnapshot::Geofence& geofence = it.second;
+                mAdapter.mOrphans.emplace(GeofenceOrphanKey(geofence.latitude,
+                                                            geofence.longitude,
+                                                            geofence.radius,
+                                                            geofence.breachMask,
+                                                            geofence.responsiveness,
+                                                            geofence.dwellTime),
+                                          it.first);
+            }
+            LOC_LOGD("%s]: %zu geofences of a previous run in %s", __func__,
+                     mAdapter.mOrphans.size(), snapshotFile);
+            if (!mAdapter.mOrphans.empty()) {
+                mAdapter.mOrphanTimer.start(GEOFENCE_ORPHAN_TIMEOUT_MS, false);
+            }
+        }
+    };
+
+    sendMsg(new MsgReadSnapshot(*this));
+}
+
+void
+GeofenceAdapter::saveSnapshotItem(uint32_t hwId)
+{
+    auto it = mGeofences.find(hwId);
+    if (mSnapshot.isOpen() && it != mGeofences.end()) {
+        const GeofenceObject& object = it->second;
+        GeofenceSnapshot::Geofence geofence = {object.key.id,
+                                               object.breachMask,
+                                               object.responsiveness,
+                                               object.dwellTime,
+                                               object.latitude,
+                                               object.longitude,
+                                               object.radius,
+                                               object.paused};
+        mSnapshot.put(hwId, geofence);
+    }
+}
+
+bool
+GeofenceAdapter::adoptGeofenceOrphan(LocationAPI* client, uint32_t clientId,
+        const GeofenceOption& options, const GeofenceInfo& info)
+{
+    if (mOrphans.empty()) {
+        return false;
+    }
+    auto it = mOrphans.find(GeofenceOrphanKey(info.latitude, info.longitude, info.radius,
+                                              options.breachTypeMask, options.responsiveness,
+                                              options.dwellTime));
+    if (it == mOrphans.end()) {
+        return false;
+    }
+    uint32_t hwId = it->second;
+    mOrphans.erase(it);
+    if (mOrphans.empty()) {
+        mOrphanTimer.stop();
+    }
+
+    auto geofence = mSnapshot.getGeofences().find(hwId);
+    bool paused = (geofence != mSnapshot.getGeofences().end() && geofence->second.paused);
+    LOC_LOGD("%s]: clientId %u takes over hwId %u", __func__, clientId, hwId);
+    saveGeofenceItem(client, clientId, hwId, options, info);
+    if (paused) {
+        mLocApi->resumeGeofence(hwId, clientId,
+                new LocApiResponse(*getContext(), [] (LocationError /*err*/) {}));
+    }
+    return true;
+}
+
+void
+GeofenceAdapter::dropGeofenceOrphans()
+{
+    for (auto& it : mOrphans) {
+        mSnapshot.remove(it.second);
+    }
+    mOrphans.clear();
+    mOrphanTimer.stop();
+}
+
+// Called in the context of LocTimer thread
+void
+GeofenceOrphanTimer::timeOutCallback()
+{
+    if (nullptr != mAdapter) {
+        mAdapter->purgeGeofenceOrphansEvent();
+    }
+}
+
+// Called in the context of LocTimer thread
+void
+GeofenceAdapter::purgeGeofenceOrphansEvent()
+{
+    struct MsgPurgeGeofenceOrphans : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        inline MsgPurgeGeofenceOrphans(GeofenceAdapter& adapter) :
+            LocMsg(),
+            mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.purgeGeofenceOrphans();
+        }
+    };
+
+    sendMsg(new MsgPurgeGeofenceOrphans(*this));
+}
+
+void
+GeofenceAdapter::purgeGeofenceOrphans()
+{
+    if (mOrphans.empty()) {
+        return;
+    }
+    LOC_LOGD("%s]: removing %zu geofences not added again", __func__, mOrphans.size());
+
+    std::vector<uint32_t> hwIds;
+    std::vector<uint32_t> clientIds;
+    for (auto& it : mOrphans) {
+        auto geofence = mSnapshot.getGeofences().find(it.second);
+        hwIds.push_back(it.second);
+        clientIds.push_back(geofence != mSnapshot.getGeofences().end() ?
+                            geofence->second.clientId : 0);
+    }
+    mOrphans.clear();
+
+    removeModemGeofences(hwIds.size(), hwIds.data(), clientIds.data(),
+            new LocApiCollectiveResponse(*getContext(),
+            [this, hwIds] (std::vector<LocationError> /*errs*/) {
+        // gone either way; a geofence the modem did not know was already gone
+        for (auto hwId : hwIds) {
+            mSnapshot.remove(hwId);
+        }
+    }));
+}
+
+void
+GeofenceAdapter::addBreachTarget(uint32_t hwId, const GeofenceKey& key)
+{
+    removeBreachTarget(hwId);
+
+    // few clients, so a scan of the slots is cheap
+    size_t slot = 0;
+    while (slot < mSlotClients.size() && mSlotClients[slot] != key.client) {
+        ++slot;
+    }
+    if (slot == mSlotClients.size()) {
+        slot = 0;
+        while (slot < mSlotClients.size() && mSlotClients[slot] != NULL) {
+            ++slot;
+        }
+        if (slot == mSlotClients.size()) {
+            mSlotClients.push_back(NULL);
+            mSlotGeofences.push_back(0);
+        }
+        mSlotClients[slot] = key.client;
+    }
+    mSlotGeofences[slot]++;
+    mBreachTargets.put(hwId, {(uint32_t)slot, key.id});
+}
+
+void
+GeofenceAdapter::removeBreachTarget(uint32_t hwId)
+{
+    const GeofenceBreachTarget* target = mBreachTargets.find(hwId);
+    if (NULL != target) {
+        uint32_t slot = target->slot;
+        mBreachTargets.erase(hwId);
+        if (0 == --mSlotGeofences[slot]) {
+            mSlotClients[slot] = NULL;
+        }
+    }
+}
+
+uint32_t
+GeofenceAdapter::addSoftwareGeofence(LocationAPI* client, uint32_t clientId,
+        const GeofenceOption& options, const GeofenceInfo& info)
+{
+    // software hwIds have the top bit set, and never collide with those of the modem
+    uint32_t hwId = mNextSoftwareHwId;
+    while (mGeofences.find(hwId) != mGeofences.end()) {
+        hwId = SOFTWARE_GEOFENCE_HWID_BIT | (hwId + 1);
+    }
+    mNextSoftwareHwId = SOFTWARE_GEOFENCE_HWID_BIT | (hwId + 1);
+
+    LOC_LOGD("%s]: modem at capacity, clientId %u evaluated on AP as hwId %u",
+             __func__, clientId, hwId);
+    saveGeofenceItem(client, clientId, hwId, options, info);
+    return hwId;
+}
+
+void
+GeofenceAdapter::updateSoftwareEngineActive()
+{
+    mSoftwareEngineActive = (mSoftwareEngine.size() > 0);
+}
+
+void
+GeofenceAdapter::removeGeofence(uint32_t hwId, uint32_t clientId,
+        LocApiResponse* adapterResponse)
+{
+    if (isSoftwareGeofence(hwId)) {
+        adapterResponse->returnToSender(LOCATION_ERROR_SUCCESS);
+    } else {
+        mLocApi->removeGeofence(hwId, clientId, adapterResponse);
+    }
+}
+
+void
+GeofenceAdapter::addGeofences(LocationAPI* client, size_t count, const uint32_t* ids,
+        const GeofenceOption* options, const GeofenceInfo* infos, LocationError* errs,
+        std::function<void ()> onDone)
+{
+    // geofences still in the modem from a previous run are taken over as they are
+    std::vector<uint32_t> modemIds;
+    std::vector<GeofenceOption> modemOptions;
+    std::vector<GeofenceInfo> modemInfos;
+    std::vector<size_t> indexes;
+    for (size_t i=0; i < count; ++i) {
+        if (adoptGeofenceOrphan(client, ids[i], options[i], infos[i])) {
+            errs[i] = LOCATION_ERROR_SUCCESS;
+        } else {
+            modemIds.push_back(ids[i]);
+            modemOptions.push_back(options[i]);
+            modemInfos.push_back(infos[i]);
+            indexes.push_back(i);
+        }
+    }
+    if (indexes.empty()) {
+        onDone();
+        return;
+    }
+
+    addModemGeofences(indexes.size(), modemIds.data(), modemOptions.data(), modemInfos.data(),
+            [this, client, ids, options, infos, errs, indexes, onDone] (GeofencesData data) {
+        for (size_t j=0; j < indexes.size(); ++j) {
+            size_t i = indexes[j];
+            LocationError itemErr = data.errs[j];
+            if (LOCATION_ERROR_SUCCESS == itemErr) {
+                saveGeofenceItem(client, ids[i], data.hwIds[j], options[i], infos[i]);
+            } else if (LOCATION_ERROR_GEOFENCES_AT_MAX == itemErr) {
+                // modem is full, overflow into the software engine
+                addSoftwareGeofence(client, ids[i], options[i], infos[i]);
+                itemErr = LOCATION_ERROR_SUCCESS;
+            }
+            errs[i] = itemErr;
+        }
+        onDone();
+    });
+}
+
+void
+GeofenceAdapter::applyToGeofences(LocationAPI* client, size_t count, const uint32_t* ids,
+        LocationError* errs, GeofenceBatchCall batchCall, GeofenceItemUpdate itemUpdate,
+        std::function<void ()> onDone)
+{
+    std::vector<uint32_t> hwIds;
+    std::vector<uint32_t> clientIds;
+    std::vector<size_t> indexes;
+    for (size_t i=0; i < count; ++i) {
+        uint32_t hwId = 0;
+        errs[i] = getHwIdFromClient(client, ids[i], hwId);
+        if (LOCATION_ERROR_SUCCESS != errs[i]) {
+            continue;
+        }
+        if (isSoftwareGeofence(hwId)) {
+            // nothing to tell the modem about
+            itemUpdate(hwId, i);
+        } else {
+            hwIds.push_back(hwId);
+            clientIds.push_back(ids[i]);
+            indexes.push_back(i);
+        }
+    }
+    if (hwIds.empty()) {
+        onDone();
+        return;
+    }
+
+    batchCall(hwIds.size(), hwIds.data(), clientIds.data(), indexes.data(),
+            new LocApiCollectiveResponse(*getContext(),
+            [hwIds, indexes, errs, itemUpdate, onDone] (std::vector<LocationError> results) {
+        for (size_t j=0; j < indexes.size(); ++j) {
+            LocationError err = (j < results.size()) ? results[j] : LOCATION_ERROR_GENERAL_FAILURE;
+            if (LOCATION_ERROR_SUCCESS == err) {
+                itemUpdate(hwIds[j], indexes[j]);
+            }
+            errs[indexes[j]] = err;
+        }
+        onDone();
+    }));
+}
+
+void
+GeofenceAdapter::addModemGeofences(size_t count, const uint32_t* clientIds,
+        const GeofenceOption* options, const GeofenceInfo* infos,
+        std::function<void (GeofencesData data)> onDone)
+{
+    // the per geofence responses all come back on this adapter's thread, so
+    // the shared results need no locking
+    auto data = std::make_shared<GeofencesData>();
+    auto pending = std::make_shared<size_t>(count);
+    data->errs.assign(count, LOCATION_ERROR_GENERAL_FAILURE);
+    data->hwIds.assign(count, 0);
+    if (0 == count) {
+        onDone(*data);
+        return;
+    }
+    for (size_t i=0; i < count; ++i) {
+        mLocApi->addGeofence(clientIds[i], options[i], infos[i],
+                new LocApiResponseData<LocApiGeofenceData>(*getContext(),
+                [data, pending, i, onDone] (LocationError err, LocApiGeofenceData itemData) {
+            data->errs[i] = err;
+            data->hwIds[i] = itemData.hwId;
+            if (0 == --(*pending)) {
+                onDone(*data);
+            }
+        }));
+    }
+}
+
+void
+GeofenceAdapter::loopModemGeofences(size_t count, LocApiCollectiveResponse* adapterResponse,
+        std::function<void (size_t i, LocApiResponse* itemResponse)> call)
+{
+    auto errs = std::make_shared<std::vector<LocationError>>(count,
+                                                             LOCATION_ERROR_GENERAL_FAILURE);
+    auto pending = std::make_shared<size_t>(count);
+    if (0 == count) {
+        adapterResponse->returnToSender(*errs);
+        return;
+    }
+    for (size_t i=0; i < count; ++i) {
+        call(i, new LocApiResponse(*getContext(),
+                [adapterResponse, errs, pending, i] (LocationError err) {
+            (*errs)[i] = err;
+            if (0 == --(*pending)) {
+                adapterResponse->returnToSender(*errs);
+            }
+        }));
+    }
+}
+
+void
+GeofenceAdapter::removeModemGeofences(size_t count, const uint32_t* hwIds,
+        const uint32_t* clientIds, LocApiCollectiveResponse* adapterResponse)
+{
+    loopModemGeofences(count, adapterResponse, [this, hwIds, clientIds]
+            (size_t i, LocApiResponse* itemResponse) {
+        mLocApi->removeGeofence(hwIds[i], clientIds[i], itemResponse);
+    });
+}
+
+void
+GeofenceAdapter::pauseModemGeofences(size_t count, const uint32_t* hwIds,
+        const uint32_t* clientIds, LocApiCollectiveResponse* adapterResponse)
+{
+    loopModemGeofences(count, adapterResponse, [this, hwIds, clientIds]
+            (size_t i, LocApiResponse* itemResponse) {
+        mLocApi->pauseGeofence(hwIds[i], clientIds[i], itemResponse);
+    });
+}
+
+void
+GeofenceAdapter::resumeModemGeofences(size_t count, const uint32_t* hwIds,
+        const uint32_t* clientIds, LocApiCollectiveResponse* adapterResponse)
+{
+    loopModemGeofences(count, adapterResponse, [this, hwIds, clientIds]
+            (size_t i, LocApiResponse* itemResponse) {
+        mLocApi->resumeGeofence(hwIds[i], clientIds[i], itemResponse);
+    });
+}
+
+void
+GeofenceAdapter::modifyModemGeofences(size_t count, const uint32_t* hwIds,
+        const uint32_t* clientIds, const GeofenceOption* options,
+        LocApiCollectiveResponse* adapterResponse)
+{
+    loopModemGeofences(count, adapterResponse, [this, hwIds, clientIds, options]
+            (size_t i, LocApiResponse* itemResponse) {
+        mLocApi->modifyGeofence(hwIds[i], clientIds[i], options[i], itemResponse);
+    });
+}
+
+/* fills hwIds with the active geofences that contain the location, or whose
+   boundary is within margin meters of it */
+void
+GeofenceAdapter::findGeofences(const Location& location, double margin,
+        std::vector<uint32_t>& hwIds)
+{
+    hwIds.clear();
+    mGeofenceIndex.query(location.latitude, location.longitude, margin, hwIds);
+    hwIds.erase(std::remove_if(hwIds.begin(), hwIds.end(), [this] (uint32_t hwId) {
+        auto it = mGeofences.find(hwId);
+        return it == mGeofences.end() || it->second.paused;
+    }), hwIds.end());
+}
 
 void
 GeofenceAdapter::geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& location,
@@ -787,33 +1257,114 @@ void
 GeofenceAdapter::geofenceBreach(size_t count, uint32_t* hwIds, const Location& location,
         GeofenceBreachType breachType, uint64_t timestamp)
 {
-
-    for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
-        uint32_t* clientIds = new uint32_t[count];
-        if (nullptr == clientIds) {
-            return;
+    // partition the breached hwIds by client slot in one pass
+    if (mSlotBreachIds.size() < mSlotClients.size()) {
+        mSlotBreachIds.resize(mSlotClients.size());
+    }
+    for (size_t i=0; i < count; ++i) {
+        const GeofenceBreachTarget* target = mBreachTargets.find(hwIds[i]);
+        if (NULL != target) {
+            mSlotBreachIds[target->slot].push_back(target->clientId);
         }
-        uint32_t index = 0;
-        for (size_t i=0; i < count; ++i) {
-            GeofenceKey key;
-            LocationError err = getGeofenceKeyFromHwId(hwIds[i], key);
-            if (LOCATION_ERROR_SUCCESS == err) {
-                if (key.client == it->first) {
-                    clientIds[index++] = key.id;
-                }
-            }
+    }
+
+    for (size_t slot=0; slot < mSlotClients.size(); ++slot) {
+        std::vector<uint32_t>& clientIds = mSlotBreachIds[slot];
+        if (clientIds.empty()) {
+            continue;
         }
-        if (index > 0 && it->second.geofenceBreachCb != nullptr) {
+        auto it = mClientData.find(mSlotClients[slot]);
+        if (it != mClientData.end() && it->second.geofenceBreachCb != nullptr) {
             GeofenceBreachNotification notify = {sizeof(GeofenceBreachNotification),
-                                                 index,
-                                                 clientIds,
+                                                 (uint32_t)clientIds.size(),
+                                                 clientIds.data(),
                                                  location,
                                                  breachType,
                                                  timestamp};
 
             it->second.geofenceBreachCb(notify);
         }
-        delete[] clientIds;
+        clientIds.clear();
+    }
+}
+
+void
+GeofenceAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
+        const GpsLocationExtended& /*locationExtended*/,
+        enum loc_sess_status status,
+        LocPosTechMask techMask,
+        GnssDataNotification* /*pDataNotify*/,
+        int /*msInWeek*/)
+{
+    if (!mSoftwareEngineActive || LOC_SESS_SUCCESS != status ||
+            !(LOC_GPS_LOCATION_HAS_LAT_LONG & ulpLocation.gpsLocation.flags)) {
+        return;
+    }
+
+    struct MsgSoftwareGeofenceFix : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        Location mLocation;
+        inline MsgSoftwareGeofenceFix(GeofenceAdapter& adapter,
+                                      const Location& location) :
+            LocMsg(),
+            mAdapter(adapter),
+            mLocation(location) {}
+        inline virtual void proc() const {
+            mAdapter.softwareGeofenceFix(mLocation);
+        }
+    };
+
+    Location location;
+    memset(&location, 0, sizeof(Location));
+    location.size = sizeof(Location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT;
+    location.latitude = ulpLocation.gpsLocation.latitude;
+    location.longitude = ulpLocation.gpsLocation.longitude;
+    if (LOC_GPS_LOCATION_HAS_ALTITUDE & ulpLocation.gpsLocation.flags) {
+        location.flags |= LOCATION_HAS_ALTITUDE_BIT;
+        location.altitude = ulpLocation.gpsLocation.altitude;
+    }
+    if (LOC_GPS_LOCATION_HAS_SPEED & ulpLocation.gpsLocation.flags) {
+        location.flags |= LOCATION_HAS_SPEED_BIT;
+        location.speed = ulpLocation.gpsLocation.speed;
+    }
+    if (LOC_GPS_LOCATION_HAS_BEARING & ulpLocation.gpsLocation.flags) {
+        location.flags |= LOCATION_HAS_BEARING_BIT;
+        location.bearing = ulpLocation.gpsLocation.bearing;
+    }
+    if (LOC_GPS_LOCATION_HAS_ACCURACY & ulpLocation.gpsLocation.flags) {
+        location.flags |= LOCATION_HAS_ACCURACY_BIT;
+        location.accuracy = ulpLocation.gpsLocation.accuracy;
+    }
+    location.timestamp = ulpLocation.gpsLocation.timestamp;
+    if (LOC_POS_TECH_MASK_SATELLITE & techMask) {
+        location.techMask |= LOCATION_TECHNOLOGY_GNSS_BIT;
+    }
+
+    sendMsg(new MsgSoftwareGeofenceFix(*this, location));
+}
+
+void
+GeofenceAdapter::softwareGeofenceFix(const Location& location)
+{
+    mSoftwareBreaches.clear();
+    mSoftwareEngine.process(location, mSoftwareBreaches);
+    if (mSoftwareBreaches.empty()) {
+        return;
+    }
+
+    // one report per breach type, as the modem does
+    for (int type = GEOFENCE_BREACH_ENTER; type < GEOFENCE_BREACH_UNKNOWN; ++type) {
+        mSoftwareBreachHwIds.clear();
+        for (auto& breach : mSoftwareBreaches) {
+            if (type == breach.breachType) {
+                mSoftwareBreachHwIds.push_back(breach.hwId);
+            }
+        }
+        if (!mSoftwareBreachHwIds.empty()) {
+            geofenceBreach(mSoftwareBreachHwIds.size(), mSoftwareBreachHwIds.data(), location,
+                           (GeofenceBreachType)type, location.timestamp);
+        }
     }
 }
 
@@ -32,7 +32,15 @@
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
+#include <GeofenceSpatialIndex.h>
+#include <GeofenceSoftwareEngine.h>
+#include <GeofenceSnapshot.h>
+#include <LocFlatMap.h>
+#include <LocTimer.h>
+#include <atomic>
 #include <map>
+#include <tuple>
+#include <vector>
 
 using namespace loc_core;
 
@@ -71,14 +79,82 @@ typedef struct {
     double radius;
     bool paused;
 } GeofenceObject;
+// hwIds of the geofences evaluated on the AP, once the modem is at capacity
+#define SOFTWARE_GEOFENCE_HWID_BIT (0x80000000)
+inline bool isSoftwareGeofence(uint32_t hwId) {
+    return (hwId & SOFTWARE_GEOFENCE_HWID_BIT) != 0;
+}
+
 typedef std::map<uint32_t, GeofenceObject> GeofencesMap; //map of hwId to GeofenceObject
+typedef struct
+{
+    std::vector<LocationError> errs;  // per geofence, in the order of the request
+    std::vector<uint32_t> hwIds;
+} GeofencesData;
+// issues one batched LocApi call for the modem geofences of a chunk; indexes
+// locate each of them in the chunk
+typedef std::function<void (size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+                            const size_t* indexes, LocApiCollectiveResponse* adapterResponse)>
+        GeofenceBatchCall;
+// applies a successful call to the saved item at index of the chunk
+typedef std::function<void (uint32_t hwId, size_t index)> GeofenceItemUpdate;
 typedef std::map<GeofenceKey, uint32_t> GeofenceIdMap; //map of GeofenceKey to hwId
+// geofences that a previous run of the process left in the modem, keyed by what
+// a client would add again: latitude, longitude, radius, breach mask,
+// responsiveness and dwell time
+typedef std::tuple<double, double, double, GeofenceBreachTypeMask, uint32_t, uint32_t>
+        GeofenceOrphanKey;
+typedef std::multimap<GeofenceOrphanKey, uint32_t> GeofenceOrphansMap; //map of key to hwId
+typedef struct {
+    uint32_t slot;      // index of the owning client in the breach fan-out
+    uint32_t clientId;
+} GeofenceBreachTarget;
+
+class GeofenceAdapter;
+
+class GeofenceOrphanTimer : public LocTimer {
+public:
+    GeofenceOrphanTimer(GeofenceAdapter* adapter) :
+            LocTimer(), mAdapter(adapter) {}
+
+private:
+    // Override
+    virtual void timeOutCallback() override;
+
+    GeofenceAdapter* mAdapter;
+};
 
 class GeofenceAdapter : public LocAdapterBase {
 
     /* ==== GEOFENCES ====================================================================== */
     GeofencesMap mGeofences; //map hwId to GeofenceObject
     GeofenceIdMap mGeofenceIds; //map of GeofenceKey to hwId
+    GeofenceSpatialIndex mGeofenceIndex; //grid index of hwIds by fence location
+
+    /* ==== BREACH FAN-OUT ================================================================= */
+    loc_util::LocFlatMap<GeofenceBreachTarget> mBreachTargets; //map of hwId to client slot
+    std::vector<LocationAPI*> mSlotClients; //client of each slot, NULL when free
+    std::vector<uint32_t> mSlotGeofences; //number of geofences of each slot
+    std::vector<std::vector<uint32_t>> mSlotBreachIds; //reused per breach report
+    void addBreachTarget(uint32_t hwId, const GeofenceKey& key);
+    void removeBreachTarget(uint32_t hwId);
+
+    /* ==== SNAPSHOT ======================================================================= */
+    GeofenceSnapshot mSnapshot; //on-disk copy of the modem geofences
+    GeofenceOrphansMap mOrphans; //modem geofences of a previous run, not yet added again
+    GeofenceOrphanTimer mOrphanTimer;
+    void saveSnapshotItem(uint32_t hwId);
+    bool adoptGeofenceOrphan(LocationAPI* client, uint32_t clientId,
+                             const GeofenceOption& options, const GeofenceInfo& info);
+    void dropGeofenceOrphans();
+
+    /* ==== SOFTWARE GEOFENCES ============================================================= */
+    GeofenceSoftwareEngine mSoftwareEngine;
+    uint32_t mNextSoftwareHwId;
+    std::atomic<bool> mSoftwareEngineActive; //checked from the QMI thread on every fix
+    std::vector<GeofenceSoftwareEngine::Breach> mSoftwareBreaches;
+    std::vector<uint32_t> mSoftwareBreachHwIds;
+    void updateSoftwareEngineActive();
 
 protected:
 
@@ -91,6 +167,14 @@ public:
     GeofenceAdapter();
     virtual ~GeofenceAdapter() {}
 
+    /* ==== SNAPSHOT ======================================================================= */
+    /* ======== COMMANDS ====(Called from Client Thread)==================================== */
+    void readSnapshotCommand();
+    /* ======== EVENTS ====(Called from LocTimer Thread)==================================== */
+    void purgeGeofenceOrphansEvent();
+    /* ======== UTILITIES ================================================================== */
+    void purgeGeofenceOrphans();
+
     /* ==== SSR ============================================================================ */
     /* ======== EVENTS ====(Called from QMI Thread)========================================= */
     virtual void handleEngineUpEvent();
@@ -118,8 +202,38 @@ public:
     void pauseGeofenceItem(uint32_t hwId);
     void resumeGeofenceItem(uint32_t hwId);
     void modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options);
+    uint32_t addSoftwareGeofence(LocationAPI* client, uint32_t clientId,
+                                 const GeofenceOption& options, const GeofenceInfo& info);
+    /* route to the LocApi, or complete right away for software geofences, whose
+       state is updated by the *GeofenceItem utilities */
+    void removeGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse);
+    /* one chunk of a command, as a single LocApi batch; errs get the per geofence
+       result, and onDone is called once the whole chunk is through */
+    void addGeofences(LocationAPI* client, size_t count, const uint32_t* ids,
+                      const GeofenceOption* options, const GeofenceInfo* infos,
+                      LocationError* errs, std::function<void ()> onDone);
+    void applyToGeofences(LocationAPI* client, size_t count, const uint32_t* ids,
+                          LocationError* errs, GeofenceBatchCall batchCall,
+                          GeofenceItemUpdate itemUpdate, std::function<void ()> onDone);
+    /* a batch of modem geofences through the per geofence LocApi calls, answered
+       once all of them are back; the arrays only need to be valid during the call */
+    void addModemGeofences(size_t count, const uint32_t* clientIds,
+                           const GeofenceOption* options, const GeofenceInfo* infos,
+                           std::function<void (GeofencesData data)> onDone);
+    void removeModemGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+                              LocApiCollectiveResponse* adapterResponse);
+    void pauseModemGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+                             LocApiCollectiveResponse* adapterResponse);
+    void resumeModemGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+                              LocApiCollectiveResponse* adapterResponse);
+    void modifyModemGeofences(size_t count, const uint32_t* hwIds, const uint32_t* clientIds,
+                              const GeofenceOption* options,
+                              LocApiCollectiveResponse* adapterResponse);
+    void loopModemGeofences(size_t count, LocApiCollectiveResponse* adapterResponse,
+                            std::function<void (size_t i, LocApiResponse* itemResponse)> call);
     LocationError getHwIdFromClient(LocationAPI* client, uint32_t clientId, uint32_t& hwId);
     LocationError getGeofenceKeyFromHwId(uint32_t hwId, GeofenceKey& key);
+    void findGeofences(const Location& location, double margin, std::vector<uint32_t>& hwIds);
     void dump();
 
     /* ==== REPORTS ======================================================================== */
@@ -127,7 +241,14 @@ public:
     void geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& location,
                              GeofenceBreachType breachType, uint64_t timestamp);
     void geofenceStatusEvent(GeofenceStatusAvailable available);
+    virtual void reportPositionEvent(const UlpLocation& location,
+                                     const GpsLocationExtended& locationExtended,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask loc_technology_mask,
+                                     GnssDataNotification* pDataNotify = nullptr,
+                                     int msInWeek = -1);
     /* ======== UTILITIES ================================================================== */
+    void softwareGeofenceFix(const Location& location);
     void geofenceBreach(size_t count, uint32_t* hwIds, const Location& location,
                         GeofenceBreachType breachType, uint64_t timestamp);
     void geofenceStatus(GeofenceStatusAvailable available);
@@ -0,0 +1,274 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_GeofenceSnapshot"
+
+#include <GeofenceSnapshot.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <log_util.h>
+
+#define SNAPSHOT_MAGIC          (0x4e534647) // "GFSN"
+#define SNAPSHOT_VERSION        (1)
+#define SNAPSHOT_OP_PUT         (1)
+#define SNAPSHOT_OP_REMOVE      (2)
+#define SNAPSHOT_MIN_CAPACITY   (64)
+
+GeofenceSnapshot::GeofenceSnapshot() :
+    mFd(-1),
+    mHeader(NULL),
+    mCapacity(0)
+{
+}
+
+GeofenceSnapshot::~GeofenceSnapshot()
+{
+    close();
+}
+
+bool
+GeofenceSnapshot::map(size_t capacity)
+{
+    unmap();
+    size_t length = sizeof(Header) + capacity * sizeof(Record);
+    struct stat st;
+    if (0 != fstat(mFd, &st)) {
+        LOC_LOGE("%s]: fstat %s failed, errno %d", __func__, mPath.c_str(), errno);
+        return false;
+    }
+    if ((size_t)st.st_size < length && 0 != ftruncate(mFd, length)) {
+        LOC_LOGE("%s]: ftruncate %s failed, errno %d", __func__, mPath.c_str(), errno);
+        return false;
+    }
+    void* data = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (MAP_FAILED == data) {
+        LOC_LOGE("%s]: mmap %s failed, errno %d", __func__, mPath.c_str(), errno);
+        return false;
+    }
+    mHeader = (Header*)data;
+    mCapacity = capacity;
+    return true;
+}
+
+void
+GeofenceSnapshot::unmap()
+{
+    if (NULL != mHeader) {
+        munmap(mHeader, sizeof(Header) + mCapacity * sizeof(Record));
+        mHeader = NULL;
+        mCapacity = 0;
+    }
+}
+
+bool
+GeofenceSnapshot::open(const char* path)
+{
+    close();
+    mPath = path;
+    mFd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (mFd < 0) {
+        LOC_LOGE("%s]: open %s failed, errno %d", __func__, path, errno);
+        return false;
+    }
+
+    struct stat st;
+    if (0 != fstat(mFd, &st)) {
+        close();
+        return false;
+    }
+    size_t fileRecords = 0;
+    if ((size_t)st.st_size > sizeof(Header)) {
+        fileRecords = ((size_t)st.st_size - sizeof(Header)) / sizeof(Record);
+    }
+    if (!map(fileRecords > SNAPSHOT_MIN_CAPACITY ? fileRecords : SNAPSHOT_MIN_CAPACITY)) {
+        close();
+        return false;
+    }
+
+    if (SNAPSHOT_MAGIC == mHeader->magic && SNAPSHOT_VERSION == mHeader->version &&
+            sizeof(Record) == mHeader->recordSize) {
+        // a file cut short still holds the updates of its whole records
+        uint32_t count = mHeader->count;
+        if (count > fileRecords) {
+            LOC_LOGW("%s]: %s is cut short, %zu of %u records left",
+                     __func__, path, fileRecords, count);
+            count = (uint32_t)fileRecords;
+        }
+        Record* log = records();
+        for (uint32_t i = 0; i < count; ++i) {
+            if (SNAPSHOT_OP_PUT == log[i].op) {
+                mGeofences[log[i].hwId] = log[i].geofence;
+            } else if (SNAPSHOT_OP_REMOVE == log[i].op) {
+                mGeofences.erase(log[i].hwId);
+            }
+        }
+    } else if (st.st_size > 0) {
+        LOC_LOGW("%s]: %s is not a valid snapshot, starting over", __func__, path);
+    }
+
+    LOC_LOGD("%s]: %s holds %zu geofences", __func__, path, mGeofences.size());
+    // start from a log of only the live geofences
+    if (!compact()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void
+GeofenceSnapshot::close()
+{
+    unmap();
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+    mGeofences.clear();
+}
+
+void
+GeofenceSnapshot::put(uint32_t hwId, const Geofence& geofence)
+{
+    mGeofences[hwId] = geofence;
+    Record record = {};
+    record.op = SNAPSHOT_OP_PUT;
+    record.hwId = hwId;
+    record.geofence = geofence;
+    append(record);
+}
+
+void
+GeofenceSnapshot::remove(uint32_t hwId)
+{
+    if (mGeofences.erase(hwId) > 0) {
+        Record record = {};
+        record.op = SNAPSHOT_OP_REMOVE;
+        record.hwId = hwId;
+        append(record);
+    }
+}
+
+void
+GeofenceSnapshot::clear()
+{
+    mGeofences.clear();
+    if (isOpen()) {
+        compact();
+    }
+}
+
+void
+GeofenceSnapshot::append(const Record& record)
+{
+    if (!isOpen()) {
+        return;
+    }
+    if (mHeader->count >= mCapacity) {
+        bool ok;
+        bool compacting = (mHeader->count >= 2 * mGeofences.size());
+        if (compacting) {
+            // mostly dead records; the compacted log already holds this update
+            ok = compact();
+        } else {
+            ok = map(2 * mCapacity);
+        }
+        if (!ok) {
+            LOC_LOGE("%s]: snapshot %s disabled", __func__, mPath.c_str());
+            close();
+            return;
+        }
+        if (compacting) {
+            return;
+        }
+    }
+    records()[mHeader->count] = record;
+    // publish the record only once it is complete
+    __sync_synchronize();
+    mHeader->count++;
+}
+
+bool
+GeofenceSnapshot::compact()
+{
+    size_t capacity = 2 * mGeofences.size();
+    if (capacity < SNAPSHOT_MIN_CAPACITY) {
+        capacity = SNAPSHOT_MIN_CAPACITY;
+    }
+    std::string tmpPath = mPath + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOC_LOGE("%s]: open %s failed, errno %d", __func__, tmpPath.c_str(), errno);
+        return false;
+    }
+
+    bool ok = (0 == ftruncate(fd, sizeof(Header) + capacity * sizeof(Record)));
+    void* data = MAP_FAILED;
+    if (ok) {
+        data = mmap(NULL, sizeof(Header) + capacity * sizeof(Record),
+                    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ok = (MAP_FAILED != data);
+    }
+    if (ok) {
+        Header* header = (Header*)data;
+        Record* log = (Record*)(header + 1);
+        uint32_t count = 0;
+        for (auto& geofence : mGeofences) {
+            memset(&log[count], 0, sizeof(Record));
+            log[count].op = SNAPSHOT_OP_PUT;
+            log[count].hwId = geofence.first;
+            log[count].geofence = geofence.second;
+            count++;
+        }
+        header->magic = SNAPSHOT_MAGIC;
+        header->version = SNAPSHOT_VERSION;
+        header->recordSize = sizeof(Record);
+        header->count = count;
+        header->reserved = 0;
+        // the new file must be complete on disk before it replaces the old one
+        ok = (0 == msync(data, sizeof(Header) + capacity * sizeof(Record), MS_SYNC));
+        munmap(data, sizeof(Header) + capacity * sizeof(Record));
+    }
+    if (ok) {
+        ok = (0 == rename(tmpPath.c_str(), mPath.c_str()));
+    }
+    if (!ok) {
+        LOC_LOGE("%s]: compacting %s failed, errno %d", __func__, mPath.c_str(), errno);
+        ::close(fd);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    unmap();
+    ::close(mFd);
+    mFd = fd;
+    return map(capacity);
+}
@@ -0,0 +1,101 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef GEOFENCE_SNAPSHOT_H
+#define GEOFENCE_SNAPSHOT_H
+
+#include <LocationDataTypes.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+
+// On-disk copy of the geofences known to GeofenceAdapter, so that a restarted
+// process can tell which fences it left behind in the modem.
+//
+// The file is a small header followed by an append log of fixed size records,
+// each putting or removing the state of one hwId, and is memory mapped while
+// open. An update costs one record store plus a bump of the header count, so
+// a record is either fully in the log or not at all. Once the log holds
+// mostly dead records it is compacted: the live geofences are written to a
+// temporary file that is then renamed over the snapshot.
+class GeofenceSnapshot {
+public:
+    typedef struct {
+        uint32_t clientId;
+        GeofenceBreachTypeMask breachMask;
+        uint32_t responsiveness;
+        uint32_t dwellTime;
+        double latitude;
+        double longitude;
+        double radius;
+        bool paused;
+    } Geofence;
+    typedef std::map<uint32_t, Geofence> GeofenceMap; //map of hwId to Geofence
+
+    GeofenceSnapshot();
+    ~GeofenceSnapshot();
+
+    // opens path, creating it if needed, and loads what it holds; a file that
+    // is not a valid snapshot is started over
+    bool open(const char* path);
+    void close();
+    inline bool isOpen() const { return NULL != mHeader; }
+    inline const GeofenceMap& getGeofences() const { return mGeofences; }
+
+    void put(uint32_t hwId, const Geofence& geofence);
+    void remove(uint32_t hwId);
+    void clear();
+
+private:
+    typedef struct {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t recordSize;
+        uint32_t count;         // records in the log
+        uint32_t reserved;
+    } Header;
+    typedef struct {
+        uint32_t op;
+        uint32_t hwId;
+        Geofence geofence;
+    } Record;
+
+    void append(const Record& record);
+    bool compact();
+    bool map(size_t capacity);
+    void unmap();
+    inline Record* records() const { return (Record*)(mHeader + 1); }
+
+    std::string mPath;
+    int mFd;
+    Header* mHeader;
+    size_t mCapacity;           // records that fit in the mapping
+    GeofenceMap mGeofences;
+};
+
+#endif /* GEOFENCE_SNAPSHOT_H */
@@ -0,0 +1,185 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_GeofenceSoftwareEngine"
+
+#include <GeofenceSoftwareEngine.h>
+#include <algorithm>
+#include <loc_geo.h>
+#include <log_util.h>
+
+void
+GeofenceSoftwareEngine::add(uint32_t hwId, const GeofenceOption& options,
+        const GeofenceInfo& info)
+{
+    remove(hwId);
+
+    Fence fence = {};
+    fence.latitude = info.latitude;
+    fence.longitude = info.longitude;
+    fence.radius = info.radius;
+    mFences[hwId] = fence;
+    modify(hwId, options);
+    mIndex.add(hwId, info.latitude, info.longitude, info.radius);
+}
+
+void
+GeofenceSoftwareEngine::remove(uint32_t hwId)
+{
+    auto it = mFences.find(hwId);
+    if (it != mFences.end()) {
+        mTracked.erase(hwId);
+        mIndex.remove(hwId);
+        mFences.erase(it);
+    }
+}
+
+void
+GeofenceSoftwareEngine::modify(uint32_t hwId, const GeofenceOption& options)
+{
+    auto it = mFences.find(hwId);
+    if (it == mFences.end()) {
+        LOC_LOGE("%s]: geofence to modify not found. hwId %u", __func__, hwId);
+        return;
+    }
+    Fence& fence = it->second;
+    fence.breachMask = options.breachTypeMask;
+    fence.responsiveness = options.responsiveness;
+    fence.dwellTime = (uint64_t)options.dwellTime * 1000;
+    fence.nextEvaluateTime = 0;
+    // an exited fence is only kept around for its DWELL_OUT
+    if (!fence.inside && !(fence.breachMask & GEOFENCE_BREACH_DWELL_OUT_BIT)) {
+        mTracked.erase(hwId);
+    }
+}
+
+void
+GeofenceSoftwareEngine::pause(uint32_t hwId)
+{
+    auto it = mFences.find(hwId);
+    if (it != mFences.end()) {
+        it->second.paused = true;
+        untrack(hwId, it->second);
+    }
+}
+
+void
+GeofenceSoftwareEngine::resume(uint32_t hwId)
+{
+    auto it = mFences.find(hwId);
+    if (it != mFences.end()) {
+        it->second.paused = false;
+        it->second.nextEvaluateTime = 0;
+    }
+}
+
+void
+GeofenceSoftwareEngine::clear()
+{
+    mFences.clear();
+    mIndex.clear();
+    mTracked.clear();
+}
+
+void
+GeofenceSoftwareEngine::untrack(uint32_t hwId, Fence& fence)
+{
+    fence.inside = false;
+    fence.dwellReported = false;
+    mTracked.erase(hwId);
+}
+
+void
+GeofenceSoftwareEngine::process(const Location& location, std::vector<Breach>& breaches)
+{
+    if (!(location.flags & LOCATION_HAS_LAT_LONG_BIT) || mFences.empty()) {
+        return;
+    }
+    double accuracy = (location.flags & LOCATION_HAS_ACCURACY_BIT) ? location.accuracy : 0.0;
+
+    // fences the fix may enter (its center must be inside them), plus those
+    // with a pending exit or dwell
+    mCandidates.clear();
+    mIndex.query(location.latitude, location.longitude, 0.0, mCandidates);
+    mCandidates.insert(mCandidates.end(), mTracked.begin(), mTracked.end());
+    std::sort(mCandidates.begin(), mCandidates.end());
+    mCandidates.erase(std::unique(mCandidates.begin(), mCandidates.end()), mCandidates.end());
+
+    for (auto hwId : mCandidates) {
+        auto it = mFences.find(hwId);
+        if (it != mFences.end() && !it->second.paused) {
+            evaluate(hwId, it->second, location, accuracy, breaches);
+        }
+    }
+}
+
+void
+GeofenceSoftwareEngine::evaluate(uint32_t hwId, Fence& fence, const Location& location,
+        double accuracy, std::vector<Breach>& breaches)
+{
+    uint64_t now = location.timestamp;
+
+    if (now >= fence.nextEvaluateTime) {
+        fence.nextEvaluateTime = now + fence.responsiveness;
+        double distance = loc_geo_distance(location.latitude, location.longitude,
+                                           fence.latitude, fence.longitude);
+        if (!fence.inside && distance + accuracy <= fence.radius) {
+            fence.inside = true;
+            fence.dwellReported = false;
+            fence.transitionTime = now;
+            mTracked.insert(hwId);
+            if (fence.breachMask & GEOFENCE_BREACH_ENTER_BIT) {
+                breaches.push_back({hwId, GEOFENCE_BREACH_ENTER});
+            }
+        } else if (fence.inside && distance - accuracy > fence.radius) {
+            fence.inside = false;
+            fence.dwellReported = false;
+            fence.transitionTime = now;
+            if (!(fence.breachMask & GEOFENCE_BREACH_DWELL_OUT_BIT)) {
+                mTracked.erase(hwId);
+            }
+            if (fence.breachMask & GEOFENCE_BREACH_EXIT_BIT) {
+                breaches.push_back({hwId, GEOFENCE_BREACH_EXIT});
+            }
+        }
+    }
+
+    if (!fence.dwellReported && mTracked.count(hwId) > 0 &&
+            now >= fence.transitionTime + fence.dwellTime) {
+        if (fence.inside) {
+            fence.dwellReported = true;
+            if (fence.breachMask & GEOFENCE_BREACH_DWELL_IN_BIT) {
+                breaches.push_back({hwId, GEOFENCE_BREACH_DWELL_IN});
+            }
+        } else {
+            // DWELL_OUT was the only reason to keep tracking an exited fence
+            untrack(hwId, fence);
+            breaches.push_back({hwId, GEOFENCE_BREACH_DWELL_OUT});
+        }
+    }
+}
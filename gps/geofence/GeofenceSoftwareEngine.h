@@ -0,0 +1,93 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef GEOFENCE_SOFTWARE_ENGINE_H
+#define GEOFENCE_SOFTWARE_ENGINE_H
+
+#include <LocationDataTypes.h>
+#include <GeofenceSpatialIndex.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Evaluates geofences on the AP against a stream of fixes. It keeps no
+// reference to the adapter or to the LocApi, and takes its notion of time
+// from the fix timestamps, so it can be driven by any sequence of Locations.
+//
+// A fence is inside when the whole uncertainty circle of the fix is within
+// its radius, and outside when the whole uncertainty circle is beyond it;
+// fixes in between do not change the fence state. A fence is evaluated at
+// most once per its responsiveness period. DWELL_IN and DWELL_OUT are
+// reported once the fence stayed inside, or outside after an exit, for
+// dwellTime.
+class GeofenceSoftwareEngine {
+public:
+    typedef struct {
+        uint32_t hwId;
+        GeofenceBreachType breachType;
+    } Breach;
+
+    void add(uint32_t hwId, const GeofenceOption& options, const GeofenceInfo& info);
+    void remove(uint32_t hwId);
+    void modify(uint32_t hwId, const GeofenceOption& options);
+    void pause(uint32_t hwId);
+    void resume(uint32_t hwId);
+    void clear();
+    inline size_t size() const { return mFences.size(); }
+
+    // evaluates the fences against location, appending what they breached
+    void process(const Location& location, std::vector<Breach>& breaches);
+
+private:
+    typedef struct {
+        GeofenceBreachTypeMask breachMask;
+        uint64_t responsiveness;    // in milliseconds
+        uint64_t dwellTime;         // in milliseconds
+        double latitude;
+        double longitude;
+        double radius;
+        bool paused;
+        bool inside;
+        bool dwellReported;
+        uint64_t transitionTime;    // last enter or exit
+        uint64_t nextEvaluateTime;
+    } Fence;
+
+    void evaluate(uint32_t hwId, Fence& fence, const Location& location, double accuracy,
+                  std::vector<Breach>& breaches);
+    void untrack(uint32_t hwId, Fence& fence);
+
+    std::unordered_map<uint32_t, Fence> mFences;
+    GeofenceSpatialIndex mIndex;
+    // fences that are inside, or outside but waiting for DWELL_OUT; all other
+    // fences are outside, and only need a look once a fix gets near them
+    std::unordered_set<uint32_t> mTracked;
+    std::vector<uint32_t> mCandidates;
+};
+
+#endif /* GEOFENCE_SOFTWARE_ENGINE_H */
@@ -0,0 +1,189 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_GeofenceSpatialIndex"
+
+#include <GeofenceSpatialIndex.h>
+#include <algorithm>
+#include <math.h>
+#include <loc_geo.h>
+
+static const int64_t GRID_ROWS = (int64_t)(180.0 / GeofenceSpatialIndex::CELL_DEG);
+static const int64_t GRID_COLS = (int64_t)(360.0 / GeofenceSpatialIndex::CELL_DEG);
+
+// Range of the cells overlapped by the bounding box of the circle; false if
+// the box can not be expressed as a cell range of a sane size.
+bool
+GeofenceSpatialIndex::getCellRange(double latitude, double longitude, double radius,
+                                   CellRange& range)
+{
+    double dLat = LOC_GEO_RAD_TO_DEG(radius / LOC_GEO_EARTH_RADIUS_M);
+    double maxAbsLat = fabs(latitude) + dLat;
+    if (maxAbsLat >= 90.0) {
+        return false;
+    }
+    // widest longitude span is at the poleward edge of the box
+    double dLon = dLat / cos(LOC_GEO_DEG_TO_RAD(maxAbsLat));
+    if (dLon >= 180.0) {
+        return false;
+    }
+    range.row0 = (int64_t)floor((latitude - dLat + 90.0) / CELL_DEG);
+    range.row1 = (int64_t)floor((latitude + dLat + 90.0) / CELL_DEG);
+    range.col0 = (int64_t)floor((longitude - dLon + 180.0) / CELL_DEG);
+    range.col1 = (int64_t)floor((longitude + dLon + 180.0) / CELL_DEG);
+    return range.count() <= MAX_CELLS_PER_FENCE;
+}
+
+// columns wrap around the antimeridian
+uint64_t
+GeofenceSpatialIndex::cellKey(int64_t row, int64_t col)
+{
+    col %= GRID_COLS;
+    if (col < 0) {
+        col += GRID_COLS;
+    }
+    return (uint64_t)row * GRID_COLS + col;
+}
+
+bool
+GeofenceSpatialIndex::isInRange(const Fence& fence, double latitude, double longitude,
+                                double margin) const
+{
+    return loc_geo_distance(latitude, longitude, fence.latitude, fence.longitude) <=
+            fence.radius + margin;
+}
+
+void
+GeofenceSpatialIndex::add(uint32_t hwId, double latitude, double longitude, double radius)
+{
+    remove(hwId);
+
+    CellRange range;
+    Fence fence = {latitude, longitude, radius,
+                   !getCellRange(latitude, longitude, radius, range)};
+    mFences[hwId] = fence;
+    if (fence.large) {
+        mLargeFences.push_back(hwId);
+    } else {
+        for (int64_t row = range.row0; row <= range.row1; row++) {
+            for (int64_t col = range.col0; col <= range.col1; col++) {
+                mCells[cellKey(row, col)].push_back(hwId);
+            }
+        }
+    }
+}
+
+void
+GeofenceSpatialIndex::remove(uint32_t hwId)
+{
+    auto it = mFences.find(hwId);
+    if (it == mFences.end()) {
+        return;
+    }
+
+    const Fence& fence = it->second;
+    CellRange range;
+    if (fence.large ||
+            !getCellRange(fence.latitude, fence.longitude, fence.radius, range)) {
+        auto large = std::find(mLargeFences.begin(), mLargeFences.end(), hwId);
+        if (large != mLargeFences.end()) {
+            *large = mLargeFences.back();
+            mLargeFences.pop_back();
+        }
+    } else {
+        for (int64_t row = range.row0; row <= range.row1; row++) {
+            for (int64_t col = range.col0; col <= range.col1; col++) {
+                auto cell = mCells.find(cellKey(row, col));
+                if (cell != mCells.end()) {
+                    auto& ids = cell->second;
+                    auto id = std::find(ids.begin(), ids.end(), hwId);
+                    if (id != ids.end()) {
+                        *id = ids.back();
+                        ids.pop_back();
+                    }
+                    if (ids.empty()) {
+                        mCells.erase(cell);
+                    }
+                }
+            }
+        }
+    }
+    mFences.erase(it);
+}
+
+void
+GeofenceSpatialIndex::clear()
+{
+    mFences.clear();
+    mCells.clear();
+    mLargeFences.clear();
+}
+
+void
+GeofenceSpatialIndex::query(double latitude, double longitude, double margin,
+                            std::vector<uint32_t>& hwIds) const
+{
+    size_t first = hwIds.size();
+    CellRange range;
+    if (!getCellRange(latitude, longitude, margin, range) || range.count() >= mFences.size()) {
+        // a query this wide is cheaper as a plain scan
+        for (auto& fence : mFences) {
+            if (isInRange(fence.second, latitude, longitude, margin)) {
+                hwIds.push_back(fence.first);
+            }
+        }
+        return;
+    }
+
+    for (int64_t row = range.row0; row <= range.row1; row++) {
+        for (int64_t col = range.col0; col <= range.col1; col++) {
+            auto cell = mCells.find(cellKey(row, col));
+            if (cell != mCells.end()) {
+                for (auto hwId : cell->second) {
+                    auto fence = mFences.find(hwId);
+                    if (fence != mFences.end() &&
+                            isInRange(fence->second, latitude, longitude, margin)) {
+                        hwIds.push_back(hwId);
+                    }
+                }
+            }
+        }
+    }
+    // a fence spanning several of the visited cells is found in each of them
+    if (range.count() > 1) {
+        std::sort(hwIds.begin() + first, hwIds.end());
+        hwIds.erase(std::unique(hwIds.begin() + first, hwIds.end()), hwIds.end());
+    }
+
+    for (auto hwId : mLargeFences) {
+        auto fence = mFences.find(hwId);
+        if (fence != mFences.end() && isInRange(fence->second, latitude, longitude, margin)) {
+            hwIds.push_back(hwId);
+        }
+    }
+}
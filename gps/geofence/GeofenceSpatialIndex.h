@@ -0,0 +1,82 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef GEOFENCE_SPATIAL_INDEX_H
+#define GEOFENCE_SPATIAL_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <unordered_map>
+
+// Grid index over geofence circles, keyed by hwId. The earth is cut into
+// cells of CELL_DEG x CELL_DEG degrees, and each fence is listed in every
+// cell its bounding box overlaps. Fences that would cover too many cells
+// (very large radius, or close to a pole) are kept in a separate list that
+// every query checks. A point query then only looks at the fences of one
+// cell plus the large ones, and confirms them with an exact distance check.
+class GeofenceSpatialIndex {
+public:
+    static constexpr double CELL_DEG = 1.0 / 64.0;   // about 1.7 km of latitude
+    static constexpr size_t MAX_CELLS_PER_FENCE = 256;
+
+    void add(uint32_t hwId, double latitude, double longitude, double radius);
+    void remove(uint32_t hwId);
+    void clear();
+    inline size_t size() const { return mFences.size(); }
+
+    // Appends to *hwIds* the fences whose circle is within *margin* meters of
+    // the point (*latitude*, *longitude*); i.e. with a *margin* of 0, the
+    // fences containing the point. Each fence is reported once, in no
+    // particular order.
+    void query(double latitude, double longitude, double margin,
+               std::vector<uint32_t>& hwIds) const;
+
+private:
+    struct Fence {
+        double latitude;
+        double longitude;
+        double radius;
+        bool large;
+    };
+    struct CellRange {
+        int64_t row0, row1, col0, col1;
+        inline size_t count() const { return (row1 - row0 + 1) * (col1 - col0 + 1); }
+    };
+
+    static bool getCellRange(double latitude, double longitude, double radius,
+                             CellRange& range);
+    static uint64_t cellKey(int64_t row, int64_t col);
+    bool isInRange(const Fence& fence, double latitude, double longitude, double margin) const;
+
+    std::unordered_map<uint32_t, Fence> mFences;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> mCells;
+    std::vector<uint32_t> mLargeFences;
+};
+
+#endif /* GEOFENCE_SPATIAL_INDEX_H */
@@ -0,0 +1,293 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <GeofenceAdapter.h>
+#include <loc_test_util.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+// Times GeofenceAdapter fanning geofence breach reports out to its clients.
+// The clients add their share of the fences through addGeofencesCommand(),
+// far from any fix so that the LocApi does not breach them itself; then
+// geofenceBreachEvent() gets bursts of breaches of fences of all clients,
+// mixed, as the modem reports them. For each burst size it prints the time
+// the adapter thread spent from the start of the report to the last client
+// callback, per burst and per breach, the wall time per burst, and the
+// callbacks per burst.
+//
+// usage: geofence_breach_bench [-c clients] [-f fences] [-r bursts]
+//   -c  clients, 8 by default
+//   -f  geofences of all clients together, 5000 by default
+//   -r  bursts per burst size, 200 by default
+
+#define BENCH_MAX_CLIENTS   64
+#define BENCH_TIMEOUT_MS    10000
+
+static std::atomic<uint32_t> sResponses(0);
+static std::atomic<uint32_t> sAddErrors(0);
+static std::atomic<uint32_t> sBreachCallbacks(0);
+static std::atomic<uint64_t> sBreachIds(0);
+// adapter thread cpu time at the start of a report and at the last callback
+static std::atomic<uint64_t> sStartCpuNs(0);
+static std::atomic<uint64_t> sLastCpuNs(0);
+
+// the adapter only uses the clients as keys
+static char sClients[BENCH_MAX_CLIENTS];
+// the adapter frees the ids it returns once it responds, so keep those of the responses
+static std::mutex sIdsLock;
+static std::vector<uint32_t> sIds;
+
+static bool waitFor(const std::atomic<uint32_t>& counter, uint32_t expected)
+{
+    uint64_t deadlineNs = monotonicNs() + BENCH_TIMEOUT_MS * 1000000ULL;
+    while (counter.load() < expected) {
+        if (monotonicNs() > deadlineNs) {
+            return false;
+        }
+        sched_yield();
+    }
+    return true;
+}
+
+// runs on the adapter thread, right before the breach report queued after it
+struct MsgMarkStart : public LocMsg {
+    inline virtual void proc() const { sStartCpuNs = threadCpuNs(); }
+};
+
+// looks up the hwIds and the clients of the fences on the adapter thread
+struct MsgGetHwIds : public LocMsg {
+    GeofenceAdapter& mAdapter;
+    int mClients;
+    std::vector<std::pair<uint32_t, int>>& mHwIds;
+    std::atomic<uint32_t>& mDone;
+    inline MsgGetHwIds(GeofenceAdapter& adapter, int clients,
+                       std::vector<std::pair<uint32_t, int>>& hwIds,
+                       std::atomic<uint32_t>& done) :
+        LocMsg(), mAdapter(adapter), mClients(clients), mHwIds(hwIds), mDone(done) {}
+    inline virtual void proc() const {
+        std::lock_guard<std::mutex> guard(sIdsLock);
+        for (auto id : sIds) {
+            for (int c = 0; c < mClients; c++) {
+                uint32_t hwId = 0;
+                if (LOCATION_ERROR_SUCCESS ==
+                        mAdapter.getHwIdFromClient((LocationAPI*)&sClients[c], id, hwId)) {
+                    mHwIds.push_back(std::make_pair(hwId, c));
+                    break;
+                }
+            }
+        }
+        mDone++;
+    }
+};
+
+static LocationCallbacks makeCallbacks()
+{
+    LocationCallbacks callbacks = {};
+    callbacks.size = sizeof(LocationCallbacks);
+    callbacks.capabilitiesCb = [] (LocationCapabilitiesMask /*mask*/) {};
+    callbacks.responseCb = [] (LocationError /*err*/, uint32_t /*id*/) {};
+    callbacks.collectiveResponseCb = [] (size_t count, LocationError* errs, uint32_t* ids) {
+        std::lock_guard<std::mutex> guard(sIdsLock);
+        for (size_t i = 0; i < count; i++) {
+            sAddErrors += (LOCATION_ERROR_SUCCESS != errs[i]);
+            sIds.push_back(ids[i]);
+        }
+        sResponses++;
+    };
+    callbacks.geofenceBreachCb = [] (GeofenceBreachNotification notification) {
+        sBreachIds += notification.count;
+        sLastCpuNs = threadCpuNs();
+        sBreachCallbacks++;
+    };
+    return callbacks;
+}
+
+typedef struct {
+    double adapterUs;       // median per burst
+    double adapterNs;       // median per breach
+    double wallUs;          // median per burst
+    double callbacks;
+    bool timedOut;
+    bool lost;
+} BurstResult;
+
+static BurstResult runBursts(GeofenceAdapter& adapter, std::vector<uint32_t>& hwIds,
+                             const std::vector<int>& owners, size_t burst, int bursts,
+                             int clients)
+{
+    BurstResult result = {};
+    Location location = {};
+    location.size = sizeof(Location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT | LOCATION_HAS_ACCURACY_BIT;
+    location.latitude = -70.0;
+    location.accuracy = 10.0f;
+
+    // the clients in the burst are the same for all bursts
+    std::vector<bool> inBurst(clients, false);
+    for (size_t i = 0; i < burst; i++) {
+        inBurst[owners[i]] = true;
+    }
+    uint32_t callbacksPerBurst = (uint32_t)std::count(inBurst.begin(), inBurst.end(), true);
+
+    std::vector<uint64_t> adapterNs, burstWallNs;
+    uint64_t breachIds = sBreachIds.load();
+    for (int b = 0; b < bursts; b++) {
+        uint32_t expected = sBreachCallbacks.load() + callbacksPerBurst;
+        location.timestamp = 1000000 + b;
+        uint64_t startNs = monotonicNs();
+        adapter.sendMsg(new MsgMarkStart());
+        adapter.geofenceBreachEvent(burst, hwIds.data(), location,
+                                    (b & 1) ? GEOFENCE_BREACH_EXIT : GEOFENCE_BREACH_ENTER,
+                                    location.timestamp);
+        if (!waitFor(sBreachCallbacks, expected)) {
+            result.timedOut = true;
+            return result;
+        }
+        burstWallNs.push_back(monotonicNs() - startNs);
+        adapterNs.push_back(sLastCpuNs.load() - sStartCpuNs.load());
+    }
+    if (sBreachIds.load() - breachIds != (uint64_t)burst * bursts) {
+        result.lost = true;
+        return result;
+    }
+    std::sort(adapterNs.begin(), adapterNs.end());
+    std::sort(burstWallNs.begin(), burstWallNs.end());
+    result.adapterUs = adapterNs[bursts / 2] / 1000.0;
+    result.adapterNs = (double)adapterNs[bursts / 2] / burst;
+    result.wallUs = burstWallNs[bursts / 2] / 1000.0;
+    result.callbacks = callbacksPerBurst;
+    return result;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-c clients] [-f fences] [-r bursts]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    int clients = 8;
+    int fences = 5000;
+    int bursts = 200;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "c:f:r:"))) {
+        switch (opt) {
+        case 'c':
+            clients = atoi(optarg);
+            break;
+        case 'f':
+            fences = atoi(optarg);
+            break;
+        case 'r':
+            bursts = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (clients <= 0 || clients > BENCH_MAX_CLIENTS || fences < clients || bursts <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    GeofenceAdapter* adapter = new GeofenceAdapter();
+    LocationCallbacks callbacks = makeCallbacks();
+
+    // each client adds its share of fences, spread along a parallel far from any fix
+    std::vector<int> perClient(clients);
+    int added = 0;
+    for (int c = 0; c < clients; c++) {
+        LocationAPI* client = (LocationAPI*)&sClients[c];
+        perClient[c] = fences / clients + ((c < fences % clients) ? 1 : 0);
+        std::vector<GeofenceOption> options(perClient[c]);
+        std::vector<GeofenceInfo> infos(perClient[c]);
+        for (int i = 0; i < perClient[c]; i++) {
+            options[i] = {sizeof(GeofenceOption),
+                          GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT, 0, 0};
+            infos[i] = {sizeof(GeofenceInfo), -70.0, -180.0 + 359.0 * (added + i) / fences,
+                        100.0};
+        }
+        added += perClient[c];
+        adapter->addClientCommand(client, callbacks);
+        adapter->addGeofencesCommand(client, perClient[c], options.data(), infos.data());
+    }
+    if (!waitFor(sResponses, clients) || 0 != sAddErrors.load()) {
+        fprintf(stderr, "adding the geofences failed\n");
+        return 1;
+    }
+
+    std::vector<std::pair<uint32_t, int>> mixed;
+    std::atomic<uint32_t> done(0);
+    adapter->sendMsg(new MsgGetHwIds(*adapter, clients, mixed, done));
+    if (!waitFor(done, 1) || (int)mixed.size() != fences) {
+        fprintf(stderr, "%zu of the %d geofences have hwIds\n", mixed.size(), fences);
+        return 1;
+    }
+
+    // the fences of all clients mixed, in a fixed random order
+    srand(1);
+    for (size_t i = mixed.size() - 1; i > 0; i--) {
+        std::swap(mixed[i], mixed[rand() % (i + 1)]);
+    }
+    std::vector<uint32_t> hwIds;
+    std::vector<int> owners;
+    for (auto& each : mixed) {
+        hwIds.push_back(each.first);
+        owners.push_back(each.second);
+    }
+
+    printf("%d clients, %zu geofences\n", clients, hwIds.size());
+    printf("%-8s %14s %14s %12s %10s\n", "breaches", "adapter us", "ns/breach", "wall us",
+           "callbacks");
+    static const size_t burstSizes[] = {1, 50, 500, 5000};
+    for (auto burst : burstSizes) {
+        burst = std::min(burst, hwIds.size());
+        BurstResult r = runBursts(*adapter, hwIds, owners, burst, bursts, clients);
+        if (r.timedOut) {
+            printf("%-8zu timed out, the clients did not get all the breaches\n", burst);
+            return 1;
+        }
+        if (r.lost) {
+            printf("%-8zu the clients got a different number of breaches\n", burst);
+            return 1;
+        }
+        printf("%-8zu %14.1f %14.1f %12.1f %10.0f\n", burst, r.adapterUs, r.adapterNs,
+               r.wallUs, r.callbacks);
+        if (burst == hwIds.size()) {
+            break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,400 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <GeofenceSoftwareEngine.h>
+#include <loc_geo.h>
+#include <loc_test_util.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+// Drives GeofenceSoftwareEngine with synthetic fixes only: enter and exit
+// against the fix uncertainty, DWELL_IN and DWELL_OUT timing, the
+// responsiveness period, pause, resume and remove, a walk across a fence at
+// walking speed, and a random walk over many fences compared with a
+// reference that evaluates every fence on every fix. The exit status is
+// the number of failed checks.
+//
+// usage: geofence_engine_test
+
+#define TEST_LATITUDE       45.0
+#define TEST_LONGITUDE      7.0
+#define TEST_RADIUS         100.0
+#define TEST_WALK_FENCES    400
+#define TEST_WALK_FIXES     20000
+
+typedef GeofenceSoftwareEngine::Breach Breach;
+
+static uint32_t sSeed = 1;
+static double nextRandom(double from, double to)
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return from + (to - from) * ((sSeed >> 8) & 0xFFFFFF) / 16777216.0;
+}
+
+static GeofenceOption makeOption(GeofenceBreachTypeMask mask, uint32_t responsiveness,
+                                 uint32_t dwellTime)
+{
+    GeofenceOption option;
+    memset(&option, 0, sizeof(option));
+    option.size = sizeof(option);
+    option.breachTypeMask = mask;
+    option.responsiveness = responsiveness;
+    option.dwellTime = dwellTime;
+    return option;
+}
+
+static GeofenceInfo makeInfo(double latitude, double longitude, double radius)
+{
+    GeofenceInfo info;
+    info.size = sizeof(info);
+    info.latitude = latitude;
+    info.longitude = longitude;
+    info.radius = radius;
+    return info;
+}
+
+// a fix *north* meters north of the test fence center; along a meridian the
+// haversine distance is exactly that
+static Location makeFix(uint64_t timestamp, double north, float accuracy)
+{
+    Location location;
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT | LOCATION_HAS_ACCURACY_BIT;
+    location.timestamp = timestamp;
+    location.latitude = TEST_LATITUDE + LOC_GEO_RAD_TO_DEG(north / LOC_GEO_EARTH_RADIUS_M);
+    location.longitude = TEST_LONGITUDE;
+    location.accuracy = accuracy;
+    return location;
+}
+
+static std::vector<Breach> feed(GeofenceSoftwareEngine& engine, const Location& location)
+{
+    std::vector<Breach> breaches;
+    engine.process(location, breaches);
+    return breaches;
+}
+
+static bool isOnly(const std::vector<Breach>& breaches, uint32_t hwId, GeofenceBreachType type)
+{
+    return 1 == breaches.size() && hwId == breaches[0].hwId && type == breaches[0].breachType;
+}
+
+static void addTestFence(GeofenceSoftwareEngine& engine, uint32_t hwId,
+                         GeofenceBreachTypeMask mask, uint32_t responsiveness,
+                         uint32_t dwellTime)
+{
+    engine.add(hwId, makeOption(mask, responsiveness, dwellTime),
+               makeInfo(TEST_LATITUDE, TEST_LONGITUDE, TEST_RADIUS));
+}
+
+/* ==== ENTER AND EXIT ================================================================= */
+
+static void testEnterExit()
+{
+    GeofenceSoftwareEngine engine;
+    addTestFence(engine, 1, GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT, 0, 0);
+    expectTrue("far outside", feed(engine, makeFix(1000, 500.0, 10.0f)).empty());
+    // center inside, but the uncertainty circle crosses the border
+    expectTrue("uncertain is not an enter", feed(engine, makeFix(2000, 95.0, 10.0f)).empty());
+    expectTrue("enter", isOnly(feed(engine, makeFix(3000, 89.0, 10.0f)), 1,
+                               GEOFENCE_BREACH_ENTER));
+    expectTrue("no second enter", feed(engine, makeFix(4000, 0.0, 10.0f)).empty());
+    expectTrue("uncertain is not an exit", feed(engine, makeFix(5000, 105.0, 10.0f)).empty());
+    expectTrue("exit", isOnly(feed(engine, makeFix(6000, 111.0, 10.0f)), 1,
+                              GEOFENCE_BREACH_EXIT));
+    expectTrue("no second exit", feed(engine, makeFix(7000, 500.0, 10.0f)).empty());
+    expectTrue("enter again", isOnly(feed(engine, makeFix(8000, -50.0, 10.0f)), 1,
+                                     GEOFENCE_BREACH_ENTER));
+
+    // a fix without a position changes nothing
+    Location noPosition = makeFix(9000, 500.0, 10.0f);
+    noPosition.flags = 0;
+    expectTrue("fix without a position", feed(engine, noPosition).empty());
+
+    // without accuracy the fix is taken as exact
+    Location exact = makeFix(10000, 101.0, 0.0f);
+    exact.flags = LOCATION_HAS_LAT_LONG_BIT;
+    expectTrue("exit without accuracy", isOnly(feed(engine, exact), 1, GEOFENCE_BREACH_EXIT));
+
+    // only the breaches in the mask are reported
+    GeofenceSoftwareEngine exitOnly;
+    addTestFence(exitOnly, 2, GEOFENCE_BREACH_EXIT_BIT, 0, 0);
+    expectTrue("enter not in mask", feed(exitOnly, makeFix(1000, 0.0, 5.0f)).empty());
+    expectTrue("exit in mask", isOnly(feed(exitOnly, makeFix(2000, 200.0, 5.0f)), 2,
+                                      GEOFENCE_BREACH_EXIT));
+}
+
+/* ==== DWELL ========================================================================== */
+
+static void testDwell()
+{
+    GeofenceSoftwareEngine engine;
+    addTestFence(engine, 1, GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT |
+                 GEOFENCE_BREACH_DWELL_IN_BIT | GEOFENCE_BREACH_DWELL_OUT_BIT, 0, 10);
+    expectTrue("enter before dwell", isOnly(feed(engine, makeFix(100000, 0.0, 5.0f)), 1,
+                                            GEOFENCE_BREACH_ENTER));
+    expectTrue("no dwell in yet", feed(engine, makeFix(109999, 0.0, 5.0f)).empty());
+    expectTrue("dwell in after dwellTime", isOnly(feed(engine, makeFix(110000, 0.0, 5.0f)), 1,
+                                                  GEOFENCE_BREACH_DWELL_IN));
+    expectTrue("dwell in once", feed(engine, makeFix(130000, 0.0, 5.0f)).empty());
+    expectTrue("exit after dwell", isOnly(feed(engine, makeFix(140000, 300.0, 5.0f)), 1,
+                                          GEOFENCE_BREACH_EXIT));
+    // the fix that reports DWELL_OUT is far away from the fence
+    expectTrue("no dwell out yet", feed(engine, makeFix(149999, 5000.0, 5.0f)).empty());
+    expectTrue("dwell out after dwellTime",
+               isOnly(feed(engine, makeFix(150000, 50000.0, 5.0f)), 1,
+                      GEOFENCE_BREACH_DWELL_OUT));
+    expectTrue("dwell out once", feed(engine, makeFix(170000, 50000.0, 5.0f)).empty());
+
+    // leaving before dwellTime: no DWELL_IN, and the exit restarts the clock
+    expectTrue("enter again", isOnly(feed(engine, makeFix(200000, 0.0, 5.0f)), 1,
+                                     GEOFENCE_BREACH_ENTER));
+    expectTrue("short stay exit", isOnly(feed(engine, makeFix(205000, 300.0, 5.0f)), 1,
+                                         GEOFENCE_BREACH_EXIT));
+    expectTrue("no dwell in after a short stay", feed(engine, makeFix(212000, 300.0, 5.0f)).empty());
+    expectTrue("dwell out after the exit", isOnly(feed(engine, makeFix(215000, 300.0, 5.0f)), 1,
+                                                  GEOFENCE_BREACH_DWELL_OUT));
+
+    // DWELL_IN alone
+    GeofenceSoftwareEngine dwellOnly;
+    addTestFence(dwellOnly, 3, GEOFENCE_BREACH_DWELL_IN_BIT, 0, 2);
+    expectTrue("silent enter", feed(dwellOnly, makeFix(1000, 0.0, 5.0f)).empty());
+    expectTrue("dwell in alone", isOnly(feed(dwellOnly, makeFix(3000, 0.0, 5.0f)), 3,
+                                        GEOFENCE_BREACH_DWELL_IN));
+    expectTrue("no dwell out without the bit",
+               feed(dwellOnly, makeFix(4000, 300.0, 5.0f)).empty() &&
+               feed(dwellOnly, makeFix(9000, 300.0, 5.0f)).empty());
+}
+
+/* ==== RESPONSIVENESS ================================================================= */
+
+static void testResponsiveness()
+{
+    GeofenceSoftwareEngine engine;
+    addTestFence(engine, 1, GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT, 5000, 0);
+    // the first look at the fence is inconclusive, the next is due 5 s later
+    expectTrue("first look", feed(engine, makeFix(10000, 95.0, 10.0f)).empty());
+    expectTrue("inside before the period", feed(engine, makeFix(11000, 0.0, 5.0f)).empty() &&
+               feed(engine, makeFix(14999, 0.0, 5.0f)).empty());
+    expectTrue("enter once the period passed",
+               isOnly(feed(engine, makeFix(15000, 0.0, 5.0f)), 1, GEOFENCE_BREACH_ENTER));
+    // an exit within the period is only seen at the next evaluation
+    expectTrue("outside before the period", feed(engine, makeFix(16000, 300.0, 5.0f)).empty());
+    expectTrue("back inside, not evaluated", feed(engine, makeFix(17000, 0.0, 5.0f)).empty());
+    expectTrue("outside at the period",
+               isOnly(feed(engine, makeFix(20000, 300.0, 5.0f)), 1, GEOFENCE_BREACH_EXIT));
+
+    // modify() takes a new period, and evaluates on the next fix
+    engine.modify(1, makeOption(GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT, 60000, 0));
+    expectTrue("evaluated after modify()",
+               isOnly(feed(engine, makeFix(21000, 0.0, 5.0f)), 1, GEOFENCE_BREACH_ENTER));
+    expectTrue("new period", feed(engine, makeFix(80999, 300.0, 5.0f)).empty());
+    expectTrue("exit at the new period",
+               isOnly(feed(engine, makeFix(81000, 300.0, 5.0f)), 1, GEOFENCE_BREACH_EXIT));
+}
+
+/* ==== PAUSE, RESUME AND REMOVE ======================================================= */
+
+static void testPauseRemove()
+{
+    GeofenceSoftwareEngine engine;
+    GeofenceBreachTypeMask mask = GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT;
+    addTestFence(engine, 1, mask, 0, 0);
+    addTestFence(engine, 2, mask, 0, 0);
+    expectTrue("two fences entered", 2 == feed(engine, makeFix(1000, 0.0, 5.0f)).size());
+    engine.pause(1);
+    expectTrue("paused fence does not exit",
+               isOnly(feed(engine, makeFix(2000, 300.0, 5.0f)), 2, GEOFENCE_BREACH_EXIT));
+    expectTrue("paused fence does not enter",
+               isOnly(feed(engine, makeFix(3000, 0.0, 5.0f)), 2, GEOFENCE_BREACH_ENTER));
+    // a paused fence starts over as outside
+    engine.resume(1);
+    expectTrue("resumed fence enters",
+               isOnly(feed(engine, makeFix(4000, 0.0, 5.0f)), 1, GEOFENCE_BREACH_ENTER));
+    engine.remove(2);
+    expectTrue("size() after remove()", 1 == engine.size());
+    expectTrue("removed fence does not exit",
+               isOnly(feed(engine, makeFix(5000, 300.0, 5.0f)), 1, GEOFENCE_BREACH_EXIT));
+    engine.clear();
+    expectTrue("cleared", 0 == engine.size() && feed(engine, makeFix(6000, 0.0, 5.0f)).empty());
+}
+
+/* ==== WALKING ACROSS A FENCE ========================================================= */
+
+static void testWalkAcross()
+{
+    // 1 Hz fixes, walking north at 1.4 m/s through the middle of the fence,
+    // 8 m accuracy, 2 s responsiveness, 30 s dwell
+    GeofenceSoftwareEngine engine;
+    addTestFence(engine, 1, GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT |
+                 GEOFENCE_BREACH_DWELL_IN_BIT | GEOFENCE_BREACH_DWELL_OUT_BIT, 2000, 30);
+    const double speed = 1.4;
+    const double accuracy = 8.0;
+    uint64_t times[GEOFENCE_BREACH_UNKNOWN] = {};
+    int counts[GEOFENCE_BREACH_UNKNOWN] = {};
+    for (uint64_t t = 0; t <= 400; t++) {
+        double north = -250.0 + speed * t;
+        for (auto& breach : feed(engine, makeFix(t * 1000, north, (float)accuracy))) {
+            times[breach.breachType] = t;
+            counts[breach.breachType]++;
+        }
+    }
+    // the fix is fully inside from -92 m on and fully outside from 108 m on,
+    // seen at most 2 s late
+    double enterAt = (250.0 - TEST_RADIUS + accuracy) / speed;
+    double exitAt = (250.0 + TEST_RADIUS + accuracy) / speed;
+    expectTrue("walk: one of each",
+               1 == counts[GEOFENCE_BREACH_ENTER] && 1 == counts[GEOFENCE_BREACH_EXIT] &&
+               1 == counts[GEOFENCE_BREACH_DWELL_IN] && 1 == counts[GEOFENCE_BREACH_DWELL_OUT]);
+    expectTrue("walk: enter within the responsiveness",
+               times[GEOFENCE_BREACH_ENTER] >= enterAt && times[GEOFENCE_BREACH_ENTER] <= enterAt + 2.0);
+    expectTrue("walk: exit within the responsiveness",
+               times[GEOFENCE_BREACH_EXIT] >= exitAt && times[GEOFENCE_BREACH_EXIT] <= exitAt + 2.0);
+    expectTrue("walk: dwell in 30 s after enter",
+               times[GEOFENCE_BREACH_DWELL_IN] == times[GEOFENCE_BREACH_ENTER] + 30);
+    expectTrue("walk: dwell out 30 s after exit",
+               times[GEOFENCE_BREACH_DWELL_OUT] == times[GEOFENCE_BREACH_EXIT] + 30);
+}
+
+/* ==== RANDOM WALK AGAINST A REFERENCE ================================================ */
+
+// the engine semantics with responsiveness 0, looking at every fence on
+// every fix
+typedef struct {
+    double latitude;
+    double longitude;
+    double radius;
+    GeofenceBreachTypeMask mask;
+    uint64_t dwellTime;
+    bool inside;
+    bool dwelling;
+    uint64_t transitionTime;
+} RefFence;
+
+static void refProcess(std::vector<RefFence>& fences, const Location& location,
+                       std::vector<Breach>& breaches)
+{
+    uint64_t now = location.timestamp;
+    for (uint32_t i = 0; i < fences.size(); i++) {
+        RefFence& fence = fences[i];
+        uint32_t hwId = i + 1;
+        double distance = loc_geo_distance(location.latitude, location.longitude,
+                                           fence.latitude, fence.longitude);
+        if (!fence.inside && distance + location.accuracy <= fence.radius) {
+            fence.inside = true;
+            fence.dwelling = true;
+            fence.transitionTime = now;
+            if (fence.mask & GEOFENCE_BREACH_ENTER_BIT) {
+                breaches.push_back({hwId, GEOFENCE_BREACH_ENTER});
+            }
+        } else if (fence.inside && distance - location.accuracy > fence.radius) {
+            fence.inside = false;
+            fence.dwelling = (0 != (fence.mask & GEOFENCE_BREACH_DWELL_OUT_BIT));
+            fence.transitionTime = now;
+            if (fence.mask & GEOFENCE_BREACH_EXIT_BIT) {
+                breaches.push_back({hwId, GEOFENCE_BREACH_EXIT});
+            }
+        }
+        if (fence.dwelling && now >= fence.transitionTime + fence.dwellTime) {
+            fence.dwelling = false;
+            if (fence.inside && (fence.mask & GEOFENCE_BREACH_DWELL_IN_BIT)) {
+                breaches.push_back({hwId, GEOFENCE_BREACH_DWELL_IN});
+            } else if (!fence.inside) {
+                breaches.push_back({hwId, GEOFENCE_BREACH_DWELL_OUT});
+            }
+        }
+    }
+}
+
+static bool breachLess(const Breach& a, const Breach& b)
+{
+    return (a.hwId != b.hwId) ? (a.hwId < b.hwId) : (a.breachType < b.breachType);
+}
+
+static void testRandomWalk()
+{
+    GeofenceSoftwareEngine engine;
+    std::vector<RefFence> fences(TEST_WALK_FENCES);
+    for (uint32_t i = 0; i < fences.size(); i++) {
+        RefFence& fence = fences[i];
+        fence.latitude = TEST_LATITUDE + nextRandom(-0.02, 0.02);
+        fence.longitude = TEST_LONGITUDE + nextRandom(-0.03, 0.03);
+        fence.radius = nextRandom(30.0, 600.0);
+        fence.mask = (GeofenceBreachTypeMask)(1 + (uint32_t)nextRandom(0.0, 15.0));
+        fence.dwellTime = (uint64_t)nextRandom(0.0, 120.0) * 1000;
+        fence.inside = false;
+        fence.dwelling = false;
+        engine.add(i + 1, makeOption(fence.mask, 0, fence.dwellTime / 1000),
+                   makeInfo(fence.latitude, fence.longitude, fence.radius));
+    }
+
+    double latitude = TEST_LATITUDE;
+    double longitude = TEST_LONGITUDE;
+    bool agree = true;
+    size_t total = 0;
+    for (int fix = 0; fix < TEST_WALK_FIXES && agree; fix++) {
+        // a vehicle at up to 20 m/s, turning at random, kept in the area
+        latitude += nextRandom(-0.00018, 0.00018);
+        longitude += nextRandom(-0.00025, 0.00025);
+        latitude = std::max(TEST_LATITUDE - 0.025, std::min(TEST_LATITUDE + 0.025, latitude));
+        longitude = std::max(TEST_LONGITUDE - 0.035, std::min(TEST_LONGITUDE + 0.035, longitude));
+        Location location = makeFix(1000000 + fix * 1000ULL, 0.0, (float)nextRandom(3.0, 50.0));
+        location.latitude = latitude;
+        location.longitude = longitude;
+
+        std::vector<Breach> expected, breaches;
+        refProcess(fences, location, expected);
+        engine.process(location, breaches);
+        std::sort(expected.begin(), expected.end(), breachLess);
+        std::sort(breaches.begin(), breaches.end(), breachLess);
+        agree = (expected.size() == breaches.size());
+        for (size_t i = 0; agree && i < expected.size(); i++) {
+            agree = (expected[i].hwId == breaches[i].hwId &&
+                     expected[i].breachType == breaches[i].breachType);
+        }
+        total += expected.size();
+    }
+    expectTrue("random walk agrees with evaluating every fence", agree);
+    expectTrue("random walk breaches fences", total > 1000);
+}
+
+int main()
+{
+    testEnterExit();
+    testDwell();
+    testResponsiveness();
+    testPauseRemove();
+    testWalkAcross();
+    testRandomWalk();
+    return testResult();
+}
@@ -0,0 +1,189 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <GeofenceSpatialIndex.h>
+#include <loc_geo.h>
+#include <loc_test_util.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+// Times GeofenceSpatialIndex on a fleet style fence set: fences of 100 m to
+// 2 km spread over a metro area of about 1 x 1 degree, one in a hundred of
+// up to 20 km, and a few regional fences on the large fence list. For 10k,
+// 20k and 50k fences it prints the cost of adding a fence, the mean and
+// worst query time for "which fences contain this point" and for "which are
+// within 1 km of it", the mean number of fences found, and the time of a
+// brute force haversine scan over all fences for comparison.
+//
+// usage: geofence_index_bench [-q queries] [-f fences]
+//   -q  queries per case, 20000 by default
+//   -f  run only this number of fences
+
+#define BENCH_NEAR_MARGIN_M     1000.0
+#define BENCH_LARGE_FENCES      20
+
+typedef struct {
+    double latitude;
+    double longitude;
+    double radius;
+} BenchFence;
+
+// keeps the compiler from dropping what is computed
+static volatile size_t sSink;
+
+static uint32_t sSeed = 1;
+static double nextRandom(double from, double to)
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return from + (to - from) * ((sSeed >> 8) & 0xFFFFFF) / 16777216.0;
+}
+
+static std::vector<BenchFence> makeFences(int count)
+{
+    std::vector<BenchFence> fences(count);
+    for (int i = 0; i < count; i++) {
+        BenchFence& fence = fences[i];
+        fence.latitude = nextRandom(37.0, 38.0);
+        fence.longitude = nextRandom(-122.5, -121.5);
+        if (i < BENCH_LARGE_FENCES) {
+            fence.radius = nextRandom(100000.0, 300000.0);
+        } else if (0 == i % 100) {
+            fence.radius = nextRandom(2000.0, 20000.0);
+        } else {
+            fence.radius = nextRandom(100.0, 2000.0);
+        }
+    }
+    return fences;
+}
+
+typedef struct {
+    double meanUs;
+    double worstUs;
+    double found;
+} QueryResult;
+
+static QueryResult timeQueries(const GeofenceSpatialIndex& index, double margin,
+                               const std::vector<double>& lats, const std::vector<double>& lons)
+{
+    QueryResult result = {0.0, 0.0, 0.0};
+    std::vector<uint32_t> hwIds;
+    uint64_t totalNs = 0, worstNs = 0;
+    size_t found = 0;
+    for (size_t q = 0; q < lats.size(); q++) {
+        hwIds.clear();
+        uint64_t startNs = threadCpuNs();
+        index.query(lats[q], lons[q], margin, hwIds);
+        uint64_t ns = threadCpuNs() - startNs;
+        totalNs += ns;
+        worstNs = (ns > worstNs) ? ns : worstNs;
+        found += hwIds.size();
+    }
+    result.meanUs = totalNs / 1000.0 / lats.size();
+    result.worstUs = worstNs / 1000.0;
+    result.found = (double)found / lats.size();
+    return result;
+}
+
+static double timeScan(const std::vector<BenchFence>& fences, const std::vector<double>& lats,
+                       const std::vector<double>& lons, size_t queries)
+{
+    size_t found = 0;
+    uint64_t startNs = threadCpuNs();
+    for (size_t q = 0; q < queries; q++) {
+        for (auto& fence : fences) {
+            found += (loc_geo_distance(lats[q], lons[q], fence.latitude, fence.longitude) <=
+                      fence.radius);
+        }
+    }
+    sSink = found;
+    return (threadCpuNs() - startNs) / 1000.0 / queries;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-q queries] [-f fences]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    int queries = 20000;
+    int onlyFences = 0;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "q:f:"))) {
+        switch (opt) {
+        case 'q':
+            queries = atoi(optarg);
+            break;
+        case 'f':
+            onlyFences = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (queries <= 0 || onlyFences < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<double> lats(queries), lons(queries);
+    for (int q = 0; q < queries; q++) {
+        lats[q] = nextRandom(37.0, 38.0);
+        lons[q] = nextRandom(-122.5, -121.5);
+    }
+
+    printf("%-7s %8s %9s %9s %7s %9s %9s %7s %9s\n", "fences", "add ns",
+           "in us", "worst us", "found", "near us", "worst us", "found", "scan us");
+    static const int fenceCounts[] = {10000, 20000, 50000};
+    for (int count : fenceCounts) {
+        if (0 != onlyFences) {
+            if (count != fenceCounts[0]) {
+                break;
+            }
+            count = onlyFences;
+        }
+        std::vector<BenchFence> fences = makeFences(count);
+        GeofenceSpatialIndex index;
+        uint64_t startNs = threadCpuNs();
+        for (int i = 0; i < count; i++) {
+            index.add(i + 1, fences[i].latitude, fences[i].longitude, fences[i].radius);
+        }
+        double addNs = (double)(threadCpuNs() - startNs) / count;
+        QueryResult in = timeQueries(index, 0.0, lats, lons);
+        QueryResult near = timeQueries(index, BENCH_NEAR_MARGIN_M, lats, lons);
+        // the scan is slow; a few hundred points are enough
+        double scanUs = timeScan(fences, lats, lons, (queries < 200) ? queries : 200);
+        printf("%-7d %8.0f %9.2f %9.1f %7.1f %9.2f %9.1f %7.1f %9.1f\n", count, addNs,
+               in.meanUs, in.worstUs, in.found, near.meanUs, near.worstUs, near.found, scanUs);
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <GeofenceSpatialIndex.h>
+#include <loc_geo.h>
+#include <loc_test_util.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+// Checks GeofenceSpatialIndex::query() against a brute force haversine scan
+// of all the fences: random fences and points, fences spanning several cells
+// and points on cell borders, fences and points on both sides of the
+// +/-180 degree seam, fences near the poles and large enough for the large
+// fence list, and the index after fences are moved and removed. The exit
+// status is the number of failed checks.
+//
+// usage: geofence_index_test
+
+#define TEST_QUERIES    2000
+
+typedef struct {
+    double latitude;
+    double longitude;
+    double radius;
+} TestFence;
+
+typedef std::unordered_map<uint32_t, TestFence> TestFences;
+
+static uint32_t sSeed = 1;
+static double nextRandom(double from, double to)
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return from + (to - from) * ((sSeed >> 8) & 0xFFFFFF) / 16777216.0;
+}
+
+static std::vector<uint32_t> bruteForce(const TestFences& fences, double latitude,
+                                        double longitude, double margin)
+{
+    std::vector<uint32_t> hwIds;
+    for (auto& fence : fences) {
+        if (loc_geo_distance(latitude, longitude, fence.second.latitude,
+                             fence.second.longitude) <= fence.second.radius + margin) {
+            hwIds.push_back(fence.first);
+        }
+    }
+    std::sort(hwIds.begin(), hwIds.end());
+    return hwIds;
+}
+
+// the index and the scan agree at the point; also false if the index
+// reports a fence twice
+static bool agrees(const GeofenceSpatialIndex& index, const TestFences& fences,
+                   double latitude, double longitude, double margin)
+{
+    std::vector<uint32_t> hwIds;
+    index.query(latitude, longitude, margin, hwIds);
+    std::sort(hwIds.begin(), hwIds.end());
+    return hwIds == bruteForce(fences, latitude, longitude, margin);
+}
+
+static void addFence(GeofenceSpatialIndex& index, TestFences& fences, uint32_t hwId,
+                     double latitude, double longitude, double radius)
+{
+    index.add(hwId, latitude, longitude, radius);
+    fences[hwId] = {latitude, longitude, radius};
+}
+
+// random points near (*latitude*, *longitude*), within *spread* degrees,
+// with and without a margin
+static bool agreesAround(const GeofenceSpatialIndex& index, const TestFences& fences,
+                         double latitude, double longitude, double spread)
+{
+    bool agree = true;
+    for (int q = 0; q < TEST_QUERIES && agree; q++) {
+        double lat = std::max(-90.0, std::min(90.0,
+                latitude + nextRandom(-spread, spread)));
+        double lon = longitude + nextRandom(-spread, spread);
+        lon = (lon > 180.0) ? lon - 360.0 : ((lon < -180.0) ? lon + 360.0 : lon);
+        double margin = (q & 1) ? 0.0 : nextRandom(0.0, 3000.0);
+        agree = agrees(index, fences, lat, lon, margin);
+    }
+    return agree;
+}
+
+/* ==== RANDOM FENCES ================================================================== */
+
+static void testRandomFences()
+{
+    GeofenceSpatialIndex index;
+    TestFences fences;
+    // a metro area: many small fences, some spanning several cells
+    for (uint32_t hwId = 1; hwId <= 5000; hwId++) {
+        addFence(index, fences, hwId, 37.3 + nextRandom(0.0, 0.5),
+                 -122.2 + nextRandom(0.0, 0.5),
+                 (hwId % 10) ? nextRandom(50.0, 500.0) : nextRandom(500.0, 10000.0));
+    }
+    expectTrue("size()", 5000 == index.size());
+    expectTrue("random points in a metro area", agreesAround(index, fences, 37.55, -121.95, 0.3));
+}
+
+/* ==== CELL BORDERS =================================================================== */
+
+static void testCellBorders()
+{
+    GeofenceSpatialIndex index;
+    TestFences fences;
+    const double cell = GeofenceSpatialIndex::CELL_DEG;
+    // fences centered on cell corners and edges, with radii around the
+    // cell size, and points on the borders of the cells around them
+    uint32_t hwId = 1;
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            double lat = 48.0 + row * cell;
+            double lon = 11.0 + col * cell;
+            addFence(index, fences, hwId++, lat, lon, 100.0 + 300.0 * ((row + col) % 8));
+            addFence(index, fences, hwId++, lat + cell / 2.0, lon, 900.0);
+            addFence(index, fences, hwId++, lat, lon + cell / 2.0, 1.0);
+        }
+    }
+    bool agree = true;
+    for (int row = -2; row < 10 && agree; row++) {
+        for (int col = -2; col < 10 && agree; col++) {
+            double lat = 48.0 + row * cell;
+            double lon = 11.0 + col * cell;
+            agree = agrees(index, fences, lat, lon, 0.0) &&
+                    agrees(index, fences, lat, lon, 500.0) &&
+                    agrees(index, fences, lat + cell / 2.0, lon, 0.0) &&
+                    agrees(index, fences, lat, lon + cell / 2.0, 0.0) &&
+                    agrees(index, fences, nextafter(lat, 0.0), nextafter(lon, 0.0), 0.0);
+        }
+    }
+    expectTrue("points on cell borders", agree);
+    expectTrue("random points around cell borders",
+               agreesAround(index, fences, 48.0 + 4 * cell, 11.0 + 4 * cell, 8 * cell));
+}
+
+/* ==== THE +/-180 DEGREE SEAM ========================================================= */
+
+static void testSeam()
+{
+    GeofenceSpatialIndex index;
+    TestFences fences;
+    // fences on both sides of the seam and on it, some reaching across it
+    for (uint32_t hwId = 1; hwId <= 2000; hwId++) {
+        double lon = nextRandom(-0.2, 0.2);
+        lon = (lon < 0.0) ? lon + 180.0 : lon - 180.0;
+        addFence(index, fences, hwId, -17.0 + nextRandom(-0.2, 0.2), lon,
+                 nextRandom(50.0, 5000.0));
+    }
+    addFence(index, fences, 2001, -17.0, 180.0, 2000.0);
+    addFence(index, fences, 2002, -17.0, -180.0, 2000.0);
+    expectTrue("points on the seam",
+               agrees(index, fences, -17.0, 180.0, 0.0) &&
+               agrees(index, fences, -17.0, -180.0, 0.0) &&
+               agrees(index, fences, -17.0, 179.999, 1000.0) &&
+               agrees(index, fences, -17.0, -179.999, 1000.0));
+    expectTrue("random points around the seam", agreesAround(index, fences, -17.0, 180.0, 0.25));
+}
+
+/* ==== LARGE FENCES =================================================================== */
+
+static void testLargeFences()
+{
+    GeofenceSpatialIndex index;
+    TestFences fences;
+    uint32_t hwId = 1;
+    // too many cells for the grid
+    addFence(index, fences, hwId++, 10.0, 20.0, 200000.0);
+    addFence(index, fences, hwId++, -45.0, 170.0, 3000000.0);
+    // reaching a pole
+    addFence(index, fences, hwId++, 89.99, 0.0, 5000.0);
+    addFence(index, fences, hwId++, -89.5, 120.0, 80000.0);
+    // near a pole, where the cells are narrow
+    addFence(index, fences, hwId++, 85.0, 45.0, 1000.0);
+    for (; hwId <= 1000; hwId++) {
+        addFence(index, fences, hwId, nextRandom(9.0, 11.0), nextRandom(19.0, 21.0),
+                 nextRandom(50.0, 2000.0));
+    }
+    expectTrue("points in and around a large fence",
+               agreesAround(index, fences, 10.0, 20.0, 2.5));
+    expectTrue("points near the north pole",
+               agrees(index, fences, 90.0, 0.0, 0.0) &&
+               agrees(index, fences, 89.995, -170.0, 0.0) &&
+               agreesAround(index, fences, 85.0, 45.0, 0.1));
+    expectTrue("points near the south pole", agreesAround(index, fences, -89.5, 120.0, 1.0));
+    expectTrue("points in a fence across the seam",
+               agreesAround(index, fences, -45.0, 180.0, 20.0));
+    // a query wide enough to fall back to a scan
+    expectTrue("wide query", agrees(index, fences, 10.0, 20.0, 500000.0));
+}
+
+/* ==== MOVE AND REMOVE ================================================================ */
+
+static void testMoveAndRemove()
+{
+    GeofenceSpatialIndex index;
+    TestFences fences;
+    for (uint32_t hwId = 1; hwId <= 3000; hwId++) {
+        addFence(index, fences, hwId, 51.4 + nextRandom(0.0, 0.2), nextRandom(-0.2, 0.0),
+                 (hwId % 50) ? nextRandom(50.0, 1500.0) : 300000.0);
+    }
+    // move every third, with a new radius, and remove every fifth
+    for (uint32_t hwId = 1; hwId <= 3000; hwId++) {
+        if (0 == hwId % 5) {
+            index.remove(hwId);
+            fences.erase(hwId);
+        } else if (0 == hwId % 3) {
+            addFence(index, fences, hwId, 51.4 + nextRandom(0.0, 0.2), nextRandom(-0.2, 0.0),
+                     (hwId % 2) ? nextRandom(50.0, 1500.0) : 400000.0);
+        }
+    }
+    index.remove(5);
+    index.remove(100000);
+    expectTrue("size() after move and remove", fences.size() == index.size());
+    expectTrue("points after move and remove", agreesAround(index, fences, 51.5, -0.1, 0.15));
+    index.clear();
+    std::vector<uint32_t> hwIds;
+    index.query(51.5, -0.1, 100000.0, hwIds);
+    expectTrue("clear()", 0 == index.size() && hwIds.empty());
+}
+
+int main()
+{
+    testRandomFences();
+    testCellBorders();
+    testSeam();
+    testLargeFences();
+    testMoveAndRemove();
+    return testResult();
+}
@@ -0,0 +1,476 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <GeofenceSnapshot.h>
+#include <loc_test_util.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+
+// Runs GeofenceSnapshot against files in a temporary directory: the round
+// trip through close and open, the append log as a process that dies without
+// closing leaves it, compaction of a log of mostly dead records and of a
+// shrinking snapshot, and files with a tail cut short or overwritten. The
+// exit status is the number of failed checks.
+//
+// usage: geofence_snapshot_test
+
+#define TEST_FENCES         200
+#define TEST_UPDATES        5000
+#define TEST_MIN_CAPACITY   64
+
+typedef GeofenceSnapshot::Geofence Geofence;
+typedef GeofenceSnapshot::GeofenceMap GeofenceMap;
+
+// the on-disk header of GeofenceSnapshot
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t count;
+    uint32_t reserved;
+} SnapshotHeader;
+
+static std::string sDir;
+
+static uint32_t sSeed = 1;
+static uint32_t nextRandom(uint32_t limit)
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return ((sSeed >> 8) & 0xFFFFFF) % limit;
+}
+
+static Geofence makeGeofence()
+{
+    Geofence geofence;
+    memset(&geofence, 0, sizeof(geofence));
+    geofence.clientId = nextRandom(100000);
+    geofence.breachMask = (GeofenceBreachTypeMask)(1 + nextRandom(15));
+    geofence.responsiveness = nextRandom(60000);
+    geofence.dwellTime = nextRandom(600);
+    geofence.latitude = -90.0 + nextRandom(1800000) / 10000.0;
+    geofence.longitude = -180.0 + nextRandom(3600000) / 10000.0;
+    geofence.radius = 50.0 + nextRandom(10000);
+    geofence.paused = (0 == nextRandom(4));
+    return geofence;
+}
+
+static bool sameGeofences(const GeofenceMap& got, const GeofenceMap& expected)
+{
+    if (got.size() != expected.size()) {
+        return false;
+    }
+    for (auto it = got.begin(), ref = expected.begin(); it != got.end(); ++it, ++ref) {
+        const Geofence& a = it->second;
+        const Geofence& b = ref->second;
+        if (it->first != ref->first || a.clientId != b.clientId ||
+                a.breachMask != b.breachMask || a.responsiveness != b.responsiveness ||
+                a.dwellTime != b.dwellTime || a.latitude != b.latitude ||
+                a.longitude != b.longitude || a.radius != b.radius || a.paused != b.paused) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string testPath(const char* name)
+{
+    return sDir + "/" + name;
+}
+
+static off_t fileSize(const std::string& path)
+{
+    struct stat st;
+    return (0 == stat(path.c_str(), &st)) ? st.st_size : -1;
+}
+
+static bool fileExists(const std::string& path)
+{
+    return fileSize(path) >= 0;
+}
+
+static SnapshotHeader readHeader(const std::string& path)
+{
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        if (sizeof(header) != pread(fd, &header, sizeof(header), 0)) {
+            memset(&header, 0, sizeof(header));
+        }
+        close(fd);
+    }
+    return header;
+}
+
+static void writeAt(const std::string& path, off_t offset, const void* data, size_t length)
+{
+    int fd = open(path.c_str(), O_WRONLY);
+    if (fd < 0 || (ssize_t)length != pwrite(fd, data, length, offset)) {
+        printf("FAIL writing %s\n", path.c_str());
+        testFailures()++;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+// what is on disk right now, as a process that dies at this point leaves it
+static void copyFile(const std::string& from, const std::string& to)
+{
+    char buffer[4096];
+    int in = open(from.c_str(), O_RDONLY);
+    int out = open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    ssize_t n = 0;
+    while (in >= 0 && out >= 0 && (n = read(in, buffer, sizeof(buffer))) > 0) {
+        if (n != write(out, buffer, n)) {
+            n = -1;
+            break;
+        }
+    }
+    if (in < 0 || out < 0 || n < 0) {
+        printf("FAIL copying %s\n", from.c_str());
+        testFailures()++;
+    }
+    if (in >= 0) {
+        close(in);
+    }
+    if (out >= 0) {
+        close(out);
+    }
+}
+
+static bool loads(const std::string& path, const GeofenceMap& expected)
+{
+    GeofenceSnapshot snapshot;
+    return snapshot.open(path.c_str()) && sameGeofences(snapshot.getGeofences(), expected);
+}
+
+// puts TEST_FENCES geofences, then updates a random one TEST_UPDATES times
+static void fill(GeofenceSnapshot& snapshot, GeofenceMap& reference, uint32_t updates)
+{
+    for (uint32_t hwId = 1; hwId <= TEST_FENCES; hwId++) {
+        reference[hwId] = makeGeofence();
+        snapshot.put(hwId, reference[hwId]);
+    }
+    for (uint32_t i = 0; i < updates; i++) {
+        uint32_t hwId = 1 + nextRandom(TEST_FENCES);
+        if (0 == nextRandom(3)) {
+            reference.erase(hwId);
+            snapshot.remove(hwId);
+        } else {
+            reference[hwId] = makeGeofence();
+            snapshot.put(hwId, reference[hwId]);
+        }
+    }
+}
+
+/* ==== ROUND TRIP ===================================================================== */
+
+static void testRoundTrip()
+{
+    std::string path = testPath("round_trip");
+    GeofenceMap reference;
+    GeofenceSnapshot snapshot;
+    expectTrue("round trip opens a new file", snapshot.open(path.c_str()));
+    expectTrue("round trip new file is empty", snapshot.getGeofences().empty());
+    fill(snapshot, reference, 300);
+    expectTrue("round trip holds what was put", sameGeofences(snapshot.getGeofences(), reference));
+    snapshot.close();
+    expectTrue("round trip closed", !snapshot.isOpen() && snapshot.getGeofences().empty());
+
+    expectTrue("round trip reopens", snapshot.open(path.c_str()));
+    expectTrue("round trip loads what was put",
+               sameGeofences(snapshot.getGeofences(), reference));
+    reference.erase(reference.begin());
+    snapshot.remove(1);
+    reference.erase(1);
+    snapshot.remove(reference.begin()->first);
+    reference.erase(reference.begin());
+    snapshot.put(TEST_FENCES + 1, reference[TEST_FENCES + 1] = makeGeofence());
+    snapshot.close();
+    expectTrue("round trip loads the updates after reopening", loads(path, reference));
+
+    snapshot.open(path.c_str());
+    snapshot.clear();
+    expectTrue("round trip clear empties the snapshot", snapshot.getGeofences().empty());
+    snapshot.close();
+    expectTrue("round trip loads nothing after clear", loads(path, GeofenceMap()));
+    expectTrue("round trip leaves no temporary file", !fileExists(path + ".tmp"));
+}
+
+/* ==== APPEND LOG ===================================================================== */
+
+static void testAppendLog()
+{
+    std::string path = testPath("append_log");
+    std::string image = testPath("append_log.image");
+    GeofenceMap reference;
+    GeofenceSnapshot snapshot;
+    snapshot.open(path.c_str());
+    fill(snapshot, reference, 100);
+    snapshot.close();
+
+    // an open log holds just the live geofences, then one record per update
+    snapshot.open(path.c_str());
+    SnapshotHeader header = readHeader(path);
+    expectTrue("append log starts from the live geofences", header.count == reference.size());
+    bool oneRecordEach = true;
+    for (uint32_t i = 0; i < 40; i++) {
+        uint32_t count = readHeader(path).count;
+        uint32_t hwId = 1 + nextRandom(TEST_FENCES);
+        bool known = (reference.end() != reference.find(hwId));
+        if (0 == i % 2) {
+            reference[hwId] = makeGeofence();
+            snapshot.put(hwId, reference[hwId]);
+            oneRecordEach = oneRecordEach && (readHeader(path).count == count + 1);
+        } else {
+            reference.erase(hwId);
+            snapshot.remove(hwId);
+            oneRecordEach = oneRecordEach && (readHeader(path).count == count + (known ? 1 : 0));
+        }
+    }
+    expectTrue("append log takes one record per update, none for unknown removes",
+               oneRecordEach);
+
+    // the log is on disk without a close
+    copyFile(path, image);
+    expectTrue("append log loads from a file never closed", loads(image, reference));
+    header = readHeader(image);
+    expectTrue("append log image is compacted once loaded", header.count == reference.size());
+    expectTrue("append log image loads again", loads(image, reference));
+}
+
+/* ==== COMPACTION ===================================================================== */
+
+static void testCompaction()
+{
+    std::string path = testPath("compaction");
+    std::string image = testPath("compaction.image");
+    GeofenceMap reference;
+    GeofenceSnapshot snapshot;
+    snapshot.open(path.c_str());
+    SnapshotHeader header = readHeader(path);
+    off_t recordSize = header.recordSize;
+    expectTrue("compaction header is valid", recordSize > 0);
+
+    // few live geofences updated over and over: the log never grows
+    bool bounded = true;
+    bool imagesLoad = true;
+    for (uint32_t i = 0; i < TEST_UPDATES; i++) {
+        uint32_t hwId = 1 + nextRandom(8);
+        if (0 == nextRandom(4)) {
+            reference.erase(hwId);
+            snapshot.remove(hwId);
+        } else {
+            reference[hwId] = makeGeofence();
+            snapshot.put(hwId, reference[hwId]);
+        }
+        bounded = bounded && (fileSize(path) ==
+                              (off_t)sizeof(SnapshotHeader) + TEST_MIN_CAPACITY * recordSize);
+        if (0 == i % 97) {
+            copyFile(path, image);
+            imagesLoad = imagesLoad && loads(image, reference);
+        }
+    }
+    expectTrue("compaction keeps a log of dead records at the minimum size", bounded);
+    expectTrue("compaction images load along the way", imagesLoad);
+    expectTrue("compaction keeps the geofences", sameGeofences(snapshot.getGeofences(), reference));
+    expectTrue("compaction leaves no temporary file", !fileExists(path + ".tmp"));
+
+    // many live geofences grow the file, removing most of them shrinks it
+    fill(snapshot, reference, TEST_UPDATES);
+    off_t grown = fileSize(path);
+    expectTrue("compaction grows the file for the live geofences",
+               grown >= (off_t)(sizeof(SnapshotHeader) + reference.size() * recordSize));
+    copyFile(path, image);
+    expectTrue("compaction grown image loads", loads(image, reference));
+    for (uint32_t hwId = 1; hwId <= TEST_FENCES; hwId++) {
+        if (hwId > 4) {
+            reference.erase(hwId);
+            snapshot.remove(hwId);
+        }
+    }
+    // the removes filled the log, so the next updates compact it
+    for (uint32_t i = 0; i < 2 * TEST_FENCES; i++) {
+        reference[1] = makeGeofence();
+        snapshot.put(1, reference[1]);
+    }
+    expectTrue("compaction shrinks the file", fileSize(path) < grown);
+    expectTrue("compaction shrunk log holds the live geofences",
+               readHeader(path).count < 2 * TEST_FENCES);
+    copyFile(path, image);
+    expectTrue("compaction shrunk image loads", loads(image, reference));
+    snapshot.close();
+    expectTrue("compaction loads after close", loads(path, reference));
+}
+
+/* ==== DAMAGED FILES ================================================================== */
+
+static void testTruncatedTail()
+{
+    std::string path = testPath("truncated");
+    std::string image = testPath("truncated.image");
+    GeofenceMap reference;
+    GeofenceSnapshot snapshot;
+    snapshot.open(path.c_str());
+    fill(snapshot, reference, 100);
+    snapshot.close();
+    snapshot.open(path.c_str());
+
+    // the last updates put new geofences, so what a cut keeps is known
+    GeofenceMap kept = reference;
+    for (uint32_t hwId = TEST_FENCES + 1; hwId <= TEST_FENCES + 3; hwId++) {
+        reference[hwId] = makeGeofence();
+        snapshot.put(hwId, reference[hwId]);
+    }
+    SnapshotHeader header = readHeader(path);
+    off_t end = sizeof(SnapshotHeader) + (off_t)header.count * header.recordSize;
+
+    copyFile(path, image);
+    expectTrue("truncated copy with the whole log loads", loads(image, reference));
+
+    // cut inside the last record
+    copyFile(path, image);
+    expectTrue("truncated cut in the last record", 0 == truncate(image.c_str(),
+                                                               end - header.recordSize / 2));
+    GeofenceMap expected = kept;
+    expected[TEST_FENCES + 1] = reference[TEST_FENCES + 1];
+    expected[TEST_FENCES + 2] = reference[TEST_FENCES + 2];
+    expectTrue("truncated keeps the whole records before a cut record", loads(image, expected));
+    expectTrue("truncated is repaired once loaded",
+               readHeader(image).count == expected.size() && loads(image, expected));
+
+    // cut at a record boundary, three records short
+    copyFile(path, image);
+    truncate(image.c_str(), end - 3 * header.recordSize);
+    expectTrue("truncated keeps the records before the cut", loads(image, kept));
+
+    // cut inside the header: nothing to keep, but the file works again
+    copyFile(path, image);
+    truncate(image.c_str(), sizeof(SnapshotHeader) / 2);
+    expectTrue("truncated header starts over", loads(image, GeofenceMap()));
+    GeofenceSnapshot again;
+    again.open(image.c_str());
+    again.put(7, kept.begin()->second);
+    again.close();
+    GeofenceMap one;
+    one[7] = kept.begin()->second;
+    expectTrue("truncated header file works again", loads(image, one));
+}
+
+static void testCorruptTail()
+{
+    std::string path = testPath("corrupt");
+    std::string image = testPath("corrupt.image");
+    GeofenceMap reference;
+    GeofenceSnapshot snapshot;
+    snapshot.open(path.c_str());
+    fill(snapshot, reference, 100);
+    snapshot.close();
+    snapshot.open(path.c_str());
+    // the last update changes a geofence, so that skipping it keeps the old one
+    GeofenceMap kept = reference;
+    uint32_t last = reference.begin()->first;
+    reference[last] = makeGeofence();
+    snapshot.put(last, reference[last]);
+    SnapshotHeader header = readHeader(path);
+    off_t end = sizeof(SnapshotHeader) + (off_t)header.count * header.recordSize;
+
+    // garbage past the last record, as an update that never got published
+    copyFile(path, image);
+    char garbage[256];
+    memset(garbage, 0xA5, sizeof(garbage));
+    off_t spare = fileSize(image) - end;
+    writeAt(image, end, garbage, (size_t)spare < sizeof(garbage) ? spare : sizeof(garbage));
+    expectTrue("corrupt garbage after the log is ignored", loads(image, reference));
+
+    // the last record overwritten with an unknown operation
+    copyFile(path, image);
+    uint32_t op = 0xDEADBEEF;
+    writeAt(image, end - header.recordSize, &op, sizeof(op));
+    expectTrue("corrupt last record is skipped", loads(image, kept));
+
+    // a count past the end of the file
+    copyFile(path, image);
+    uint32_t count = 0xFFFFFFFF;
+    writeAt(image, offsetof(SnapshotHeader, count), &count, sizeof(count));
+    expectTrue("corrupt count loads the records in the file", loads(image, reference));
+
+    // a header that is not a snapshot starts over
+    copyFile(path, image);
+    uint32_t magic = 0;
+    writeAt(image, offsetof(SnapshotHeader, magic), &magic, sizeof(magic));
+    expectTrue("corrupt magic starts over", loads(image, GeofenceMap()));
+    copyFile(path, image);
+    uint16_t recordSize = header.recordSize + 8;
+    writeAt(image, offsetof(SnapshotHeader, recordSize), &recordSize, sizeof(recordSize));
+    expectTrue("corrupt record size starts over", loads(image, GeofenceMap()));
+
+    // a temporary file left by a compaction that died is not loaded
+    copyFile(path, image);
+    copyFile(path, image + ".tmp");
+    writeAt(image + ".tmp", offsetof(SnapshotHeader, magic), &magic, sizeof(magic));
+    expectTrue("corrupt leftover temporary file is ignored", loads(image, reference));
+    unlink((image + ".tmp").c_str());
+}
+
+int main()
+{
+    const char* tmp = getenv("TMPDIR");
+    std::string pattern = std::string((NULL != tmp) ? tmp : "/tmp") +
+                          "/geofence_snapshot_test.XXXXXX";
+    char* dir = mkdtemp(&pattern[0]);
+    if (NULL == dir) {
+        printf("FAIL creating a temporary directory\n");
+        return 1;
+    }
+    sDir = dir;
+
+    testRoundTrip();
+    testAppendLog();
+    testCompaction();
+    testTruncatedTail();
+    testCorruptTail();
+
+    static const char* const files[] = {"round_trip", "append_log", "append_log.image",
+                                        "compaction", "compaction.image", "truncated",
+                                        "truncated.image", "corrupt", "corrupt.image"};
+    for (auto file : files) {
+        unlink(testPath(file).c_str());
+        unlink((testPath(file) + ".tmp").c_str());
+    }
+    rmdir(sDir.c_str());
+    return testResult();
+}
@@ -23,6 +23,10 @@ LOCAL_SHARED_LIBRARIES := \
 LOCAL_SRC_FILES += \
     location_gnss.cpp \
     GnssAdapter.cpp \
+    StationaryDetector.cpp \
+    PositionPropagator.cpp \
+    LocationReport.cpp \
+    NmeaPipeline.cpp \
     Agps.cpp \
     XtraSystemStatusObserver.cpp
 
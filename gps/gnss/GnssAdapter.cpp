@@ -41,8 +41,10 @@
 #include <GnssAdapter.h>
 #include <string>
 #include <sstream>
+#include <algorithm>
 #include <loc_log.h>
 #include <loc_nmea.h>
+#include <loc_geo.h>
 #include <Agps.h>
 #include <SystemStatus.h>
 
@@ -69,11 +71,26 @@ GnssAdapter::GnssAdapter() :
                                                    LocContext::mLocationHalName,
                                                    false), true, nullptr),
     mEngHubProxy(new EngineHubProxyBase()),
+    mEngineTrackingOptions(),
+    mTrackingReconfigureTimer(this),
+    mTrackingReconfigurePending(false),
+    mStationaryTrackingInterval(0),
+    mStationaryTrackingPowerMode(GNSS_POWER_MODE_INVALID),
+    mStationaryDetector(),
+    mTrackingHoldTimer(this),
+    mHeldLocationInfo(),
+    mHeldHasLocationInfo(false),
+    mHeldLocationUptimeMs(0),
+    mHeldReportToFlpClient(false),
+    mPositionPropagator(),
     mLocPositionMode(),
     mGnssSvIdUsedInPosition(),
     mGnssSvIdUsedInPosAvail(false),
     mGnssMbSvIdUsedInPosition{},
     mGnssMbSvIdUsedInPosAvail(false),
+    mPositionInfoDispatch(false),
+    mNmeaApSentenceMask(0),
+    mNmeaApConfSentenceMask(LOC_NMEA_AP_SUPPORTED_MASK),
     mControlCallbacks(),
     mAfwControlId(0),
     mNmeaMask(0),
@@ -168,336 +185,6 @@ GnssAdapter::convertOptions(LocPosMode& out, const TrackingOptions& trackingOpti
     out.timeBetweenMeasurements = trackingOptions.tbm;
 }
 
-void
-GnssAdapter::convertLocation(Location& out, const UlpLocation& ulpLocation,
-                             const GpsLocationExtended& locationExtended,
-                             const LocPosTechMask techMask)
-{
-    memset(&out, 0, sizeof(Location));
-    out.size = sizeof(Location);
-    if (LOC_GPS_LOCATION_HAS_LAT_LONG & ulpLocation.gpsLocation.flags) {
-        out.flags |= LOCATION_HAS_LAT_LONG_BIT;
-        out.latitude = ulpLocation.gpsLocation.latitude;
-        out.longitude = ulpLocation.gpsLocation.longitude;
-    }
-    if (LOC_GPS_LOCATION_HAS_ALTITUDE & ulpLocation.gpsLocation.flags) {
-        out.flags |= LOCATION_HAS_ALTITUDE_BIT;
-        out.altitude = ulpLocation.gpsLocation.altitude;
-    }
-    if (LOC_GPS_LOCATION_HAS_SPEED & ulpLocation.gpsLocation.flags) {
-        out.flags |= LOCATION_HAS_SPEED_BIT;
-        out.speed = ulpLocation.gpsLocation.speed;
-    }
-    if (LOC_GPS_LOCATION_HAS_BEARING & ulpLocation.gpsLocation.flags) {
-        out.flags |= LOCATION_HAS_BEARING_BIT;
-        out.bearing = ulpLocation.gpsLocation.bearing;
-    }
-    if (LOC_GPS_LOCATION_HAS_ACCURACY & ulpLocation.gpsLocation.flags) {
-        out.flags |= LOCATION_HAS_ACCURACY_BIT;
-        out.accuracy = ulpLocation.gpsLocation.accuracy;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_VERT_UNC & locationExtended.flags) {
-        out.flags |= LOCATION_HAS_VERTICAL_ACCURACY_BIT;
-        out.verticalAccuracy = locationExtended.vert_unc;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_SPEED_UNC & locationExtended.flags) {
-        out.flags |= LOCATION_HAS_SPEED_ACCURACY_BIT;
-        out.speedAccuracy = locationExtended.speed_unc;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_BEARING_UNC & locationExtended.flags) {
-        out.flags |= LOCATION_HAS_BEARING_ACCURACY_BIT;
-        out.bearingAccuracy = locationExtended.bearing_unc;
-    }
-    out.timestamp = ulpLocation.gpsLocation.timestamp;
-    if (LOC_POS_TECH_MASK_SATELLITE & techMask) {
-        out.techMask |= LOCATION_TECHNOLOGY_GNSS_BIT;
-    }
-    if (LOC_POS_TECH_MASK_CELLID & techMask) {
-        out.techMask |= LOCATION_TECHNOLOGY_CELL_BIT;
-    }
-    if (LOC_POS_TECH_MASK_WIFI & techMask) {
-        out.techMask |= LOCATION_TECHNOLOGY_WIFI_BIT;
-    }
-    if (LOC_POS_TECH_MASK_SENSORS & techMask) {
-        out.techMask |= LOCATION_TECHNOLOGY_SENSORS_BIT;
-    }
-
-    if (LOC_GPS_LOCATION_HAS_SPOOF_MASK & ulpLocation.gpsLocation.flags) {
-        out.flags |= LOCATION_HAS_SPOOF_MASK;
-        out.spoofMask = ulpLocation.gpsLocation.spoof_mask;
-    }
-}
-
-/* This is utility routine that computes number of SV used
-   in the fix from the svUsedIdsMask.
- */
-#define MAX_SV_CNT_SUPPORTED_IN_ONE_CONSTELLATION 64
-uint16_t GnssAdapter::getNumSvUsed(uint64_t svUsedIdsMask,
-                                   int totalSvCntInThisConstellation)
-{
-    if (totalSvCntInThisConstellation > MAX_SV_CNT_SUPPORTED_IN_ONE_CONSTELLATION) {
-        LOC_LOGe ("error: total SV count in this constellation %d exceeded limit of %d",
-                  totalSvCntInThisConstellation, MAX_SV_CNT_SUPPORTED_IN_ONE_CONSTELLATION);
-        return 0;
-    }
-
-    uint16_t numSvUsed = 0;
-    uint64_t mask = 0x1;
-    for (int i = 0; i < totalSvCntInThisConstellation; i++) {
-        if (svUsedIdsMask & mask) {
-            numSvUsed++;
-        }
-        mask <<= 1;
-    }
-
-    return numSvUsed;
-}
-
-void
-GnssAdapter::convertLocationInfo(GnssLocationInfoNotification& out,
-                                 const GpsLocationExtended& locationExtended)
-{
-    out.size = sizeof(GnssLocationInfoNotification);
-    if (GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_ALTITUDE_MEAN_SEA_LEVEL_BIT;
-        out.altitudeMeanSeaLevel = locationExtended.altitudeMeanSeaLevel;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_EXT_DOP & locationExtended.flags) {
-        out.flags |= (GNSS_LOCATION_INFO_DOP_BIT|GNSS_LOCATION_INFO_EXT_DOP_BIT);
-        out.pdop = locationExtended.extDOP.PDOP;
-        out.hdop = locationExtended.extDOP.HDOP;
-        out.vdop = locationExtended.extDOP.VDOP;
-        out.gdop = locationExtended.extDOP.GDOP;
-        out.tdop = locationExtended.extDOP.TDOP;
-    } else if (GPS_LOCATION_EXTENDED_HAS_DOP & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_DOP_BIT;
-        out.pdop = locationExtended.pdop;
-        out.hdop = locationExtended.hdop;
-        out.vdop = locationExtended.vdop;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_MAG_DEV & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_MAGNETIC_DEVIATION_BIT;
-        out.magneticDeviation = locationExtended.magneticDeviation;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_HOR_RELIABILITY & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_HOR_RELIABILITY_BIT;
-        switch (locationExtended.horizontal_reliability) {
-            case LOC_RELIABILITY_VERY_LOW:
-                out.horReliability = LOCATION_RELIABILITY_VERY_LOW;
-                break;
-            case LOC_RELIABILITY_LOW:
-                out.horReliability = LOCATION_RELIABILITY_LOW;
-                break;
-            case LOC_RELIABILITY_MEDIUM:
-                out.horReliability = LOCATION_RELIABILITY_MEDIUM;
-                break;
-            case LOC_RELIABILITY_HIGH:
-                out.horReliability = LOCATION_RELIABILITY_HIGH;
-                break;
-            default:
-                out.horReliability = LOCATION_RELIABILITY_NOT_SET;
-                break;
-        }
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_VERT_RELIABILITY & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_VER_RELIABILITY_BIT;
-        switch (locationExtended.vertical_reliability) {
-            case LOC_RELIABILITY_VERY_LOW:
-                out.verReliability = LOCATION_RELIABILITY_VERY_LOW;
-                break;
-            case LOC_RELIABILITY_LOW:
-                out.verReliability = LOCATION_RELIABILITY_LOW;
-                break;
-            case LOC_RELIABILITY_MEDIUM:
-                out.verReliability = LOCATION_RELIABILITY_MEDIUM;
-                break;
-            case LOC_RELIABILITY_HIGH:
-                out.verReliability = LOCATION_RELIABILITY_HIGH;
-                break;
-            default:
-                out.verReliability = LOCATION_RELIABILITY_NOT_SET;
-                break;
-        }
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_HOR_ELIP_UNC_MAJOR & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_HOR_ACCURACY_ELIP_SEMI_MAJOR_BIT;
-        out.horUncEllipseSemiMajor = locationExtended.horUncEllipseSemiMajor;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_HOR_ELIP_UNC_MINOR & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_HOR_ACCURACY_ELIP_SEMI_MINOR_BIT;
-        out.horUncEllipseSemiMinor = locationExtended.horUncEllipseSemiMinor;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_HOR_ELIP_UNC_AZIMUTH & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_HOR_ACCURACY_ELIP_AZIMUTH_BIT;
-        out.horUncEllipseOrientAzimuth = locationExtended.horUncEllipseOrientAzimuth;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_NORTH_STD_DEV & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_NORTH_STD_DEV_BIT;
-        out.northStdDeviation = locationExtended.northStdDeviation;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_EAST_STD_DEV & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_EAST_STD_DEV_BIT;
-        out.eastStdDeviation = locationExtended.eastStdDeviation;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_NORTH_VEL & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_NORTH_VEL_BIT;
-        out.northVelocity = locationExtended.northVelocity;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_NORTH_VEL_UNC & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_NORTH_VEL_UNC_BIT;
-        out.northVelocityStdDeviation = locationExtended.northVelocityStdDeviation;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_EAST_VEL & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_EAST_VEL_BIT;
-        out.eastVelocity = locationExtended.eastVelocity;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_EAST_VEL_UNC & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_EAST_VEL_UNC_BIT;
-        out.eastVelocityStdDeviation = locationExtended.eastVelocityStdDeviation;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_UP_VEL & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_UP_VEL_BIT;
-        out.upVelocity = locationExtended.upVelocity;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_UP_VEL_UNC & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_UP_VEL_UNC_BIT;
-        out.upVelocityStdDeviation = locationExtended.upVelocityStdDeviation;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_GNSS_SV_USED_DATA_BIT;
-        out.svUsedInPosition.gpsSvUsedIdsMask =
-                locationExtended.gnss_sv_used_ids.gps_sv_used_ids_mask;
-        out.svUsedInPosition.gloSvUsedIdsMask =
-                locationExtended.gnss_sv_used_ids.glo_sv_used_ids_mask;
-        out.svUsedInPosition.galSvUsedIdsMask =
-                locationExtended.gnss_sv_used_ids.gal_sv_used_ids_mask;
-        out.svUsedInPosition.bdsSvUsedIdsMask =
-                locationExtended.gnss_sv_used_ids.bds_sv_used_ids_mask;
-        out.svUsedInPosition.qzssSvUsedIdsMask =
-                locationExtended.gnss_sv_used_ids.qzss_sv_used_ids_mask;
-
-        out.flags |= GNSS_LOCATION_INFO_NUM_SV_USED_IN_POSITION_BIT;
-        out.numSvUsedInPosition = getNumSvUsed(out.svUsedInPosition.gpsSvUsedIdsMask,
-                                               GPS_SV_PRN_MAX - GPS_SV_PRN_MIN + 1);
-        out.numSvUsedInPosition += getNumSvUsed(out.svUsedInPosition.gloSvUsedIdsMask,
-                                                GLO_SV_PRN_MAX - GLO_SV_PRN_MIN + 1);
-        out.numSvUsedInPosition += getNumSvUsed(out.svUsedInPosition.qzssSvUsedIdsMask,
-                                                QZSS_SV_PRN_MAX - QZSS_SV_PRN_MIN + 1);
-        out.numSvUsedInPosition += getNumSvUsed(out.svUsedInPosition.bdsSvUsedIdsMask,
-                                                BDS_SV_PRN_MAX - BDS_SV_PRN_MIN + 1);
-        out.numSvUsedInPosition += getNumSvUsed(out.svUsedInPosition.galSvUsedIdsMask,
-                                                GAL_SV_PRN_MAX - GAL_SV_PRN_MIN + 1);
-
-        out.numOfMeasReceived = locationExtended.numOfMeasReceived;
-        for (int idx =0; idx < locationExtended.numOfMeasReceived; idx++) {
-            out.measUsageInfo[idx].gnssSignalType =
-                    locationExtended.measUsageInfo[idx].gnssSignalType;
-            out.measUsageInfo[idx].gnssSvId =
-                    locationExtended.measUsageInfo[idx].gnssSvId;
-            out.measUsageInfo[idx].gnssConstellation =
-                    locationExtended.measUsageInfo[idx].gnssConstellation;
-        }
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_NAV_SOLUTION_MASK & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_NAV_SOLUTION_MASK_BIT;
-        out.navSolutionMask = locationExtended.navSolutionMask;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_POS_TECH_MASK & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_POS_TECH_MASK_BIT;
-        out.posTechMask = locationExtended.tech_mask;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_POS_DYNAMICS_DATA & locationExtended.flags) {
-        out.flags |= GPS_LOCATION_EXTENDED_HAS_POS_DYNAMICS_DATA;
-        if (locationExtended.bodyFrameData.bodyFrameDataMask &
-                LOCATION_NAV_DATA_HAS_LONG_ACCEL_BIT) {
-            out.bodyFrameData.bodyFrameDataMask |= LOCATION_NAV_DATA_HAS_LONG_ACCEL_BIT;
-        }
-        if (locationExtended.bodyFrameData.bodyFrameDataMask &
-                LOCATION_NAV_DATA_HAS_LAT_ACCEL_BIT) {
-            out.bodyFrameData.bodyFrameDataMask |= LOCATION_NAV_DATA_HAS_LAT_ACCEL_BIT;
-        }
-        if (locationExtended.bodyFrameData.bodyFrameDataMask &
-                LOCATION_NAV_DATA_HAS_VERT_ACCEL_BIT) {
-            out.bodyFrameData.bodyFrameDataMask |= LOCATION_NAV_DATA_HAS_VERT_ACCEL_BIT;
-        }
-        if (locationExtended.bodyFrameData.bodyFrameDataMask & LOCATION_NAV_DATA_HAS_YAW_RATE_BIT) {
-            out.bodyFrameData.bodyFrameDataMask |= LOCATION_NAV_DATA_HAS_YAW_RATE_BIT;
-        }
-        if (locationExtended.bodyFrameData.bodyFrameDataMask & LOCATION_NAV_DATA_HAS_PITCH_BIT) {
-            out.bodyFrameData.bodyFrameDataMask |= LOCATION_NAV_DATA_HAS_PITCH_BIT;
-        }
-        out.bodyFrameData.longAccel = locationExtended.bodyFrameData.longAccel;
-        out.bodyFrameData.latAccel = locationExtended.bodyFrameData.latAccel;
-        out.bodyFrameData.vertAccel = locationExtended.bodyFrameData.vertAccel;
-        out.bodyFrameData.yawRate = locationExtended.bodyFrameData.yawRate;
-        out.bodyFrameData.pitch = locationExtended.bodyFrameData.pitch;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_GPS_TIME & locationExtended.flags) {
-        out.flags |= GPS_LOCATION_EXTENDED_HAS_GPS_TIME;
-        out.gnssSystemTime.gnssSystemTimeSrc = locationExtended.gnssSystemTime.gnssSystemTimeSrc;
-        out.gnssSystemTime.u = locationExtended.gnssSystemTime.u;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_NORTH_VEL & locationExtended.flags) {
-        out.flags |= GPS_LOCATION_EXTENDED_HAS_NORTH_VEL;
-        out.northVelocity = locationExtended.northVelocity;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_EAST_VEL & locationExtended.flags) {
-        out.flags |= GPS_LOCATION_EXTENDED_HAS_EAST_VEL;
-        out.eastVelocity = locationExtended.eastVelocity;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_UP_VEL & locationExtended.flags) {
-        out.flags |= GPS_LOCATION_EXTENDED_HAS_UP_VEL;
-        out.upVelocity = locationExtended.upVelocity;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_NORTH_VEL_UNC & locationExtended.flags) {
-        out.flags |= GPS_LOCATION_EXTENDED_HAS_NORTH_VEL_UNC;
-        out.northVelocityStdDeviation = locationExtended.northVelocityStdDeviation;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_EAST_VEL_UNC & locationExtended.flags) {
-        out.flags |= GPS_LOCATION_EXTENDED_HAS_EAST_VEL_UNC;
-        out.eastVelocityStdDeviation = locationExtended.eastVelocityStdDeviation;
-    }
-    if (GPS_LOCATION_EXTENDED_HAS_UP_VEL_UNC & locationExtended.flags) {
-        out.flags |= GPS_LOCATION_EXTENDED_HAS_UP_VEL_UNC;
-        out.upVelocityStdDeviation = locationExtended.upVelocityStdDeviation;
-    }
-
-    // Validity of this structure is established from the timeSrc of the GnssSystemTime structure.
-    out.gnssSystemTime = locationExtended.gnssSystemTime;
-
-    if (GPS_LOCATION_EXTENDED_HAS_LEAP_SECONDS & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_LEAP_SECONDS_BIT;
-        out.leapSeconds = locationExtended.leapSeconds;
-    }
-
-    if (GPS_LOCATION_EXTENDED_HAS_TIME_UNC & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_TIME_UNC_BIT;
-        out.timeUncMs = locationExtended.timeUncMs;
-    }
-
-    if (GPS_LOCATION_EXTENDED_HAS_CALIBRATION_CONFIDENCE & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_CALIBRATION_CONFIDENCE_BIT;
-        out.calibrationConfidence = locationExtended.calibrationConfidence;
-    }
-
-    if (GPS_LOCATION_EXTENDED_HAS_CALIBRATION_STATUS & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_CALIBRATION_STATUS_BIT;
-        out.calibrationStatus = locationExtended.calibrationStatus;
-    }
-
-    if (GPS_LOCATION_EXTENDED_HAS_OUTPUT_ENG_TYPE & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT;
-        out.locOutputEngType = locationExtended.locOutputEngType;
-    }
-
-    if (GPS_LOCATION_EXTENDED_HAS_OUTPUT_ENG_MASK & locationExtended.flags) {
-        out.flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_MASK_BIT;
-        out.locOutputEngMask = locationExtended.locOutputEngMask;
-    }
-}
-
-
-
 inline uint32_t
 GnssAdapter::convertSuplVersion(const GnssConfigSuplVersion suplVersion)
 {
@@ -650,6 +337,41 @@ GnssAdapter::readConfigCommand()
                 UTIL_READ_CONF(LOC_PATH_FLP_CONF, flp_conf_param_table);
                 LOC_LOGd("allowFlpNetworkFixes %u", allowFlpNetworkFixes);
                 mAdapter->setAllowFlpNetworkFixes(allowFlpNetworkFixes);
+
+                uint32_t stationaryInterval = 0;
+                uint32_t stationaryPowerMode = GNSS_POWER_MODE_INVALID;
+                double stationarySpeed = 0.5;
+                uint32_t stationaryFixes = 5;
+                uint32_t nmeaPipelineDepth = 0;
+                uint32_t nmeaApSentenceMask = LOC_NMEA_AP_SUPPORTED_MASK;
+                const loc_param_s_type gps_conf_param_table[] =
+                {
+                    {"ADAPTIVE_TRACKING_INTERVAL", &stationaryInterval, NULL, 'n'},
+                    {"ADAPTIVE_TRACKING_POWER_MODE", &stationaryPowerMode, NULL, 'n'},
+                    {"ADAPTIVE_TRACKING_STATIONARY_SPEED", &stationarySpeed, NULL, 'f'},
+                    {"ADAPTIVE_TRACKING_STATIONARY_FIXES", &stationaryFixes, NULL, 'n'},
+                    {"NMEA_PIPELINE_DEPTH", &nmeaPipelineDepth, NULL, 'n'},
+                    {"NMEA_AP_SENTENCE_MASK", &nmeaApSentenceMask, NULL, 'n'},
+                };
+                UTIL_READ_CONF(LOC_PATH_GPS_CONF, gps_conf_param_table);
+                if (stationaryPowerMode > GNSS_POWER_MODE_M5) {
+                    stationaryPowerMode = GNSS_POWER_MODE_INVALID;
+                }
+                LOC_LOGd("adaptive tracking interval %u powerMode %u speed %.2f fixes %u",
+                         stationaryInterval, stationaryPowerMode, stationarySpeed,
+                         stationaryFixes);
+                mAdapter->mStationaryTrackingInterval = stationaryInterval;
+                mAdapter->mStationaryTrackingPowerMode = (GnssPowerMode)stationaryPowerMode;
+                mAdapter->mStationaryDetector.configure(stationarySpeed, stationaryFixes);
+
+                LOC_LOGd("nmea pipeline depth %u ap sentence mask 0x%x",
+                         nmeaPipelineDepth, nmeaApSentenceMask);
+                mAdapter->mNmeaApConfSentenceMask =
+                        nmeaApSentenceMask & LOC_NMEA_AP_SUPPORTED_MASK;
+                if (nmeaPipelineDepth > 0) {
+                    mAdapter->mNmeaPipeline.start(nmeaPipelineDepth);
+                }
+                mAdapter->updateClientsDispatch();
             }
         }
     };
@@ -2051,9 +1773,60 @@ GnssAdapter::stopClientSessions(LocationAPI* client)
 
 }
 
+void
+GnssAdapter::updateClientsDispatch()
+{
+    mPositionDispatch.clear();
+    mPositionInfoDispatch = false;
+    mSvDispatch.clear();
+    mNmeaDispatch.clear();
+    mDataDispatch.clear();
+    mMeasurementsDispatch.clear();
+    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
+        if (nullptr != it->second.gnssLocationInfoCb ||
+            nullptr != it->second.engineLocationsInfoCb ||
+            nullptr != it->second.trackingCb) {
+            mPositionDispatch.push_back({it->first, &it->second, isFlpClient(it->second)});
+        }
+        if (nullptr != it->second.gnssLocationInfoCb ||
+            nullptr != it->second.engineLocationsInfoCb) {
+            mPositionInfoDispatch = true;
+        }
+        if (nullptr != it->second.gnssSvCb) {
+            mSvDispatch.push_back(&it->second.gnssSvCb);
+        }
+        if (nullptr != it->second.gnssNmeaCb) {
+            mNmeaDispatch.push_back(&it->second.gnssNmeaCb);
+        }
+        if (nullptr != it->second.gnssDataCb) {
+            mDataDispatch.push_back(&it->second.gnssDataCb);
+        }
+        if (nullptr != it->second.gnssMeasurementsCb) {
+            mMeasurementsDispatch.push_back(&it->second.gnssMeasurementsCb);
+        }
+    }
+
+    // clients cannot pick sentences through LocationAPI, so each NMEA client
+    // wants the gps.conf selection and nothing is generated without one
+    mNmeaApSentenceMask = mNmeaDispatch.empty() ? 0 : mNmeaApConfSentenceMask;
+
+    if (mNmeaPipeline.isStarted()) {
+        NmeaPipeline::ClientList nmeaClients;
+        for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
+            if (nullptr != it->second.gnssNmeaCb) {
+                nmeaClients.push_back({it->first, it->second.gnssNmeaCb});
+            }
+        }
+        mNmeaPipeline.setClients(nmeaClients);
+    }
+}
+
 void
 GnssAdapter::updateClientsEventMask()
 {
+    // called whenever a client is added or removed
+    updateClientsDispatch();
+
     LOC_API_ADAPTER_EVENT_MASK_T mask = 0;
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (it->second.trackingCb != nullptr || it->second.gnssLocationInfoCb != nullptr) {
@@ -2150,29 +1923,12 @@ GnssAdapter::restartSessions()
     // odcpi session is no longer active after restart
     mOdcpiRequestActive = false;
 
-    if (!mTimeBasedTrackingSessions.empty()) {
-        // get the LocationOptions that has the smallest interval, which should be the active one
-        TrackingOptions smallestIntervalOptions; // size is zero until set for the first time
-        TrackingOptions highestPowerTrackingOptions;
-        memset(&smallestIntervalOptions, 0, sizeof(smallestIntervalOptions));
-        memset(&highestPowerTrackingOptions, 0, sizeof(highestPowerTrackingOptions));
-        for (auto it = mTimeBasedTrackingSessions.begin(); it != mTimeBasedTrackingSessions.end(); ++it) {
-            // size of zero means we havent set it yet
-            if (0 == smallestIntervalOptions.size ||
-                it->second.minInterval < smallestIntervalOptions.minInterval) {
-                 smallestIntervalOptions = it->second;
-            }
-            GnssPowerMode powerMode = it->second.powerMode;
-            // Size of zero means we havent set it yet
-            if (0 == highestPowerTrackingOptions.size ||
-                (GNSS_POWER_MODE_INVALID != powerMode &&
-                        powerMode < highestPowerTrackingOptions.powerMode)) {
-                 highestPowerTrackingOptions = it->second;
-            }
-        }
-
-        highestPowerTrackingOptions.setLocationOptions(smallestIntervalOptions);
-        mLocApi->startTimeBasedTracking(highestPowerTrackingOptions, nullptr);
+    // get the smallest interval and highest power mode, which should be the active ones
+    TrackingOptions multiplexedOptions;
+    if (getMultiplexedTrackingOptions(multiplexedOptions)) {
+        adaptTrackingOptions(multiplexedOptions);
+        mLocApi->startTimeBasedTracking(multiplexedOptions, nullptr);
+        mEngineTrackingOptions = multiplexedOptions;
     }
 
     for (auto it = mDistanceBasedTrackingSessions.begin();
@@ -2291,8 +2047,16 @@ GnssAdapter::saveTrackingSession(LocationAPI* client, uint32_t sessionId,
             ContextBase::isMessageSupported(LOC_API_ADAPTER_MESSAGE_DISTANCE_BASE_TRACKING)) {
         mDistanceBasedTrackingSessions[key] = options;
     } else {
+        auto it = mTimeBasedTrackingSessions.find(key);
+        if (it != mTimeBasedTrackingSessions.end()) {
+            mTrackingIntervalIndex.erase(std::make_pair(it->second.minInterval, key));
+            mTrackingPowerModeIndex.erase(std::make_pair(it->second.powerMode, key));
+        }
         mTimeBasedTrackingSessions[key] = options;
+        mTrackingIntervalIndex.emplace(options.minInterval, key);
+        mTrackingPowerModeIndex.emplace(options.powerMode, key);
     }
+    updateTrackingReportFilter(client);
     reportPowerStateIfChanged();
 }
 
@@ -2302,6 +2066,8 @@ GnssAdapter::eraseTrackingSession(LocationAPI* client, uint32_t sessionId)
     LocationSessionKey key(client, sessionId);
     auto it = mTimeBasedTrackingSessions.find(key);
     if (it != mTimeBasedTrackingSessions.end()) {
+        mTrackingIntervalIndex.erase(std::make_pair(it->second.minInterval, key));
+        mTrackingPowerModeIndex.erase(std::make_pair(it->second.powerMode, key));
         mTimeBasedTrackingSessions.erase(it);
     } else {
         auto itr = mDistanceBasedTrackingSessions.find(key);
@@ -2309,9 +2075,197 @@ GnssAdapter::eraseTrackingSession(LocationAPI* client, uint32_t sessionId)
             mDistanceBasedTrackingSessions.erase(itr);
         }
     }
+    updateTrackingReportFilter(client);
     reportPowerStateIfChanged();
 }
 
+bool
+GnssAdapter::getMultiplexedTrackingOptions(TrackingOptions& options,
+                                           const LocationSessionKey* excludedKey)
+{
+    // the smallest interval, skipping the excluded session
+    auto itInterval = mTrackingIntervalIndex.begin();
+    if (itInterval != mTrackingIntervalIndex.end() &&
+        nullptr != excludedKey && itInterval->second == *excludedKey) {
+        ++itInterval;
+    }
+    if (itInterval == mTrackingIntervalIndex.end()) {
+        return false;
+    }
+    options = mTimeBasedTrackingSessions[itInterval->second];
+
+    // the highest power mode that is set, GNSS_POWER_MODE_INVALID only if none is
+    GnssPowerMode powerMode = GNSS_POWER_MODE_INVALID;
+    auto itPowerMode = mTrackingPowerModeIndex.lower_bound(
+            std::make_pair(GNSS_POWER_MODE_M1, LocationSessionKey(nullptr, 0)));
+    if (itPowerMode != mTrackingPowerModeIndex.end() &&
+        nullptr != excludedKey && itPowerMode->second == *excludedKey) {
+        ++itPowerMode;
+    }
+    if (itPowerMode != mTrackingPowerModeIndex.end()) {
+        powerMode = itPowerMode->first;
+    }
+    options.powerMode = powerMode;
+    return true;
+}
+
+bool
+GnssAdapter::isEngineTrackingWith(const TrackingOptions& options)
+{
+    TrackingOptions engineOptions = options;
+    adaptTrackingOptions(engineOptions);
+    return (0 != mEngineTrackingOptions.size &&
+            mEngineTrackingOptions.minInterval == engineOptions.minInterval &&
+            mEngineTrackingOptions.powerMode == engineOptions.powerMode);
+}
+
+void
+GnssAdapter::adaptTrackingOptions(TrackingOptions& options)
+{
+    // only ever slows the engine down, and only while the device is stationary
+    if (!mStationaryDetector.isStationary()) {
+        return;
+    }
+    if (options.minInterval < mStationaryTrackingInterval) {
+        options.minInterval = mStationaryTrackingInterval;
+    }
+    if (GNSS_POWER_MODE_INVALID != mStationaryTrackingPowerMode &&
+        options.powerMode < mStationaryTrackingPowerMode) {
+        options.powerMode = mStationaryTrackingPowerMode;
+        if (0 == options.tbm) {
+            options.tbm = options.minInterval;
+        }
+    }
+}
+
+void
+GnssAdapter::updateAdaptiveTracking(const LocationReport& report, bool reportToFlpClient)
+{
+    if (!isAdaptiveTrackingEnabled() || 0 == mEngineTrackingOptions.size) {
+        return;
+    }
+    if (mStationaryDetector.addLocation(report.getLocation())) {
+        LOC_LOGd("device is %s", mStationaryDetector.isStationary() ? "stationary" : "moving");
+        // the engine follows on the next reconfiguration, right away if there is no
+        // window running
+        mTrackingReconfigurePending = true;
+        if (!mTrackingReconfigureTimer.isActive()) {
+            trackingReconfigureTimerExpire();
+        }
+    }
+
+    // while the engine runs slower than the clients asked for, the fix is held
+    // and handed to them again at their interval
+    TrackingOptions requestedOptions;
+    if (mStationaryDetector.isStationary() &&
+        getMultiplexedTrackingOptions(requestedOptions) &&
+        requestedOptions.minInterval < mEngineTrackingOptions.minInterval) {
+        // the full info is only built and copied for clients that take it
+        if (mPositionInfoDispatch) {
+            mHeldLocationInfo = report.getLocationInfo();
+        } else {
+            mHeldLocationInfo.location = report.getLocation();
+        }
+        mHeldHasLocationInfo = mPositionInfoDispatch;
+        mHeldLocationUptimeMs = uptimeMillis();
+        mHeldReportToFlpClient = reportToFlpClient;
+        mTrackingHoldTimer.start(requestedOptions.minInterval);
+    } else if (mTrackingHoldTimer.isActive()) {
+        mTrackingHoldTimer.stop();
+    }
+}
+
+bool
+GnssAdapter::canReconfigureTracking()
+{
+    // only one reconfiguration per window, the rest is applied when it runs out
+    if (mTrackingReconfigureTimer.isActive()) {
+        mTrackingReconfigurePending = true;
+        return false;
+    }
+    return true;
+}
+
+void
+GnssAdapter::updateTrackingReportFilter(LocationAPI* client)
+{
+    TrackingReportFilter filter = {};
+    bool hasSession = false;
+    for (auto it = mTimeBasedTrackingSessions.begin();
+            it != mTimeBasedTrackingSessions.end(); ++it) {
+        if (it->first.client != client) {
+            continue;
+        }
+        // with more than one session, the client gets what the most demanding one asks for
+        if (!hasSession || it->second.minInterval < filter.minInterval) {
+            filter.minInterval = it->second.minInterval;
+        }
+        if (!hasSession || it->second.minDistance < filter.minDistance) {
+            filter.minDistance = it->second.minDistance;
+        }
+        hasSession = true;
+    }
+    // the fixes of all sessions of a client go to the same callback, so one
+    // filter cannot tell the distance based fixes from the time based ones;
+    // the engine already filters the former, the client gets them all
+    bool hasDistanceBasedSession = false;
+    for (auto it = mDistanceBasedTrackingSessions.begin();
+            it != mDistanceBasedTrackingSessions.end(); ++it) {
+        if (it->first.client == client) {
+            hasDistanceBasedSession = true;
+            break;
+        }
+    }
+
+    auto it = mTrackingReportFilters.find(client);
+    if (!hasSession || hasDistanceBasedSession) {
+        // clients without a time based session get every fix, as they always did,
+        // and so do clients that also have a distance based one
+        if (it != mTrackingReportFilters.end()) {
+            mTrackingReportFilters.erase(it);
+        }
+    } else if (it == mTrackingReportFilters.end()) {
+        mTrackingReportFilters[client] = filter;
+    } else {
+        it->second.minInterval = filter.minInterval;
+        it->second.minDistance = filter.minDistance;
+    }
+}
+
+bool
+GnssAdapter::isTrackingReportDue(LocationAPI* client, const Location& location)
+{
+    auto it = mTrackingReportFilters.find(client);
+    if (it == mTrackingReportFilters.end() || 0 == location.timestamp) {
+        return true;
+    }
+    TrackingReportFilter& filter = it->second;
+    bool hasPosition = (0 != (location.flags & LOCATION_HAS_LAT_LONG_BIT));
+
+    // fixes are timed by the engine, so that AP scheduling jitter does not
+    // make a client miss one; a fix a tenth of the interval early, up to
+    // half a second, still counts as on time
+    if (0 != filter.lastTimestamp && location.timestamp >= filter.lastTimestamp) {
+        uint32_t earlyMs = std::min(filter.minInterval / 10, (uint32_t)500);
+        if (location.timestamp - filter.lastTimestamp + earlyMs < filter.minInterval) {
+            return false;
+        }
+        if (filter.minDistance > 0 && hasPosition && filter.hasLastPosition &&
+                loc_geo_distance(filter.lastLatitude, filter.lastLongitude,
+                                 location.latitude, location.longitude) < filter.minDistance) {
+            return false;
+        }
+    }
+
+    filter.lastTimestamp = location.timestamp;
+    if (hasPosition) {
+        filter.hasLastPosition = true;
+        filter.lastLatitude = location.latitude;
+        filter.lastLongitude = location.longitude;
+    }
+    return true;
+}
+
 
 bool GnssAdapter::setLocPositionMode(const LocPosMode& mode) {
     if (!mLocPositionMode.equals(mode)) {
@@ -2464,36 +2418,20 @@ GnssAdapter::startTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t sessi
         reportToClientWithNoWait = false;
     } else {
         // find the smallest interval and powerMode
-        TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-        GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-        memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-        for (auto it = mTimeBasedTrackingSessions.begin(); it != mTimeBasedTrackingSessions.end(); ++it) {
-            // if not set or there is a new smallest interval, then set the new interval
-            if (0 == multiplexedOptions.size ||
-                it->second.minInterval < multiplexedOptions.minInterval) {
-                multiplexedOptions = it->second;
-            }
-            // if session is not the one we are updating and either powerMode
-            // is not set or there is a new smallest powerMode, then set the new powerMode
-            if (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                it->second.powerMode < multiplexedPowerMode) {
-                multiplexedPowerMode = it->second.powerMode;
-            }
-        }
-        bool updateOptions = false;
+        TrackingOptions multiplexedOptions;
+        getMultiplexedTrackingOptions(multiplexedOptions);
         // if session we are starting has smaller interval then next smallest
         if (options.minInterval < multiplexedOptions.minInterval) {
             multiplexedOptions.minInterval = options.minInterval;
-            updateOptions = true;
         }
         // if session we are starting has smaller powerMode then next smallest
-        if (options.powerMode < multiplexedPowerMode) {
+        if (GNSS_POWER_MODE_INVALID != options.powerMode &&
+            (GNSS_POWER_MODE_INVALID == multiplexedOptions.powerMode ||
+             options.powerMode < multiplexedOptions.powerMode)) {
             multiplexedOptions.powerMode = options.powerMode;
-            updateOptions = true;
         }
-        if (updateOptions) {
+        if (!isEngineTrackingWith(multiplexedOptions) && canReconfigureTracking()) {
             // restart time based tracking with the newly updated options
-
             startTimeBasedTracking(client, sessionId, multiplexedOptions);
             // need to wait for QMI callback
             reportToClientWithNoWait = false;
@@ -2512,14 +2450,18 @@ GnssAdapter::startTimeBasedTracking(LocationAPI* client, uint32_t sessionId,
             trackingOptions.minInterval, trackingOptions.minDistance,
             trackingOptions.mode, trackingOptions.powerMode, trackingOptions.tbm);
 
+    TrackingOptions engineOptions = trackingOptions;
+    adaptTrackingOptions(engineOptions);
     LocPosMode locPosMode = {};
-    convertOptions(locPosMode, trackingOptions);
+    convertOptions(locPosMode, engineOptions);
 
     // inform engine hub that GNSS session is about to start
     mEngHubProxy->gnssSetFixMode(locPosMode);
     mEngHubProxy->gnssStartFix();
 
-    mLocApi->startTimeBasedTracking(trackingOptions, new LocApiResponse(*getContext(),
+    mEngineTrackingOptions = engineOptions;
+    mTrackingReconfigureTimer.start();
+    mLocApi->startTimeBasedTracking(engineOptions, new LocApiResponse(*getContext(),
                       [this, client, sessionId] (LocationError err) {
             if (LOCATION_ERROR_SUCCESS != err) {
                 eraseTrackingSession(client, sessionId);
@@ -2534,14 +2476,18 @@ void
 GnssAdapter::updateTracking(LocationAPI* client, uint32_t sessionId,
         const TrackingOptions& updatedOptions, const TrackingOptions& oldOptions)
 {
+    TrackingOptions engineOptions = updatedOptions;
+    adaptTrackingOptions(engineOptions);
     LocPosMode locPosMode = {};
-    convertOptions(locPosMode, updatedOptions);
+    convertOptions(locPosMode, engineOptions);
 
     // inform engine hub that GNSS session is about to start
     mEngHubProxy->gnssSetFixMode(locPosMode);
     mEngHubProxy->gnssStartFix();
 
-    mLocApi->startTimeBasedTracking(updatedOptions, new LocApiResponse(*getContext(),
+    mEngineTrackingOptions = engineOptions;
+    mTrackingReconfigureTimer.start();
+    mLocApi->startTimeBasedTracking(engineOptions, new LocApiResponse(*getContext(),
                       [this, client, sessionId, oldOptions] (LocationError err) {
             if (LOCATION_ERROR_SUCCESS != err) {
                 // restore the old LocationOptions
@@ -2683,55 +2629,35 @@ GnssAdapter::updateTrackingMultiplex(LocationAPI* client, uint32_t id,
     // get the session we are updating
     auto it = mTimeBasedTrackingSessions.find(key);
 
-    // cache the clients existing LocationOptions
-    TrackingOptions oldOptions = it->second;
-
     // if session we are updating exists and the minInterval or powerMode has changed
     if (it != mTimeBasedTrackingSessions.end() &&
        (it->second.minInterval != trackingOptions.minInterval ||
         it->second.powerMode != trackingOptions.powerMode)) {
+        // cache the clients existing LocationOptions
+        TrackingOptions oldOptions = it->second;
         // find the smallest interval and powerMode, other than the session we are updating
-        TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-        GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-        memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-        for (auto it2 = mTimeBasedTrackingSessions.begin();
-             it2 != mTimeBasedTrackingSessions.end(); ++it2) {
-            // if session is not the one we are updating and either interval
-            // is not set or there is a new smallest interval, then set the new interval
-            if (it2->first != key && (0 == multiplexedOptions.size ||
-                it2->second.minInterval < multiplexedOptions.minInterval)) {
-                 multiplexedOptions = it2->second;
-            }
-            // if session is not the one we are updating and either powerMode
-            // is not set or there is a new smallest powerMode, then set the new powerMode
-            if (it2->first != key && (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                it2->second.powerMode < multiplexedPowerMode)) {
-                multiplexedPowerMode = it2->second.powerMode;
-            }
-            // else part: no QMI call is made, need to report back to client right away
-        }
-        bool updateOptions = false;
-        // if session we are updating has smaller interval then next smallest
-        if (trackingOptions.minInterval < multiplexedOptions.minInterval) {
-            multiplexedOptions.minInterval = trackingOptions.minInterval;
-            updateOptions = true;
-        }
-        // if session we are updating has smaller powerMode then next smallest
-        if (trackingOptions.powerMode < multiplexedPowerMode) {
-            multiplexedOptions.powerMode = trackingOptions.powerMode;
-            updateOptions = true;
-        }
+        TrackingOptions multiplexedOptions;
         // if only one session exists, then tracking should be updated with it
-        if (1 == mTimeBasedTrackingSessions.size()) {
+        if (!getMultiplexedTrackingOptions(multiplexedOptions, &key)) {
             multiplexedOptions = trackingOptions;
-            updateOptions = true;
+        } else {
+            // if session we are updating has smaller interval or powerMode then next smallest
+            if (trackingOptions.minInterval < multiplexedOptions.minInterval) {
+                multiplexedOptions.minInterval = trackingOptions.minInterval;
+            }
+            if (GNSS_POWER_MODE_INVALID != trackingOptions.powerMode &&
+                (GNSS_POWER_MODE_INVALID == multiplexedOptions.powerMode ||
+                 trackingOptions.powerMode < multiplexedOptions.powerMode)) {
+                multiplexedOptions.powerMode = trackingOptions.powerMode;
+            }
         }
-        if (updateOptions) {
+        if (!isEngineTrackingWith(multiplexedOptions) && canReconfigureTracking()) {
             // restart time based tracking with the newly updated options
             updateTracking(client, id, multiplexedOptions, oldOptions);
             // need to wait for QMI callback
             reportToClientWithNoWait = false;
         }
+        // else part: no QMI call is made, need to report back to client right away
     }
 
     return reportToClientWithNoWait;
@@ -2806,29 +2732,11 @@ GnssAdapter::stopTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t id)
         auto it = mTimeBasedTrackingSessions.find(key);
         if (it != mTimeBasedTrackingSessions.end()) {
             // find the smallest interval and powerMode, other than the session we are stopping
-            TrackingOptions multiplexedOptions = {}; // size is 0 until set for the first time
-            GnssPowerMode multiplexedPowerMode = GNSS_POWER_MODE_INVALID;
-            memset(&multiplexedOptions, 0, sizeof(multiplexedOptions));
-            for (auto it2 = mTimeBasedTrackingSessions.begin();
-                 it2 != mTimeBasedTrackingSessions.end(); ++it2) {
-                // if session is not the one we are stopping and either interval
-                // is not set or there is a new smallest interval, then set the new interval
-                if (it2->first != key && (0 == multiplexedOptions.size ||
-                    it2->second.minInterval < multiplexedOptions.minInterval)) {
-                     multiplexedOptions = it2->second;
-                }
-                // if session is not the one we are stopping and either powerMode
-                // is not set or there is a new smallest powerMode, then set the new powerMode
-                if (it2->first != key && (GNSS_POWER_MODE_INVALID == multiplexedPowerMode ||
-                    it2->second.powerMode < multiplexedPowerMode)) {
-                    multiplexedPowerMode = it2->second.powerMode;
-                }
-            }
-            // if session we are stopping has smaller interval then next smallest or
-            // if session we are stopping has smaller powerMode then next smallest
-            if (it->second.minInterval < multiplexedOptions.minInterval ||
-                it->second.powerMode < multiplexedPowerMode) {
-                multiplexedOptions.powerMode = multiplexedPowerMode;
+            TrackingOptions multiplexedOptions;
+            // if that is not what the engine runs, the session we are stopping
+            // had the smallest interval or powerMode
+            if (getMultiplexedTrackingOptions(multiplexedOptions, &key) &&
+                !isEngineTrackingWith(multiplexedOptions) && canReconfigureTracking()) {
                 // restart time based tracking with the newly updated options
                 startTimeBasedTracking(client, id, multiplexedOptions);
                 // need to wait for QMI callback
@@ -2841,12 +2749,29 @@ GnssAdapter::stopTimeBasedTrackingMultiplex(LocationAPI* client, uint32_t id)
     return reportToClientWithNoWait;
 }
 
+bool
+GnssAdapter::getCurrentLocation(uint64_t timestamp, Location& location)
+{
+    if (0 == timestamp) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        timestamp = (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    }
+    return mPositionPropagator.getLocation(timestamp, location);
+}
+
 void
 GnssAdapter::stopTracking(LocationAPI* client, uint32_t id)
 {
     // inform engine hub that GNSS session has stopped
     mEngHubProxy->gnssStopFix();
 
+    mEngineTrackingOptions = TrackingOptions();
+    mTrackingReconfigurePending = false;
+    mTrackingReconfigureTimer.stop();
+    mStationaryDetector.reset();
+    mTrackingHoldTimer.stop();
+    mPositionPropagator.reset();
     mLocApi->stopFix(new LocApiResponse(*getContext(),
                      [this, client, id] (LocationError err) {
         reportResponse(client, err, id);
@@ -3207,40 +3132,61 @@ GnssAdapter::isFlpClient(LocationCallbacks& locationCallbacks)
             locationCallbacks.gnssMeasurementsCb == nullptr);
 }
 
+void
+GnssAdapter::reportLocationInfo(const LocationReport& report,
+                                bool reportToGnssClient, bool reportToFlpClient)
+{
+    for (const PositionDispatchEntry& entry : mPositionDispatch) {
+        if (((reportToFlpClient && entry.isFlpClient) ||
+                (reportToGnssClient && !entry.isFlpClient)) &&
+                isTrackingReportDue(entry.client, report.getLocation())) {
+            const LocationCallbacks& callbacks = *entry.callbacks;
+            if (nullptr != callbacks.gnssLocationInfoCb) {
+                callbacks.gnssLocationInfoCb(report.getLocationInfo());
+            } else if ((nullptr != callbacks.engineLocationsInfoCb) &&
+                    (false == initEngHubProxy())) {
+                // if engine hub is disabled, this is SPE fix from modem
+                // we need to mark one copy marked as fused and one copy marked as PPE
+                // and dispatch it to the engineLocationsInfoCb
+                GnssLocationInfoNotification engLocationsInfo[2];
+                engLocationsInfo[0] = report.getLocationInfo();
+                engLocationsInfo[0].locOutputEngType = LOC_OUTPUT_ENGINE_FUSED;
+                engLocationsInfo[0].flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT;
+                engLocationsInfo[1] = report.getLocationInfo();
+                callbacks.engineLocationsInfoCb(2, engLocationsInfo);
+            } else if (nullptr != callbacks.trackingCb) {
+                callbacks.trackingCb(report.getLocation());
+            }
+        }
+    }
+}
+
 void
 GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
                             const GpsLocationExtended& locationExtended,
                             enum loc_sess_status status,
                             LocPosTechMask techMask)
 {
+    GnssLocationInfoNotification locationInfo;
+    reportPosition(LocationReport(ulpLocation, locationExtended, techMask, locationInfo),
+                   status, techMask);
+}
+
+void
+GnssAdapter::reportPosition(const LocationReport& report,
+                            enum loc_sess_status status,
+                            LocPosTechMask techMask)
+{
+    const UlpLocation& ulpLocation = *report.getUlpLocation();
+    const GpsLocationExtended& locationExtended = *report.getLocationExtended();
     bool reportToGnssClient = needReportForGnssClient(ulpLocation, status, techMask);
     bool reportToFlpClient = needReportForFlpClient(status, techMask);
 
     if (reportToGnssClient || reportToFlpClient) {
-        GnssLocationInfoNotification locationInfo = {};
-        convertLocationInfo(locationInfo, locationExtended);
-        convertLocation(locationInfo.location, ulpLocation, locationExtended, techMask);
-
-        for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-            if ((reportToFlpClient && isFlpClient(it->second)) ||
-                    (reportToGnssClient && !isFlpClient(it->second))) {
-                if (nullptr != it->second.gnssLocationInfoCb) {
-                    it->second.gnssLocationInfoCb(locationInfo);
-                } else if ((nullptr != it->second.engineLocationsInfoCb) &&
-                        (false == initEngHubProxy())) {
-                    // if engine hub is disabled, this is SPE fix from modem
-                    // we need to mark one copy marked as fused and one copy marked as PPE
-                    // and dispatch it to the engineLocationsInfoCb
-                    GnssLocationInfoNotification engLocationsInfo[2];
-                    engLocationsInfo[0] = locationInfo;
-                    engLocationsInfo[0].locOutputEngType = LOC_OUTPUT_ENGINE_FUSED;
-                    engLocationsInfo[0].flags |= GNSS_LOCATION_INFO_OUTPUT_ENG_TYPE_BIT;
-                    engLocationsInfo[1] = locationInfo;
-                    it->second.engineLocationsInfoCb(2, engLocationsInfo);
-                } else if (nullptr != it->second.trackingCb) {
-                    it->second.trackingCb(locationInfo.location);
-                }
-            }
+        reportLocationInfo(report, reportToGnssClient, reportToFlpClient);
+        if (reportToGnssClient && LOC_SESS_SUCCESS == status) {
+            mPositionPropagator.addLocation(report.getLocation(), locationExtended);
+            updateAdaptiveTracking(report, reportToFlpClient);
         }
 
         mGnssSvIdUsedInPosAvail = false;
@@ -3259,13 +3205,13 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
             // inject DRE fix to modem
             if ((1 == ContextBase::mGps_conf.POSITION_ASSISTED_CLOCK_ESTIMATOR_ENABLED) &&
                     (true == initEngHubProxy()) && (LOC_POS_TECH_MASK_SENSORS & techMask)) {
-                mLocApi->injectPosition(locationInfo, false);
+                mLocApi->injectPosition(report.getLocationInfo(), false);
             }
         }
     }
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
-        !mTimeBasedTrackingSessions.empty()) {
+        !mTimeBasedTrackingSessions.empty() && 0 != mNmeaApSentenceMask) {
         /*Only BlankNMEA sentence needs to be processed and sent, if both lat, long is 0 &
           horReliability is not set. */
         bool blank_fix = ((0 == ulpLocation.gpsLocation.latitude) &&
@@ -3275,7 +3221,8 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
         bool custom_nmea_gga = (1 == ContextBase::mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED);
         std::vector<std::string> nmeaArraystr;
         loc_nmea_generate_pos(ulpLocation, locationExtended, mLocSystemInfo,
-                              generate_nmea, custom_nmea_gga, nmeaArraystr);
+                              generate_nmea, custom_nmea_gga, mNmeaApSentenceMask,
+                              nmeaArraystr);
         stringstream ss;
         for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
             ss << *itor;
@@ -3297,24 +3244,23 @@ GnssAdapter::reportEnginePositions(unsigned int count,
         }
     }
 
-    GnssLocationInfoNotification locationInfo[LOC_OUTPUT_ENGINE_COUNT] = {};
+    GnssLocationInfoNotification locationInfo[LOC_OUTPUT_ENGINE_COUNT];
     for (unsigned int i = 0; i < count; i++) {
         const EngineLocationInfo* engLocation = (locationArr+i);
+        // converted once, for the fused clients and the engine clients alike
+        LocationReport report(engLocation->location,
+                              engLocation->locationExtended,
+                              engLocation->location.tech_mask,
+                              locationInfo[i]);
         // if it is fused/default location, call reportPosition maintain legacy behavior
         if ((GPS_LOCATION_EXTENDED_HAS_OUTPUT_ENG_TYPE & engLocation->locationExtended.flags) &&
             (LOC_OUTPUT_ENGINE_FUSED == engLocation->locationExtended.locOutputEngType)) {
-            reportPosition(engLocation->location,
-                           engLocation->locationExtended,
-                           engLocation->sessionStatus,
-                           engLocation->location.tech_mask);
+            reportPosition(report, engLocation->sessionStatus, engLocation->location.tech_mask);
         }
 
         if (needReportEnginePositions) {
-            convertLocationInfo(locationInfo[i], engLocation->locationExtended);
-            convertLocation(locationInfo[i].location,
-                            engLocation->location,
-                            engLocation->locationExtended,
-                            engLocation->location.tech_mask);
+            // the engine clients get it from locationInfo[i]
+            report.materializeLocationInfo();
         }
     }
 
@@ -3490,16 +3436,15 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
         }
     }
 
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssSvCb) {
-            it->second.gnssSvCb(svNotify);
-        }
+    for (const gnssSvCallback* svCb : mSvDispatch) {
+        (*svCb)(svNotify);
     }
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
-        !mTimeBasedTrackingSessions.empty()) {
+        !mTimeBasedTrackingSessions.empty() &&
+        (mNmeaApSentenceMask & LOC_NMEA_MASK_GSV_V02)) {
         std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_sv(svNotify, nmeaArraystr);
+        loc_nmea_generate_sv(svNotify, mNmeaApSentenceMask, nmeaArraystr);
         stringstream ss;
         for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
             ss << *itor;
@@ -3514,9 +3459,14 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
 void
 GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
 {
-    if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
-        !loc_nmea_is_debug(nmea, length)) {
-        return;
+    if (!loc_nmea_is_debug(nmea, length)) {
+        // with the AP NMEA only the debug sentences of the modem are of use; the
+        // others go straight to the pipeline when there is one, the debug ones
+        // are for SystemStatus, on the adapter thread
+        if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER ||
+            mNmeaPipeline.push(nmea, length)) {
+            return;
+        }
     }
 
     struct MsgReportNmea : public LocMsg {
@@ -3560,6 +3510,10 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
 void
 GnssAdapter::reportNmea(const char* nmea, size_t length)
 {
+    if (mNmeaPipeline.push(nmea, length)) {
+        return;
+    }
+
     GnssNmeaNotification nmeaNotification = {};
     nmeaNotification.size = sizeof(GnssNmeaNotification);
 
@@ -3570,10 +3524,8 @@ GnssAdapter::reportNmea(const char* nmea, size_t length)
     nmeaNotification.nmea = nmea;
     nmeaNotification.length = length;
 
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssNmeaCb) {
-            it->second.gnssNmeaCb(nmeaNotification);
-        }
+    for (const gnssNmeaCallback* nmeaCb : mNmeaDispatch) {
+        (*nmeaCb)(nmeaNotification);
     }
 }
 
@@ -3618,10 +3570,8 @@ GnssAdapter::reportData(GnssDataNotification& dataNotify)
             LOC_LOGv("agc[%d]=%f", sig, dataNotify.agc[sig]);
         }
     }
-    for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssDataCb) {
-            it->second.gnssDataCb(dataNotify);
-        }
+    for (const gnssDataCallback* dataCb : mDataDispatch) {
+        (*dataCb)(dataNotify);
     }
 }
 
@@ -3925,10 +3875,8 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
 void
 GnssAdapter::reportGnssMeasurementData(const GnssMeasurementsNotification& measurements)
 {
-    for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
-        if (nullptr != it->second.gnssMeasurementsCb) {
-            it->second.gnssMeasurementsCb(measurements);
-        }
+    for (const gnssMeasurementsCallback* measurementsCb : mMeasurementsDispatch) {
+        (*measurementsCb)(measurements);
     }
 }
 
@@ -4109,6 +4057,108 @@ void GnssAdapter::odcpiTimerExpireEvent()
     };
     sendMsg(new MsgOdcpiTimerExpire(*this));
 }
+// Called in the context of LocTimer thread
+void TrackingReconfigureTimer::timeOutCallback()
+{
+    if (nullptr != mAdapter) {
+        mAdapter->trackingReconfigureTimerExpireEvent();
+    }
+}
+
+// Called in the context of LocTimer thread
+void GnssAdapter::trackingReconfigureTimerExpireEvent()
+{
+    struct MsgTrackingReconfigureTimerExpire : public LocMsg {
+        GnssAdapter& mAdapter;
+        inline MsgTrackingReconfigureTimerExpire(GnssAdapter& adapter) :
+                LocMsg(),
+                mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.trackingReconfigureTimerExpire();
+        }
+    };
+    sendMsg(new MsgTrackingReconfigureTimerExpire(*this));
+}
+
+void GnssAdapter::trackingReconfigureTimerExpire()
+{
+    LOC_LOGd("reconfigurePending: %d engine minInterval %u powerMode %u",
+            mTrackingReconfigurePending, mEngineTrackingOptions.minInterval,
+            mEngineTrackingOptions.powerMode);
+
+    mTrackingReconfigureTimer.stop();
+    if (!mTrackingReconfigurePending) {
+        return;
+    }
+    mTrackingReconfigurePending = false;
+
+    // apply whatever the sessions ask for by now, unless the engine is stopped
+    TrackingOptions multiplexedOptions;
+    if (0 != mEngineTrackingOptions.size &&
+        getMultiplexedTrackingOptions(multiplexedOptions) &&
+        !isEngineTrackingWith(multiplexedOptions)) {
+        adaptTrackingOptions(multiplexedOptions);
+        LocPosMode locPosMode = {};
+        convertOptions(locPosMode, multiplexedOptions);
+        mEngHubProxy->gnssSetFixMode(locPosMode);
+        mEngHubProxy->gnssStartFix();
+
+        mEngineTrackingOptions = multiplexedOptions;
+        mTrackingReconfigureTimer.start();
+        mLocApi->startTimeBasedTracking(multiplexedOptions, nullptr);
+    }
+}
+
+// Called in the context of LocTimer thread
+void TrackingHoldTimer::timeOutCallback()
+{
+    if (nullptr != mAdapter) {
+        mAdapter->trackingHoldTimerExpireEvent();
+    }
+}
+
+// Called in the context of LocTimer thread
+void GnssAdapter::trackingHoldTimerExpireEvent()
+{
+    struct MsgTrackingHoldTimerExpire : public LocMsg {
+        GnssAdapter& mAdapter;
+        inline MsgTrackingHoldTimerExpire(GnssAdapter& adapter) :
+                LocMsg(),
+                mAdapter(adapter) {}
+        inline virtual void proc() const {
+            mAdapter.trackingHoldTimerExpire();
+        }
+    };
+    sendMsg(new MsgTrackingHoldTimerExpire(*this));
+}
+
+void GnssAdapter::trackingHoldTimerExpire()
+{
+    // a fix or a stop may have come in after the timer went off
+    TrackingOptions requestedOptions;
+    if (!mTrackingHoldTimer.isActive() || !mStationaryDetector.isStationary() ||
+        !getMultiplexedTrackingOptions(requestedOptions)) {
+        mTrackingHoldTimer.stop();
+        return;
+    }
+
+    // the device has not moved beyond the uncertainty of the held fix, so it
+    // still stands, only its time moves on
+    GnssLocationInfoNotification locationInfo;
+    if (mHeldHasLocationInfo) {
+        locationInfo = mHeldLocationInfo;
+    } else {
+        memset(&locationInfo, 0, sizeof(locationInfo));
+        locationInfo.size = sizeof(locationInfo);
+        locationInfo.location = mHeldLocationInfo.location;
+    }
+    uint64_t heldMs = uptimeMillis() - mHeldLocationUptimeMs;
+    locationInfo.location.timestamp += heldMs;
+    LOC_LOGv("held fix %" PRIu64 " ms on", heldMs);
+    reportLocationInfo(LocationReport(locationInfo), true, mHeldReportToFlpClient);
+    mTrackingHoldTimer.start(requestedOptions.minInterval);
+}
+
 void GnssAdapter::odcpiTimerExpire()
 {
     LOC_LOGd("requestActive: %d timerActive: %d",
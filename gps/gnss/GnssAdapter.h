@@ -37,7 +37,12 @@
 #include <Agps.h>
 #include <SystemStatus.h>
 #include <XtraSystemStatusObserver.h>
+#include <StationaryDetector.h>
+#include <PositionPropagator.h>
+#include <LocationReport.h>
+#include <NmeaPipeline.h>
 #include <map>
+#include <set>
 
 #define MAX_URL_LEN 256
 #define NMEA_SENTENCE_MAX_LENGTH 200
@@ -46,11 +51,14 @@
 #define LOC_NI_NO_RESPONSE_TIME 20
 #define LOC_GPS_NI_RESPONSE_IGNORE 4
 #define ODCPI_EXPECTED_INJECTION_TIME_MS 10000
+#define TRACKING_RECONFIGURE_WINDOW_MS 1000
 
 class GnssAdapter;
 
 typedef std::map<LocationSessionKey, LocationOptions> LocationSessionMap;
 typedef std::map<LocationSessionKey, TrackingOptions> TrackingOptionsMap;
+typedef std::set<std::pair<uint32_t, LocationSessionKey>> TrackingIntervalIndex;
+typedef std::set<std::pair<GnssPowerMode, LocationSessionKey>> TrackingPowerModeIndex;
 
 class OdcpiTimer : public LocTimer {
 public:
@@ -81,6 +89,62 @@ private:
     bool mActive;
 };
 
+// While the device is stationary and the engine runs slower than the
+// clients asked for, hands the last fix to them again at their interval.
+class TrackingHoldTimer : public LocTimer {
+public:
+    TrackingHoldTimer(GnssAdapter* adapter) :
+            LocTimer(), mAdapter(adapter), mActive(false) {}
+
+    // restarts the timer if it runs already
+    inline void start(uint32_t interval) {
+        LocTimer::stop();
+        mActive = true;
+        LocTimer::start(interval, false);
+    }
+    inline void stop() {
+        mActive = false;
+        LocTimer::stop();
+    }
+    inline bool isActive() {
+        return mActive;
+    }
+
+private:
+    // Override
+    virtual void timeOutCallback() override;
+
+    GnssAdapter* mAdapter;
+    bool mActive;
+};
+
+// After the engine is reconfigured for the multiplexed tracking options,
+// further changes wait until this runs out, and then go in together.
+class TrackingReconfigureTimer : public LocTimer {
+public:
+    TrackingReconfigureTimer(GnssAdapter* adapter) :
+            LocTimer(), mAdapter(adapter), mActive(false) {}
+
+    inline void start() {
+        mActive = true;
+        LocTimer::start(TRACKING_RECONFIGURE_WINDOW_MS, false);
+    }
+    inline void stop() {
+        mActive = false;
+        LocTimer::stop();
+    }
+    inline bool isActive() {
+        return mActive;
+    }
+
+private:
+    // Override
+    virtual void timeOutCallback() override;
+
+    GnssAdapter* mAdapter;
+    bool mActive;
+};
+
 typedef struct {
     pthread_t               thread;        /* NI thread */
     uint32_t                respTimeLeft;  /* examine time for NI response */
@@ -122,6 +186,29 @@ typedef struct {
     double latLonDiffThreshold;
 } BlockCPIInfo;
 
+// The engine runs at the smallest interval of all time based tracking
+// sessions; a client is only handed a fix once its own minInterval has
+// passed since the previous one it got, and, if it asked for a minDistance
+// the modem does not filter on, it has moved that far since then. A client
+// that also has a distance based session is not filtered.
+typedef struct {
+    uint32_t minInterval;       // in milliseconds
+    uint32_t minDistance;       // in meters, 0 for none
+    uint64_t lastTimestamp;     // of the last fix handed over, 0 before the first
+    bool hasLastPosition;
+    double lastLatitude;
+    double lastLongitude;
+} TrackingReportFilter;
+typedef std::map<LocationAPI*, TrackingReportFilter> TrackingReportFilterMap;
+
+// A client that takes position reports, with what reportPosition needs to
+// know about it worked out when the client list changes, not per fix.
+typedef struct {
+    LocationAPI* client;
+    const LocationCallbacks* callbacks;     // points into mClientData
+    bool isFlpClient;
+} PositionDispatchEntry;
+
 using namespace loc_core;
 
 namespace loc_core {
@@ -141,13 +228,53 @@ class GnssAdapter : public LocAdapterBase {
 
     /* ==== TRACKING ======================================================================= */
     TrackingOptionsMap mTimeBasedTrackingSessions;
+    // the time based sessions by interval and by power mode, the first
+    // entries give the multiplexed options
+    TrackingIntervalIndex mTrackingIntervalIndex;
+    TrackingPowerModeIndex mTrackingPowerModeIndex;
+    // what the engine was last started with, size 0 while it is stopped
+    TrackingOptions mEngineTrackingOptions;
+    TrackingReconfigureTimer mTrackingReconfigureTimer;
+    bool mTrackingReconfigurePending;
+    // adaptive tracking: the engine interval and power mode while the device
+    // is stationary, from gps.conf, both 0 when it is off
+    uint32_t mStationaryTrackingInterval;
+    GnssPowerMode mStationaryTrackingPowerMode;
+    StationaryDetector mStationaryDetector;
+    TrackingHoldTimer mTrackingHoldTimer;
+    // the held fix; the rest of its info only if a client takes it
+    GnssLocationInfoNotification mHeldLocationInfo;
+    bool mHeldHasLocationInfo;
+    uint64_t mHeldLocationUptimeMs;
+    bool mHeldReportToFlpClient;
+    // the last fixes of the tracking session, for getCurrentLocation
+    PositionPropagator mPositionPropagator;
     LocationSessionMap mDistanceBasedTrackingSessions;
+    TrackingReportFilterMap mTrackingReportFilters;
     LocPosMode mLocPositionMode;
     GnssSvUsedInPosition mGnssSvIdUsedInPosition;
     bool mGnssSvIdUsedInPosAvail;
     GnssSvMbUsedInPosition mGnssMbSvIdUsedInPosition;
     bool mGnssMbSvIdUsedInPosAvail;
 
+    /* ==== CLIENT DISPATCH ================================================================ */
+    // per event type, the clients that have a callback for it, rebuilt from
+    // mClientData whenever a client is added or removed
+    std::vector<PositionDispatchEntry> mPositionDispatch;
+    // whether one of them takes the GnssLocationInfoNotification
+    bool mPositionInfoDispatch;
+    std::vector<const gnssSvCallback*> mSvDispatch;
+    std::vector<const gnssNmeaCallback*> mNmeaDispatch;
+    // delivers to the mNmeaDispatch clients instead, if gps.conf turns it on
+    NmeaPipeline mNmeaPipeline;
+    // sentences the AP NMEA generator makes for the mNmeaDispatch clients,
+    // and the gps.conf selection it is taken from
+    NmeaSentenceTypesMask mNmeaApSentenceMask;
+    NmeaSentenceTypesMask mNmeaApConfSentenceMask;
+    std::vector<const gnssDataCallback*> mDataDispatch;
+    std::vector<const gnssMeasurementsCallback*> mMeasurementsDispatch;
+    void updateClientsDispatch();
+
     /* ==== CONTROL ======================================================================== */
     LocationControlCallbacks mControlCallbacks;
     uint32_t mAfwControlId;
@@ -199,13 +326,6 @@ class GnssAdapter : public LocAdapterBase {
 
     /*==== CONVERSION ===================================================================*/
     static void convertOptions(LocPosMode& out, const TrackingOptions& trackingOptions);
-    static void convertLocation(Location& out, const UlpLocation& ulpLocation,
-                                const GpsLocationExtended& locationExtended,
-                                const LocPosTechMask techMask);
-    static void convertLocationInfo(GnssLocationInfoNotification& out,
-                                    const GpsLocationExtended& locationExtended);
-    static uint16_t getNumSvUsed(uint64_t svUsedIdsMask,
-                                 int totalSvCntInThisConstellation);
 
     /* ======== UTILITIES ================================================================== */
     inline void initOdcpi(const OdcpiRequestCallback& callback);
@@ -240,6 +360,9 @@ public:
     void updateTrackingOptionsCommand(
             LocationAPI* client, uint32_t id, TrackingOptions& trackingOptions);
     void stopTrackingCommand(LocationAPI* client, uint32_t id);
+    /* the position at timestamp (ms since the epoch, 0 for now), propagated from
+       the last fixes of the tracking session; answered on the client thread */
+    bool getCurrentLocation(uint64_t timestamp, Location& location);
     /* ======== RESPONSES ================================================================== */
     void reportResponse(LocationAPI* client, LocationError err, uint32_t sessionId);
     /* ======== UTILITIES ================================================================== */
@@ -251,6 +374,21 @@ public:
     void saveTrackingSession(LocationAPI* client, uint32_t sessionId,
                              const TrackingOptions& trackingOptions);
     void eraseTrackingSession(LocationAPI* client, uint32_t sessionId);
+    void updateTrackingReportFilter(LocationAPI* client);
+    bool getMultiplexedTrackingOptions(TrackingOptions& options,
+                                       const LocationSessionKey* excludedKey = nullptr);
+    bool isEngineTrackingWith(const TrackingOptions& options);
+    bool canReconfigureTracking();
+    void trackingReconfigureTimerExpire();
+    inline bool isAdaptiveTrackingEnabled() {
+        return (0 != mStationaryTrackingInterval ||
+                GNSS_POWER_MODE_INVALID != mStationaryTrackingPowerMode);
+    }
+    void adaptTrackingOptions(TrackingOptions& options);
+    void updateAdaptiveTracking(const LocationReport& report,
+                                bool reportToFlpClient);
+    void trackingHoldTimerExpire();
+    bool isTrackingReportDue(LocationAPI* client, const Location& location);
 
     bool setLocPositionMode(const LocPosMode& mode);
     LocPosMode& getLocPositionMode() { return mLocPositionMode; }
@@ -343,6 +481,8 @@ public:
     void initDefaultAgps();
     bool initEngHubProxy();
     void odcpiTimerExpireEvent();
+    void trackingReconfigureTimerExpireEvent();
+    void trackingHoldTimerExpireEvent();
 
     /* ==== REPORTS ======================================================================== */
     /* ======== EVENTS ====(Called from QMI/EngineHub Thread)===================================== */
@@ -387,6 +527,11 @@ public:
                         const GpsLocationExtended &locationExtended,
                         enum loc_sess_status status,
                         LocPosTechMask techMask);
+    void reportPosition(const LocationReport& report,
+                        enum loc_sess_status status,
+                        LocPosTechMask techMask);
+    void reportLocationInfo(const LocationReport& report,
+                            bool reportToGnssClient, bool reportToFlpClient);
     void reportEnginePositions(unsigned int count,
                                const EngineLocationInfo* locationArr);
     void reportSv(GnssSvNotification& svNotify);
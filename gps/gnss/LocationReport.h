@@ -0,0 +1,83 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef LOCATION_REPORT_H
+#define LOCATION_REPORT_H
+
+#include <LocationDataTypes.h>
+#include <gps_extended_c.h>
+#include <stdint.h>
+
+// One fix of an epoch as the clients get it, converted from the engine report
+// once, however many clients and views it goes to.
+//
+// The Location is converted right away, as most clients only want that. The
+// GnssLocationInfoNotification, which carries the measurement usage of every
+// SV and is large, is only converted the first time it is asked for, so an
+// epoch without gnssLocationInfoCb or engineLocationsInfoCb clients never
+// builds it. Both are built in the GnssLocationInfoNotification the report is
+// given, so that engine fixes go right into the array the engine clients get.
+// The report refers to what it was made from and must not outlive it.
+class LocationReport {
+public:
+    LocationReport(const UlpLocation& ulpLocation,
+                   const GpsLocationExtended& locationExtended,
+                   LocPosTechMask techMask,
+                   GnssLocationInfoNotification& locationInfo);
+    // a fix converted before, like a held one
+    LocationReport(GnssLocationInfoNotification& locationInfo);
+
+    inline const Location& getLocation() const { return mLocationInfo.location; }
+    const GnssLocationInfoNotification& getLocationInfo() const;
+    // builds the rest of the GnssLocationInfoNotification the report was
+    // given, for one that is read from there rather than through the report
+    void materializeLocationInfo() const;
+    // NULL for a report made from a GnssLocationInfoNotification
+    inline const UlpLocation* getUlpLocation() const { return mUlpLocation; }
+    inline const GpsLocationExtended* getLocationExtended() const {
+        return mLocationExtended;
+    }
+
+    static void convertLocation(Location& out, const UlpLocation& ulpLocation,
+                                const GpsLocationExtended& locationExtended,
+                                const LocPosTechMask techMask);
+    // fills everything but out.location, which is left as it is
+    static void convertLocationInfo(GnssLocationInfoNotification& out,
+                                    const GpsLocationExtended& locationExtended);
+    static uint16_t getNumSvUsed(uint64_t svUsedIdsMask,
+                                 int totalSvCntInThisConstellation);
+
+private:
+    const UlpLocation* mUlpLocation;
+    const GpsLocationExtended* mLocationExtended;
+    // location is always valid, the rest once mHasLocationInfo is set
+    GnssLocationInfoNotification& mLocationInfo;
+    mutable bool mHasLocationInfo;
+};
+
+#endif /* LOCATION_REPORT_H */
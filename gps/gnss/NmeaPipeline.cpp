@@ -0,0 +1,227 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_NmeaPipeline"
+
+#include <NmeaPipeline.h>
+#include <inttypes.h>
+#include <log_util.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+// below the default priority of the adapter and LocApi threads
+#define NMEA_PIPELINE_NICE 10
+
+// the LocThread deletes its runnable, so it only points at the client
+class NmeaPipelineRunnable : public LocRunnable {
+    NmeaPipeline& mPipeline;
+    NmeaPipeline::Client& mClient;
+public:
+    inline NmeaPipelineRunnable(NmeaPipeline& pipeline, NmeaPipeline::Client& client) :
+        mPipeline(pipeline), mClient(client) {}
+    virtual void prerun() override {
+        // on Linux this only applies to the calling thread
+        if (0 != setpriority(PRIO_PROCESS, 0, NMEA_PIPELINE_NICE)) {
+            LOC_LOGw("failed to lower the priority of the NMEA delivery thread");
+        }
+    }
+    virtual bool run() override {
+        return mPipeline.deliver(mClient);
+    }
+};
+
+NmeaPipeline::NmeaPipeline() :
+    mDepth(0)
+{
+    pthread_mutex_init(&mLock, NULL);
+}
+
+NmeaPipeline::~NmeaPipeline()
+{
+    pthread_mutex_lock(&mLock);
+    std::vector<Client*> clients;
+    clients.swap(mClients);
+    pthread_mutex_unlock(&mLock);
+    stopClients(clients);
+    pthread_mutex_destroy(&mLock);
+}
+
+void
+NmeaPipeline::start(uint32_t depth)
+{
+    if (0 == depth || 0 != mDepth) {
+        return;
+    }
+    pthread_mutex_lock(&mLock);
+    mDepth = depth;
+    pthread_mutex_unlock(&mLock);
+    LOC_LOGd("NMEA delivered from threads of its own, %u sentences per client", depth);
+}
+
+void
+NmeaPipeline::setClients(const ClientList& clients)
+{
+    if (0 == mDepth) {
+        return;
+    }
+
+    pthread_mutex_lock(&mLock);
+    std::vector<Client*> oldClients;
+    oldClients.swap(mClients);
+    for (const auto& it : clients) {
+        Client* client = NULL;
+        for (auto old = oldClients.begin(); old != oldClients.end(); ++old) {
+            if ((*old)->client == it.first) {
+                client = *old;
+                oldClients.erase(old);
+                break;
+            }
+        }
+        if (NULL == client) {
+            client = new Client();
+            client->client = it.first;
+            client->ring.resize(mDepth);
+            client->first = 0;
+            client->count = 0;
+            client->dropped = 0;
+            pthread_mutex_init(&client->lock, NULL);
+            pthread_cond_init(&client->cond, NULL);
+            client->waiting = false;
+            client->stopping = false;
+            NmeaPipelineRunnable* runnable = new NmeaPipelineRunnable(*this, *client);
+            if (!client->thread.start("NmeaPipeline", runnable)) {
+                LOC_LOGe("failed to start the NMEA delivery thread of client %p", it.first);
+                delete runnable;
+                pthread_cond_destroy(&client->cond);
+                pthread_mutex_destroy(&client->lock);
+                delete client;
+                continue;
+            }
+        }
+        // the delivery thread picks it up with its next sentence, it may be
+        // calling the old one right now
+        pthread_mutex_lock(&client->lock);
+        client->nmeaCb = it.second;
+        client->nmeaCbChanged = true;
+        pthread_mutex_unlock(&client->lock);
+        mClients.push_back(client);
+    }
+    pthread_mutex_unlock(&mLock);
+
+    stopClients(oldClients);
+}
+
+void
+NmeaPipeline::stopClients(const std::vector<Client*>& clients)
+{
+    // out of the client list already, so only their delivery threads know them
+    for (Client* client : clients) {
+        pthread_mutex_lock(&client->lock);
+        client->stopping = true;
+        pthread_cond_signal(&client->cond);
+        pthread_mutex_unlock(&client->lock);
+    }
+    for (Client* client : clients) {
+        // joins, so a callback under way has returned after this
+        client->thread.stop();
+        pthread_cond_destroy(&client->cond);
+        pthread_mutex_destroy(&client->lock);
+        delete client;
+    }
+}
+
+bool
+NmeaPipeline::push(const char* nmea, size_t length)
+{
+    struct timeval tv;
+    gettimeofday(&tv, (struct timezone *) NULL);
+    int64_t now = tv.tv_sec * 1000LL + tv.tv_usec / 1000;
+
+    pthread_mutex_lock(&mLock);
+    if (0 == mDepth) {
+        pthread_mutex_unlock(&mLock);
+        return false;
+    }
+    for (Client* client : mClients) {
+        pthread_mutex_lock(&client->lock);
+        if (client->count == mDepth) {
+            client->first = (client->first + 1) % mDepth;
+            client->count--;
+            if (0 == client->dropped++ % 100) {
+                LOC_LOGw("client %p behind, %" PRIu64 " sentences dropped",
+                         client->client, client->dropped);
+            }
+        }
+        // assign keeps the capacity of the slot, so it stops allocating once warm
+        NmeaEntry& entry = client->ring[(client->first + client->count) % mDepth];
+        entry.nmea.assign(nmea, length);
+        entry.timestamp = now;
+        client->count++;
+        if (client->waiting) {
+            pthread_cond_signal(&client->cond);
+        }
+        pthread_mutex_unlock(&client->lock);
+    }
+    pthread_mutex_unlock(&mLock);
+    return true;
+}
+
+bool
+NmeaPipeline::deliver(Client& client)
+{
+    pthread_mutex_lock(&client.lock);
+    while (!client.stopping && 0 == client.count) {
+        client.waiting = true;
+        pthread_cond_wait(&client.cond, &client.lock);
+        client.waiting = false;
+    }
+    if (client.stopping) {
+        pthread_mutex_unlock(&client.lock);
+        return false;
+    }
+    // the swap hands the slot the capacity of the sentence delivered before
+    NmeaEntry& entry = client.ring[client.first];
+    client.delivery.nmea.swap(entry.nmea);
+    client.delivery.timestamp = entry.timestamp;
+    client.first = (client.first + 1) % mDepth;
+    client.count--;
+    if (client.nmeaCbChanged) {
+        client.deliveryCb = client.nmeaCb;
+        client.nmeaCbChanged = false;
+    }
+    pthread_mutex_unlock(&client.lock);
+
+    GnssNmeaNotification nmeaNotification = {};
+    nmeaNotification.size = sizeof(GnssNmeaNotification);
+    nmeaNotification.timestamp = client.delivery.timestamp;
+    nmeaNotification.nmea = client.delivery.nmea.c_str();
+    nmeaNotification.length = client.delivery.nmea.length();
+    client.deliveryCb(nmeaNotification);
+    return true;
+}
@@ -0,0 +1,106 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef NMEA_PIPELINE_H
+#define NMEA_PIPELINE_H
+
+#include <LocationDataTypes.h>
+#include <LocThread.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class LocationAPI;
+
+// Delivers NMEA to the gnssNmeaCb clients on threads of their own, so that
+// sentences neither wait behind nor delay fixes on the adapter thread.
+//
+// Each client has a ring of depth sentences, emptied by a delivery thread of
+// its own that runs at a lower priority. When a client falls behind, the
+// oldest sentence in its ring is dropped, so a slow client only ever loses
+// its own sentences and never holds up another one. The one thread that
+// produces sentences, the LocApi thread for the modem NMEA or the adapter
+// thread for the AP NMEA, pushes them. Each ring has a lock of its own, which
+// pushing and taking a sentence only hold to copy it in or swap it out, so a
+// delivery thread can only hold up the producer for one sentence of its own
+// ring, never behind another client. The callbacks run without any lock, on a
+// copy of the callback that the delivery thread takes under the ring lock.
+// Once setClients returns, a client that is no longer in the list gets no
+// more callbacks.
+class NmeaPipeline {
+public:
+    typedef std::vector<std::pair<LocationAPI*, gnssNmeaCallback>> ClientList;
+
+    NmeaPipeline();
+    ~NmeaPipeline();
+
+    // turns the pipeline on with rings of depth sentences, 0 keeps it off
+    void start(uint32_t depth);
+    // called on the thread that calls start and setClients
+    inline bool isStarted() const { return 0 != mDepth; }
+    void setClients(const ClientList& clients);
+    // false if the pipeline is not started, so the caller delivers itself
+    bool push(const char* nmea, size_t length);
+
+    typedef struct {
+        std::string nmea;
+        int64_t timestamp;
+    } NmeaEntry;
+
+    typedef struct {
+        LocationAPI* client;
+        // guards all below, but for the delivery entries
+        pthread_mutex_t lock;
+        gnssNmeaCallback nmeaCb;
+        bool nmeaCbChanged;         // deliveryCb is to be copied from nmeaCb
+        std::vector<NmeaEntry> ring;
+        uint32_t first;             // index of the oldest sentence
+        uint32_t count;
+        uint64_t dropped;
+        pthread_cond_t cond;
+        bool waiting;
+        bool stopping;
+        LocThread thread;
+        NmeaEntry delivery;         // the sentence being delivered, thread only
+        gnssNmeaCallback deliveryCb;    // the callback it goes to, thread only
+    } Client;
+
+    // one sentence to the client, on its delivery thread; false once stopping
+    bool deliver(Client& client);
+
+private:
+    void stopClients(const std::vector<Client*>& clients);
+
+    // guards the client list; taken before the lock of a client
+    pthread_mutex_t mLock;
+    uint32_t mDepth;
+    std::vector<Client*> mClients;
+};
+
+#endif /* NMEA_PIPELINE_H */
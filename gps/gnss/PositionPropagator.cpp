@@ -0,0 +1,231 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <PositionPropagator.h>
+#include <loc_geo.h>
+#include <math.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define PROPAGATOR_MAX_HORIZON_MS       10000
+// fixes further apart than that are not interpolated between
+#define PROPAGATOR_MAX_GAP_MS           5000
+#define PROPAGATOR_ACCELERATION         2.0     // m/s^2
+#define PROPAGATOR_VELOCITY_UNCERTAINTY 1.0f    // m/s, when the fix has none
+
+PositionPropagator::PositionPropagator() :
+    mCount(0)
+{
+    pthread_mutex_init(&mLock, NULL);
+    memset(mFixes, 0, sizeof(mFixes));
+}
+
+PositionPropagator::~PositionPropagator()
+{
+    pthread_mutex_destroy(&mLock);
+}
+
+void
+PositionPropagator::reset()
+{
+    pthread_mutex_lock(&mLock);
+    mCount = 0;
+    pthread_mutex_unlock(&mLock);
+}
+
+void
+PositionPropagator::addLocation(const Location& location,
+                                const GpsLocationExtended& locationExtended)
+{
+    if (!(location.flags & LOCATION_HAS_LAT_LONG_BIT)) {
+        return;
+    }
+
+    Fix fix;
+    memset(&fix, 0, sizeof(fix));
+    fix.location = location;
+    if ((locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_NORTH_VEL) &&
+        (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_EAST_VEL)) {
+        fix.northVelocity = locationExtended.northVelocity;
+        fix.eastVelocity = locationExtended.eastVelocity;
+        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_UP_VEL) {
+            fix.upVelocity = locationExtended.upVelocity;
+        }
+        fix.hasVelocity = true;
+    } else if ((location.flags & LOCATION_HAS_SPEED_BIT) &&
+               (location.flags & LOCATION_HAS_BEARING_BIT)) {
+        fix.northVelocity = location.speed * cos(LOC_GEO_DEG_TO_RAD(location.bearing));
+        fix.eastVelocity = location.speed * sin(LOC_GEO_DEG_TO_RAD(location.bearing));
+        fix.hasVelocity = true;
+    }
+    if ((locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_NORTH_VEL_UNC) &&
+        (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_EAST_VEL_UNC)) {
+        fix.velocityUncertainty = sqrtf(
+                locationExtended.northVelocityStdDeviation *
+                locationExtended.northVelocityStdDeviation +
+                locationExtended.eastVelocityStdDeviation *
+                locationExtended.eastVelocityStdDeviation);
+    } else if (location.flags & LOCATION_HAS_SPEED_ACCURACY_BIT) {
+        fix.velocityUncertainty = location.speedAccuracy;
+    } else {
+        fix.velocityUncertainty = PROPAGATOR_VELOCITY_UNCERTAINTY;
+    }
+
+    pthread_mutex_lock(&mLock);
+    if (0 == mCount || location.timestamp > mFixes[1].location.timestamp) {
+        mFixes[0] = mFixes[1];
+        mFixes[1] = fix;
+        if (mCount < 2) {
+            mCount++;
+        }
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+bool
+PositionPropagator::getLocation(uint64_t timestamp, Location& location)
+{
+    pthread_mutex_lock(&mLock);
+    uint32_t count = mCount;
+    Fix previous = mFixes[0];
+    Fix last = mFixes[1];
+    pthread_mutex_unlock(&mLock);
+
+    if (0 == count) {
+        return false;
+    }
+    if (timestamp >= last.location.timestamp) {
+        if (timestamp - last.location.timestamp > PROPAGATOR_MAX_HORIZON_MS) {
+            return false;
+        }
+        extrapolate(last, timestamp, location);
+        return true;
+    }
+    if (count < 2 || timestamp < previous.location.timestamp ||
+        last.location.timestamp - previous.location.timestamp > PROPAGATOR_MAX_GAP_MS) {
+        return false;
+    }
+    interpolate(previous, last, timestamp, location);
+    return true;
+}
+
+// a longitude, or the difference of two, in [-180, 180), so that the way
+// across the antimeridian is the short one
+static double wrapLongitude(double longitude)
+{
+    return longitude - 360.0 * floor((longitude + 180.0) / 360.0);
+}
+
+// the horizontal offset of the second point from the first one, in meters
+static void localOffset(const Location& from, const Location& to, double& north, double& east)
+{
+    north = LOC_GEO_DEG_TO_RAD(to.latitude - from.latitude) * LOC_GEO_EARTH_RADIUS_M;
+    east = LOC_GEO_DEG_TO_RAD(wrapLongitude(to.longitude - from.longitude)) *
+           LOC_GEO_EARTH_RADIUS_M * cos(LOC_GEO_DEG_TO_RAD(from.latitude));
+}
+
+static void moveBy(const Location& from, double north, double east, Location& location)
+{
+    location.latitude = from.latitude + LOC_GEO_RAD_TO_DEG(north / LOC_GEO_EARTH_RADIUS_M);
+    location.longitude = wrapLongitude(from.longitude + LOC_GEO_RAD_TO_DEG(
+            east / (LOC_GEO_EARTH_RADIUS_M * cos(LOC_GEO_DEG_TO_RAD(from.latitude)))));
+}
+
+static void setVelocity(double north, double east, Location& location)
+{
+    location.speed = (float)sqrt(north * north + east * east);
+    if (location.speed > 0) {
+        double bearing = LOC_GEO_RAD_TO_DEG(atan2(east, north));
+        location.bearing = (float)((bearing < 0) ? bearing + 360 : bearing);
+    }
+}
+
+void
+PositionPropagator::interpolate(const Fix& from, const Fix& to, uint64_t timestamp,
+                                Location& location)
+{
+    double span = (to.location.timestamp - from.location.timestamp) / 1000.0;
+    double s = (timestamp - from.location.timestamp) / 1000.0 / span;
+    double toNorth = 0;
+    double toEast = 0;
+    localOffset(from.location, to.location, toNorth, toEast);
+
+    // cubic Hermite basis, the velocities only if both fixes have one
+    double h10 = 0;
+    double h01 = s;
+    double h11 = 0;
+    if (from.hasVelocity && to.hasVelocity) {
+        h10 = s * s * s - 2 * s * s + s;
+        h01 = -2 * s * s * s + 3 * s * s;
+        h11 = s * s * s - s * s;
+    }
+    double north = h10 * span * from.northVelocity + h01 * toNorth +
+                   h11 * span * to.northVelocity;
+    double east = h10 * span * from.eastVelocity + h01 * toEast +
+                  h11 * span * to.eastVelocity;
+
+    location = to.location;
+    location.timestamp = timestamp;
+    moveBy(from.location, north, east, location);
+    location.altitude = from.location.altitude + s * (to.location.altitude -
+                                                      from.location.altitude);
+    if (from.hasVelocity && to.hasVelocity) {
+        setVelocity(from.northVelocity + s * (to.northVelocity - from.northVelocity),
+                    from.eastVelocity + s * (to.eastVelocity - from.eastVelocity),
+                    location);
+    }
+    location.accuracy = from.location.accuracy + s * (to.location.accuracy -
+                                                      from.location.accuracy);
+    location.verticalAccuracy = from.location.verticalAccuracy +
+            s * (to.location.verticalAccuracy - from.location.verticalAccuracy);
+}
+
+void
+PositionPropagator::extrapolate(const Fix& from, uint64_t timestamp, Location& location)
+{
+    double dt = (timestamp - from.location.timestamp) / 1000.0;
+    location = from.location;
+    location.timestamp = timestamp;
+    if (from.hasVelocity) {
+        moveBy(from.location, from.northVelocity * dt, from.eastVelocity * dt, location);
+        location.altitude += from.upVelocity * dt;
+    }
+
+    // what the velocity and an unknown acceleration may have added since
+    double velocityError = from.velocityUncertainty * dt;
+    double accelerationError = PROPAGATOR_ACCELERATION * dt * dt / 2;
+    double growth = velocityError * velocityError + accelerationError * accelerationError;
+    location.accuracy = (float)sqrt(from.location.accuracy * from.location.accuracy + growth);
+    if (location.flags & LOCATION_HAS_VERTICAL_ACCURACY_BIT) {
+        location.verticalAccuracy = (float)sqrt(from.location.verticalAccuracy *
+                                                from.location.verticalAccuracy + growth);
+    }
+    if (location.flags & LOCATION_HAS_SPEED_ACCURACY_BIT) {
+        location.speedAccuracy += (float)(PROPAGATOR_ACCELERATION * dt);
+    }
+}
@@ -0,0 +1,77 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef POSITION_PROPAGATOR_H
+#define POSITION_PROPAGATOR_H
+
+#include <LocationDataTypes.h>
+#include <gps_extended_c.h>
+#include <pthread.h>
+#include <stdint.h>
+
+// Answers where the device is at a given time from the last two fixes, for
+// clients that need positions more often than the engine makes them.
+//
+// Between the two fixes the position follows a cubic through both of them
+// and their velocities. After the last one it is dead reckoned at the last
+// velocity, for up to PROPAGATOR_MAX_HORIZON_MS. The horizontal and vertical
+// accuracies grow with the velocity uncertainty and an unknown acceleration
+// of PROPAGATOR_ACCELERATION m/s^2. Fixes are added on the adapter thread;
+// queries come from the client threads and only take the lock for a copy.
+class PositionPropagator {
+public:
+    PositionPropagator();
+    ~PositionPropagator();
+
+    void addLocation(const Location& location, const GpsLocationExtended& locationExtended);
+    // timestamp in ms since the epoch, as in Location; false if there is no
+    // fix to go from, or the time is before the previous or too far after
+    // the last one
+    bool getLocation(uint64_t timestamp, Location& location);
+    void reset();
+
+private:
+    typedef struct {
+        Location location;
+        double northVelocity;       // meters per second
+        double eastVelocity;
+        double upVelocity;
+        float velocityUncertainty;  // meters per second, horizontal
+        bool hasVelocity;
+    } Fix;
+
+    static void interpolate(const Fix& from, const Fix& to, uint64_t timestamp,
+                            Location& location);
+    static void extrapolate(const Fix& from, uint64_t timestamp, Location& location);
+
+    pthread_mutex_t mLock;
+    Fix mFixes[2];                  // the previous and the last fix
+    uint32_t mCount;
+};
+
+#endif /* POSITION_PROPAGATOR_H */
@@ -0,0 +1,84 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <StationaryDetector.h>
+#include <loc_geo.h>
+
+StationaryDetector::StationaryDetector(float maxSpeed, uint32_t minFixes) :
+    mMaxSpeed(maxSpeed),
+    mMinFixes(minFixes),
+    mStationary(false),
+    mStillFixes(0),
+    mAnchorLatitude(0),
+    mAnchorLongitude(0),
+    mAnchorAccuracy(0)
+{
+}
+
+void
+StationaryDetector::configure(float maxSpeed, uint32_t minFixes)
+{
+    mMaxSpeed = maxSpeed;
+    mMinFixes = (minFixes > 0) ? minFixes : 1;
+    reset();
+}
+
+void
+StationaryDetector::reset()
+{
+    mStationary = false;
+    mStillFixes = 0;
+}
+
+bool
+StationaryDetector::addLocation(const Location& location)
+{
+    if (!(location.flags & LOCATION_HAS_LAT_LONG_BIT)) {
+        return false;
+    }
+    float accuracy = (location.flags & LOCATION_HAS_ACCURACY_BIT) ? location.accuracy : 0.0f;
+    bool still = !(location.flags & LOCATION_HAS_SPEED_BIT) || location.speed <= mMaxSpeed;
+    if (still && mStillFixes > 0) {
+        double distance = loc_geo_distance(mAnchorLatitude, mAnchorLongitude,
+                                           location.latitude, location.longitude);
+        still = distance <= ((accuracy > mAnchorAccuracy) ? accuracy : mAnchorAccuracy);
+    }
+
+    bool wasStationary = mStationary;
+    if (still && mStillFixes > 0) {
+        mStillFixes++;
+    } else {
+        // moving, or the first still fix: a new run starts here
+        mStillFixes = still ? 1 : 0;
+        mAnchorLatitude = location.latitude;
+        mAnchorLongitude = location.longitude;
+        mAnchorAccuracy = accuracy;
+    }
+    mStationary = (mStillFixes >= mMinFixes);
+    return (mStationary != wasStationary);
+}
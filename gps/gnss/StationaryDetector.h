@@ -0,0 +1,63 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef STATIONARY_DETECTOR_H
+#define STATIONARY_DETECTOR_H
+
+#include <LocationDataTypes.h>
+#include <stdint.h>
+
+// Tells from consecutive fixes whether the device is sitting still, so that
+// the tracking session can be slowed down while it is.
+//
+// A fix is still when its speed, if it has one, is at most the speed limit
+// and it lies within the horizontal uncertainty of the fix that started the
+// still run (or its own, whichever is larger). The device is stationary once
+// that many consecutive fixes were still, and moving again on the first fix
+// that is not.
+class StationaryDetector {
+public:
+    StationaryDetector(float maxSpeed = 0.5f, uint32_t minFixes = 5);
+
+    void configure(float maxSpeed, uint32_t minFixes);
+    // returns true if the fix changed the state
+    bool addLocation(const Location& location);
+    inline bool isStationary() const { return mStationary; }
+    void reset();
+
+private:
+    float mMaxSpeed;            // meters per second
+    uint32_t mMinFixes;
+    bool mStationary;
+    uint32_t mStillFixes;       // 0 when there is no anchor
+    double mAnchorLatitude;
+    double mAnchorLongitude;
+    float mAnchorAccuracy;
+};
+
+#endif /* STATIONARY_DETECTOR_H */
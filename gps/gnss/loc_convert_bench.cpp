@@ -0,0 +1,215 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocationReport.h>
+#include <loc_test_util.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Times the conversion of one epoch from the engine report to what the
+// clients get, per kind of client, both the way it is done now, through
+// LocationReport, and the way it was done before, with a full
+// GnssLocationInfoNotification per fix and another one per engine fix.
+//
+// usage: loc_convert_bench [-n epochs] [-m measurements] [-e engines]
+//   -n  epochs to convert per case, 1000000 by default
+//   -m  measurements used in the fix, 40 by default
+//   -e  engine fixes per epoch, the first one fused, 3 by default
+
+static void makeFix(EngineLocationInfo& fix, int measurements, LocOutputEngineType engine)
+{
+    memset(&fix, 0, sizeof(fix));
+    UlpLocation& ulp = fix.location;
+    ulp.gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+            LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+            LOC_GPS_LOCATION_HAS_ACCURACY;
+    ulp.gpsLocation.latitude = 37.4;
+    ulp.gpsLocation.longitude = -122.1;
+    ulp.gpsLocation.altitude = 30;
+    ulp.gpsLocation.speed = 12;
+    ulp.gpsLocation.bearing = 90;
+    ulp.gpsLocation.accuracy = 4;
+    ulp.gpsLocation.timestamp = 1600000000000ULL;
+    ulp.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+
+    GpsLocationExtended& ext = fix.locationExtended;
+    ext.flags = GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL |
+            GPS_LOCATION_EXTENDED_HAS_EXT_DOP | GPS_LOCATION_EXTENDED_HAS_VERT_UNC |
+            GPS_LOCATION_EXTENDED_HAS_SPEED_UNC | GPS_LOCATION_EXTENDED_HAS_BEARING_UNC |
+            GPS_LOCATION_EXTENDED_HAS_HOR_RELIABILITY |
+            GPS_LOCATION_EXTENDED_HAS_VERT_RELIABILITY |
+            GPS_LOCATION_EXTENDED_HAS_NORTH_VEL | GPS_LOCATION_EXTENDED_HAS_EAST_VEL |
+            GPS_LOCATION_EXTENDED_HAS_UP_VEL | GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA |
+            GPS_LOCATION_EXTENDED_HAS_POS_TECH_MASK | GPS_LOCATION_EXTENDED_HAS_GPS_TIME |
+            GPS_LOCATION_EXTENDED_HAS_OUTPUT_ENG_TYPE;
+    ext.vert_unc = 6;
+    ext.speed_unc = 0.3f;
+    ext.bearing_unc = 2;
+    ext.horizontal_reliability = LOC_RELIABILITY_HIGH;
+    ext.vertical_reliability = LOC_RELIABILITY_MEDIUM;
+    ext.eastVelocity = 12;
+    ext.gnss_sv_used_ids.gps_sv_used_ids_mask = 0x0f0f0f0fULL;
+    ext.gnss_sv_used_ids.glo_sv_used_ids_mask = 0x00ff00ffULL;
+    ext.gnss_sv_used_ids.gal_sv_used_ids_mask = 0x3333ULL;
+    ext.gnss_sv_used_ids.bds_sv_used_ids_mask = 0x0101010101ULL;
+    if (measurements > GNSS_SV_MAX) {
+        measurements = GNSS_SV_MAX;
+    }
+    ext.numOfMeasReceived = measurements;
+    for (int i = 0; i < measurements; i++) {
+        ext.measUsageInfo[i].gnssSvId = i + 1;
+    }
+    ext.locOutputEngType = engine;
+    fix.sessionStatus = LOC_SESS_SUCCESS;
+}
+
+// keeps the compiler from dropping what is converted
+static volatile double sSink;
+
+static void consume(const Location& location)
+{
+    sSink = location.latitude;
+}
+
+static void consume(const GnssLocationInfoNotification& locationInfo)
+{
+    sSink = locationInfo.location.latitude + locationInfo.numSvUsedInPosition;
+}
+
+// how GnssAdapter converted a fix before LocationReport: everything, always
+static void legacyConvert(GnssLocationInfoNotification& locationInfo,
+                          const EngineLocationInfo& fix)
+{
+    memset(&locationInfo, 0, sizeof(locationInfo));
+    LocationReport::convertLocationInfo(locationInfo, fix.locationExtended);
+    LocationReport::convertLocation(locationInfo.location, fix.location,
+                                    fix.locationExtended, fix.location.tech_mask);
+}
+
+typedef enum {
+    BENCH_TRACKING,             // trackingCb clients, like the HIDL client
+    BENCH_LOCATION_INFO,        // gnssLocationInfoCb clients
+    BENCH_ENGINES,              // engineLocationsInfoCb clients as well
+    BENCH_CASE_COUNT
+} BenchCase;
+
+static const char* sCaseNames[BENCH_CASE_COUNT] = {
+    "tracking", "location info", "engines"
+};
+
+static double run(BenchCase benchCase, bool legacy, const EngineLocationInfo* fixes,
+                  int engines, int epochs)
+{
+    static GnssLocationInfoNotification sEngineInfo[LOC_OUTPUT_ENGINE_COUNT];
+    static GnssLocationInfoNotification sInfo;
+    uint64_t startNs = threadCpuNs();
+    for (int epoch = 0; epoch < epochs; epoch++) {
+        if (legacy) {
+            // reportPosition for the fused fix, then reportEnginePositions again
+            legacyConvert(sInfo, fixes[0]);
+            if (BENCH_TRACKING == benchCase) {
+                consume(sInfo.location);
+            } else {
+                consume(sInfo);
+            }
+            if (BENCH_ENGINES == benchCase) {
+                for (int i = 0; i < engines; i++) {
+                    legacyConvert(sEngineInfo[i], fixes[i]);
+                }
+                consume(sEngineInfo[engines - 1]);
+            }
+        } else {
+            LocationReport report(fixes[0].location, fixes[0].locationExtended,
+                                  fixes[0].location.tech_mask, sEngineInfo[0]);
+            if (BENCH_TRACKING == benchCase) {
+                consume(report.getLocation());
+            } else {
+                consume(report.getLocationInfo());
+            }
+            if (BENCH_ENGINES == benchCase) {
+                for (int i = 1; i < engines; i++) {
+                    LocationReport engineReport(fixes[i].location, fixes[i].locationExtended,
+                                                fixes[i].location.tech_mask, sEngineInfo[i]);
+                    engineReport.materializeLocationInfo();
+                }
+                consume(sEngineInfo[engines - 1]);
+            }
+        }
+    }
+    return (threadCpuNs() - startNs) / 1e3 / epochs;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-n epochs] [-m measurements] [-e engines]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    int epochs = 1000000;
+    int measurements = 40;
+    int engines = 3;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "n:m:e:"))) {
+        switch (opt) {
+        case 'n':
+            epochs = atoi(optarg);
+            break;
+        case 'm':
+            measurements = atoi(optarg);
+            break;
+        case 'e':
+            engines = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (epochs <= 0 || engines <= 0 || engines > LOC_OUTPUT_ENGINE_COUNT) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    EngineLocationInfo fixes[LOC_OUTPUT_ENGINE_COUNT];
+    for (int i = 0; i < engines; i++) {
+        makeFix(fixes[i], measurements,
+                (0 == i) ? LOC_OUTPUT_ENGINE_FUSED : LOC_OUTPUT_ENGINE_SPE);
+    }
+
+    printf("%-16s %12s %12s\n", "clients", "before us", "now us");
+    for (int benchCase = 0; benchCase < BENCH_CASE_COUNT; benchCase++) {
+        double legacyUs = run((BenchCase)benchCase, true, fixes, engines, epochs);
+        double reportUs = run((BenchCase)benchCase, false, fixes, engines, epochs);
+        printf("%-16s %12.3f %12.3f\n", sCaseNames[benchCase], legacyUs, reportUs);
+    }
+    return 0;
+}
@@ -79,6 +79,7 @@ static void odcpiInject(const Location& location);
 static void blockCPI(double latitude, double longitude, float accuracy,
                      int blockDurationMsec, double latLonDiffThreshold);
 static void updateBatteryStatus(bool charging);
+static bool getCurrentLocation(uint64_t timestamp, Location& location);
 
 static const GnssInterface gGnssInterface = {
     sizeof(GnssInterface),
@@ -117,7 +118,8 @@ static const GnssInterface gGnssInterface = {
     nfwInit,
     getPowerStateChanges,
     injectLocationExt,
-    updateBatteryStatus
+    updateBatteryStatus,
+    getCurrentLocation
 };
 
 #ifndef DEBUG_X86
@@ -390,3 +392,12 @@ static void updateBatteryStatus(bool charging) {
         gGnssAdapter->getSystemStatus()->updatePowerConnectState(charging);
     }
 }
+
+static bool getCurrentLocation(uint64_t timestamp, Location& location)
+{
+    if (NULL != gGnssAdapter) {
+        return gGnssAdapter->getCurrentLocation(timestamp, location);
+    } else {
+        return false;
+    }
+}
@@ -0,0 +1,300 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <PositionPropagator.h>
+#include <loc_geo.h>
+#include <loc_test_util.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Runs PositionPropagator on synthetic fixes: interpolation between two
+// fixes with and without velocities, dead reckoning after the last one, both
+// across the antimeridian in either direction, the growth of the horizontal,
+// vertical and speed accuracies with time, and the times it declines to
+// answer for. The exit status is the number of failed checks.
+//
+// usage: position_propagator_test
+
+#define TEST_LATITUDE       37.4
+#define TEST_LONGITUDE      -122.1
+#define TEST_TIME_MS        1600000000000ULL
+#define TEST_ACCURACY       5.0f
+#define TEST_VERTICAL       8.0f
+// PositionPropagator assumes an unknown acceleration of up to that
+#define TEST_ACCELERATION   2.0
+
+static Location makeFix(uint64_t timestamp, double latitude, double longitude)
+{
+    Location location;
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT | LOCATION_HAS_ACCURACY_BIT |
+                     LOCATION_HAS_ALTITUDE_BIT | LOCATION_HAS_VERTICAL_ACCURACY_BIT;
+    location.timestamp = timestamp;
+    location.latitude = latitude;
+    location.longitude = longitude;
+    location.altitude = 100.0;
+    location.accuracy = TEST_ACCURACY;
+    location.verticalAccuracy = TEST_VERTICAL;
+    return location;
+}
+
+static GpsLocationExtended makeVelocity(double north, double east, float uncertainty)
+{
+    GpsLocationExtended extended;
+    memset(&extended, 0, sizeof(extended));
+    extended.size = sizeof(extended);
+    extended.flags = GPS_LOCATION_EXTENDED_HAS_NORTH_VEL | GPS_LOCATION_EXTENDED_HAS_EAST_VEL |
+                     GPS_LOCATION_EXTENDED_HAS_NORTH_VEL_UNC |
+                     GPS_LOCATION_EXTENDED_HAS_EAST_VEL_UNC;
+    extended.northVelocity = north;
+    extended.eastVelocity = east;
+    extended.northVelocityStdDeviation = uncertainty;
+    extended.eastVelocityStdDeviation = 0.0f;
+    return extended;
+}
+
+static GpsLocationExtended noVelocity()
+{
+    GpsLocationExtended extended;
+    memset(&extended, 0, sizeof(extended));
+    extended.size = sizeof(extended);
+    return extended;
+}
+
+// the point *meters* east of a longitude along a parallel
+static double eastOf(double latitude, double longitude, double meters)
+{
+    double lon = longitude + LOC_GEO_RAD_TO_DEG(
+            meters / (LOC_GEO_EARTH_RADIUS_M * cos(LOC_GEO_DEG_TO_RAD(latitude))));
+    return (lon >= 180.0) ? lon - 360.0 : ((lon < -180.0) ? lon + 360.0 : lon);
+}
+
+static bool inRange(double longitude)
+{
+    return longitude >= -180.0 && longitude < 180.0;
+}
+
+static double distance(const Location& a, double latitude, double longitude)
+{
+    return loc_geo_distance(a.latitude, a.longitude, latitude, longitude);
+}
+
+/* ==== INTERPOLATION ================================================================== */
+
+static void testInterpolate()
+{
+    // without velocities the position goes straight from one fix to the other
+    PositionPropagator straight;
+    double toLongitude = eastOf(TEST_LATITUDE, TEST_LONGITUDE, 40.0);
+    straight.addLocation(makeFix(TEST_TIME_MS, TEST_LATITUDE, TEST_LONGITUDE), noVelocity());
+    straight.addLocation(makeFix(TEST_TIME_MS + 2000, TEST_LATITUDE, toLongitude), noVelocity());
+    Location location;
+    bool straightAgrees = true;
+    for (uint64_t ms = 0; ms <= 2000; ms += 250) {
+        straightAgrees = straightAgrees &&
+                straight.getLocation(TEST_TIME_MS + ms, location) &&
+                location.timestamp == TEST_TIME_MS + ms &&
+                distance(location, TEST_LATITUDE,
+                         eastOf(TEST_LATITUDE, TEST_LONGITUDE, 40.0 * ms / 2000)) < 0.01;
+    }
+    expectTrue("interpolate without velocities goes straight", straightAgrees);
+
+    // at a constant velocity the cubic is the straight line as well; at the
+    // time of the last fix that fix is the answer, speed and all
+    PositionPropagator steady;
+    steady.addLocation(makeFix(TEST_TIME_MS, TEST_LATITUDE, TEST_LONGITUDE),
+                       makeVelocity(0.0, 20.0, 0.5f));
+    steady.addLocation(makeFix(TEST_TIME_MS + 2000, TEST_LATITUDE, toLongitude),
+                       makeVelocity(0.0, 20.0, 0.5f));
+    bool steadyAgrees = true;
+    for (uint64_t ms = 0; ms < 2000; ms += 250) {
+        steadyAgrees = steadyAgrees && steady.getLocation(TEST_TIME_MS + ms, location) &&
+                distance(location, TEST_LATITUDE,
+                         eastOf(TEST_LATITUDE, TEST_LONGITUDE, 20.0 * ms / 1000)) < 0.01 &&
+                fabs(location.speed - 20.0f) < 0.01f && fabs(location.bearing - 90.0f) < 0.01f;
+    }
+    expectTrue("interpolate at a constant velocity goes straight", steadyAgrees);
+
+    // the accuracy goes from the one of the first fix to the one of the second
+    PositionPropagator blur;
+    Location second = makeFix(TEST_TIME_MS + 1000, TEST_LATITUDE, TEST_LONGITUDE);
+    second.accuracy = 3 * TEST_ACCURACY;
+    blur.addLocation(makeFix(TEST_TIME_MS, TEST_LATITUDE, TEST_LONGITUDE), noVelocity());
+    blur.addLocation(second, noVelocity());
+    expectTrue("interpolate blends the accuracy",
+               blur.getLocation(TEST_TIME_MS + 500, location) &&
+               fabs(location.accuracy - 2 * TEST_ACCURACY) < 1e-3);
+}
+
+/* ==== ANTIMERIDIAN =================================================================== */
+
+static void testAntimeridian()
+{
+    // 1e-4 degrees either side of the antimeridian, some 22 m apart on the equator
+    Location location;
+    PositionPropagator east;
+    east.addLocation(makeFix(TEST_TIME_MS, 0.0, 179.9999), noVelocity());
+    east.addLocation(makeFix(TEST_TIME_MS + 1000, 0.0, -179.9999), noVelocity());
+    double across = loc_geo_distance(0.0, 179.9999, 0.0, -179.9999);
+    bool eastShort = true;
+    for (uint64_t ms = 0; ms <= 1000; ms += 100) {
+        eastShort = eastShort && east.getLocation(TEST_TIME_MS + ms, location) &&
+                inRange(location.longitude) &&
+                fabs(distance(location, 0.0, 179.9999) - across * ms / 1000) < 0.01;
+    }
+    expectTrue("antimeridian interpolate east takes the short way", eastShort);
+
+    PositionPropagator west;
+    west.addLocation(makeFix(TEST_TIME_MS, 10.0, -179.9999), makeVelocity(0.0, -20.0, 0.5f));
+    west.addLocation(makeFix(TEST_TIME_MS + 1000, 10.0, eastOf(10.0, -179.9999, -20.0)),
+                     makeVelocity(0.0, -20.0, 0.5f));
+    bool westShort = true;
+    for (uint64_t ms = 0; ms <= 1000; ms += 100) {
+        westShort = westShort && west.getLocation(TEST_TIME_MS + ms, location) &&
+                inRange(location.longitude) &&
+                distance(location, 10.0, eastOf(10.0, -179.9999, -20.0 * ms / 1000)) < 0.01;
+    }
+    expectTrue("antimeridian interpolate west with velocities takes the short way", westShort);
+
+    // dead reckoning over the antimeridian comes out on the other side
+    PositionPropagator reckon;
+    reckon.addLocation(makeFix(TEST_TIME_MS, -33.0, 179.9999), makeVelocity(5.0, 30.0, 0.5f));
+    bool reckonAgrees = true;
+    for (uint64_t ms = 0; ms <= 10000; ms += 500) {
+        double dt = ms / 1000.0;
+        reckonAgrees = reckonAgrees && reckon.getLocation(TEST_TIME_MS + ms, location) &&
+                inRange(location.longitude) &&
+                fabs(distance(location, -33.0, 179.9999) - sqrt(25.0 + 900.0) * dt) < 0.05;
+    }
+    expectTrue("antimeridian extrapolate east wraps the longitude", reckonAgrees &&
+               location.longitude < -179.99);
+
+    PositionPropagator back;
+    back.addLocation(makeFix(TEST_TIME_MS, 60.0, -179.9999), makeVelocity(0.0, -30.0, 0.5f));
+    expectTrue("antimeridian extrapolate west wraps the longitude",
+               back.getLocation(TEST_TIME_MS + 5000, location) &&
+               inRange(location.longitude) && location.longitude > 179.99 &&
+               distance(location, 60.0, eastOf(60.0, -179.9999, -150.0)) < 0.05);
+}
+
+/* ==== ACCURACY ======================================================================= */
+
+static void testAccuracyGrowth()
+{
+    PositionPropagator propagator;
+    Location fix = makeFix(TEST_TIME_MS, TEST_LATITUDE, TEST_LONGITUDE);
+    fix.flags |= LOCATION_HAS_SPEED_ACCURACY_BIT;
+    fix.speedAccuracy = 0.5f;
+    const float velocityUncertainty = 0.8f;
+    propagator.addLocation(fix, makeVelocity(3.0, 4.0, velocityUncertainty));
+
+    Location location;
+    bool atFix = propagator.getLocation(TEST_TIME_MS, location);
+    expectTrue("accuracy at the fix is its own", atFix &&
+               location.accuracy == TEST_ACCURACY && location.verticalAccuracy == TEST_VERTICAL);
+
+    bool growing = true;
+    bool modeled = true;
+    float lastAccuracy = TEST_ACCURACY;
+    for (uint64_t ms = 100; ms <= 10000; ms += 100) {
+        if (!propagator.getLocation(TEST_TIME_MS + ms, location)) {
+            growing = false;
+            break;
+        }
+        double dt = ms / 1000.0;
+        double velocityError = velocityUncertainty * dt;
+        double accelerationError = TEST_ACCELERATION * dt * dt / 2;
+        double growth = velocityError * velocityError + accelerationError * accelerationError;
+        growing = growing && location.accuracy > lastAccuracy &&
+                  location.verticalAccuracy > TEST_VERTICAL;
+        modeled = modeled &&
+                fabs(location.accuracy - sqrt(TEST_ACCURACY * TEST_ACCURACY + growth)) < 1e-3 &&
+                fabs(location.verticalAccuracy -
+                     sqrt(TEST_VERTICAL * TEST_VERTICAL + growth)) < 1e-3 &&
+                fabs(location.speedAccuracy - (0.5 + TEST_ACCELERATION * dt)) < 1e-4;
+        lastAccuracy = location.accuracy;
+    }
+    expectTrue("accuracy grows with the time since the fix", growing);
+    expectTrue("accuracy grows with velocity uncertainty and acceleration", modeled);
+    expectTrue("accuracy after 10 s covers the acceleration",
+               lastAccuracy >= TEST_ACCELERATION * 100 / 2);
+}
+
+/* ==== LIMITS ========================================================================= */
+
+static void testLimits()
+{
+    PositionPropagator propagator;
+    Location location;
+    expectTrue("limits no fix, no position", !propagator.getLocation(TEST_TIME_MS, location));
+
+    propagator.addLocation(makeFix(TEST_TIME_MS, TEST_LATITUDE, TEST_LONGITUDE), noVelocity());
+    expectTrue("limits one fix, nothing before it",
+               !propagator.getLocation(TEST_TIME_MS - 1, location));
+    expectTrue("limits dead reckoning up to 10 s",
+               propagator.getLocation(TEST_TIME_MS + 10000, location) &&
+               !propagator.getLocation(TEST_TIME_MS + 10001, location));
+
+    // an older fix does not replace the last one
+    propagator.addLocation(makeFix(TEST_TIME_MS - 500, TEST_LATITUDE + 1.0, TEST_LONGITUDE),
+                           noVelocity());
+    expectTrue("limits an older fix is ignored",
+               propagator.getLocation(TEST_TIME_MS, location) &&
+               location.latitude == TEST_LATITUDE &&
+               !propagator.getLocation(TEST_TIME_MS - 250, location));
+
+    // fixes too far apart are not interpolated between
+    propagator.addLocation(makeFix(TEST_TIME_MS + 6000, TEST_LATITUDE, TEST_LONGITUDE),
+                           noVelocity());
+    expectTrue("limits no interpolation over a gap",
+               !propagator.getLocation(TEST_TIME_MS + 3000, location) &&
+               propagator.getLocation(TEST_TIME_MS + 6000, location));
+
+    Location noPosition = makeFix(TEST_TIME_MS + 7000, 0.0, 0.0);
+    noPosition.flags = LOCATION_HAS_ACCURACY_BIT;
+    propagator.addLocation(noPosition, noVelocity());
+    expectTrue("limits a fix without a position is ignored",
+               propagator.getLocation(TEST_TIME_MS + 7000, location) &&
+               location.latitude == TEST_LATITUDE);
+
+    propagator.reset();
+    expectTrue("limits reset forgets the fixes",
+               !propagator.getLocation(TEST_TIME_MS + 7000, location));
+}
+
+int main()
+{
+    testInterpolate();
+    testAntimeridian();
+    testAccuracyGrowth();
+    testLimits();
+    return testResult();
+}
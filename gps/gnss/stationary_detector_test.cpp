@@ -0,0 +1,209 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <StationaryDetector.h>
+#include <loc_geo.h>
+#include <loc_test_util.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Drives StationaryDetector with synthetic fixes: the run of still fixes it
+// takes to become stationary, jitter within the fix uncertainty, speed above
+// the limit, a walk that never stays within the uncertainty, fixes without
+// a position, configure() and reset(). The exit status is the number of
+// failed checks.
+//
+// usage: stationary_detector_test
+
+#define TEST_LATITUDE       45.0
+#define TEST_LONGITUDE      7.0
+#define TEST_MAX_SPEED      0.5f
+#define TEST_MIN_FIXES      5
+
+static uint32_t sSeed = 1;
+static double nextRandom(double from, double to)
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return from + (to - from) * ((sSeed >> 8) & 0xFFFFFF) / 16777216.0;
+}
+
+// a fix *north* meters north of the test point; along a meridian the
+// haversine distance is exactly that
+static Location makeFix(double north, float accuracy)
+{
+    Location location;
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT | LOCATION_HAS_ACCURACY_BIT;
+    location.latitude = TEST_LATITUDE + LOC_GEO_RAD_TO_DEG(north / LOC_GEO_EARTH_RADIUS_M);
+    location.longitude = TEST_LONGITUDE;
+    location.accuracy = accuracy;
+    return location;
+}
+
+static Location withSpeed(Location location, float speed)
+{
+    location.flags |= LOCATION_HAS_SPEED_BIT;
+    location.speed = speed;
+    return location;
+}
+
+// feeds the same fix until the state changes, returns the fixes it took
+static uint32_t fixesToChange(StationaryDetector& detector, const Location& location)
+{
+    for (uint32_t fixes = 1; fixes <= 100; fixes++) {
+        if (detector.addLocation(location)) {
+            return fixes;
+        }
+    }
+    return 0;
+}
+
+/* ==== STILL RUN ====================================================================== */
+
+static void testStillRun()
+{
+    StationaryDetector detector(TEST_MAX_SPEED, TEST_MIN_FIXES);
+    expectTrue("still run starts moving", !detector.isStationary());
+    expectTrue("still run takes the minimum of still fixes",
+               TEST_MIN_FIXES == fixesToChange(detector, makeFix(0.0, 10.0f)));
+    expectTrue("still run is stationary after them", detector.isStationary());
+    expectTrue("still run changes state only once", !detector.addLocation(makeFix(0.0, 10.0f)));
+
+    // one fix beyond the uncertainty is enough to move again
+    expectTrue("still run moves on a fix beyond the uncertainty",
+               detector.addLocation(makeFix(10.5, 10.0f)) && !detector.isStationary());
+    // and the next still run starts after it
+    expectTrue("still run starts over after the fix that moved",
+               TEST_MIN_FIXES == fixesToChange(detector, makeFix(10.5, 10.0f)));
+    expectTrue("still run is stationary at the new anchor", detector.isStationary());
+
+    // the uncertainty is the larger one of the anchor and the fix
+    StationaryDetector wide(TEST_MAX_SPEED, TEST_MIN_FIXES);
+    fixesToChange(wide, makeFix(0.0, 50.0f));
+    expectTrue("still run keeps the wide anchor uncertainty",
+               !wide.addLocation(makeFix(40.0, 3.0f)) && wide.isStationary());
+    expectTrue("still run beyond the wide anchor uncertainty moves",
+               wide.addLocation(makeFix(60.0, 3.0f)) && !wide.isStationary());
+}
+
+/* ==== JITTER ========================================================================= */
+
+static void testJitter()
+{
+    // fixes scattered around a device that does not move, within half their
+    // uncertainty, so any two are within the larger one of theirs
+    StationaryDetector detector(TEST_MAX_SPEED, TEST_MIN_FIXES);
+    uint32_t changes = 0;
+    uint32_t firstStationary = 0;
+    for (uint32_t fix = 1; fix <= 3600; fix++) {
+        float accuracy = (float)nextRandom(5.0, 20.0);
+        Location location = makeFix(nextRandom(-accuracy / 2, accuracy / 2), accuracy);
+        if (0 == fix % 3) {
+            location = withSpeed(location, (float)nextRandom(0.0, TEST_MAX_SPEED));
+        }
+        if (detector.addLocation(location)) {
+            changes++;
+            if (0 == firstStationary) {
+                firstStationary = fix;
+            }
+        }
+    }
+    expectTrue("jitter becomes stationary", detector.isStationary());
+    expectTrue("jitter becomes stationary after the minimum of fixes",
+               TEST_MIN_FIXES == firstStationary);
+    expectTrue("jitter within the uncertainty never moves", 1 == changes);
+}
+
+/* ==== MOVING ========================================================================= */
+
+static void testMoving()
+{
+    // a fix in place, but with speed above the limit
+    StationaryDetector detector(TEST_MAX_SPEED, TEST_MIN_FIXES);
+    fixesToChange(detector, makeFix(0.0, 10.0f));
+    expectTrue("moving on speed above the limit",
+               detector.addLocation(withSpeed(makeFix(0.0, 10.0f), TEST_MAX_SPEED + 0.1f)) &&
+               !detector.isStationary());
+    expectTrue("moving at speed never becomes stationary",
+               0 == fixesToChange(detector, withSpeed(makeFix(0.0, 10.0f), 1.0f)));
+    expectTrue("moving stops at the speed limit",
+               TEST_MIN_FIXES == fixesToChange(detector,
+                                               withSpeed(makeFix(0.0, 10.0f), TEST_MAX_SPEED)));
+
+    // walking without a speed in the fixes leaves the uncertainty within the run
+    StationaryDetector walk(TEST_MAX_SPEED, TEST_MIN_FIXES);
+    bool stationary = false;
+    for (int fix = 0; fix < 600; fix++) {
+        walk.addLocation(makeFix(1.4 * fix, 5.0f));
+        stationary = stationary || walk.isStationary();
+    }
+    expectTrue("moving at walking speed never becomes stationary", !stationary);
+
+    // a fix without a position tells nothing
+    StationaryDetector blind(TEST_MAX_SPEED, TEST_MIN_FIXES);
+    Location noPosition = makeFix(0.0, 10.0f);
+    noPosition.flags = LOCATION_HAS_ACCURACY_BIT;
+    expectTrue("moving ignores fixes without a position",
+               0 == fixesToChange(blind, noPosition) && !blind.isStationary());
+    fixesToChange(blind, makeFix(0.0, 10.0f));
+    noPosition.latitude += 1.0;
+    expectTrue("moving ignores fixes without a position while stationary",
+               !blind.addLocation(noPosition) && blind.isStationary());
+}
+
+/* ==== CONFIGURE ====================================================================== */
+
+static void testConfigure()
+{
+    StationaryDetector detector(TEST_MAX_SPEED, TEST_MIN_FIXES);
+    fixesToChange(detector, makeFix(0.0, 10.0f));
+    detector.configure(2.0f, 2);
+    expectTrue("configure resets the state", !detector.isStationary());
+    expectTrue("configure sets the minimum of fixes",
+               2 == fixesToChange(detector, withSpeed(makeFix(0.0, 10.0f), 1.5f)));
+    detector.configure(2.0f, 0);
+    expectTrue("configure takes no minimum as one fix",
+               1 == fixesToChange(detector, makeFix(0.0, 10.0f)));
+    expectTrue("configure with one fix still moves",
+               detector.addLocation(withSpeed(makeFix(0.0, 10.0f), 3.0f)) &&
+               !detector.isStationary());
+    detector.reset();
+    expectTrue("reset starts over", !detector.isStationary() &&
+               1 == fixesToChange(detector, makeFix(100.0, 10.0f)));
+}
+
+int main()
+{
+    testStillRun();
+    testJitter();
+    testMoving();
+    testConfigure();
+    return testResult();
+}
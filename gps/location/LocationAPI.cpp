@@ -33,6 +33,7 @@
 #include <loc_pla.h>
 #include <log_util.h>
 #include <pthread.h>
+#include <stddef.h>
 #include <map>
 #include <loc_misc_utils.h>
 
@@ -63,8 +64,14 @@ typedef struct {
     BatchingInterface* batchingInterface;
 } LocationAPIData;
 
+// gData is guarded by gDataLock. The API calls of existing clients only take
+// it for read, so they don't serialize with each other. Creating, updating and
+// destroying clients, as well as loading the adapter interfaces, is serialized
+// by gClientMutex instead, and takes gDataLock for write only around the
+// updates of gData itself.
 static LocationAPIData gData = {};
-static pthread_mutex_t gDataMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t gDataLock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t gClientMutex = PTHREAD_MUTEX_INITIALIZER;
 static bool gGnssLoadFailed = false;
 static bool gBatchingLoadFailed = false;
 static bool gGeofenceLoadFailed = false;
@@ -80,6 +87,44 @@ static const T1* loadLocationInterface(const char* library, const char* name) {
     }
 }
 
+// Loads and initializes the interface *inf* on first use. Must be called with
+// gClientMutex held, which is the only lock the writers of *inf* all hold, so
+// reading *inf* here needs no gDataLock.
+template <typename T1, typename T2>
+static T1* getLocationInterface(T1*& inf, bool& loadFailed,
+                                const char* library, const char* name) {
+    if (NULL == inf && !loadFailed) {
+        T1* loadedInf = (T1*)loadLocationInterface<T1, T2>(library, name);
+        if (NULL == loadedInf) {
+            loadFailed = true;
+            LOC_LOGW("%s:%d]: No interface available from %s", __func__, __LINE__, library);
+        } else {
+            loadedInf->initialize();
+            pthread_rwlock_wrlock(&gDataLock);
+            inf = loadedInf;
+            pthread_rwlock_unlock(&gDataLock);
+        }
+    }
+    return inf;
+}
+
+static inline GnssInterface* loadGnssInterface() {
+    return getLocationInterface<GnssInterface, getGnssInterface>(
+            gData.gnssInterface, gGnssLoadFailed, "libgnss.so", "getGnssInterface");
+}
+
+static inline BatchingInterface* loadBatchingInterface() {
+    return getLocationInterface<BatchingInterface, getBatchingInterface>(
+            gData.batchingInterface, gBatchingLoadFailed,
+            "libbatching.so", "getBatchingInterface");
+}
+
+static inline GeofenceInterface* loadGeofenceInterface() {
+    return getLocationInterface<GeofenceInterface, getGeofenceInterface>(
+            gData.geofenceInterface, gGeofenceLoadFailed,
+            "libgeofencing.so", "getGeofenceInterface");
+}
+
 static bool isGnssClient(LocationCallbacks& locationCallbacks)
 {
     return (locationCallbacks.gnssNiCb != nullptr ||
@@ -106,7 +151,7 @@ void LocationAPI::onRemoveClientCompleteCb (LocationAdapterTypeMask adapterType)
     bool invokeCallback = false;
     locationApiDestroyCompleteCallback destroyCompleteCb;
     LOC_LOGd("adatper type %x", adapterType);
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_wrlock(&gDataLock);
     auto it = gData.destroyClientData.find(this);
     if (it != gData.destroyClientData.end()) {
         it->second.waitAdapterMask &= ~adapterType;
@@ -116,7 +161,7 @@ void LocationAPI::onRemoveClientCompleteCb (LocationAdapterTypeMask adapterType)
             gData.destroyClientData.erase(it);
         }
     }
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 
     if ((true == invokeCallback) && (nullptr != destroyCompleteCb)) {
         LOC_LOGd("invoke client destroy cb");
@@ -154,74 +199,46 @@ LocationAPI::createInstance(LocationCallbacks& locationCallbacks)
     LocationAPI* newLocationAPI = new LocationAPI();
     bool requestedCapabilities = false;
 
-    pthread_mutex_lock(&gDataMutex);
+    pthread_mutex_lock(&gClientMutex);
 
     if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
-            gData.gnssInterface->addClient(newLocationAPI, locationCallbacks);
+        GnssInterface* gnssInterface = loadGnssInterface();
+        if (NULL != gnssInterface) {
+            gnssInterface->addClient(newLocationAPI, locationCallbacks);
             if (!requestedCapabilities) {
-                gData.gnssInterface->requestCapabilities(newLocationAPI);
+                gnssInterface->requestCapabilities(newLocationAPI);
                 requestedCapabilities = true;
             }
         }
     }
 
     if (isBatchingClient(locationCallbacks)) {
-        if (NULL == gData.batchingInterface && !gBatchingLoadFailed) {
-            gData.batchingInterface =
-                (BatchingInterface*)loadLocationInterface<BatchingInterface,
-                 getBatchingInterface>("libbatching.so", "getBatchingInterface");
-            if (NULL == gData.batchingInterface) {
-                gBatchingLoadFailed = true;
-                LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
-            } else {
-                gData.batchingInterface->initialize();
-            }
-        }
-        if (NULL != gData.batchingInterface) {
-            gData.batchingInterface->addClient(newLocationAPI, locationCallbacks);
+        BatchingInterface* batchingInterface = loadBatchingInterface();
+        if (NULL != batchingInterface) {
+            batchingInterface->addClient(newLocationAPI, locationCallbacks);
             if (!requestedCapabilities) {
-                gData.batchingInterface->requestCapabilities(newLocationAPI);
+                batchingInterface->requestCapabilities(newLocationAPI);
                 requestedCapabilities = true;
             }
         }
     }
 
     if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-               (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
-               getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
-        }
-        if (NULL != gData.geofenceInterface) {
-            gData.geofenceInterface->addClient(newLocationAPI, locationCallbacks);
+        GeofenceInterface* geofenceInterface = loadGeofenceInterface();
+        if (NULL != geofenceInterface) {
+            geofenceInterface->addClient(newLocationAPI, locationCallbacks);
             if (!requestedCapabilities) {
-                gData.geofenceInterface->requestCapabilities(newLocationAPI);
+                geofenceInterface->requestCapabilities(newLocationAPI);
                 requestedCapabilities = true;
             }
         }
     }
 
+    pthread_rwlock_wrlock(&gDataLock);
     gData.clientData[newLocationAPI] = locationCallbacks;
+    pthread_rwlock_unlock(&gDataLock);
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_mutex_unlock(&gClientMutex);
 
     return newLocationAPI;
 }
@@ -230,15 +247,19 @@ void
 LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
 {
     bool invokeDestroyCb = false;
+    bool removeFromGnssInf = false;
+    bool removeFromBatchingInf = false;
+    bool removeFromGeofenceInf = false;
 
-    pthread_mutex_lock(&gDataMutex);
+    pthread_mutex_lock(&gClientMutex);
+    pthread_rwlock_wrlock(&gDataLock);
     auto it = gData.clientData.find(this);
     if (it != gData.clientData.end()) {
-        bool removeFromGnssInf =
+        removeFromGnssInf =
                 (isGnssClient(it->second) && NULL != gData.gnssInterface);
-        bool removeFromBatchingInf =
+        removeFromBatchingInf =
                 (isBatchingClient(it->second) && NULL != gData.batchingInterface);
-        bool removeFromGeofenceInf =
+        removeFromGeofenceInf =
                 (isGeofenceClient(it->second) && NULL != gData.geofenceInterface);
         bool needToWait = (removeFromGnssInf || removeFromBatchingInf || removeFromGeofenceInf);
         LOC_LOGe("removeFromGnssInf: %d, removeFromBatchingInf: %d, removeFromGeofenceInf: %d,"
@@ -261,19 +282,6 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
             LOC_LOGe("destroy data stored in the map: 0x%x", destroyCbData.waitAdapterMask);
         }
 
-        if (removeFromGnssInf) {
-            gData.gnssInterface->removeClient(it->first,
-                                              onGnssRemoveClientCompleteCb);
-        }
-        if (removeFromBatchingInf) {
-            gData.batchingInterface->removeClient(it->first,
-                                             onBatchingRemoveClientCompleteCb);
-        }
-        if (removeFromGeofenceInf) {
-            gData.geofenceInterface->removeClient(it->first,
-                                                  onGeofenceRemoveClientCompleteCb);
-        }
-
         gData.clientData.erase(it);
 
         if ((NULL != destroyCompleteCb) && (false == needToWait)) {
@@ -283,8 +291,22 @@ LocationAPI::destroy(locationApiDestroyCompleteCallback destroyCompleteCb)
         LOC_LOGE("%s:%d]: Location API client %p not found in client data",
                  __func__, __LINE__, this);
     }
+    pthread_rwlock_unlock(&gDataLock);
 
-    pthread_mutex_unlock(&gDataMutex);
+    // the interfaces may call back into onRemoveClientCompleteCb(), which
+    // takes gDataLock, so the removals are done outside of it. The interface
+    // pointers are only ever set under gClientMutex, which is still held.
+    if (removeFromGnssInf) {
+        gData.gnssInterface->removeClient(this, onGnssRemoveClientCompleteCb);
+    }
+    if (removeFromBatchingInf) {
+        gData.batchingInterface->removeClient(this, onBatchingRemoveClientCompleteCb);
+    }
+    if (removeFromGeofenceInf) {
+        gData.geofenceInterface->removeClient(this, onGeofenceRemoveClientCompleteCb);
+    }
+
+    pthread_mutex_unlock(&gClientMutex);
     if (invokeDestroyCb == true) {
         (destroyCompleteCb) ();
         delete this;
@@ -311,72 +333,44 @@ LocationAPI::updateCallbacks(LocationCallbacks& locationCallbacks)
         return;
     }
 
-    pthread_mutex_lock(&gDataMutex);
+    pthread_mutex_lock(&gClientMutex);
 
     if (isGnssClient(locationCallbacks)) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
+        GnssInterface* gnssInterface = loadGnssInterface();
+        if (NULL != gnssInterface) {
             // either adds new Client or updates existing Client
-            gData.gnssInterface->addClient(this, locationCallbacks);
+            gnssInterface->addClient(this, locationCallbacks);
         }
     }
 
     if (isBatchingClient(locationCallbacks)) {
-        if (NULL == gData.batchingInterface && !gBatchingLoadFailed) {
-            gData.batchingInterface =
-                (BatchingInterface*)loadLocationInterface<BatchingInterface,
-                 getBatchingInterface>("libbatching.so", "getBatchingInterface");
-            if (NULL == gData.batchingInterface) {
-                gBatchingLoadFailed = true;
-                LOC_LOGW("%s:%d]: No batching interface available", __func__, __LINE__);
-            } else {
-                gData.batchingInterface->initialize();
-            }
-        }
-        if (NULL != gData.batchingInterface) {
+        BatchingInterface* batchingInterface = loadBatchingInterface();
+        if (NULL != batchingInterface) {
             // either adds new Client or updates existing Client
-            gData.batchingInterface->addClient(this, locationCallbacks);
+            batchingInterface->addClient(this, locationCallbacks);
         }
     }
 
     if (isGeofenceClient(locationCallbacks)) {
-        if (NULL == gData.geofenceInterface && !gGeofenceLoadFailed) {
-            gData.geofenceInterface =
-                (GeofenceInterface*)loadLocationInterface<GeofenceInterface,
-                 getGeofenceInterface>("libgeofencing.so", "getGeofenceInterface");
-            if (NULL == gData.geofenceInterface) {
-                gGeofenceLoadFailed = true;
-                LOC_LOGW("%s:%d]: No geofence interface available", __func__, __LINE__);
-            } else {
-                gData.geofenceInterface->initialize();
-            }
-        }
-        if (NULL != gData.geofenceInterface) {
+        GeofenceInterface* geofenceInterface = loadGeofenceInterface();
+        if (NULL != geofenceInterface) {
             // either adds new Client or updates existing Client
-            gData.geofenceInterface->addClient(this, locationCallbacks);
+            geofenceInterface->addClient(this, locationCallbacks);
         }
     }
 
+    pthread_rwlock_wrlock(&gDataLock);
     gData.clientData[this] = locationCallbacks;
+    pthread_rwlock_unlock(&gDataLock);
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_mutex_unlock(&gClientMutex);
 }
 
 uint32_t
 LocationAPI::startTracking(TrackingOptions& trackingOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     auto it = gData.clientData.find(this);
     if (it != gData.clientData.end()) {
@@ -391,14 +385,14 @@ LocationAPI::startTracking(TrackingOptions& trackingOptions)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 void
 LocationAPI::stopTracking(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     auto it = gData.clientData.find(this);
     if (it != gData.clientData.end()) {
@@ -413,14 +407,33 @@ LocationAPI::stopTracking(uint32_t id)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
+}
+
+bool
+LocationAPI::getCurrentLocation(uint64_t timestamp, Location& location)
+{
+    bool ret = false;
+    pthread_rwlock_rdlock(&gDataLock);
+
+    // the interface may come from an older libgnss without the entry
+    if (gData.gnssInterface != NULL &&
+            gData.gnssInterface->size > offsetof(GnssInterface, getCurrentLocation)) {
+        ret = gData.gnssInterface->getCurrentLocation(timestamp, location);
+    } else {
+        LOC_LOGE("%s:%d]: No gnss interface available for Location API client %p ",
+                 __func__, __LINE__, this);
+    }
+
+    pthread_rwlock_unlock(&gDataLock);
+    return ret;
 }
 
 void
 LocationAPI::updateTrackingOptions(
         uint32_t id, TrackingOptions& trackingOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     auto it = gData.clientData.find(this);
     if (it != gData.clientData.end()) {
@@ -435,14 +448,14 @@ LocationAPI::updateTrackingOptions(
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 uint32_t
 LocationAPI::startBatching(BatchingOptions &batchingOptions)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (NULL != gData.batchingInterface) {
         id = gData.batchingInterface->startBatching(this, batchingOptions);
@@ -451,14 +464,14 @@ LocationAPI::startBatching(BatchingOptions &batchingOptions)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 void
 LocationAPI::stopBatching(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (NULL != gData.batchingInterface) {
         gData.batchingInterface->stopBatching(this, id);
@@ -467,13 +480,13 @@ LocationAPI::stopBatching(uint32_t id)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::updateBatchingOptions(uint32_t id, BatchingOptions& batchOptions)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (NULL != gData.batchingInterface) {
         gData.batchingInterface->updateBatchingOptions(this, id, batchOptions);
@@ -482,13 +495,13 @@ LocationAPI::updateBatchingOptions(uint32_t id, BatchingOptions& batchOptions)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::getBatchedLocations(uint32_t id, size_t count)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.batchingInterface != NULL) {
         gData.batchingInterface->getBatchedLocations(this, id, count);
@@ -497,14 +510,14 @@ LocationAPI::getBatchedLocations(uint32_t id, size_t count)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 uint32_t*
 LocationAPI::addGeofences(size_t count, GeofenceOption* options, GeofenceInfo* info)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         ids = gData.geofenceInterface->addGeofences(this, count, options, info);
@@ -513,14 +526,14 @@ LocationAPI::addGeofences(size_t count, GeofenceOption* options, GeofenceInfo* i
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return ids;
 }
 
 void
 LocationAPI::removeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         gData.geofenceInterface->removeGeofences(this, count, ids);
@@ -529,13 +542,13 @@ LocationAPI::removeGeofences(size_t count, uint32_t* ids)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::modifyGeofences(size_t count, uint32_t* ids, GeofenceOption* options)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         gData.geofenceInterface->modifyGeofences(this, count, ids, options);
@@ -544,13 +557,13 @@ LocationAPI::modifyGeofences(size_t count, uint32_t* ids, GeofenceOption* option
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::pauseGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         gData.geofenceInterface->pauseGeofences(this, count, ids);
@@ -559,13 +572,13 @@ LocationAPI::pauseGeofences(size_t count, uint32_t* ids)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::resumeGeofences(size_t count, uint32_t* ids)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.geofenceInterface != NULL) {
         gData.geofenceInterface->resumeGeofences(this, count, ids);
@@ -574,13 +587,13 @@ LocationAPI::resumeGeofences(size_t count, uint32_t* ids)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 void
 LocationAPI::gnssNiResponse(uint32_t id, GnssNiResponse response)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         gData.gnssInterface->gnssNiResponse(this, id, response);
@@ -589,36 +602,28 @@ LocationAPI::gnssNiResponse(uint32_t id, GnssNiResponse response)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 LocationControlAPI*
 LocationControlAPI::createInstance(LocationControlCallbacks& locationControlCallbacks)
 {
     LocationControlAPI* controlAPI = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_mutex_lock(&gClientMutex);
 
     if (nullptr != locationControlCallbacks.responseCb && NULL == gData.controlAPI) {
-        if (NULL == gData.gnssInterface && !gGnssLoadFailed) {
-            gData.gnssInterface =
-                (GnssInterface*)loadLocationInterface<GnssInterface,
-                    getGnssInterface>("libgnss.so", "getGnssInterface");
-            if (NULL == gData.gnssInterface) {
-                gGnssLoadFailed = true;
-                LOC_LOGW("%s:%d]: No gnss interface available", __func__, __LINE__);
-            } else {
-                gData.gnssInterface->initialize();
-            }
-        }
-        if (NULL != gData.gnssInterface) {
-            gData.controlAPI = new LocationControlAPI();
+        GnssInterface* gnssInterface = loadGnssInterface();
+        if (NULL != gnssInterface) {
+            controlAPI = new LocationControlAPI();
+            pthread_rwlock_wrlock(&gDataLock);
+            gData.controlAPI = controlAPI;
             gData.controlCallbacks = locationControlCallbacks;
-            gData.gnssInterface->setControlCallbacks(locationControlCallbacks);
-            controlAPI = gData.controlAPI;
+            pthread_rwlock_unlock(&gDataLock);
+            gnssInterface->setControlCallbacks(locationControlCallbacks);
         }
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_mutex_unlock(&gClientMutex);
     return controlAPI;
 }
 
@@ -636,18 +641,20 @@ LocationControlAPI::LocationControlAPI()
 LocationControlAPI::~LocationControlAPI()
 {
     LOC_LOGD("LOCATION CONTROL API DESTRUCTOR");
-    pthread_mutex_lock(&gDataMutex);
+    pthread_mutex_lock(&gClientMutex);
+    pthread_rwlock_wrlock(&gDataLock);
 
     gData.controlAPI = NULL;
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
+    pthread_mutex_unlock(&gClientMutex);
 }
 
 uint32_t
 LocationControlAPI::enable(LocationTechnologyType techType)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->enable(techType);
@@ -656,14 +663,14 @@ LocationControlAPI::enable(LocationTechnologyType techType)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
 
 void
 LocationControlAPI::disable(uint32_t id)
 {
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         gData.gnssInterface->disable(id);
@@ -672,14 +679,14 @@ LocationControlAPI::disable(uint32_t id)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
 }
 
 uint32_t*
 LocationControlAPI::gnssUpdateConfig(GnssConfig config)
 {
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         ids = gData.gnssInterface->gnssUpdateConfig(config);
@@ -688,14 +695,14 @@ LocationControlAPI::gnssUpdateConfig(GnssConfig config)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return ids;
 }
 
 uint32_t* LocationControlAPI::gnssGetConfig(GnssConfigFlagsMask mask) {
 
     uint32_t* ids = NULL;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (NULL != gData.gnssInterface) {
         ids = gData.gnssInterface->gnssGetConfig(mask);
@@ -703,7 +710,7 @@ uint32_t* LocationControlAPI::gnssGetConfig(GnssConfigFlagsMask mask) {
         LOC_LOGe("No gnss interface available for Control API client %p", this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return ids;
 }
 
@@ -711,7 +718,7 @@ uint32_t
 LocationControlAPI::gnssDeleteAidingData(GnssAidingData& data)
 {
     uint32_t id = 0;
-    pthread_mutex_lock(&gDataMutex);
+    pthread_rwlock_rdlock(&gDataLock);
 
     if (gData.gnssInterface != NULL) {
         id = gData.gnssInterface->gnssDeleteAidingData(data);
@@ -720,6 +727,6 @@ LocationControlAPI::gnssDeleteAidingData(GnssAidingData& data)
                  __func__, __LINE__, this);
     }
 
-    pthread_mutex_unlock(&gDataMutex);
+    pthread_rwlock_unlock(&gDataLock);
     return id;
 }
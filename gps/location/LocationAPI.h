@@ -85,6 +85,15 @@ public:
                 LOCATION_ERROR_ID_UNKNOWN if id is not associated with a tracking session */
     virtual void updateTrackingOptions(uint32_t id, TrackingOptions&) override;
 
+    /* getCurrentLocation fills location with the position at timestamp (ms since the epoch,
+       0 for now), propagated from the last fixes of the tracking session, so that a client
+       can draw it more often than the fixes come. The accuracy grows with the time since
+       the last fix. It is answered synchronously, without a responseCallback.
+        returns:
+                true if location was filled
+                false if there is no recent fix or no gnss interface */
+    bool getCurrentLocation(uint64_t timestamp, Location& location);
+
     /* ================================== BATCHING ================================== */
 
     /* startBatching starts a batching session, which returns a session id that will be
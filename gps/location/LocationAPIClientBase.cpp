@@ -834,9 +834,9 @@ void LocationAPIClientBase::beforeGeofenceBreachCb(
     if (mGeofenceBreachCallback != nullptr) {
         size_t count = 0;
         for (size_t i = 0; i < n; i++) {
-            uint32_t id = mGeofenceBiDict.getId(geofenceBreachNotification.ids[i]);
-            GeofenceBreachTypeMask type =
-                mGeofenceBiDict.getExtBySession(geofenceBreachNotification.ids[i]);
+            uint32_t id = 0;
+            GeofenceBreachTypeMask type = 0;
+            mGeofenceBiDict.getIdAndExtBySession(geofenceBreachNotification.ids[i], id, type);
             // if type == 0, we will not head into the fllowing block anyway.
             // so we don't need to check id and type
             if ((geofenceBreachNotification.type == GEOFENCE_BREACH_ENTER &&
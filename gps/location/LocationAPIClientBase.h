@@ -38,6 +38,7 @@
 #include "LocationAPI.h"
 #include <loc_pla.h>
 #include <log_util.h>
+#include <LocFlatMap.h>
 
 enum SESSION_MODE {
     SESSION_MODE_NONE = 0,
@@ -292,117 +293,143 @@ private:
         uint32_t sessionMode;
     } SessionEntity;
 
+    // loc_bidict_test and loc_bidict_bench reach BiDict through it
+    friend class BiDictAccess;
+
+    // Bidirectional id <-> session dictionary, with an extra value per
+    // session. Both directions are flat hash maps; lookups take the lock
+    // for read only, so concurrent lookups (e.g. geofence breaches) don't
+    // serialize, and a lookup miss never inserts.
     template<typename T>
     class BiDict {
     public:
         BiDict() {
-            pthread_mutex_init(&mBiDictMutex, nullptr);
+            pthread_rwlock_init(&mBiDictLock, nullptr);
         }
         virtual ~BiDict() {
-            pthread_mutex_destroy(&mBiDictMutex);
+            pthread_rwlock_destroy(&mBiDictLock);
         }
         bool hasId(uint32_t id) {
-            pthread_mutex_lock(&mBiDictMutex);
-            bool ret = (mForwardMap.find(id) != mForwardMap.end());
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_rdlock(&mBiDictLock);
+            bool ret = (nullptr != mForwardMap.find(id));
+            pthread_rwlock_unlock(&mBiDictLock);
             return ret;
         }
         bool hasSession(uint32_t session) {
-            pthread_mutex_lock(&mBiDictMutex);
-            bool ret = (mBackwardMap.find(session) != mBackwardMap.end());
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_rdlock(&mBiDictLock);
+            bool ret = (nullptr != mBackwardMap.find(session));
+            pthread_rwlock_unlock(&mBiDictLock);
             return ret;
         }
         void set(uint32_t id, uint32_t session, T& ext) {
-            pthread_mutex_lock(&mBiDictMutex);
-            mForwardMap[id] = session;
-            mBackwardMap[session] = id;
-            mExtMap[session] = ext;
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_wrlock(&mBiDictLock);
+            mForwardMap.put(id, session);
+            mBackwardMap.put(session, SessionEntry(id, ext));
+            pthread_rwlock_unlock(&mBiDictLock);
         }
         void clear() {
-            pthread_mutex_lock(&mBiDictMutex);
+            pthread_rwlock_wrlock(&mBiDictLock);
             mForwardMap.clear();
             mBackwardMap.clear();
-            mExtMap.clear();
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_unlock(&mBiDictLock);
         }
         void rmById(uint32_t id) {
-            pthread_mutex_lock(&mBiDictMutex);
-            mBackwardMap.erase(mForwardMap[id]);
-            mExtMap.erase(mForwardMap[id]);
-            mForwardMap.erase(id);
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_wrlock(&mBiDictLock);
+            uint32_t* session = mForwardMap.find(id);
+            if (nullptr != session) {
+                mBackwardMap.erase(*session);
+                mForwardMap.erase(id);
+            }
+            pthread_rwlock_unlock(&mBiDictLock);
         }
         void rmBySession(uint32_t session) {
-            pthread_mutex_lock(&mBiDictMutex);
-            mForwardMap.erase(mBackwardMap[session]);
-            mBackwardMap.erase(session);
-            mExtMap.erase(session);
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_wrlock(&mBiDictLock);
+            SessionEntry* entry = mBackwardMap.find(session);
+            if (nullptr != entry) {
+                mForwardMap.erase(entry->id);
+                mBackwardMap.erase(session);
+            }
+            pthread_rwlock_unlock(&mBiDictLock);
         }
         uint32_t getId(uint32_t session) {
-            pthread_mutex_lock(&mBiDictMutex);
+            pthread_rwlock_rdlock(&mBiDictLock);
             uint32_t ret = 0;
-            auto it = mBackwardMap.find(session);
-            if (it != mBackwardMap.end()) {
-                ret = it->second;
+            SessionEntry* entry = mBackwardMap.find(session);
+            if (nullptr != entry) {
+                ret = entry->id;
             }
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_unlock(&mBiDictLock);
             return ret;
         }
         uint32_t getSession(uint32_t id) {
-            pthread_mutex_lock(&mBiDictMutex);
+            pthread_rwlock_rdlock(&mBiDictLock);
             uint32_t ret = 0;
-            auto it = mForwardMap.find(id);
-            if (it != mForwardMap.end()) {
-                ret = it->second;
+            uint32_t* session = mForwardMap.find(id);
+            if (nullptr != session) {
+                ret = *session;
             }
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_unlock(&mBiDictLock);
             return ret;
         }
         T getExtById(uint32_t id) {
-            pthread_mutex_lock(&mBiDictMutex);
+            pthread_rwlock_rdlock(&mBiDictLock);
             T ret;
             memset(&ret, 0, sizeof(T));
-            uint32_t session = mForwardMap[id];
-            if (session > 0) {
-                auto it = mExtMap.find(session);
-                if (it != mExtMap.end()) {
-                    ret = it->second;
+            uint32_t* session = mForwardMap.find(id);
+            if (nullptr != session && *session > 0) {
+                SessionEntry* entry = mBackwardMap.find(*session);
+                if (nullptr != entry) {
+                    ret = entry->ext;
                 }
             }
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_unlock(&mBiDictLock);
             return ret;
         }
         T getExtBySession(uint32_t session) {
-            pthread_mutex_lock(&mBiDictMutex);
+            pthread_rwlock_rdlock(&mBiDictLock);
             T ret;
             memset(&ret, 0, sizeof(T));
-            auto it = mExtMap.find(session);
-            if (it != mExtMap.end()) {
-                ret = it->second;
+            SessionEntry* entry = mBackwardMap.find(session);
+            if (nullptr != entry) {
+                ret = entry->ext;
             }
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_unlock(&mBiDictLock);
             return ret;
         }
+        // getId() and getExtBySession() in one lookup; false if not found
+        bool getIdAndExtBySession(uint32_t session, uint32_t& id, T& ext) {
+            pthread_rwlock_rdlock(&mBiDictLock);
+            SessionEntry* entry = mBackwardMap.find(session);
+            bool found = (nullptr != entry);
+            if (found) {
+                id = entry->id;
+                ext = entry->ext;
+            }
+            pthread_rwlock_unlock(&mBiDictLock);
+            return found;
+        }
         std::vector<uint32_t> getAllSessions() {
             std::vector<uint32_t> ret;
-            pthread_mutex_lock(&mBiDictMutex);
-            for (auto it = mBackwardMap.begin(); it != mBackwardMap.end(); it++) {
-                ret.push_back(it->first);
-            }
-            pthread_mutex_unlock(&mBiDictMutex);
+            pthread_rwlock_rdlock(&mBiDictLock);
+            ret.reserve(mBackwardMap.size());
+            mBackwardMap.forEach([&ret] (uint32_t session, const SessionEntry& /*entry*/) {
+                ret.push_back(session);
+            });
+            pthread_rwlock_unlock(&mBiDictLock);
             return ret;
         }
     private:
-        pthread_mutex_t mBiDictMutex;
+        struct SessionEntry {
+            uint32_t id;
+            T ext;
+            inline SessionEntry() : id(0) { memset(&ext, 0, sizeof(T)); }
+            inline SessionEntry(uint32_t i, const T& e) : id(i), ext(e) {}
+        };
+        pthread_rwlock_t mBiDictLock;
         // mForwarMap mapping id->session
-        std::map<uint32_t, uint32_t> mForwardMap;
-        // mBackwardMap mapping session->id
-        std::map<uint32_t, uint32_t> mBackwardMap;
-        // mExtMap mapping session->ext
-        std::map<uint32_t, T> mExtMap;
+        loc_util::LocFlatMap<uint32_t> mForwardMap;
+        // mBackwardMap mapping session->(id, ext)
+        loc_util::LocFlatMap<SessionEntry> mBackwardMap;
     };
 
     class StartTrackingRequest : public LocationAPIRequest {
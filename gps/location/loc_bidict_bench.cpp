@@ -0,0 +1,287 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocationAPIClientBase.h>
+#include <loc_test_util.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <map>
+#include <vector>
+
+// Times LocationAPIClientBase::BiDict against the std::map based dictionary
+// it replaced, the way a geofence client with many fences uses it: adding
+// the fences, resolving breach notifications the way onGeofenceBreachCb()
+// does, from one and from several threads at once, and removing the fences.
+// Prints ns per fence or per breach.
+//
+// usage: loc_bidict_bench [-f fences] [-r breaches] [-t threads]
+//   -f  geofences, 10000 by default
+//   -r  breaches resolved per case and thread, 2000000 by default
+//   -t  threads resolving breaches at once in the last case, 4 by default
+
+// a friend of LocationAPIClientBase, to reach its private BiDict
+class BiDictAccess {
+public:
+    typedef LocationAPIClientBase::BiDict<GeofenceBreachTypeMask> GeofenceBiDict;
+};
+typedef BiDictAccess::GeofenceBiDict FlatBiDict;
+
+// the dictionary BiDict replaced, three std::map behind one mutex, with
+// just what is timed here
+class MapBiDict {
+public:
+    MapBiDict() { pthread_mutex_init(&mBiDictMutex, nullptr); }
+    ~MapBiDict() { pthread_mutex_destroy(&mBiDictMutex); }
+    void set(uint32_t id, uint32_t session, GeofenceBreachTypeMask& ext) {
+        pthread_mutex_lock(&mBiDictMutex);
+        mForwardMap[id] = session;
+        mBackwardMap[session] = id;
+        mExtMap[session] = ext;
+        pthread_mutex_unlock(&mBiDictMutex);
+    }
+    void rmById(uint32_t id) {
+        pthread_mutex_lock(&mBiDictMutex);
+        mBackwardMap.erase(mForwardMap[id]);
+        mExtMap.erase(mForwardMap[id]);
+        mForwardMap.erase(id);
+        pthread_mutex_unlock(&mBiDictMutex);
+    }
+    uint32_t getId(uint32_t session) {
+        pthread_mutex_lock(&mBiDictMutex);
+        uint32_t ret = 0;
+        auto it = mBackwardMap.find(session);
+        if (it != mBackwardMap.end()) {
+            ret = it->second;
+        }
+        pthread_mutex_unlock(&mBiDictMutex);
+        return ret;
+    }
+    GeofenceBreachTypeMask getExtBySession(uint32_t session) {
+        pthread_mutex_lock(&mBiDictMutex);
+        GeofenceBreachTypeMask ret = 0;
+        auto it = mExtMap.find(session);
+        if (it != mExtMap.end()) {
+            ret = it->second;
+        }
+        pthread_mutex_unlock(&mBiDictMutex);
+        return ret;
+    }
+private:
+    pthread_mutex_t mBiDictMutex;
+    std::map<uint32_t, uint32_t> mForwardMap;
+    std::map<uint32_t, uint32_t> mBackwardMap;
+    std::map<uint32_t, GeofenceBreachTypeMask> mExtMap;
+};
+
+// keeps the compiler from dropping what is computed
+static volatile uint32_t sSink;
+
+// the modem hands out sessions, the client its own ids
+static inline uint32_t sessionOf(uint32_t fence) { return 0x1000 + fence * 3; }
+static inline uint32_t idOf(uint32_t fence) { return fence + 1; }
+
+// resolves the breach sessions in turn, in bursts of *burst*, as
+// onGeofenceBreachCb() does; returns the number of enter breaches
+static uint32_t resolveFlat(FlatBiDict& dict, const std::vector<uint32_t>& breaches,
+                            size_t count, size_t burst)
+{
+    uint32_t entered = 0;
+    size_t next = 0;
+    for (size_t done = 0; done < count; done += burst) {
+        for (size_t i = 0; i < burst; i++) {
+            uint32_t id = 0;
+            GeofenceBreachTypeMask type = 0;
+            dict.getIdAndExtBySession(breaches[next], id, type);
+            if (type & GEOFENCE_BREACH_ENTER_BIT) {
+                entered += (id != 0);
+            }
+            next = (next + 1 == breaches.size()) ? 0 : next + 1;
+        }
+    }
+    return entered;
+}
+
+static uint32_t resolveMap(MapBiDict& dict, const std::vector<uint32_t>& breaches,
+                           size_t count, size_t burst)
+{
+    uint32_t entered = 0;
+    size_t next = 0;
+    for (size_t done = 0; done < count; done += burst) {
+        for (size_t i = 0; i < burst; i++) {
+            uint32_t id = dict.getId(breaches[next]);
+            GeofenceBreachTypeMask type = dict.getExtBySession(breaches[next]);
+            if (type & GEOFENCE_BREACH_ENTER_BIT) {
+                entered += (id != 0);
+            }
+            next = (next + 1 == breaches.size()) ? 0 : next + 1;
+        }
+    }
+    return entered;
+}
+
+template <typename DICT>
+static double timeAdd(DICT& dict, uint32_t fences)
+{
+    uint64_t startNs = threadCpuNs();
+    for (uint32_t fence = 0; fence < fences; fence++) {
+        GeofenceBreachTypeMask mask = (fence & 1) ? GEOFENCE_BREACH_ENTER_BIT :
+                (GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT);
+        dict.set(idOf(fence), sessionOf(fence), mask);
+    }
+    return (double)(threadCpuNs() - startNs) / fences;
+}
+
+template <typename DICT>
+static double timeRemove(DICT& dict, uint32_t fences)
+{
+    uint64_t startNs = threadCpuNs();
+    for (uint32_t fence = 0; fence < fences; fence++) {
+        dict.rmById(idOf(fence));
+    }
+    return (double)(threadCpuNs() - startNs) / fences;
+}
+
+static double timeResolve(FlatBiDict& flat, MapBiDict& map, bool useFlat,
+                          const std::vector<uint32_t>& breaches, size_t count, size_t burst)
+{
+    uint64_t startNs = threadCpuNs();
+    sSink = useFlat ? resolveFlat(flat, breaches, count, burst) :
+                      resolveMap(map, breaches, count, burst);
+    return (double)(threadCpuNs() - startNs) / count;
+}
+
+typedef struct {
+    FlatBiDict* flat;
+    MapBiDict* map;
+    bool useFlat;
+    const std::vector<uint32_t>* breaches;
+    size_t count;
+    pthread_barrier_t* start;
+} ResolveArgs;
+
+static void* resolveThread(void* arg)
+{
+    ResolveArgs* args = (ResolveArgs*)arg;
+    pthread_barrier_wait(args->start);
+    sSink = args->useFlat ? resolveFlat(*args->flat, *args->breaches, args->count, 256) :
+                            resolveMap(*args->map, *args->breaches, args->count, 256);
+    return nullptr;
+}
+
+// wall time per breach with *threads* threads resolving at once
+static double timeResolveThreads(FlatBiDict& flat, MapBiDict& map, bool useFlat,
+                                 const std::vector<uint32_t>& breaches, size_t count,
+                                 int threads)
+{
+    std::vector<pthread_t> ids(threads);
+    std::vector<ResolveArgs> args(threads);
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, nullptr, threads + 1);
+    for (int t = 0; t < threads; t++) {
+        args[t] = {&flat, &map, useFlat, &breaches, count, &start};
+        pthread_create(&ids[t], nullptr, resolveThread, &args[t]);
+    }
+    pthread_barrier_wait(&start);
+    uint64_t startNs = monotonicNs();
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], nullptr);
+    }
+    double ns = (double)(monotonicNs() - startNs) / ((double)count * threads);
+    pthread_barrier_destroy(&start);
+    return ns;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-f fences] [-r breaches] [-t threads]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    int fences = 10000;
+    int count = 2000000;
+    int threads = 4;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "f:r:t:"))) {
+        switch (opt) {
+        case 'f':
+            fences = atoi(optarg);
+            break;
+        case 'r':
+            count = atoi(optarg);
+            break;
+        case 't':
+            threads = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (fences <= 0 || count <= 0 || threads <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    // whole bursts only
+    count = (count + 4095) / 4096 * 4096;
+
+    // breaches of random fences; one in eight of a fence removed meanwhile
+    std::vector<uint32_t> breaches(1 << 16);
+    srand(1);
+    for (auto& session : breaches) {
+        uint32_t fence = rand() % fences;
+        session = (0 == rand() % 8) ? sessionOf(fence) + 1 : sessionOf(fence);
+    }
+
+    FlatBiDict flat;
+    MapBiDict map;
+    char name[32];
+    printf("%-24s %12s %12s\n", "case", "std::map ns", "flat ns");
+    double mapNs = timeAdd(map, fences);
+    double flatNs = timeAdd(flat, fences);
+    printf("%-24s %12.1f %12.1f\n", "add fence", mapNs, flatNs);
+    static const size_t bursts[] = {1, 16, 256, 4096};
+    for (auto burst : bursts) {
+        snprintf(name, sizeof(name), "breach, burst %zu", burst);
+        mapNs = timeResolve(flat, map, false, breaches, count, burst);
+        flatNs = timeResolve(flat, map, true, breaches, count, burst);
+        printf("%-24s %12.1f %12.1f\n", name, mapNs, flatNs);
+    }
+    snprintf(name, sizeof(name), "breach, %d threads", threads);
+    mapNs = timeResolveThreads(flat, map, false, breaches, count, threads);
+    flatNs = timeResolveThreads(flat, map, true, breaches, count, threads);
+    printf("%-24s %12.1f %12.1f\n", name, mapNs, flatNs);
+    mapNs = timeRemove(map, fences);
+    flatNs = timeRemove(flat, fences);
+    printf("%-24s %12.1f %12.1f\n", "remove fence", mapNs, flatNs);
+    return 0;
+}
@@ -0,0 +1,216 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocationAPIClientBase.h>
+#include <loc_test_util.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+// Checks LocationAPIClientBase::BiDict as the geofence client uses it: id and
+// breach type mask by session with getIdAndExtBySession(), removal from
+// either side, lookup misses that must not insert, and lookups racing with
+// fences being added and removed. The exit status is the number of failed
+// checks.
+//
+// usage: loc_bidict_test
+
+#define TEST_FENCES         2000
+#define TEST_READERS        4
+#define TEST_BREACH_BURST   64
+#define TEST_WRITER_ROUNDS  200
+
+// a friend of LocationAPIClientBase, to reach its private BiDict
+class BiDictAccess {
+public:
+    typedef LocationAPIClientBase::BiDict<GeofenceBreachTypeMask> GeofenceBiDict;
+};
+typedef BiDictAccess::GeofenceBiDict GeofenceBiDict;
+
+// each fence is kept consistent in all the tests: id, session and mask are
+// all derived from the session
+static inline uint32_t idOf(uint32_t session) { return session + 1000000; }
+static inline GeofenceBreachTypeMask maskOf(uint32_t session)
+{
+    return (GeofenceBreachTypeMask)((session & 1) ? GEOFENCE_BREACH_ENTER_BIT :
+            (GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT));
+}
+
+static void addFence(GeofenceBiDict& dict, uint32_t session)
+{
+    GeofenceBreachTypeMask mask = maskOf(session);
+    dict.set(idOf(session), session, mask);
+}
+
+/* ==== LOOKUPS ======================================================================== */
+
+static void testGetIdAndExtBySession()
+{
+    GeofenceBiDict dict;
+    for (uint32_t session = 1; session <= TEST_FENCES; session++) {
+        addFence(dict, session);
+    }
+    bool allFound = true;
+    for (uint32_t session = 1; session <= TEST_FENCES; session++) {
+        uint32_t id = 0;
+        GeofenceBreachTypeMask mask = 0;
+        allFound = allFound && dict.getIdAndExtBySession(session, id, mask) &&
+                id == idOf(session) && mask == maskOf(session) &&
+                id == dict.getId(session) && mask == dict.getExtBySession(session) &&
+                mask == dict.getExtById(id) && session == dict.getSession(id);
+    }
+    expectTrue("getIdAndExtBySession() finds each fence", allFound);
+
+    uint32_t id = 7;
+    GeofenceBreachTypeMask mask = 3;
+    expectTrue("getIdAndExtBySession() miss",
+               !dict.getIdAndExtBySession(TEST_FENCES + 1, id, mask));
+    expectTrue("getIdAndExtBySession() miss leaves id and ext", 7 == id && 3 == mask);
+    expectTrue("getExtById() miss", 0 == dict.getExtById(1));
+    expectTrue("getExtById() miss does not insert", !dict.hasId(1));
+    expectTrue("getId() miss", 0 == dict.getId(TEST_FENCES + 1));
+    expectTrue("getId() miss does not insert", !dict.hasSession(TEST_FENCES + 1));
+    expectTrue("getAllSessions()", TEST_FENCES == dict.getAllSessions().size());
+}
+
+static void testRemove()
+{
+    GeofenceBiDict dict;
+    for (uint32_t session = 1; session <= TEST_FENCES; session++) {
+        addFence(dict, session);
+    }
+    // every third by id, every third by session, the rest stays
+    for (uint32_t session = 1; session <= TEST_FENCES; session++) {
+        if (0 == session % 3) {
+            dict.rmById(idOf(session));
+        } else if (1 == session % 3) {
+            dict.rmBySession(session);
+        }
+    }
+    bool right = true;
+    for (uint32_t session = 1; session <= TEST_FENCES; session++) {
+        uint32_t id = 0;
+        GeofenceBreachTypeMask mask = 0;
+        bool kept = (2 == session % 3);
+        right = right && (kept == dict.getIdAndExtBySession(session, id, mask)) &&
+                (kept == dict.hasId(idOf(session))) && (kept == dict.hasSession(session));
+    }
+    expectTrue("rmById() and rmBySession() remove both sides", right);
+    dict.rmById(idOf(3));
+    dict.rmBySession(1);
+    expectTrue("removing again", (TEST_FENCES + 1) / 3 == dict.getAllSessions().size());
+    std::vector<uint32_t> sessions = dict.getAllSessions();
+    std::sort(sessions.begin(), sessions.end());
+    expectTrue("getAllSessions() after removal", 2 == sessions.front() && 0 == (sessions.back() - 2) % 3);
+    dict.clear();
+    expectTrue("clear()", dict.getAllSessions().empty() && !dict.hasSession(2));
+}
+
+/* ==== CONCURRENCY ==================================================================== */
+
+typedef struct {
+    GeofenceBiDict* dict;
+    std::atomic<bool>* done;
+    bool consistent;
+    uint64_t found;
+} ReaderArgs;
+
+static void* readBreaches(void* arg)
+{
+    ReaderArgs* args = (ReaderArgs*)arg;
+    uint32_t session = 1;
+    args->consistent = true;
+    args->found = 0;
+    while (!args->done->load()) {
+        // a burst of breaches, then a break, so the writer gets the lock
+        for (int i = 0; i < TEST_BREACH_BURST; i++) {
+            uint32_t id = 0;
+            GeofenceBreachTypeMask mask = 0;
+            if (args->dict->getIdAndExtBySession(session, id, mask)) {
+                args->consistent = args->consistent &&
+                        id == idOf(session) && mask == maskOf(session);
+                args->found++;
+            }
+            session = (session % TEST_FENCES) + 1;
+        }
+        sched_yield();
+    }
+    return nullptr;
+}
+
+static void testConcurrentLookups()
+{
+    GeofenceBiDict dict;
+    for (uint32_t session = 1; session <= TEST_FENCES; session++) {
+        addFence(dict, session);
+    }
+    std::atomic<bool> done(false);
+    pthread_t readers[TEST_READERS];
+    ReaderArgs args[TEST_READERS];
+    for (int r = 0; r < TEST_READERS; r++) {
+        args[r].dict = &dict;
+        args[r].done = &done;
+        pthread_create(&readers[r], nullptr, readBreaches, &args[r]);
+    }
+    // remove and add back half the fences, which also rehashes the maps
+    for (int round = 0; round < TEST_WRITER_ROUNDS; round++) {
+        for (uint32_t session = 1 + (round & 1); session <= TEST_FENCES; session += 2) {
+            if (round & 2) {
+                dict.rmById(idOf(session));
+            } else {
+                dict.rmBySession(session);
+            }
+        }
+        for (uint32_t session = 1 + (round & 1); session <= TEST_FENCES; session += 2) {
+            addFence(dict, session);
+        }
+    }
+    done = true;
+    bool consistent = true;
+    uint64_t found = 0;
+    for (int r = 0; r < TEST_READERS; r++) {
+        pthread_join(readers[r], nullptr);
+        consistent = consistent && args[r].consistent;
+        found += args[r].found;
+    }
+    expectTrue("lookups racing with add and remove see whole entries", consistent);
+    expectTrue("lookups racing with add and remove find fences", found > 0);
+    expectTrue("all fences there after the race", TEST_FENCES == dict.getAllSessions().size());
+}
+
+int main()
+{
+    testGetIdAndExtBySession();
+    testRemove();
+    testConcurrentLookups();
+    return testResult();
+}
@@ -88,6 +88,7 @@ struct GnssInterface {
     void (*getPowerStateChanges)(void* powerStateCb);
     void (*injectLocationExt)(const GnssLocationInfoNotification &locationInfo);
     void (*updateBatteryStatus)(bool charging);
+    bool (*getCurrentLocation)(uint64_t timestamp, Location& location);
 };
 
 struct BatchingInterface {
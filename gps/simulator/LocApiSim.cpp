@@ -0,0 +1,908 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_LocApiSim"
+
+#include <LocApiSim.h>
+#include <ContextBase.h>
+#include <loc_cfg.h>
+#include <loc_geo.h>
+#include <log_util.h>
+#include <inttypes.h>
+#include <math.h>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOC_SIM_CONF_DEFAULT        "/etc/loc_sim.conf"
+#define LOC_SIM_IDLE_TICK_MS        100
+#define LOC_SIM_BATCH_SIZE          20
+#define LOC_SIM_TRIP_BATCH_SIZE     600
+#define LOC_SIM_GPS_L1_HZ           1575420000.0f
+#define LOC_SIM_GPS_L1_WAVELENGTH   0.19029367
+#define LOC_SIM_GPS_EPOCH_UNIX_MS   315964800000LL
+
+static std::atomic<LocApiSimReplayListener> sReplayListener(nullptr);
+
+static std::atomic<uint64_t> sReceiverOnMs(0);
+
+extern "C" uint64_t getLocApiSimReceiverOnMs()
+{
+    return sReceiverOnMs;
+}
+
+extern "C" void setLocApiSimReplayListener(LocApiSimReplayListener listener)
+{
+    sReplayListener = listener;
+}
+
+static uint64_t simMonotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t simNowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+class LocApiSim::Ticker : public LocRunnable {
+    LocApiSim& mSim;
+    struct timespec mNext;
+public:
+    inline Ticker(LocApiSim& sim) : mSim(sim) {
+        clock_gettime(CLOCK_MONOTONIC, &mNext);
+    }
+    virtual bool run() {
+        uint32_t tickMs = mSim.mTickMs;
+        if (0 == tickMs) {
+            tickMs = LOC_SIM_IDLE_TICK_MS;
+        }
+        mNext.tv_nsec += (long)tickMs * 1000000;
+        mNext.tv_sec += mNext.tv_nsec / 1000000000;
+        mNext.tv_nsec %= 1000000000;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &mNext, NULL);
+
+        // never more than one tick in the LocApi queue
+        if (mSim.mTickQueued.exchange(true)) {
+            mSim.mMissedTicks++;
+            return true;
+        }
+        LocApiSim* sim = &mSim;
+        mSim.sendMsg(new LocApiMsg([sim] {
+            sim->mTickQueued = false;
+            sim->tick();
+        }));
+        return true;
+    }
+};
+
+class LocApiSim::Replayer : public LocRunnable {
+    LocApiSim& mSim;
+    uint32_t mLoop;
+    uint64_t mStartNs;      // when the first event of this loop went out
+    uint64_t mBaseNs;       // and its time in the trace
+    uint64_t mEvents;
+    uint64_t mCpuStartNs;
+
+    static uint64_t cpuNs() {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+    void done() {
+        LocApiSimReplayListener listener = sReplayListener;
+        if (nullptr != listener) {
+            listener(LOC_API_TRACE_NONE, 0, simMonotonicNs());
+        }
+        LOC_LOGD("%s]: %" PRIu64 " events in %u loops, replay thread CPU %" PRIu64 " ns/event",
+                 __func__, mEvents, mLoop,
+                 (0 != mEvents) ? (cpuNs() - mCpuStartNs) / mEvents : 0);
+    }
+public:
+    inline Replayer(LocApiSim& sim) :
+        mSim(sim), mLoop(0), mStartNs(0), mBaseNs(0), mEvents(0), mCpuStartNs(cpuNs()) {
+        mSim.mTraceReader.rewind();
+    }
+    virtual bool run() {
+        LocApiTraceReader& reader = mSim.mTraceReader;
+        bool first = (0 == mEvents);
+        if (!reader.next()) {
+            if (0 == mEvents || (0 != mSim.mReplayLoops && ++mLoop >= mSim.mReplayLoops)) {
+                done();
+                return false;
+            }
+            reader.rewind();
+            if (!reader.next()) {
+                done();
+                return false;
+            }
+            first = true;
+        }
+        if (first) {
+            mStartNs = simMonotonicNs();
+            mBaseNs = reader.timeNs();
+        }
+        if (mSim.mReplaySpeed > 0) {
+            uint64_t dueNs = mStartNs +
+                    (uint64_t)((reader.timeNs() - mBaseNs) / mSim.mReplaySpeed);
+            struct timespec due = {(time_t)(dueNs / 1000000000ULL),
+                                   (long)(dueNs % 1000000000ULL)};
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+        }
+        LocApiSimReplayListener listener = sReplayListener;
+        if (nullptr != listener) {
+            listener(reader.event(), reader.key(), simMonotonicNs());
+        }
+        if (!reader.deliver(mSim)) {
+            LOC_LOGW("%s]: event %d at %" PRIu64 " ns not delivered",
+                     __func__, reader.event(), reader.timeNs());
+        }
+        mEvents++;
+        return true;
+    }
+};
+
+LocApiSim::LocApiSim(LOC_API_ADAPTER_EVENT_MASK_T exMask, ContextBase* context) :
+    LocApiBase(exMask, context),
+    mStartMs(simNowMs()),
+    mFixIntervalMs(0),
+    mSvIntervalMs(1000),
+    mNmeaIntervalMs(0),
+    mMeasurementIntervalMs(1000),
+    mGeofenceIntervalMs(1000),
+    mSvCount(12),
+    mReceiverOnMs(1000),
+    mFixSessionIntervalMs(0),
+    mNmeaTypesMask(LOC_NMEA_MASK_GGA_V02 | LOC_NMEA_MASK_RMC_V02),
+    mAccountedMs(simNowMs()),
+    mBatchSize(LOC_SIM_BATCH_SIZE),
+    mTripBatchSize(LOC_SIM_TRIP_BATCH_SIZE),
+    mTripDistance(0),
+    mTripTbfMs(0),
+    mTripAccumulatedDistance(0),
+    mTripHasLast(false),
+    mNextGeofenceHwId(1),
+    mMeasurements(new GnssMeasurements),
+    mTickMs(0),
+    mTickQueued(false),
+    mMissedTicks(0),
+    mReplaying(false),
+    mReplaySpeed(1),
+    mReplayLoops(1)
+{
+    memset(&mLastLocation, 0, sizeof(mLastLocation));
+    memset(&mTripLastLocation, 0, sizeof(mTripLastLocation));
+    SimStream off = {0, 0};
+    mFixStream = mSvStream = mNmeaStream = mMeasurementStream = off;
+    mBatchStream = mTripStream = mGeofenceStream = off;
+    readConfig();
+}
+
+LocApiSim::~LocApiSim()
+{
+    mReplayThread.stop();
+    mTickerThread.stop();
+    delete mMeasurements;
+}
+
+void
+LocApiSim::readConfig()
+{
+    char traceFile[LOC_MAX_PARAM_STRING];
+    char segments[LOC_MAX_PARAM_STRING];
+    char eventTrace[LOC_MAX_PARAM_STRING];
+    double latitude = 37.4220;
+    double longitude = -122.0841;
+    double radius = 500;
+    double speed = 10;
+    double accuracy = 5;
+    memset(traceFile, 0, sizeof(traceFile));
+    memset(segments, 0, sizeof(segments));
+    memset(eventTrace, 0, sizeof(eventTrace));
+    const loc_param_s_type sim_conf_param_table[] =
+    {
+        {"SIM_TRACE_FILE", &traceFile, NULL, 's'},
+        {"SIM_ORIGIN_LATITUDE", &latitude, NULL, 'f'},
+        {"SIM_ORIGIN_LONGITUDE", &longitude, NULL, 'f'},
+        {"SIM_RADIUS", &radius, NULL, 'f'},
+        {"SIM_SPEED", &speed, NULL, 'f'},
+        {"SIM_ACCURACY", &accuracy, NULL, 'f'},
+        {"SIM_SEGMENTS", &segments, NULL, 's'},
+        {"SIM_FIX_INTERVAL_MS", &mFixIntervalMs, NULL, 'n'},
+        {"SIM_SV_INTERVAL_MS", &mSvIntervalMs, NULL, 'n'},
+        {"SIM_NMEA_INTERVAL_MS", &mNmeaIntervalMs, NULL, 'n'},
+        {"SIM_MEASUREMENT_INTERVAL_MS", &mMeasurementIntervalMs, NULL, 'n'},
+        {"SIM_GEOFENCE_INTERVAL_MS", &mGeofenceIntervalMs, NULL, 'n'},
+        {"SIM_SV_COUNT", &mSvCount, NULL, 'n'},
+        {"SIM_RECEIVER_ON_MS", &mReceiverOnMs, NULL, 'n'},
+        {"SIM_EVENT_TRACE", &eventTrace, NULL, 's'},
+        {"SIM_EVENT_TRACE_SPEED", &mReplaySpeed, NULL, 'f'},
+        {"SIM_EVENT_TRACE_LOOPS", &mReplayLoops, NULL, 'n'},
+    };
+    const char* conf = getenv("LOC_SIM_CONF");
+    UTIL_READ_CONF((NULL != conf) ? conf : LOC_SIM_CONF_DEFAULT, sim_conf_param_table);
+
+    if (mSvCount > GNSS_MEASUREMENTS_MAX) {
+        mSvCount = GNSS_MEASUREMENTS_MAX;
+    }
+    mTrajectory.setCircle(latitude, longitude, radius, speed, accuracy);
+    if ('\0' != segments[0]) {
+        mTrajectory.setSegments(segments);
+    }
+    if ('\0' != traceFile[0]) {
+        mTrajectory.loadTrace(traceFile);
+    }
+    if ('\0' != eventTrace[0]) {
+        mReplaying = mTraceReader.open(eventTrace);
+        if (mReplaying) {
+            LOC_LOGD("%s]: replaying %s at %.1fx, %u loops", __func__,
+                     eventTrace, mReplaySpeed, mReplayLoops);
+        }
+    }
+    LOC_LOGD("%s]: %s, fix %u sv %u nmea %u meas %u geofence %u ms, %u SVs", __func__,
+             mTrajectory.isTrace() ? traceFile : "circle", mFixIntervalMs, mSvIntervalMs,
+             mNmeaIntervalMs, mMeasurementIntervalMs, mGeofenceIntervalMs, mSvCount);
+}
+
+enum loc_api_adapter_err
+LocApiSim::open(LOC_API_ADAPTER_EVENT_MASK_T mask)
+{
+    if (!ContextBase::isEngineCapabilitiesKnown() && nullptr != mContext) {
+        // the simulator backs every feature the adapters may ask about
+        uint8_t features[MAX_FEATURE_LENGTH];
+        memset(features, 0xFF, sizeof(features));
+        mContext->setEngineCapabilities((1ULL << LOC_API_ADAPTER_MESSAGE_MAX) - 1,
+                                        features, true);
+    }
+    mMask = mask;
+    if (mReplaying) {
+        // the trace stands in for all the synthetic reports
+        if (!mReplayThread.isRunning()) {
+            mReplayThread.start("LocApiSimReplay", new Replayer(*this));
+        }
+    } else if (!mTickerThread.isRunning()) {
+        mTickerThread.start("LocApiSimTicker", new Ticker(*this));
+    }
+    updateStreams();
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+enum loc_api_adapter_err
+LocApiSim::close()
+{
+    mReplayThread.stop();
+    mTickerThread.stop();
+    mMask = 0;
+    if (mMissedTicks > 0) {
+        LOC_LOGW("%s]: %u ticks missed, the LocApi thread could not keep up",
+                 __func__, (uint32_t)mMissedTicks);
+    }
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+void
+LocApiSim::respond(LocApiResponse* adapterResponse, LocationError err)
+{
+    if (nullptr != adapterResponse) {
+        adapterResponse->returnToSender(err);
+    }
+}
+
+/* ==== SCHEDULING ========================================================================= */
+
+void
+LocApiSim::updateStreams()
+{
+    uint64_t nowMs = simNowMs();
+    accountReceiverOn(nowMs);
+    auto setStream = [nowMs] (SimStream& stream, uint32_t intervalMs) {
+        if (stream.intervalMs != intervalMs) {
+            stream.intervalMs = intervalMs;
+            stream.dueMs = nowMs;
+        }
+    };
+
+    uint32_t fixIntervalMs = mFixSessionIntervalMs;
+    for (auto& session : mDistanceSessions) {
+        if (0 == fixIntervalMs || session.second < fixIntervalMs) {
+            fixIntervalMs = session.second;
+        }
+    }
+    bool tracking = (0 != fixIntervalMs);
+    if (tracking && 0 != mFixIntervalMs) {
+        fixIntervalMs = mFixIntervalMs;
+    }
+    uint32_t batchIntervalMs = 0;
+    for (auto& session : mBatchingSessions) {
+        if (0 == batchIntervalMs || session.second < batchIntervalMs) {
+            batchIntervalMs = session.second;
+        }
+    }
+
+    setStream(mFixStream, fixIntervalMs);
+    setStream(mSvStream, tracking ? mSvIntervalMs : 0);
+    setStream(mNmeaStream, tracking ? mNmeaIntervalMs : 0);
+    setStream(mMeasurementStream,
+              (tracking && (mMask & LOC_API_ADAPTER_BIT_GNSS_MEASUREMENT)) ?
+              mMeasurementIntervalMs : 0);
+    setStream(mBatchStream, batchIntervalMs);
+    setStream(mTripStream, (0 != mTripDistance) ? mTripTbfMs : 0);
+    setStream(mGeofenceStream, mGeofences.empty() ? 0 : mGeofenceIntervalMs);
+
+    uint32_t tickMs = 0;
+    for (const SimStream* stream : {&mFixStream, &mSvStream, &mNmeaStream,
+            &mMeasurementStream, &mBatchStream, &mTripStream, &mGeofenceStream}) {
+        if (0 != stream->intervalMs && (0 == tickMs || stream->intervalMs < tickMs)) {
+            tickMs = stream->intervalMs;
+        }
+    }
+    mTickMs = tickMs;
+}
+
+bool
+LocApiSim::isDue(SimStream& stream, uint64_t nowMs)
+{
+    if (0 == stream.intervalMs || nowMs < stream.dueMs) {
+        return false;
+    }
+    stream.dueMs += stream.intervalMs;
+    if (stream.dueMs <= nowMs) {
+        // fell behind, do not try to catch up with a burst
+        stream.dueMs = nowMs + stream.intervalMs;
+    }
+    return true;
+}
+
+void
+LocApiSim::accountReceiverOn(uint64_t nowMs)
+{
+    // the receiver runs for the most frequent of the fixes asked for
+    uint32_t fixIntervalMs = 0;
+    for (const SimStream* stream : {&mFixStream, &mBatchStream, &mTripStream}) {
+        if (0 != stream->intervalMs &&
+            (0 == fixIntervalMs || stream->intervalMs < fixIntervalMs)) {
+            fixIntervalMs = stream->intervalMs;
+        }
+    }
+    if (0 != fixIntervalMs && nowMs > mAccountedMs) {
+        uint64_t elapsedMs = nowMs - mAccountedMs;
+        sReceiverOnMs += (fixIntervalMs <= mReceiverOnMs) ?
+                elapsedMs : elapsedMs * mReceiverOnMs / fixIntervalMs;
+    }
+    mAccountedMs = nowMs;
+}
+
+void
+LocApiSim::tick()
+{
+    uint64_t nowMs = simNowMs();
+    accountReceiverOn(nowMs);
+    Location location;
+    mTrajectory.getLocation(nowMs - mStartMs, location);
+    location.timestamp = nowMs;
+    mLastLocation = location;
+
+    if (isDue(mFixStream, nowMs)) {
+        reportSimPosition(location);
+        if (0 == mNmeaIntervalMs) {
+            reportSimNmea(location);
+        }
+    }
+    if (isDue(mNmeaStream, nowMs)) {
+        reportSimNmea(location);
+    }
+    if (isDue(mSvStream, nowMs)) {
+        reportSimSv(nowMs);
+    }
+    if (isDue(mMeasurementStream, nowMs)) {
+        reportSimMeasurements(nowMs);
+    }
+    if (isDue(mBatchStream, nowMs)) {
+        batchLocation(location);
+    }
+    if (isDue(mTripStream, nowMs)) {
+        tripLocation(location);
+    }
+    if (isDue(mGeofenceStream, nowMs)) {
+        checkGeofences(location);
+    }
+}
+
+/* ==== REPORTS ============================================================================ */
+
+void
+LocApiSim::reportSimPosition(const Location& location)
+{
+    UlpLocation ulpLocation;
+    memset(&ulpLocation, 0, sizeof(ulpLocation));
+    ulpLocation.size = sizeof(ulpLocation);
+    ulpLocation.position_source = ULP_LOCATION_IS_FROM_GNSS;
+    ulpLocation.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+    LocGpsLocation& gpsLocation = ulpLocation.gpsLocation;
+    gpsLocation.size = sizeof(gpsLocation);
+    gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+                        LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+                        LOC_GPS_LOCATION_HAS_ACCURACY;
+    gpsLocation.latitude = location.latitude;
+    gpsLocation.longitude = location.longitude;
+    gpsLocation.altitude = location.altitude;
+    gpsLocation.speed = location.speed;
+    gpsLocation.bearing = location.bearing;
+    gpsLocation.accuracy = location.accuracy;
+    gpsLocation.timestamp = location.timestamp;
+
+    GpsLocationExtended locationExtended;
+    memset(&locationExtended, 0, sizeof(locationExtended));
+    locationExtended.size = sizeof(locationExtended);
+
+    reportPosition(ulpLocation, locationExtended, LOC_SESS_SUCCESS,
+                   LOC_POS_TECH_MASK_SATELLITE);
+}
+
+void
+LocApiSim::reportSimSv(uint64_t nowMs)
+{
+    if (!(mMask & LOC_API_ADAPTER_BIT_SATELLITE_REPORT)) {
+        return;
+    }
+    GnssSvNotification svNotify;
+    memset(&svNotify, 0, sizeof(svNotify));
+    svNotify.size = sizeof(svNotify);
+    svNotify.count = mSvCount;
+    // SVs spread over the sky, drifting a degree a minute
+    double drift = (nowMs / 60000) % 360;
+    for (uint32_t i = 0; i < mSvCount; ++i) {
+        GnssSv& sv = svNotify.gnssSvs[i];
+        sv.size = sizeof(GnssSv);
+        sv.svId = i + 1;
+        sv.type = GNSS_SV_TYPE_GPS;
+        sv.cN0Dbhz = 30 + (i * 7) % 16;
+        sv.elevation = 10 + (i * 23) % 80;
+        sv.azimuth = fmod(i * 360.0 / mSvCount + drift, 360);
+        sv.gnssSvOptionsMask = GNSS_SV_OPTIONS_HAS_EPHEMER_BIT | GNSS_SV_OPTIONS_USED_IN_FIX_BIT;
+        sv.carrierFrequencyHz = LOC_SIM_GPS_L1_HZ;
+    }
+    reportSv(svNotify);
+}
+
+static int simNmeaSentence(char* buf, int size, const char* body)
+{
+    uint8_t checksum = 0;
+    for (const char* c = body; '\0' != *c; ++c) {
+        checksum ^= (uint8_t)*c;
+    }
+    return snprintf(buf, size, "$%s*%02X\r\n", body, checksum);
+}
+
+void
+LocApiSim::reportSimNmea(const Location& location)
+{
+    if (!(mMask & (LOC_API_ADAPTER_BIT_NMEA_1HZ_REPORT |
+                   LOC_API_ADAPTER_BIT_NMEA_POSITION_REPORT))) {
+        return;
+    }
+
+    time_t seconds = location.timestamp / 1000;
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    double lat = fabs(location.latitude);
+    double lon = fabs(location.longitude);
+    int latDeg = (int)lat;
+    int lonDeg = (int)lon;
+    char body[128];
+    char sentence[160];
+
+    if (mNmeaTypesMask & LOC_NMEA_MASK_GGA_V02) {
+        snprintf(body, sizeof(body),
+                 "GPGGA,%02d%02d%02d.%02d,%02d%08.5f,%c,%03d%08.5f,%c,1,%02u,0.9,%.1f,M,0.0,M,,",
+                 utc.tm_hour, utc.tm_min, utc.tm_sec, (int)(location.timestamp % 1000) / 10,
+                 latDeg, (lat - latDeg) * 60, (location.latitude >= 0) ? 'N' : 'S',
+                 lonDeg, (lon - lonDeg) * 60, (location.longitude >= 0) ? 'E' : 'W',
+                 mSvCount, location.altitude);
+        int length = simNmeaSentence(sentence, sizeof(sentence), body);
+        reportNmea(sentence, length);
+    }
+    if (mNmeaTypesMask & LOC_NMEA_MASK_RMC_V02) {
+        snprintf(body, sizeof(body),
+                 "GPRMC,%02d%02d%02d.%02d,A,%02d%08.5f,%c,%03d%08.5f,%c,%.1f,%.1f,"
+                 "%02d%02d%02d,,,A",
+                 utc.tm_hour, utc.tm_min, utc.tm_sec, (int)(location.timestamp % 1000) / 10,
+                 latDeg, (lat - latDeg) * 60, (location.latitude >= 0) ? 'N' : 'S',
+                 lonDeg, (lon - lonDeg) * 60, (location.longitude >= 0) ? 'E' : 'W',
+                 location.speed * 1.94384, location.bearing,
+                 utc.tm_mday, utc.tm_mon + 1, utc.tm_year % 100);
+        int length = simNmeaSentence(sentence, sizeof(sentence), body);
+        reportNmea(sentence, length);
+    }
+}
+
+void
+LocApiSim::reportSimMeasurements(uint64_t nowMs)
+{
+    memset(mMeasurements, 0, sizeof(GnssMeasurements));
+    mMeasurements->size = sizeof(GnssMeasurements);
+    GnssMeasurementsNotification& notify = mMeasurements->gnssMeasNotification;
+    notify.size = sizeof(notify);
+    notify.count = mSvCount;
+
+    int64_t gpsTimeNs = ((int64_t)nowMs - LOC_SIM_GPS_EPOCH_UNIX_MS) * 1000000LL;
+    notify.clock.size = sizeof(notify.clock);
+    notify.clock.flags = GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT;
+    notify.clock.timeNs = (int64_t)(nowMs - mStartMs) * 1000000LL;
+    notify.clock.fullBiasNs = notify.clock.timeNs - gpsTimeNs;
+
+    for (uint32_t i = 0; i < mSvCount; ++i) {
+        GnssMeasurementsData& data = notify.measurements[i];
+        data.size = sizeof(data);
+        data.flags = GNSS_MEASUREMENTS_DATA_SV_ID_BIT | GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT |
+                     GNSS_MEASUREMENTS_DATA_STATE_BIT |
+                     GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_BIT |
+                     GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_UNCERTAINTY_BIT |
+                     GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT |
+                     GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_BIT |
+                     GNSS_MEASUREMENTS_DATA_PSEUDORANGE_RATE_UNCERTAINTY_BIT;
+        data.svId = i + 1;
+        data.svType = GNSS_SV_TYPE_GPS;
+        data.stateMask = GNSS_MEASUREMENTS_STATE_CODE_LOCK_BIT |
+                         GNSS_MEASUREMENTS_STATE_TOW_DECODED_BIT;
+        // time of week at the SV, about 70 ms of flight earlier
+        data.receivedSvTimeNs = (gpsTimeNs - 70000000LL - i * 1000000LL) %
+                                (604800LL * 1000000000LL);
+        data.receivedSvTimeUncertaintyNs = 10;
+        data.carrierToNoiseDbHz = 30 + (i * 7) % 16;
+        data.pseudorangeRateMps = 800.0 * sin(i + (nowMs - mStartMs) / 600000.0);
+        data.pseudorangeRateUncertaintyMps = 0.1;
+        data.carrierFrequencyHz = LOC_SIM_GPS_L1_HZ;
+    }
+
+    int msInWeek = (int)((gpsTimeNs / 1000000LL) % (604800LL * 1000));
+    reportGnssMeasurements(*mMeasurements, msInWeek);
+}
+
+/* ==== TRACKING =========================================================================== */
+
+void
+LocApiSim::startFix(const LocPosMode& fixCriteria, LocApiResponse* adapterResponse)
+{
+    mFixSessionIntervalMs = (0 != fixCriteria.min_interval) ? fixCriteria.min_interval : 1000;
+    updateStreams();
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::stopFix(LocApiResponse* adapterResponse)
+{
+    mFixSessionIntervalMs = 0;
+    updateStreams();
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::startTimeBasedTracking(const TrackingOptions& options,
+        LocApiResponse* adapterResponse)
+{
+    mFixSessionIntervalMs = (0 != options.minInterval) ? options.minInterval : 1000;
+    updateStreams();
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::stopTimeBasedTracking(LocApiResponse* adapterResponse)
+{
+    stopFix(adapterResponse);
+}
+
+void
+LocApiSim::startDistanceBasedTracking(uint32_t sessionId, const LocationOptions& options,
+        LocApiResponse* adapterResponse)
+{
+    mDistanceSessions[sessionId] = (0 != options.minInterval) ? options.minInterval : 1000;
+    updateStreams();
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::stopDistanceBasedTracking(uint32_t sessionId, LocApiResponse* adapterResponse)
+{
+    mDistanceSessions.erase(sessionId);
+    updateStreams();
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+enum loc_api_adapter_err
+LocApiSim::setNMEATypesSync(uint32_t typesMask)
+{
+    mNmeaTypesMask = typesMask;
+    return LOC_API_ADAPTER_ERR_SUCCESS;
+}
+
+void
+LocApiSim::addToCallQueue(LocApiResponse* adapterResponse)
+{
+    // every call above completes before returning
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+/* ==== BATCHING =========================================================================== */
+
+void
+LocApiSim::batchLocation(const Location& location)
+{
+    mBatch.push_back(location);
+    if (mBatch.size() < mBatchSize) {
+        return;
+    }
+    if (mMask & LOC_API_ADAPTER_BIT_BATCH_FULL) {
+        reportLocations(mBatch.data(), mBatch.size(), BATCHING_MODE_ROUTINE);
+        mBatch.clear();
+    } else {
+        // nobody wants it pushed, keep the newest
+        mBatch.erase(mBatch.begin());
+    }
+}
+
+void
+LocApiSim::startBatching(uint32_t sessionId, const LocationOptions& options,
+        uint32_t /*accuracy*/, uint32_t /*timeout*/, LocApiResponse* adapterResponse)
+{
+    mBatchingSessions[sessionId] = (0 != options.minInterval) ? options.minInterval : 1000;
+    updateStreams();
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::stopBatching(uint32_t sessionId, LocApiResponse* adapterResponse)
+{
+    mBatchingSessions.erase(sessionId);
+    if (mBatchingSessions.empty()) {
+        mBatch.clear();
+    }
+    updateStreams();
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::getBatchedLocations(size_t count, LocApiResponse* adapterResponse)
+{
+    count = std::min(count, mBatch.size());
+    if (count > 0) {
+        reportLocations(mBatch.data(), count, BATCHING_MODE_ROUTINE);
+        mBatch.erase(mBatch.begin(), mBatch.begin() + count);
+    }
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::setBatchSize(size_t size)
+{
+    mBatchSize = (0 != size) ? size : LOC_SIM_BATCH_SIZE;
+}
+
+void
+LocApiSim::setTripBatchSize(size_t size)
+{
+    mTripBatchSize = (0 != size) ? size : LOC_SIM_TRIP_BATCH_SIZE;
+}
+
+void
+LocApiSim::tripLocation(const Location& location)
+{
+    if (mTripHasLast) {
+        mTripAccumulatedDistance += loc_geo_distance(
+                mTripLastLocation.latitude, mTripLastLocation.longitude,
+                location.latitude, location.longitude);
+    }
+    mTripLastLocation = location;
+    mTripHasLast = true;
+
+    mTripBatch.push_back(location);
+    if (mTripBatch.size() >= mTripBatchSize) {
+        if (mMask & LOC_API_ADAPTER_BIT_BATCH_FULL) {
+            reportLocations(mTripBatch.data(), mTripBatch.size(), BATCHING_MODE_TRIP);
+            mTripBatch.clear();
+        } else {
+            mTripBatch.erase(mTripBatch.begin());
+        }
+    }
+
+    if (mTripAccumulatedDistance >= mTripDistance) {
+        // the trip is over, flush it and stop until restarted
+        if (!mTripBatch.empty()) {
+            reportLocations(mTripBatch.data(), mTripBatch.size(), BATCHING_MODE_TRIP);
+            mTripBatch.clear();
+        }
+        uint32_t accumulatedDistance = (uint32_t)mTripAccumulatedDistance;
+        mTripDistance = 0;
+        updateStreams();
+        reportCompletedTrips(accumulatedDistance);
+    }
+}
+
+void
+LocApiSim::startOutdoorTripBatching(uint32_t tripDistance, uint32_t tripTbf,
+        uint32_t /*timeout*/, LocApiResponse* adapterResponse)
+{
+    mTripBatch.clear();
+    reStartOutdoorTripBatching(tripDistance, tripTbf, 0, adapterResponse);
+}
+
+void
+LocApiSim::reStartOutdoorTripBatching(uint32_t ongoingTripDistance,
+        uint32_t ongoingTripInterval, uint32_t /*batchingTimeout*/,
+        LocApiResponse* adapterResponse)
+{
+    mTripDistance = ongoingTripDistance;
+    mTripTbfMs = (0 != ongoingTripInterval) ? ongoingTripInterval : 1000;
+    mTripAccumulatedDistance = 0;
+    mTripHasLast = false;
+    updateStreams();
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::stopOutdoorTripBatching(bool deallocBatchBuffer, LocApiResponse* adapterResponse)
+{
+    mTripDistance = 0;
+    if (deallocBatchBuffer) {
+        mTripBatch.clear();
+    }
+    updateStreams();
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::getBatchedTripLocations(size_t count, uint32_t /*accumulatedDistance*/,
+        LocApiResponse* adapterResponse)
+{
+    count = std::min(count, mTripBatch.size());
+    if (count > 0) {
+        reportLocations(mTripBatch.data(), count, BATCHING_MODE_TRIP);
+        mTripBatch.erase(mTripBatch.begin(), mTripBatch.begin() + count);
+    }
+    respond(adapterResponse, LOCATION_ERROR_SUCCESS);
+}
+
+void
+LocApiSim::queryAccumulatedTripDistance(
+        LocApiResponseData<LocApiBatchData>* adapterResponseData)
+{
+    LocApiBatchData data = {(uint32_t)mTripAccumulatedDistance, (uint32_t)mTripBatch.size()};
+    if (nullptr != adapterResponseData) {
+        adapterResponseData->returnToSender(LOCATION_ERROR_SUCCESS, data);
+    }
+}
+
+/* ==== GEOFENCE =========================================================================== */
+
+void
+LocApiSim::checkGeofences(const Location& location)
+{
+    std::vector<uint32_t> entered;
+    std::vector<uint32_t> exited;
+    for (auto& it : mGeofences) {
+        SimGeofence& geofence = it.second;
+        if (geofence.paused) {
+            continue;
+        }
+        bool inside = loc_geo_distance(geofence.latitude, geofence.longitude,
+                location.latitude, location.longitude) <= geofence.radius;
+        if (inside == geofence.inside) {
+            continue;
+        }
+        geofence.inside = inside;
+        if (inside && (geofence.breachTypeMask & GEOFENCE_BREACH_ENTER_BIT)) {
+            entered.push_back(it.first);
+        } else if (!inside && (geofence.breachTypeMask & GEOFENCE_BREACH_EXIT_BIT)) {
+            exited.push_back(it.first);
+        }
+    }
+
+    Location breachLocation = location;
+    if (!entered.empty()) {
+        geofenceBreach(entered.size(), entered.data(), breachLocation,
+                       GEOFENCE_BREACH_ENTER, location.timestamp);
+    }
+    if (!exited.empty()) {
+        geofenceBreach(exited.size(), exited.data(), breachLocation,
+                       GEOFENCE_BREACH_EXIT, location.timestamp);
+    }
+}
+
+void
+LocApiSim::addGeofence(uint32_t /*clientId*/, const GeofenceOption& options,
+        const GeofenceInfo& info, LocApiResponseData<LocApiGeofenceData>* adapterResponseData)
+{
+    LocApiGeofenceData data = {mNextGeofenceHwId++};
+    SimGeofence geofence = {info.latitude, info.longitude, info.radius,
+                            options.breachTypeMask, false, false};
+    mGeofences[data.hwId] = geofence;
+    updateStreams();
+    if (nullptr != adapterResponseData) {
+        adapterResponseData->returnToSender(LOCATION_ERROR_SUCCESS, data);
+    }
+}
+
+void
+LocApiSim::removeGeofence(uint32_t hwId, uint32_t /*clientId*/,
+        LocApiResponse* adapterResponse)
+{
+    LocationError err = (0 != mGeofences.erase(hwId)) ?
+            LOCATION_ERROR_SUCCESS : LOCATION_ERROR_ID_UNKNOWN;
+    updateStreams();
+    respond(adapterResponse, err);
+}
+
+void
+LocApiSim::pauseGeofence(uint32_t hwId, uint32_t /*clientId*/,
+        LocApiResponse* adapterResponse)
+{
+    auto it = mGeofences.find(hwId);
+    if (mGeofences.end() != it) {
+        it->second.paused = true;
+    }
+    respond(adapterResponse, (mGeofences.end() != it) ?
+            LOCATION_ERROR_SUCCESS : LOCATION_ERROR_ID_UNKNOWN);
+}
+
+void
+LocApiSim::resumeGeofence(uint32_t hwId, uint32_t /*clientId*/,
+        LocApiResponse* adapterResponse)
+{
+    auto it = mGeofences.find(hwId);
+    if (mGeofences.end() != it) {
+        it->second.paused = false;
+    }
+    respond(adapterResponse, (mGeofences.end() != it) ?
+            LOCATION_ERROR_SUCCESS : LOCATION_ERROR_ID_UNKNOWN);
+}
+
+void
+LocApiSim::modifyGeofence(uint32_t hwId, uint32_t /*clientId*/, const GeofenceOption& options,
+        LocApiResponse* adapterResponse)
+{
+    auto it = mGeofences.find(hwId);
+    if (mGeofences.end() != it) {
+        it->second.breachTypeMask = options.breachTypeMask;
+    }
+    respond(adapterResponse, (mGeofences.end() != it) ?
+            LOCATION_ERROR_SUCCESS : LOCATION_ERROR_ID_UNKNOWN);
+}
+
+extern "C" LocApiBase* getLocApi(LOC_API_ADAPTER_EVENT_MASK_T exMask,
+                                 ContextBase* context)
+{
+    return new LocApiSim(exMask, context);
+}
@@ -0,0 +1,215 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef LOC_API_SIM_H
+#define LOC_API_SIM_H
+
+#include <LocApiBase.h>
+#include <LocApiTrace.h>
+#include <LocThread.h>
+#include <SimTrajectory.h>
+#include <atomic>
+#include <map>
+#include <vector>
+
+using namespace loc_core;
+
+// LocApiBase that stands in for the modem, so that the adapters can be
+// driven, and measured, on a workstation. ContextBase falls back to it when
+// no modem LocApi library is present.
+//
+// Fixes follow a SimTrajectory; position, SV status, NMEA and measurement
+// reports go out at the rates set in loc_sim.conf while a tracking session
+// is on. Batching sessions keep fixes in a batch that is reported when full
+// or when asked for, trip batching and geofences are evaluated against the
+// same fixes. Everything runs on the LocApi thread; a ticker thread only
+// posts the next tick there, and skips ticks while one is still queued, so
+// a saturated pipeline shows up as missed ticks rather than a backlog.
+//
+// With SIM_EVENT_TRACE set, the reports come from a LocApiTrace recorded on
+// a device instead, replayed from a thread of its own as the modem reports
+// would come in, at the recorded pace, faster, or as fast as the adapters
+// take them.
+class LocApiSim : public LocApiBase {
+public:
+    LocApiSim(LOC_API_ADAPTER_EVENT_MASK_T exMask, ContextBase* context);
+    virtual ~LocApiSim();
+
+    /* ==== TRACKING ======================================================================= */
+    virtual void startFix(const LocPosMode& fixCriteria, LocApiResponse* adapterResponse);
+    virtual void stopFix(LocApiResponse* adapterResponse);
+    virtual void startTimeBasedTracking(const TrackingOptions& options,
+            LocApiResponse* adapterResponse);
+    virtual void stopTimeBasedTracking(LocApiResponse* adapterResponse);
+    virtual void startDistanceBasedTracking(uint32_t sessionId, const LocationOptions& options,
+            LocApiResponse* adapterResponse);
+    virtual void stopDistanceBasedTracking(uint32_t sessionId,
+            LocApiResponse* adapterResponse = nullptr);
+    virtual enum loc_api_adapter_err setNMEATypesSync(uint32_t typesMask);
+
+    /* ==== BATCHING ======================================================================= */
+    virtual void startBatching(uint32_t sessionId, const LocationOptions& options,
+            uint32_t accuracy, uint32_t timeout, LocApiResponse* adapterResponse);
+    virtual void stopBatching(uint32_t sessionId, LocApiResponse* adapterResponse);
+    virtual void startOutdoorTripBatching(uint32_t tripDistance, uint32_t tripTbf,
+            uint32_t timeout, LocApiResponse* adapterResponse);
+    virtual void reStartOutdoorTripBatching(uint32_t ongoingTripDistance,
+            uint32_t ongoingTripInterval, uint32_t batchingTimeout,
+            LocApiResponse* adapterResponse);
+    virtual void stopOutdoorTripBatching(bool deallocBatchBuffer = true,
+            LocApiResponse* adapterResponse = nullptr);
+    virtual void getBatchedLocations(size_t count, LocApiResponse* adapterResponse);
+    virtual void getBatchedTripLocations(size_t count, uint32_t accumulatedDistance,
+            LocApiResponse* adapterResponse);
+    virtual void queryAccumulatedTripDistance(
+            LocApiResponseData<LocApiBatchData>* adapterResponseData);
+    virtual void setBatchSize(size_t size);
+    virtual void setTripBatchSize(size_t size);
+
+    /* ==== GEOFENCE ======================================================================= */
+    virtual void addGeofence(uint32_t clientId, const GeofenceOption& options,
+            const GeofenceInfo& info, LocApiResponseData<LocApiGeofenceData>* adapterResponseData);
+    virtual void removeGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse);
+    virtual void pauseGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse);
+    virtual void resumeGeofence(uint32_t hwId, uint32_t clientId, LocApiResponse* adapterResponse);
+    virtual void modifyGeofence(uint32_t hwId, uint32_t clientId, const GeofenceOption& options,
+            LocApiResponse* adapterResponse);
+
+    virtual void addToCallQueue(LocApiResponse* adapterResponse);
+
+protected:
+    virtual enum loc_api_adapter_err open(LOC_API_ADAPTER_EVENT_MASK_T mask);
+    virtual enum loc_api_adapter_err close();
+
+private:
+    typedef struct {
+        double latitude;
+        double longitude;
+        double radius;
+        GeofenceBreachTypeMask breachTypeMask;
+        bool paused;
+        bool inside;
+    } SimGeofence;
+
+    // one periodic report; 0 interval is off
+    typedef struct {
+        uint32_t intervalMs;
+        uint64_t dueMs;
+    } SimStream;
+
+    class Ticker;
+    friend class Ticker;
+    class Replayer;
+    friend class Replayer;
+
+    void readConfig();
+    void tick();
+    void updateStreams();
+    bool isDue(SimStream& stream, uint64_t nowMs);
+    void accountReceiverOn(uint64_t nowMs);
+    void reportSimPosition(const Location& location);
+    void reportSimSv(uint64_t nowMs);
+    void reportSimNmea(const Location& location);
+    void reportSimMeasurements(uint64_t nowMs);
+    void batchLocation(const Location& location);
+    void tripLocation(const Location& location);
+    void checkGeofences(const Location& location);
+    static void respond(LocApiResponse* adapterResponse, LocationError err);
+
+    SimTrajectory mTrajectory;
+    uint64_t mStartMs;
+    Location mLastLocation;
+
+    // from loc_sim.conf
+    uint32_t mFixIntervalMs;        // 0: follow the tracking sessions
+    uint32_t mSvIntervalMs;
+    uint32_t mNmeaIntervalMs;       // 0: with every fix
+    uint32_t mMeasurementIntervalMs;
+    uint32_t mGeofenceIntervalMs;
+    uint32_t mSvCount;
+    uint32_t mReceiverOnMs;         // per fix, once the receiver sleeps in between
+
+    // sessions
+    uint32_t mFixSessionIntervalMs;     // startFix / time based tracking, 0 when off
+    std::map<uint32_t, uint32_t> mDistanceSessions;     // id to interval
+    std::map<uint32_t, uint32_t> mBatchingSessions;     // id to interval
+    uint32_t mNmeaTypesMask;
+    uint64_t mAccountedMs;          // receiver on time is accounted up to here
+
+    SimStream mFixStream;
+    SimStream mSvStream;
+    SimStream mNmeaStream;
+    SimStream mMeasurementStream;
+    SimStream mBatchStream;
+    SimStream mTripStream;
+    SimStream mGeofenceStream;
+
+    // batching
+    std::vector<Location> mBatch;
+    size_t mBatchSize;
+    std::vector<Location> mTripBatch;
+    size_t mTripBatchSize;
+    uint32_t mTripDistance;         // 0 when no trip
+    uint32_t mTripTbfMs;
+    double mTripAccumulatedDistance;
+    Location mTripLastLocation;
+    bool mTripHasLast;
+
+    // geofence
+    std::map<uint32_t, SimGeofence> mGeofences;
+    uint32_t mNextGeofenceHwId;
+
+    GnssMeasurements* mMeasurements;    // too big for the stack
+
+    LocThread mTickerThread;
+    std::atomic<uint32_t> mTickMs;      // read by the ticker
+    std::atomic<bool> mTickQueued;
+    std::atomic<uint32_t> mMissedTicks;
+
+    // trace replay
+    LocApiTraceReader mTraceReader;
+    bool mReplaying;
+    double mReplaySpeed;            // 0: as fast as possible
+    uint32_t mReplayLoops;          // 0: forever
+    LocThread mReplayThread;
+};
+
+// Called from the replay thread right before each traced event goes to the
+// adapters, with LocApiTraceReader::key() of the event and the
+// CLOCK_MONOTONIC time, so that a client can tell how long the event took
+// to reach it. The event is LOC_API_TRACE_NONE once the replay is over.
+typedef void (*LocApiSimReplayListener)(LocApiTraceEvent event, uint64_t key,
+                                        uint64_t timeNs);
+extern "C" void setLocApiSimReplayListener(LocApiSimReplayListener listener);
+
+// How long the simulated receiver was on so far, in milliseconds. While
+// fixes are due, it is on all the time at intervals up to SIM_RECEIVER_ON_MS
+// of loc_sim.conf, and for that long per fix at longer intervals.
+extern "C" uint64_t getLocApiSimReceiverOnMs();
+
+#endif /* LOC_API_SIM_H */
@@ -0,0 +1,207 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_SimTrajectory"
+
+#include <SimTrajectory.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <loc_geo.h>
+#include <log_util.h>
+
+SimTrajectory::SimTrajectory() :
+    mLatitude(37.4220),
+    mLongitude(-122.0841),
+    mRadius(500),
+    mSpeed(10),
+    mAccuracy(5),
+    mSegmentsDurationMs(0),
+    mSegmentsDistance(0),
+    mTraceDurationMs(0)
+{
+}
+
+void
+SimTrajectory::setCircle(double latitude, double longitude, double radius, double speed,
+        float accuracy)
+{
+    mLatitude = latitude;
+    mLongitude = longitude;
+    mRadius = (radius > 1) ? radius : 1;
+    mSpeed = speed;
+    mAccuracy = accuracy;
+}
+
+bool
+SimTrajectory::setSegments(const char* segments)
+{
+    mSegments.clear();
+    mSegmentsDurationMs = 0;
+    mSegmentsDistance = 0;
+    const char* next = segments;
+    while (NULL != next && '\0' != *next) {
+        Segment segment;
+        double seconds = 0;
+        int length = 0;
+        if (2 != sscanf(next, " %lf:%lf%n", &segment.speed, &seconds, &length) ||
+                segment.speed < 0 || seconds <= 0) {
+            LOC_LOGE("%s]: bad segment in %s", __func__, segments);
+            mSegments.clear();
+            mSegmentsDurationMs = 0;
+            mSegmentsDistance = 0;
+            return false;
+        }
+        segment.durationMs = (uint64_t)(seconds * 1000);
+        mSegments.push_back(segment);
+        mSegmentsDurationMs += segment.durationMs;
+        mSegmentsDistance += segment.speed * seconds;
+        next = strchr(next + length, ',');
+        if (NULL != next) {
+            ++next;
+        }
+    }
+    LOC_LOGD("%s]: %zu segments over %" PRIu64 " ms", __func__,
+             mSegments.size(), mSegmentsDurationMs);
+    return !mSegments.empty();
+}
+
+void
+SimTrajectory::getCircleDistance(uint64_t elapsedMs, double& distance, double& speed) const
+{
+    if (mSegments.empty()) {
+        distance = mSpeed * elapsedMs / 1000.0;
+        speed = mSpeed;
+        return;
+    }
+    distance = mSegmentsDistance * (elapsedMs / mSegmentsDurationMs);
+    uint64_t at = elapsedMs % mSegmentsDurationMs;
+    for (const Segment& segment : mSegments) {
+        if (at < segment.durationMs) {
+            distance += segment.speed * at / 1000.0;
+            speed = segment.speed;
+            return;
+        }
+        distance += segment.speed * segment.durationMs / 1000.0;
+        at -= segment.durationMs;
+    }
+    speed = 0;
+}
+
+bool
+SimTrajectory::loadTrace(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (NULL == file) {
+        LOC_LOGE("%s]: cannot open %s", __func__, path);
+        return false;
+    }
+
+    mTrace.clear();
+    char line[256];
+    while (NULL != fgets(line, sizeof(line), file)) {
+        Location location;
+        memset(&location, 0, sizeof(Location));
+        location.size = sizeof(Location);
+        unsigned int flags = 0;
+        if (8 == sscanf(line, "$PQBLC,%" SCNu64 ",%X,%lf,%lf,%lf,%f,%f,%f",
+                        &location.timestamp, &flags, &location.latitude,
+                        &location.longitude, &location.altitude, &location.speed,
+                        &location.bearing, &location.accuracy) &&
+                (mTrace.empty() || location.timestamp > mTrace.back().timestamp)) {
+            location.flags = (LocationFlagsMask)flags;
+            mTrace.push_back(location);
+        }
+    }
+    fclose(file);
+
+    if (mTrace.size() < 2) {
+        LOC_LOGE("%s]: %s has %zu usable fixes, need 2", __func__, path, mTrace.size());
+        mTrace.clear();
+        return false;
+    }
+    mTraceDurationMs = mTrace.back().timestamp - mTrace.front().timestamp;
+    LOC_LOGD("%s]: %zu fixes over %" PRIu64 " ms from %s",
+             __func__, mTrace.size(), mTraceDurationMs, path);
+    return true;
+}
+
+void
+SimTrajectory::getLocation(uint64_t elapsedMs, Location& location) const
+{
+    memset(&location, 0, sizeof(Location));
+    location.size = sizeof(Location);
+
+    if (!mTrace.empty()) {
+        uint64_t at = mTrace.front().timestamp + elapsedMs % mTraceDurationMs;
+        size_t hi = 1;
+        while (mTrace[hi].timestamp < at) {
+            ++hi;
+        }
+        const Location& a = mTrace[hi - 1];
+        const Location& b = mTrace[hi];
+        double f = (double)(at - a.timestamp) / (b.timestamp - a.timestamp);
+        location = a;
+        location.latitude = a.latitude + f * (b.latitude - a.latitude);
+        location.longitude = a.longitude + f * (b.longitude - a.longitude);
+        location.altitude = a.altitude + f * (b.altitude - a.altitude);
+        location.speed = a.speed + f * (b.speed - a.speed);
+        location.accuracy = a.accuracy + f * (b.accuracy - a.accuracy);
+        return;
+    }
+
+    // counterclockwise seen from above, starting due north of the origin
+    double distance = 0;
+    double speed = 0;
+    getCircleDistance(elapsedMs, distance, speed);
+    double angle = distance / mRadius;
+    double north = mRadius * cos(angle);
+    double east = -mRadius * sin(angle);
+    if (0 == speed) {
+        // standing, the fixes still scatter a little
+        north += mAccuracy / 3 * sin(elapsedMs / 9000.0);
+        east += mAccuracy / 3 * cos(elapsedMs / 13000.0);
+        speed = 0.2 * fabs(sin(elapsedMs / 5000.0));
+    }
+    location.flags = LOCATION_HAS_LAT_LONG_BIT | LOCATION_HAS_ALTITUDE_BIT |
+                     LOCATION_HAS_SPEED_BIT | LOCATION_HAS_BEARING_BIT |
+                     LOCATION_HAS_ACCURACY_BIT;
+    location.latitude = mLatitude + LOC_GEO_RAD_TO_DEG(north / LOC_GEO_EARTH_RADIUS_M);
+    location.longitude = mLongitude + LOC_GEO_RAD_TO_DEG(east / LOC_GEO_EARTH_RADIUS_M /
+                                                         cos(LOC_GEO_DEG_TO_RAD(mLatitude)));
+    location.altitude = 30;
+    location.speed = speed;
+    location.bearing = 270 - fmod(LOC_GEO_RAD_TO_DEG(angle), 360);
+    if (location.bearing < 0) {
+        location.bearing += 360;
+    }
+    location.accuracy = mAccuracy;
+    location.techMask = LOCATION_TECHNOLOGY_GNSS_BIT;
+}
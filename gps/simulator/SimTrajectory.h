@@ -0,0 +1,78 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef SIM_TRAJECTORY_H
+#define SIM_TRAJECTORY_H
+
+#include <LocationDataTypes.h>
+#include <stdint.h>
+#include <vector>
+
+// Where the simulated receiver is at a given time: either a synthetic circle
+// driven around an origin, or a recorded trace played in a loop. Traces are
+// the $PQBLC sentences the batched location export writes, positions in
+// between two recorded fixes are interpolated.
+//
+// The circle is driven at constant speed, or in segments of given speeds and
+// durations, repeated, such as a drive, a stop and a walk. While stopped the
+// position wanders within a third of the accuracy, as a real fix would.
+class SimTrajectory {
+public:
+    SimTrajectory();
+
+    void setCircle(double latitude, double longitude, double radius, double speed,
+                   float accuracy);
+    // "speed:seconds,speed:seconds,...", speeds in meters per second
+    bool setSegments(const char* segments);
+    bool loadTrace(const char* path);
+    inline bool isTrace() const { return !mTrace.empty(); }
+
+    // fills everything but the timestamp, elapsedMs is from the simulation start
+    void getLocation(uint64_t elapsedMs, Location& location) const;
+
+private:
+    typedef struct {
+        double speed;           // meters per second
+        uint64_t durationMs;
+    } Segment;
+
+    void getCircleDistance(uint64_t elapsedMs, double& distance, double& speed) const;
+
+    double mLatitude;
+    double mLongitude;
+    double mRadius;         // meters
+    double mSpeed;          // meters per second
+    float mAccuracy;        // meters
+    std::vector<Segment> mSegments;
+    uint64_t mSegmentsDurationMs;
+    double mSegmentsDistance;   // meters, over all of the segments
+    std::vector<Location> mTrace;
+    uint64_t mTraceDurationMs;
+};
+
+#endif /* SIM_TRAJECTORY_H */
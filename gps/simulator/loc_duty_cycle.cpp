@@ -0,0 +1,180 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocApiSim.h>
+#include <LocationAPI.h>
+#include <loc_test_util.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <mutex>
+
+// Tracks with one LocationAPI client on the simulator for a while and prints
+// per window how many fixes the client got, the longest it waited for one,
+// how fast the device went and how long the simulated receiver was on, then
+// the same for the whole run. With SIM_SEGMENTS in loc_sim.conf describing a
+// drive, a stop and a walk, running it with and without
+// ADAPTIVE_TRACKING_INTERVAL in gps.conf shows what duty cycling the
+// receiver while standing saves, and that the client still gets its fixes.
+//
+// usage: loc_duty_cycle -c loc_sim.conf -t seconds [-i ms] [-w seconds]
+//   -i  tracking interval, 1000 ms by default
+//   -w  window length, 60 seconds by default
+
+typedef struct {
+    uint32_t fixes;
+    uint64_t maxGapMs;
+    double speedSum;
+} Window;
+
+static std::mutex sLock;
+static Window sWindow = {};
+static Window sTotal = {};
+static uint64_t sLastFixMs = 0;
+
+static void onLocation(const Location& location)
+{
+    uint64_t nowMs = monotonicNs() / 1000000;
+    std::lock_guard<std::mutex> guard(sLock);
+    if (0 != sLastFixMs) {
+        uint64_t gapMs = nowMs - sLastFixMs;
+        if (gapMs > sWindow.maxGapMs) {
+            sWindow.maxGapMs = gapMs;
+        }
+        if (gapMs > sTotal.maxGapMs) {
+            sTotal.maxGapMs = gapMs;
+        }
+    }
+    sLastFixMs = nowMs;
+    sWindow.fixes++;
+    sTotal.fixes++;
+    sWindow.speedSum += location.speed;
+    sTotal.speedSum += location.speed;
+}
+
+static void printWindow(const char* label, const Window& window,
+                        uint64_t lengthMs, uint64_t receiverOnMs)
+{
+    printf("%-8s %8u %10" PRIu64 " %9.1f %10" PRIu64 " %7.1f%%\n", label, window.fixes,
+           window.maxGapMs, (0 != window.fixes) ? window.speedSum / window.fixes : 0.0,
+           receiverOnMs, (0 != lengthMs) ? 100.0 * receiverOnMs / lengthMs : 0.0);
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s -c loc_sim.conf -t seconds [-i ms] [-w seconds]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* conf = NULL;
+    int durationSec = 0;
+    uint32_t interval = 1000;
+    int windowSec = 60;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "c:t:i:w:"))) {
+        switch (opt) {
+        case 'c':
+            conf = optarg;
+            break;
+        case 't':
+            durationSec = atoi(optarg);
+            break;
+        case 'i':
+            interval = (uint32_t)atoi(optarg);
+            break;
+        case 'w':
+            windowSec = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (NULL == conf || durationSec <= 0 || windowSec <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    // read by the simulator once the stack loads it
+    setenv("LOC_SIM_CONF", conf, 1);
+
+    LocationCallbacks callbacks = {};
+    callbacks.size = sizeof(callbacks);
+    callbacks.capabilitiesCb = [] (LocationCapabilitiesMask) {};
+    callbacks.responseCb = [] (LocationError, uint32_t) {};
+    callbacks.collectiveResponseCb = [] (uint32_t, LocationError*, uint32_t*) {};
+    callbacks.trackingCb = [] (Location location) {
+        onLocation(location);
+    };
+
+    LocationAPI* api = LocationAPI::createInstance(callbacks);
+    if (NULL == api) {
+        fprintf(stderr, "no LocationAPI\n");
+        return 1;
+    }
+    TrackingOptions trackingOptions;
+    trackingOptions.size = sizeof(trackingOptions);
+    trackingOptions.minInterval = interval;
+    uint32_t trackingId = api->startTracking(trackingOptions);
+
+    printf("%-8s %8s %10s %9s %10s %8s\n", "time s", "fixes", "max gap ms", "speed m/s",
+           "rx on ms", "rx on");
+    uint64_t startMs = monotonicNs() / 1000000;
+    uint64_t startOnMs = getLocApiSimReceiverOnMs();
+    uint64_t windowStartMs = startMs;
+    uint64_t windowStartOnMs = startOnMs;
+    uint64_t endMs = startMs + (uint64_t)durationSec * 1000;
+    while (windowStartMs < endMs) {
+        uint64_t windowEndMs = windowStartMs + (uint64_t)windowSec * 1000;
+        if (windowEndMs > endMs) {
+            windowEndMs = endMs;
+        }
+        usleep((windowEndMs - windowStartMs) * 1000);
+        uint64_t onMs = getLocApiSimReceiverOnMs();
+        Window window;
+        {
+            std::lock_guard<std::mutex> guard(sLock);
+            window = sWindow;
+            sWindow = {};
+        }
+        char label[24];
+        snprintf(label, sizeof(label), "%" PRIu64, (windowEndMs - startMs) / 1000);
+        printWindow(label, window, windowEndMs - windowStartMs, onMs - windowStartOnMs);
+        windowStartMs = windowEndMs;
+        windowStartOnMs = onMs;
+    }
+
+    api->stopTracking(trackingId);
+    {
+        std::lock_guard<std::mutex> guard(sLock);
+        printWindow("total", sTotal, endMs - startMs, windowStartOnMs - startOnMs);
+    }
+    api->destroy();
+    return 0;
+}
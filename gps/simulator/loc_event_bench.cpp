@@ -0,0 +1,316 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocApiSim.h>
+#include <LocationAPI.h>
+#include <loc_test_util.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Replays the LocApiTrace that the loc_sim.conf given with -c names in
+// SIM_EVENT_TRACE through the whole stack, up to the callbacks of a
+// LocationAPI client, then prints per event type how long the events took
+// from the replay thread to the client, and the CPU time the process spent
+// per event. The replay pace is the one of loc_sim.conf, SIM_EVENT_TRACE_SPEED=0
+// measures the stack saturated.
+//
+// usage: loc_event_bench -c loc_sim.conf [-b] [-t seconds] [-n clients] [-i ms]
+//   -b  also run a batching session, for the batched location events
+//   -t  stop after that many seconds instead of at the end of the replay
+//   -n  track with that many more clients, whose callbacks do nothing, so
+//       the CPU per event includes fanning the events out to them
+//   -i  tracking interval of all clients, 1000 ms by default; -n 15 -i 100
+//       gives 16 clients at 10 Hz
+//
+// Events that carry a time or a sentence are matched to their callback by
+// it, the others in order. What never reaches a callback, like SV reports
+// outside of a session or geofence breaches of geofences this client did
+// not add, counts as not delivered.
+
+#define BENCH_MAX_PENDING       4096
+#define BENCH_DRAIN_MS          1000
+#define BENCH_STALE_MS          500
+
+typedef struct {
+    std::multimap<uint64_t, uint64_t> pending;  // key to replay time, a looping
+                                                // trace repeats the keys
+    std::deque<uint64_t> pendingInOrder;        // replay times of events without a key
+    std::vector<uint64_t> latencies;
+    uint64_t sent;
+} EventStats;
+
+static const char* sEventNames[LOC_API_TRACE_EVENT_MAX] = {
+    "", "position", "dbt position", "sv", "status", "nmea", "data", "measurements",
+    "geofence breach", "geofence status", "locations", "completed trips", "batch status"
+};
+
+static std::mutex sLock;
+static std::condition_variable sReplayDoneCond;
+static bool sReplayDone = false;
+static EventStats sStats[LOC_API_TRACE_EVENT_MAX];
+
+static void onReplay(LocApiTraceEvent event, uint64_t key, uint64_t timeNs)
+{
+    std::lock_guard<std::mutex> guard(sLock);
+    if (LOC_API_TRACE_NONE == event) {
+        sReplayDone = true;
+        sReplayDoneCond.notify_all();
+        return;
+    }
+    EventStats& stats = sStats[event];
+    stats.sent++;
+    if (0 != key) {
+        if (stats.pending.size() >= BENCH_MAX_PENDING) {
+            stats.pending.erase(stats.pending.begin());
+        }
+        stats.pending.emplace(key, timeNs);
+    } else {
+        if (stats.pendingInOrder.size() >= BENCH_MAX_PENDING) {
+            stats.pendingInOrder.pop_front();
+        }
+        stats.pendingInOrder.push_back(timeNs);
+    }
+}
+
+// matches a callback to the first of the events that has it pending
+static void onCallback(std::initializer_list<LocApiTraceEvent> events, uint64_t key)
+{
+    uint64_t nowNs = monotonicNs();
+    std::lock_guard<std::mutex> guard(sLock);
+    for (LocApiTraceEvent event : events) {
+        EventStats& stats = sStats[event];
+        if (0 != key) {
+            // the oldest first, if the trace loops faster than it is delivered
+            auto it = stats.pending.lower_bound(key);
+            if (stats.pending.end() != it && key == it->first) {
+                stats.latencies.push_back(nowNs - it->second);
+                stats.pending.erase(it);
+                return;
+            }
+        } else if (!stats.pendingInOrder.empty()) {
+            // what waits longer than that was not delivered, like the SV reports
+            // before the session started, and would offset every later match
+            while (stats.pendingInOrder.size() > 1 &&
+                   nowNs - stats.pendingInOrder.front() > BENCH_STALE_MS * 1000000ULL) {
+                stats.pendingInOrder.pop_front();
+            }
+            stats.latencies.push_back(nowNs - stats.pendingInOrder.front());
+            stats.pendingInOrder.pop_front();
+            return;
+        }
+    }
+}
+
+static double percentileUs(const std::vector<uint64_t>& sorted, int percent)
+{
+    return sorted[(sorted.size() - 1) * percent / 100] / 1000.0;
+}
+
+static void printStats(uint64_t cpuNs, uint64_t wallNs)
+{
+    std::lock_guard<std::mutex> guard(sLock);
+    uint64_t sent = 0;
+    printf("%-16s %8s %9s %10s %10s %10s %10s\n", "event", "sent", "delivered",
+           "p50 us", "p90 us", "p99 us", "max us");
+    for (int event = LOC_API_TRACE_NONE + 1; event < LOC_API_TRACE_EVENT_MAX; event++) {
+        EventStats& stats = sStats[event];
+        if (0 == stats.sent) {
+            continue;
+        }
+        sent += stats.sent;
+        std::vector<uint64_t>& latencies = stats.latencies;
+        if (latencies.empty()) {
+            printf("%-16s %8" PRIu64 " %9d\n", sEventNames[event], stats.sent, 0);
+            continue;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        printf("%-16s %8" PRIu64 " %9zu %10.1f %10.1f %10.1f %10.1f\n",
+               sEventNames[event], stats.sent, latencies.size(),
+               percentileUs(latencies, 50), percentileUs(latencies, 90),
+               percentileUs(latencies, 99), latencies.back() / 1000.0);
+    }
+    printf("%" PRIu64 " events in %.2f s, process CPU %.2f s, %.1f us per event\n",
+           sent, wallNs / 1e9, cpuNs / 1e9, (0 != sent) ? cpuNs / 1e3 / sent : 0.0);
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s -c loc_sim.conf [-b] [-t seconds] [-n clients] [-i ms]\n",
+            name);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* conf = NULL;
+    bool batching = false;
+    int timeoutSec = 0;
+    int extraClients = 0;
+    uint32_t interval = 1000;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "c:bt:n:i:"))) {
+        switch (opt) {
+        case 'c':
+            conf = optarg;
+            break;
+        case 'b':
+            batching = true;
+            break;
+        case 't':
+            timeoutSec = atoi(optarg);
+            break;
+        case 'n':
+            extraClients = atoi(optarg);
+            break;
+        case 'i':
+            interval = (uint32_t)atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (NULL == conf) {
+        usage(argv[0]);
+        return 1;
+    }
+    // read by the simulator once the stack loads it
+    setenv("LOC_SIM_CONF", conf, 1);
+    setLocApiSimReplayListener(onReplay);
+
+    LocationCallbacks callbacks = {};
+    callbacks.size = sizeof(callbacks);
+    callbacks.capabilitiesCb = [] (LocationCapabilitiesMask) {};
+    callbacks.responseCb = [] (LocationError, uint32_t) {};
+    callbacks.collectiveResponseCb = [] (uint32_t, LocationError*, uint32_t*) {};
+    callbacks.trackingCb = [] (Location location) {
+        onCallback({LOC_API_TRACE_POSITION, LOC_API_TRACE_DBT_POSITION}, location.timestamp);
+    };
+    callbacks.gnssSvCb = [] (GnssSvNotification) {
+        onCallback({LOC_API_TRACE_SV}, 0);
+    };
+    callbacks.gnssNmeaCb = [] (GnssNmeaNotification notification) {
+        onCallback({LOC_API_TRACE_NMEA},
+                   LocApiTraceReader::nmeaKey(notification.nmea, notification.length));
+    };
+    callbacks.gnssDataCb = [] (GnssDataNotification) {
+        onCallback({LOC_API_TRACE_DATA}, 0);
+    };
+    callbacks.gnssMeasurementsCb = [] (GnssMeasurementsNotification notification) {
+        onCallback({LOC_API_TRACE_MEASUREMENTS}, notification.clock.timeNs);
+    };
+    callbacks.batchingCb = [] (uint32_t count, Location* locations, BatchingOptions) {
+        if (count > 0) {
+            onCallback({LOC_API_TRACE_LOCATIONS}, locations[0].timestamp);
+        }
+    };
+    callbacks.geofenceBreachCb = [] (GeofenceBreachNotification notification) {
+        onCallback({LOC_API_TRACE_GEOFENCE_BREACH}, notification.timestamp);
+    };
+    callbacks.geofenceStatusCb = [] (GeofenceStatusNotification) {
+        onCallback({LOC_API_TRACE_GEOFENCE_STATUS}, 0);
+    };
+    callbacks.batchingStatusCb = [] (BatchingStatusInfo info, std::list<uint32_t>&) {
+        onCallback({(BATCHING_STATUS_TRIP_COMPLETED == info.batchingStatus) ?
+                    LOC_API_TRACE_COMPLETED_TRIPS : LOC_API_TRACE_BATCH_STATUS}, 0);
+    };
+
+    LocationCallbacks idleCallbacks = {};
+    idleCallbacks.size = sizeof(idleCallbacks);
+    idleCallbacks.capabilitiesCb = callbacks.capabilitiesCb;
+    idleCallbacks.responseCb = callbacks.responseCb;
+    idleCallbacks.collectiveResponseCb = callbacks.collectiveResponseCb;
+    idleCallbacks.trackingCb = [] (Location) {};
+    idleCallbacks.gnssSvCb = [] (GnssSvNotification) {};
+    idleCallbacks.gnssNmeaCb = [] (GnssNmeaNotification) {};
+    idleCallbacks.gnssDataCb = [] (GnssDataNotification) {};
+    idleCallbacks.gnssMeasurementsCb = [] (GnssMeasurementsNotification) {};
+
+    uint64_t cpuStartNs = processCpuNs();
+    uint64_t wallStartNs = monotonicNs();
+
+    LocationAPI* api = LocationAPI::createInstance(callbacks);
+    if (NULL == api) {
+        fprintf(stderr, "no LocationAPI\n");
+        return 1;
+    }
+    TrackingOptions trackingOptions;
+    trackingOptions.size = sizeof(trackingOptions);
+    trackingOptions.minInterval = interval;
+    uint32_t trackingId = api->startTracking(trackingOptions);
+    std::vector<std::pair<LocationAPI*, uint32_t>> extraApis;
+    for (int i = 0; i < extraClients; i++) {
+        LocationAPI* extraApi = LocationAPI::createInstance(idleCallbacks);
+        if (NULL != extraApi) {
+            extraApis.emplace_back(extraApi, extraApi->startTracking(trackingOptions));
+        }
+    }
+    uint32_t batchingId = 0;
+    if (batching) {
+        BatchingOptions batchingOptions;
+        batchingOptions.size = sizeof(batchingOptions);
+        batchingOptions.minInterval = 1000;
+        batchingId = api->startBatching(batchingOptions);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(sLock);
+        if (timeoutSec > 0) {
+            sReplayDoneCond.wait_for(lock, std::chrono::seconds(timeoutSec),
+                                     [] { return sReplayDone; });
+        } else {
+            sReplayDoneCond.wait(lock, [] { return sReplayDone; });
+        }
+    }
+    // let what is still in the queues reach the callbacks
+    usleep(BENCH_DRAIN_MS * 1000);
+
+    uint64_t cpuNs = processCpuNs() - cpuStartNs;
+    uint64_t wallNs = monotonicNs() - wallStartNs;
+    printStats(cpuNs, wallNs);
+
+    for (auto& extraApi : extraApis) {
+        extraApi.first->stopTracking(extraApi.second);
+        extraApi.first->destroy();
+    }
+    api->stopTracking(trackingId);
+    if (batching) {
+        api->stopBatching(batchingId);
+    }
+    api->destroy();
+    return 0;
+}
@@ -0,0 +1,160 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_FLAT_MAP_H__
+#define __LOC_FLAT_MAP_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace loc_util {
+
+// Open addressing hash map keyed by uint32_t, with linear probing and
+// backward shift deletion, so there are no tombstones and lookups stay
+// short under add/remove churn. All entries live in one flat array.
+// Lookups never insert. Not thread safe; callers provide locking.
+template <typename VAL>
+class LocFlatMap {
+    struct Slot {
+        uint32_t key;
+        bool used;
+        VAL val;
+        inline Slot() : key(0), used(false), val() {}
+    };
+
+    static const uint32_t MIN_CAPACITY_BITS = 4;
+    std::vector<Slot> mSlots;
+    uint32_t mBits;
+    size_t mSize;
+
+    inline size_t home(uint32_t key) const {
+        return (size_t)((uint32_t)(key * 0x9E3779B1u) >> (32 - mBits));
+    }
+    inline size_t mask() const { return mSlots.size() - 1; }
+
+    // returns the slot holding *key*, or the empty slot where it would go
+    inline size_t probe(uint32_t key) const {
+        size_t i = home(key);
+        while (mSlots[i].used && mSlots[i].key != key) {
+            i = (i + 1) & mask();
+        }
+        return i;
+    }
+
+    void rehash(uint32_t bits) {
+        std::vector<Slot> oldSlots(1 << bits);
+        oldSlots.swap(mSlots);
+        mBits = bits;
+        for (auto& slot : oldSlots) {
+            if (slot.used) {
+                Slot& newSlot = mSlots[probe(slot.key)];
+                newSlot.key = slot.key;
+                newSlot.val = slot.val;
+                newSlot.used = true;
+            }
+        }
+    }
+
+public:
+    inline LocFlatMap() : mSlots(1 << MIN_CAPACITY_BITS), mBits(MIN_CAPACITY_BITS), mSize(0) {}
+
+    inline size_t size() const { return mSize; }
+    inline bool empty() const { return 0 == mSize; }
+
+    // Returns a pointer to the VAL keyed by *key*, or nullptr if not found.
+    // The pointer is valid until the next put() or erase().
+    inline VAL* find(uint32_t key) {
+        Slot& slot = mSlots[probe(key)];
+        return slot.used ? &slot.val : nullptr;
+    }
+    inline const VAL* find(uint32_t key) const {
+        const Slot& slot = mSlots[probe(key)];
+        return slot.used ? &slot.val : nullptr;
+    }
+
+    // Adds or replaces the VAL keyed by *key*. The table is kept at most
+    // half full.
+    void put(uint32_t key, const VAL& val) {
+        if ((mSize + 1) * 2 > mSlots.size()) {
+            rehash(mBits + 1);
+        }
+        Slot& slot = mSlots[probe(key)];
+        if (!slot.used) {
+            slot.key = key;
+            slot.used = true;
+            mSize++;
+        }
+        slot.val = val;
+    }
+
+    bool erase(uint32_t key) {
+        size_t i = probe(key);
+        if (!mSlots[i].used) {
+            return false;
+        }
+        // shift back the following entries of the same probe run that
+        // would otherwise become unreachable
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & mask();
+            if (!mSlots[j].used) {
+                break;
+            }
+            size_t k = home(mSlots[j].key);
+            bool inRun = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (!inRun) {
+                mSlots[i] = mSlots[j];
+                i = j;
+            }
+        }
+        mSlots[i] = Slot();
+        mSize--;
+        return true;
+    }
+
+    inline void clear() {
+        std::vector<Slot>(1 << MIN_CAPACITY_BITS).swap(mSlots);
+        mBits = MIN_CAPACITY_BITS;
+        mSize = 0;
+    }
+
+    // Calls *func(key, val)* for each entry, in no particular order.
+    template <typename FUNC>
+    inline void forEach(FUNC func) const {
+        for (auto& slot : mSlots) {
+            if (slot.used) {
+                func(slot.key, slot.val);
+            }
+        }
+    }
+};
+
+} // namespace loc_util
+
+#endif // #ifndef __LOC_FLAT_MAP_H__
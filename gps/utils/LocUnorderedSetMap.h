@@ -30,9 +30,11 @@
 #define __LOC_UNORDERDED_SETMAP_H__
 
 #include <algorithm>
+#include <bitset>
 #include <unordered_set>
 #include <unordered_map>
 
+using std::bitset;
 using std::unordered_set;
 using std::unordered_map;
 
@@ -56,19 +58,39 @@ inline static void trimSet(unordered_set<T>& fromSet, const unordered_set<T>& rV
 template <typename T>
 static unordered_set<T> removeAndReturnInterset(unordered_set<T>& s1, unordered_set<T>& s2) {
     unordered_set<T> common(0);
-    for (auto b = s2.begin(); b != s2.end(); b++) {
-        auto a = find(s1.begin(), s1.end(), *b);
+    for (auto b = s2.begin(); b != s2.end(); ) {
+        auto a = s1.find(*b);
         if (a != s1.end()) {
             // this is a common item of both l1 and l2, remove from both
             // but after we add to common
             common.insert(*a);
             s1.erase(a);
-            s2.erase(b);
+            b = s2.erase(b);
+        } else {
+            b++;
         }
     }
     return common;
 }
 
+// Bitset versions of the above, for small and dense integral value domains.
+// Both run in O(N / word size).
+template <size_t N>
+inline static void trimSet(bitset<N>& fromSet, const bitset<N>& rVals, bitset<N>* goneVals) {
+    if (nullptr != goneVals) {
+        *goneVals |= (fromSet & rVals);
+    }
+    fromSet &= ~rVals;
+}
+
+template <size_t N>
+static bitset<N> removeAndReturnInterset(bitset<N>& s1, bitset<N>& s2) {
+    bitset<N> common(s1 & s2);
+    s1 &= ~common;
+    s2 &= ~common;
+    return common;
+}
+
 template <typename KEY, typename VAL>
 class LocUnorderedSetMap {
     unordered_map<KEY, unordered_set<VAL>> mMap;
@@ -110,7 +132,7 @@ public:
     // This gets all the KEYs from the map
     inline unordered_set<KEY> getKeys() {
         unordered_set<KEY> keys(0);
-        for (auto entry : mMap) {
+        for (auto& entry : mMap) {
             keys.insert(entry.first);
         }
         return keys;
@@ -133,7 +155,7 @@ public:
         for (auto key : keys) {
             auto iter = mMap.find(key);
             if (iter != mMap.end() && trimOrRemove(iter, rVals, goneVals) && nullptr != goneKeys) {
-                goneKeys->insert(iter->first);
+                goneKeys->insert(key);
             }
         }
     }
@@ -172,16 +194,161 @@ public:
 
     // This puts *newVals* into the map keyed by *key*, and returns the VALs that are
     // in effect removed from the keyed VAL set in the map entry.
-    // This call would also remove those same VALs from *newVals*.
+    // This call would also remove from *newVals* the VALs that were already
+    // in the entry, leaving only the newly added ones.
     inline unordered_set<VAL> update(const KEY& key, unordered_set<VAL>& newVals) {
         unordered_set<VAL> goneVals(0);
 
         if (newVals.empty()) {
-            mMap.erase(key);
+            auto iter = mMap.find(key);
+            if (iter != mMap.end()) {
+                goneVals = std::move(iter->second);
+                mMap.erase(iter);
+            }
+        } else {
+            auto& entry = mMap[key];
+            unordered_set<VAL> curVals(std::move(entry));
+            entry = newVals;
+            removeAndReturnInterset(curVals, newVals);
+            goneVals = std::move(curVals);
+        }
+        return goneVals;
+    }
+};
+
+// Same as LocUnorderedSetMap, but the VALs of each entry are kept in a bitset
+// of *N* bits. VAL must be an integral or enum type whose values of interest
+// are in [0, N); values outside of that range are ignored. All set operations
+// are O(N / word size) and none of them allocate.
+template <typename KEY, typename VAL, size_t N>
+class LocBitSetMap {
+public:
+    typedef bitset<N> ValSet;
+
+private:
+    unordered_map<KEY, ValSet> mMap;
+
+    bool trimOrRemove(typename unordered_map<KEY, ValSet>::iterator iter,
+                      const ValSet& rVals, ValSet* goneVals) {
+        trimSet<N>(iter->second, rVals, goneVals);
+        bool removeEntry = (iter->second.none());
+        if (removeEntry) {
+            mMap.erase(iter);
+        }
+        return removeEntry;
+    }
+
+public:
+    inline LocBitSetMap() {}
+    inline LocBitSetMap(size_t size) : mMap(size) {}
+
+    inline static bool isValidVal(VAL val) {
+        return (long long)val >= 0 && (long long)val < (long long)N;
+    }
+
+    // Conversions between the bitset and unordered_set representations.
+    static ValSet toValSet(const unordered_set<VAL>& vals) {
+        ValSet valSet;
+        for (auto val : vals) {
+            if (isValidVal(val)) {
+                valSet.set((size_t)val);
+            }
+        }
+        return valSet;
+    }
+    static unordered_set<VAL> toUnorderedSet(const ValSet& valSet) {
+        unordered_set<VAL> vals(valSet.count());
+        for (size_t i = 0; i < N; i++) {
+            if (valSet.test(i)) {
+                vals.insert((VAL)i);
+            }
+        }
+        return vals;
+    }
+
+    inline bool empty() { return mMap.empty(); }
+
+    // This gets the raw pointer to the VALs pointed to by *key*
+    // If the entry is not in the map, nullptr will be returned.
+    inline ValSet* getValSetPtr(const KEY& key) {
+        auto entry = mMap.find(key);
+        return (entry != mMap.end()) ? &(entry->second) : nullptr;
+    }
+
+    // This gets a copy of VALs pointed to by *key*
+    // If the entry is not in the map, an empty set will be returned.
+    inline ValSet getValSet(const KEY& key) {
+        auto entry = mMap.find(key);
+        return (entry != mMap.end()) ? entry->second : ValSet();
+    }
+
+    // This gets all the KEYs from the map
+    inline unordered_set<KEY> getKeys() {
+        unordered_set<KEY> keys(mMap.size());
+        for (auto& entry : mMap) {
+            keys.insert(entry.first);
+        }
+        return keys;
+    }
+
+    inline bool remove(const KEY& key) {
+        return mMap.erase(key) > 0;
+    }
+
+    // See LocUnorderedSetMap::trimOrRemove()
+    inline void trimOrRemove(unordered_set<KEY>&& keys, const ValSet& rVals,
+                             unordered_set<KEY>* goneKeys, ValSet* goneVals) {
+        trimOrRemove(keys, rVals, goneKeys, goneVals);
+    }
+    inline void trimOrRemove(unordered_set<KEY>& keys, const ValSet& rVals,
+                             unordered_set<KEY>* goneKeys, ValSet* goneVals) {
+        for (auto key : keys) {
+            auto iter = mMap.find(key);
+            if (iter != mMap.end() && trimOrRemove(iter, rVals, goneVals) && nullptr != goneKeys) {
+                goneKeys->insert(key);
+            }
+        }
+    }
+
+    // See LocUnorderedSetMap::add()
+    bool add(const KEY& key, const ValSet& newVals) {
+        bool newEntryAdded = false;
+        if (newVals.any()) {
+            auto iter = mMap.find(key);
+            if (iter != mMap.end()) {
+                iter->second |= newVals;
+            } else {
+                mMap[key] = newVals;
+                newEntryAdded = true;
+            }
+        }
+        return newEntryAdded;
+    }
+    inline void add(const unordered_set<KEY>& keys, const ValSet& newVals,
+                    unordered_set<KEY>* newKeys) {
+        for (auto key : keys) {
+            if (add(key, newVals) && nullptr != newKeys) {
+                newKeys->insert(key);
+            }
+        }
+    }
+
+    // See LocUnorderedSetMap::update()
+    inline ValSet update(const KEY& key, ValSet& newVals) {
+        ValSet goneVals;
+
+        if (newVals.none()) {
+            auto iter = mMap.find(key);
+            if (iter != mMap.end()) {
+                goneVals = iter->second;
+                mMap.erase(iter);
+            }
         } else {
-            auto curVals = mMap[key];
-            mMap[key] = newVals;
-            goneVals = removeAndReturnInterset(curVals, newVals);
+            auto& curVals = mMap[key];
+            goneVals = curVals & ~newVals;
+            ValSet addedVals(newVals & ~curVals);
+            curVals = newVals;
+            newVals = addedVals;
         }
         return goneVals;
     }
@@ -0,0 +1,231 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocFlatMap.h>
+#include <loc_test_util.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace loc_util;
+
+// Checks LocFlatMap: erase() of entries in the middle of a probe run,
+// including runs that wrap around the end of the table, that lookup misses
+// don't insert, growth, and, over a random sequence of put(), erase() and
+// find(), that it always holds what std::unordered_map holds. The exit
+// status is the number of failed checks.
+//
+// usage: loc_flatmap_test
+
+// few enough keys for the table to stay small and the probe runs long
+#define TEST_KEYS       48
+#define TEST_STEPS      200000
+
+typedef LocFlatMap<uint32_t> FlatMap;
+
+static uint32_t sSeed = 1;
+static uint32_t nextRandom(uint32_t range)
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return (sSeed >> 8) % range;
+}
+
+// the home slot of *key* in the initial 16 slot table, as LocFlatMap::home()
+static uint32_t initialHome(uint32_t key)
+{
+    return (uint32_t)(key * 0x9E3779B1u) >> 28;
+}
+
+// the first *count* keys from *from* on with the home slot *home*
+static std::vector<uint32_t> keysAtHome(uint32_t home, size_t count, uint32_t from = 1)
+{
+    std::vector<uint32_t> keys;
+    for (uint32_t key = from; keys.size() < count; key++) {
+        if (initialHome(key) == home) {
+            keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+static bool holdsAll(const FlatMap& map, const std::vector<uint32_t>& keys)
+{
+    for (auto key : keys) {
+        const uint32_t* val = map.find(key);
+        if (nullptr == val || *val != key * 10) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ==== BACKWARD SHIFT DELETE ========================================================== */
+
+static void testEraseInRun()
+{
+    // one run of five keys at the same home slot, erased from the head,
+    // the middle and the tail; the others must stay reachable
+    for (size_t erased = 0; erased < 5; erased++) {
+        std::vector<uint32_t> keys = keysAtHome(5, 5);
+        FlatMap map;
+        for (auto key : keys) {
+            map.put(key, key * 10);
+        }
+        expectTrue("erase() of a key in a run", map.erase(keys[erased]));
+        expectTrue("erased key is gone", nullptr == map.find(keys[erased]));
+        keys.erase(keys.begin() + erased);
+        expectTrue("the rest of the run stays reachable", holdsAll(map, keys));
+        expectTrue("size after erase()", map.size() == keys.size());
+    }
+}
+
+static void testEraseInWrappedRun()
+{
+    // three keys at the last slot wrap around to slots 0 and 1, and two
+    // keys at slot 0 are pushed behind them to slots 2 and 3
+    std::vector<uint32_t> tail = keysAtHome(15, 3);
+    std::vector<uint32_t> head = keysAtHome(0, 2);
+    for (size_t erased = 0; erased < 5; erased++) {
+        std::vector<uint32_t> keys(tail);
+        keys.insert(keys.end(), head.begin(), head.end());
+        FlatMap map;
+        for (auto key : keys) {
+            map.put(key, key * 10);
+        }
+        expectTrue("erase() of a key in a wrapped run", map.erase(keys[erased]));
+        keys.erase(keys.begin() + erased);
+        expectTrue("the rest of the wrapped run stays reachable", holdsAll(map, keys));
+        // erase them all, one by one, in the order they were put
+        for (size_t i = 0; i < keys.size(); i++) {
+            map.erase(keys[i]);
+            std::vector<uint32_t> rest(keys.begin() + i + 1, keys.end());
+            expectTrue("wrapped run emptied one by one", holdsAll(map, rest));
+        }
+        expectTrue("wrapped run emptied", map.empty());
+    }
+}
+
+static void testEraseKeepsOtherRuns()
+{
+    // a key whose home slot is inside the run must not be shifted in
+    // front of its home slot
+    std::vector<uint32_t> first = keysAtHome(8, 3);
+    std::vector<uint32_t> second = keysAtHome(9, 1);
+    FlatMap map;
+    for (auto key : first) {
+        map.put(key, key * 10);
+    }
+    map.put(second[0], second[0] * 10);
+    map.erase(first[0]);
+    std::vector<uint32_t> rest(first.begin() + 1, first.end());
+    rest.push_back(second[0]);
+    expectTrue("keys of the next run stay reachable", holdsAll(map, rest));
+    expectTrue("erase() of a missing key", !map.erase(first[0]));
+    expectTrue("size after erase() of a missing key", map.size() == rest.size());
+}
+
+/* ==== LOOKUPS AND GROWTH ============================================================= */
+
+static void testFindDoesNotInsert()
+{
+    FlatMap map;
+    map.put(7, 70);
+    expectTrue("find() miss", nullptr == map.find(8));
+    expectTrue("find() miss does not insert", map.size() == 1);
+    expectTrue("const find()", 70 == *static_cast<const FlatMap&>(map).find(7));
+    map.put(7, 71);
+    expectTrue("put() replaces", map.size() == 1 && 71 == *map.find(7));
+}
+
+static void testGrowth()
+{
+    FlatMap map;
+    std::vector<uint32_t> keys;
+    for (uint32_t key = 1; key <= 10000; key++) {
+        keys.push_back(key * 7919);
+        map.put(key * 7919, key * 7919 * 10);
+    }
+    expectTrue("size after growth", map.size() == keys.size());
+    expectTrue("all keys found after growth", holdsAll(map, keys));
+    size_t visited = 0;
+    map.forEach([&visited] (uint32_t key, const uint32_t& val) {
+        visited += (val == key * 10);
+    });
+    expectTrue("forEach() visits each entry once", visited == keys.size());
+    map.clear();
+    expectTrue("clear()", map.empty() && nullptr == map.find(7919));
+}
+
+/* ==== AGAINST std::unordered_map ===================================================== */
+
+static void testAgainstUnorderedMap()
+{
+    FlatMap map;
+    std::unordered_map<uint32_t, uint32_t> expected;
+    bool agree = true;
+    for (int step = 0; step < TEST_STEPS && agree; step++) {
+        uint32_t key = nextRandom(TEST_KEYS);
+        switch (nextRandom(3)) {
+        case 0:
+            map.put(key, step);
+            expected[key] = step;
+            break;
+        case 1:
+            agree = (map.erase(key) == (expected.erase(key) > 0));
+            break;
+        default: {
+            uint32_t* val = map.find(key);
+            auto it = expected.find(key);
+            agree = (it == expected.end()) ? (nullptr == val) :
+                    (nullptr != val && *val == it->second);
+            break;
+        }
+        }
+        agree = agree && (map.size() == expected.size());
+        // every so often check that every key is where a lookup finds it
+        for (uint32_t k = 0; 0 == step % 64 && k < TEST_KEYS && agree; k++) {
+            auto it = expected.find(k);
+            uint32_t* val = map.find(k);
+            agree = (it == expected.end()) ? (nullptr == val) :
+                    (nullptr != val && *val == it->second);
+        }
+    }
+    expectTrue("LocFlatMap agrees with std::unordered_map", agree);
+}
+
+int main()
+{
+    testEraseInRun();
+    testEraseInWrappedRun();
+    testEraseKeepsOtherRuns();
+    testFindDoesNotInsert();
+    testGrowth();
+    testAgainstUnorderedMap();
+    return testResult();
+}
@@ -0,0 +1,296 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <math.h>
+#include <loc_geo.h>
+
+double loc_geo_distance(double lat1, double lon1, double lat2, double lon2)
+{
+    double phi1 = LOC_GEO_DEG_TO_RAD(lat1);
+    double phi2 = LOC_GEO_DEG_TO_RAD(lat2);
+    double sinHalfDPhi = sin((phi2 - phi1) * 0.5);
+    double sinHalfDLambda = sin(LOC_GEO_DEG_TO_RAD(lon2 - lon1) * 0.5);
+    double a = sinHalfDPhi * sinHalfDPhi +
+            cos(phi1) * cos(phi2) * sinHalfDLambda * sinHalfDLambda;
+    if (a > 1.0) {
+        a = 1.0;
+    }
+    return 2.0 * LOC_GEO_EARTH_RADIUS_M * asin(sqrt(a));
+}
+
+double loc_geo_bearing(double lat1, double lon1, double lat2, double lon2)
+{
+    double bearing;
+    loc_geo_bearing_n(lat1, lon1, &lat2, &lon2, &bearing, 1);
+    return bearing;
+}
+
+#define LOC_GEO_VINCENTY_MAX_ITERATIONS  (100)
+#define LOC_GEO_VINCENTY_TOLERANCE       (1e-12)
+
+double loc_geo_distance_vincenty(double lat1, double lon1, double lat2, double lon2)
+{
+    const double a = loc_geo_wgs84.a;
+    const double f = loc_geo_wgs84.f;
+    const double b = a * (1.0 - f);
+    // reduced latitudes
+    double u1 = atan((1.0 - f) * tan(LOC_GEO_DEG_TO_RAD(lat1)));
+    double u2 = atan((1.0 - f) * tan(LOC_GEO_DEG_TO_RAD(lat2)));
+    double sinU1 = sin(u1);
+    double cosU1 = cos(u1);
+    double sinU2 = sin(u2);
+    double cosU2 = cos(u2);
+    double l = LOC_GEO_DEG_TO_RAD(lon2 - lon1);
+
+    double lambda = l;
+    double sinSigma = 0.0;
+    double cosSigma = 1.0;
+    double sigma = 0.0;
+    double cos2Alpha = 1.0;
+    double cos2SigmaM = 0.0;
+    int iteration = 0;
+    for (; iteration < LOC_GEO_VINCENTY_MAX_ITERATIONS; iteration++) {
+        double sinLambda = sin(lambda);
+        double cosLambda = cos(lambda);
+        double t1 = cosU2 * sinLambda;
+        double t2 = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+        sinSigma = sqrt(t1 * t1 + t2 * t2);
+        if (0.0 == sinSigma) {
+            // coincident points
+            return 0.0;
+        }
+        cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+        sigma = atan2(sinSigma, cosSigma);
+        double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+        cos2Alpha = 1.0 - sinAlpha * sinAlpha;
+        // both points on the equator when cos2Alpha is 0
+        cos2SigmaM = (0.0 != cos2Alpha) ? cosSigma - 2.0 * sinU1 * sinU2 / cos2Alpha : 0.0;
+        double c = f / 16.0 * cos2Alpha * (4.0 + f * (4.0 - 3.0 * cos2Alpha));
+        double previous = lambda;
+        lambda = l + (1.0 - c) * f * sinAlpha *
+                (sigma + c * sinSigma *
+                 (cos2SigmaM + c * cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM)));
+        if (fabs(lambda - previous) < LOC_GEO_VINCENTY_TOLERANCE) {
+            break;
+        }
+    }
+    if (iteration >= LOC_GEO_VINCENTY_MAX_ITERATIONS) {
+        return loc_geo_distance(lat1, lon1, lat2, lon2);
+    }
+
+    double uSquare = cos2Alpha * (a * a - b * b) / (b * b);
+    double bigA = 1.0 + uSquare / 16384.0 *
+            (4096.0 + uSquare * (-768.0 + uSquare * (320.0 - 175.0 * uSquare)));
+    double bigB = uSquare / 1024.0 *
+            (256.0 + uSquare * (-128.0 + uSquare * (74.0 - 47.0 * uSquare)));
+    double deltaSigma = bigB * sinSigma *
+            (cos2SigmaM + bigB / 4.0 *
+             (cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM) -
+              bigB / 6.0 * cos2SigmaM * (-3.0 + 4.0 * sinSigma * sinSigma) *
+              (-3.0 + 4.0 * cos2SigmaM * cos2SigmaM)));
+    return b * bigA * (sigma - deltaSigma);
+}
+
+/* Haversine of the central angle from (lat0, lon0), whose cosine of latitude
+   is cosPhi0, to (lat, lon). cos(lat) is derived from lat0 and the half angle
+   already computed, which saves a cosine per point. */
+static inline double loc_geo_haversine(double lat0, double lon0, double sinPhi0,
+                                       double cosPhi0, double lat, double lon)
+{
+    double sinHalfDPhi = sin(LOC_GEO_DEG_TO_RAD(lat - lat0) * 0.5);
+    double sinHalfDLambda = sin(LOC_GEO_DEG_TO_RAD(lon - lon0) * 0.5);
+    double s2 = sinHalfDPhi * sinHalfDPhi;
+    double cosHalfDPhi = sqrt(1.0 - s2);
+    // cos(phi0 + dPhi) = cos(phi0) cos(dPhi) - sin(phi0) sin(dPhi)
+    double cosPhi = cosPhi0 * (1.0 - 2.0 * s2) - sinPhi0 * 2.0 * sinHalfDPhi * cosHalfDPhi;
+    double a = s2 + cosPhi0 * cosPhi * sinHalfDLambda * sinHalfDLambda;
+    return (a > 1.0) ? 1.0 : a;
+}
+
+void loc_geo_distance_n(double lat0, double lon0, const double* lat, const double* lon,
+                        double* distance, size_t count)
+{
+    double sinPhi0 = sin(LOC_GEO_DEG_TO_RAD(lat0));
+    double cosPhi0 = cos(LOC_GEO_DEG_TO_RAD(lat0));
+    for (size_t i = 0; i < count; i++) {
+        double a = loc_geo_haversine(lat0, lon0, sinPhi0, cosPhi0, lat[i], lon[i]);
+        distance[i] = 2.0 * LOC_GEO_EARTH_RADIUS_M * asin(sqrt(a));
+    }
+}
+
+void loc_geo_bearing_n(double lat0, double lon0, const double* lat, const double* lon,
+                       double* bearing, size_t count)
+{
+    double sinPhi0 = sin(LOC_GEO_DEG_TO_RAD(lat0));
+    double cosPhi0 = cos(LOC_GEO_DEG_TO_RAD(lat0));
+    for (size_t i = 0; i < count; i++) {
+        double phi = LOC_GEO_DEG_TO_RAD(lat[i]);
+        double dLambda = LOC_GEO_DEG_TO_RAD(lon[i] - lon0);
+        double cosPhi = cos(phi);
+        double y = sin(dLambda) * cosPhi;
+        double x = cosPhi0 * sin(phi) - sinPhi0 * cosPhi * cos(dLambda);
+        double theta = LOC_GEO_RAD_TO_DEG(atan2(y, x));
+        theta += (theta < 0.0) ? 360.0 : 0.0;
+        // a tiny negative angle rounds up to 360
+        bearing[i] = (theta >= 360.0) ? 0.0 : theta;
+    }
+}
+
+size_t loc_geo_within_radius(double lat0, double lon0, const double* lat, const double* lon,
+                             const double* radius, unsigned char* inside, size_t count)
+{
+    double sinPhi0 = sin(LOC_GEO_DEG_TO_RAD(lat0));
+    double cosPhi0 = cos(LOC_GEO_DEG_TO_RAD(lat0));
+    size_t insideCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        double a = loc_geo_haversine(lat0, lon0, sinPhi0, cosPhi0, lat[i], lon[i]);
+        // distance <= radius  <=>  a <= sin^2(radius / 2R), for radii up to
+        // half the circumference; larger circles hold every point
+        double halfAngle = radius[i] * (0.5 / LOC_GEO_EARTH_RADIUS_M);
+        double sinHalfAngle = sin(halfAngle);
+        unsigned char in = (a <= sinHalfAngle * sinHalfAngle) |
+                (halfAngle >= M_PI / 2.0);
+        inside[i] = in;
+        insideCount += in;
+    }
+    return insideCount;
+}
+
+const LocGeoEllipsoid loc_geo_wgs84 = { 6378137.0, 1.0 / 298.257223563 };
+const LocGeoEllipsoid loc_geo_pz90 = { 6378136.0, (6378136.0 - 6356751.3618) / 6378136.0 };
+
+/* milliarcseconds to radians */
+#define LOC_GEO_MAS_TO_RAD(mas)      ((mas) * 4.848136811095361e-09)
+
+const LocGeoHelmert loc_geo_wgs84_to_pz90 = {
+    +0.003, +0.001, 0.000, 1.0,
+    LOC_GEO_MAS_TO_RAD(-0.019), LOC_GEO_MAS_TO_RAD(+0.042), LOC_GEO_MAS_TO_RAD(-0.002)
+};
+
+void loc_geo_lla_to_ecef(const LocGeoEllipsoid* ellipsoid,
+                         const double* lat, const double* lon, const double* alt,
+                         double* x, double* y, double* z, size_t count)
+{
+    const double a = ellipsoid->a;
+    const double e2 = ellipsoid->f * (2.0 - ellipsoid->f);
+    for (size_t i = 0; i < count; i++) {
+        double phi = LOC_GEO_DEG_TO_RAD(lat[i]);
+        double lambda = LOC_GEO_DEG_TO_RAD(lon[i]);
+        double h = alt[i];
+        double sinPhi = sin(phi);
+        double cosPhi = cos(phi);
+        // prime vertical radius of curvature
+        double n = a / sqrt(1.0 - e2 * sinPhi * sinPhi);
+        x[i] = (n + h) * cosPhi * cos(lambda);
+        y[i] = (n + h) * cosPhi * sin(lambda);
+        z[i] = (n * (1.0 - e2) + h) * sinPhi;
+    }
+}
+
+void loc_geo_ecef_to_lla(const LocGeoEllipsoid* ellipsoid,
+                         const double* x, const double* y, const double* z,
+                         double* lat, double* lon, double* alt, size_t count)
+{
+    const double a = ellipsoid->a;
+    const double oneMinusF = 1.0 - ellipsoid->f;
+    const double e2 = ellipsoid->f * (2.0 - ellipsoid->f);
+    for (size_t i = 0; i < count; i++) {
+        double xi = x[i];
+        double yi = y[i];
+        double zi = z[i];
+        double p = sqrt(xi * xi + yi * yi);
+        double r = sqrt(p * p + zi * zi);
+        r = (r < 1.0) ? 1.0 : r;
+        // sine and cosine of the estimated parametric latitude, from its
+        // tangent rather than through atan2, sin and cos
+        double tanMuNum = zi * (oneMinusF + e2 * a / r);
+        double hypMu = sqrt(tanMuNum * tanMuNum + p * p);
+        hypMu = (hypMu > 0.0) ? hypMu : 1.0;
+        double sinMu = tanMuNum / hypMu;
+        double cosMu = p / hypMu;
+        // Bowring's step
+        double phiNum = zi * oneMinusF + e2 * a * sinMu * sinMu * sinMu;
+        double phiDen = oneMinusF * (p - e2 * a * cosMu * cosMu * cosMu);
+        double hypPhi = sqrt(phiNum * phiNum + phiDen * phiDen);
+        hypPhi = (hypPhi > 0.0) ? hypPhi : 1.0;
+        double sinPhi = phiNum / hypPhi;
+        double cosPhi = phiDen / hypPhi;
+        lat[i] = LOC_GEO_RAD_TO_DEG(atan2(phiNum, phiDen));
+        lon[i] = LOC_GEO_RAD_TO_DEG(atan2(yi, xi));
+        alt[i] = p * cosPhi + zi * sinPhi - a * sqrt(1.0 - e2 * sinPhi * sinPhi);
+    }
+}
+
+void loc_geo_helmert(const LocGeoHelmert* helmert,
+                     const double* x, const double* y, const double* z,
+                     double* outX, double* outY, double* outZ, size_t count)
+{
+    const LocGeoHelmert h = *helmert;
+    for (size_t i = 0; i < count; i++) {
+        double xi = x[i];
+        double yi = y[i];
+        double zi = z[i];
+        outX[i] = h.dx + h.scale * (xi + h.rz * yi - h.ry * zi);
+        outY[i] = h.dy + h.scale * (yi - h.rz * xi + h.rx * zi);
+        outZ[i] = h.dz + h.scale * (zi + h.ry * xi - h.rx * yi);
+    }
+}
+
+/* points converted at a time by loc_geo_convert_datum, small enough for the
+   ECEF coordinates to stay in the L1 cache */
+#define LOC_GEO_DATUM_BLOCK          (64)
+
+void loc_geo_convert_datum(const LocGeoEllipsoid* from, const LocGeoHelmert* helmert,
+                           const LocGeoEllipsoid* to,
+                           double* lat, double* lon, double* alt, size_t count)
+{
+    double x[LOC_GEO_DATUM_BLOCK];
+    double y[LOC_GEO_DATUM_BLOCK];
+    double z[LOC_GEO_DATUM_BLOCK];
+    for (size_t start = 0; start < count; start += LOC_GEO_DATUM_BLOCK) {
+        size_t n = count - start;
+        if (n > LOC_GEO_DATUM_BLOCK) {
+            n = LOC_GEO_DATUM_BLOCK;
+        }
+        loc_geo_lla_to_ecef(from, lat + start, lon + start, alt + start, x, y, z, n);
+        loc_geo_helmert(helmert, x, y, z, x, y, z, n);
+        loc_geo_ecef_to_lla(to, x, y, z, lat + start, lon + start, alt + start, n);
+    }
+}
+
+void loc_geo_ecef_distance(double x0, double y0, double z0,
+                           const double* x, const double* y, const double* z,
+                           double* distance, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        double dx = x[i] - x0;
+        double dy = y[i] - y0;
+        double dz = z[i] - z0;
+        distance[i] = sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
@@ -0,0 +1,295 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef _LOC_GEO_H_
+#define _LOC_GEO_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Mean earth radius (IUGG), in meters */
+#define LOC_GEO_EARTH_RADIUS_M       (6371008.8)
+#define LOC_GEO_DEG_TO_RAD(deg)      ((deg) * 0.017453292519943295)
+#define LOC_GEO_RAD_TO_DEG(rad)      ((rad) * 57.29577951308232)
+
+/*===========================================================================
+FUNCTION loc_geo_distance
+
+DESCRIPTION
+   Great circle distance between two points on a spherical earth, using the
+   haversine formula. Latitudes and longitudes are in degrees.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Distance in meters
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+double loc_geo_distance(double lat1, double lon1, double lat2, double lon2);
+
+/*===========================================================================
+FUNCTION loc_geo_bearing
+
+DESCRIPTION
+   Initial great circle bearing from the first point to the second one.
+   Latitudes and longitudes are in degrees.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Bearing in degrees clockwise from true north, in [0, 360)
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+double loc_geo_bearing(double lat1, double lon1, double lat2, double lon2);
+
+/*===========================================================================
+FUNCTION loc_geo_distance_vincenty
+
+DESCRIPTION
+   Geodesic distance between two points on the WGS84 ellipsoid, using
+   Vincenty's inverse formula; about 0.5% more accurate than the spherical
+   loc_geo_distance. Latitudes and longitudes are in degrees. For nearly
+   antipodal points, where the formula does not converge, it falls back to
+   loc_geo_distance.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Distance in meters
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+double loc_geo_distance_vincenty(double lat1, double lon1, double lat2, double lon2);
+
+/*
+ * Batched forms of the functions above, from one point (lat0, lon0) to count
+ * others given as arrays of latitudes and longitudes, in degrees. The loops
+ * have no branches, so that the compiler can vectorize them where it has
+ * vector math functions.
+ */
+
+/*===========================================================================
+FUNCTION loc_geo_distance_n
+
+DESCRIPTION
+   Haversine distances, as loc_geo_distance, from (lat0, lon0) to each point.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_geo_distance_n(double lat0, double lon0, const double* lat, const double* lon,
+                        double* distance, size_t count);
+
+/*===========================================================================
+FUNCTION loc_geo_bearing_n
+
+DESCRIPTION
+   Bearings, as loc_geo_bearing, from (lat0, lon0) to each point.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_geo_bearing_n(double lat0, double lon0, const double* lat, const double* lon,
+                       double* bearing, size_t count);
+
+/*===========================================================================
+FUNCTION loc_geo_within_radius
+
+DESCRIPTION
+   Tells for each circle, of center (lat[i], lon[i]) and radius radius[i] in
+   meters, whether (lat0, lon0) is in it, without computing the distances.
+   inside[i] is set to 1 if it is, 0 if not.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Number of circles the point is in
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+size_t loc_geo_within_radius(double lat0, double lon0, const double* lat, const double* lon,
+                             const double* radius, unsigned char* inside, size_t count);
+
+/** Reference ellipsoid of a datum */
+typedef struct {
+    double a;       /* semi-major axis, in meters */
+    double f;       /* flattening */
+} LocGeoEllipsoid;
+
+/** Seven parameter (Helmert) transformation from one datum to another */
+typedef struct {
+    double dx;      /* translation, in meters */
+    double dy;
+    double dz;
+    double scale;   /* 1 plus the scale correction */
+    double rx;      /* rotation, in radians */
+    double ry;
+    double rz;
+} LocGeoHelmert;
+
+extern const LocGeoEllipsoid loc_geo_wgs84;
+extern const LocGeoEllipsoid loc_geo_pz90;
+extern const LocGeoHelmert loc_geo_wgs84_to_pz90;
+
+/*
+ * The functions below work on arrays of count points, one array per
+ * coordinate, so that the loops over them can be vectorized. Latitudes and
+ * longitudes are in degrees, altitudes above the ellipsoid and ECEF
+ * coordinates in meters. The output arrays may be the input arrays.
+ */
+
+/*===========================================================================
+FUNCTION loc_geo_lla_to_ecef
+
+DESCRIPTION
+   Converts geodetic coordinates on the given ellipsoid to ECEF.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_geo_lla_to_ecef(const LocGeoEllipsoid* ellipsoid,
+                         const double* lat, const double* lon, const double* alt,
+                         double* x, double* y, double* z, size_t count);
+
+/*===========================================================================
+FUNCTION loc_geo_ecef_to_lla
+
+DESCRIPTION
+   Converts ECEF coordinates to geodetic coordinates on the given ellipsoid,
+   in closed form with one step of Bowring's method. The error is well under
+   a millimeter from the earth's surface to orbit altitudes.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_geo_ecef_to_lla(const LocGeoEllipsoid* ellipsoid,
+                         const double* x, const double* y, const double* z,
+                         double* lat, double* lon, double* alt, size_t count);
+
+/*===========================================================================
+FUNCTION loc_geo_helmert
+
+DESCRIPTION
+   Applies a seven parameter datum transformation to ECEF coordinates.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_geo_helmert(const LocGeoHelmert* helmert,
+                     const double* x, const double* y, const double* z,
+                     double* outX, double* outY, double* outZ, size_t count);
+
+/*===========================================================================
+FUNCTION loc_geo_convert_datum
+
+DESCRIPTION
+   Converts geodetic coordinates from one datum to another, in place,
+   through ECEF.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_geo_convert_datum(const LocGeoEllipsoid* from, const LocGeoHelmert* helmert,
+                           const LocGeoEllipsoid* to,
+                           double* lat, double* lon, double* alt, size_t count);
+
+/*===========================================================================
+FUNCTION loc_geo_ecef_distance
+
+DESCRIPTION
+   Straight line distances from one ECEF point to count others. Over the
+   few kilometers of a geofence or of the steps of a trip, they are within
+   millimeters of the distance along the ground.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   N/A
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+void loc_geo_ecef_distance(double x0, double y0, double z0,
+                           const double* x, const double* y, const double* z,
+                           double* distance, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_LOC_GEO_H_
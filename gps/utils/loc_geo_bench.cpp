@@ -0,0 +1,170 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <loc_geo.h>
+#include <loc_test_util.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+// Times the loc_geo kernels, in ns per point, from one position to a set of
+// points around it, as the geofence and batching code would use them: each
+// scalar function called in a loop, and the batched forms over the same
+// arrays.
+//
+// usage: loc_geo_bench [-n points] [-r rounds] [-k spread_km]
+//   -n  points per round, 1024 by default
+//   -r  rounds per kernel, 2000 by default
+//   -k  half width of the square the points are spread over, 50 km by default
+
+// keeps the compiler from dropping what is computed
+static volatile double sSink;
+
+static const double LAT0 = 37.4;
+static const double LON0 = -122.1;
+
+typedef enum {
+    BENCH_DISTANCE,
+    BENCH_DISTANCE_N,
+    BENCH_VINCENTY,
+    BENCH_BEARING,
+    BENCH_BEARING_N,
+    BENCH_RADIUS_LOOP,          // distance <= radius, scalar
+    BENCH_WITHIN_RADIUS,
+    BENCH_CASE_COUNT
+} BenchCase;
+
+static const char* sCaseNames[BENCH_CASE_COUNT] = {
+    "loc_geo_distance", "loc_geo_distance_n", "loc_geo_distance_vincenty",
+    "loc_geo_bearing", "loc_geo_bearing_n", "distance <= radius", "loc_geo_within_radius"
+};
+
+static double run(BenchCase benchCase, const std::vector<double>& lat,
+                  const std::vector<double>& lon, const std::vector<double>& radius,
+                  int rounds)
+{
+    size_t count = lat.size();
+    std::vector<double> out(count);
+    std::vector<unsigned char> inside(count);
+    double sum = 0;
+    uint64_t startNs = threadCpuNs();
+    for (int round = 0; round < rounds; round++) {
+        switch (benchCase) {
+        case BENCH_DISTANCE:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = loc_geo_distance(LAT0, LON0, lat[i], lon[i]);
+            }
+            break;
+        case BENCH_DISTANCE_N:
+            loc_geo_distance_n(LAT0, LON0, lat.data(), lon.data(), out.data(), count);
+            break;
+        case BENCH_VINCENTY:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = loc_geo_distance_vincenty(LAT0, LON0, lat[i], lon[i]);
+            }
+            break;
+        case BENCH_BEARING:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = loc_geo_bearing(LAT0, LON0, lat[i], lon[i]);
+            }
+            break;
+        case BENCH_BEARING_N:
+            loc_geo_bearing_n(LAT0, LON0, lat.data(), lon.data(), out.data(), count);
+            break;
+        case BENCH_RADIUS_LOOP:
+            for (size_t i = 0; i < count; i++) {
+                inside[i] = loc_geo_distance(LAT0, LON0, lat[i], lon[i]) <= radius[i];
+            }
+            out[0] = inside[0];
+            break;
+        case BENCH_WITHIN_RADIUS:
+            out[0] = loc_geo_within_radius(LAT0, LON0, lat.data(), lon.data(), radius.data(),
+                                           inside.data(), count);
+            break;
+        default:
+            break;
+        }
+        sum += out[round % count];
+    }
+    double ns = (double)(threadCpuNs() - startNs) / rounds / count;
+    sSink = sum;
+    return ns;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-n points] [-r rounds] [-k spread_km]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    int points = 1024;
+    int rounds = 2000;
+    double spreadKm = 50;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "n:r:k:"))) {
+        switch (opt) {
+        case 'n':
+            points = atoi(optarg);
+            break;
+        case 'r':
+            rounds = atoi(optarg);
+            break;
+        case 'k':
+            spreadKm = atof(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (points <= 0 || rounds <= 0 || spreadKm <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<double> lat(points);
+    std::vector<double> lon(points);
+    std::vector<double> radius(points);
+    double spreadDeg = LOC_GEO_RAD_TO_DEG(spreadKm * 1000 / LOC_GEO_EARTH_RADIUS_M);
+    srand(1);
+    for (int i = 0; i < points; i++) {
+        lat[i] = LAT0 + spreadDeg * (2.0 * rand() / RAND_MAX - 1.0);
+        lon[i] = LON0 + spreadDeg * (2.0 * rand() / RAND_MAX - 1.0);
+        radius[i] = 100 + 10000.0 * rand() / RAND_MAX;
+    }
+
+    printf("%-28s %10s\n", "kernel", "ns/point");
+    for (int benchCase = 0; benchCase < BENCH_CASE_COUNT; benchCase++) {
+        double ns = run((BenchCase)benchCase, lat, lon, radius, rounds);
+        printf("%-28s %10.2f\n", sCaseNames[benchCase], ns);
+    }
+    return 0;
+}
@@ -0,0 +1,342 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <loc_geo.h>
+#include <loc_nmea.h>
+#include <loc_test_util.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Checks the accuracy of the loc_geo kernels: the datum conversion against
+// the per point functions loc_nmea used before it, which are kept below as
+// the reference, the ECEF round trip against an iterative inverse, Vincenty
+// against published geodesics, and the batched distance, bearing and radius
+// kernels against the scalar functions. Each check prints its worst error
+// and its bound; the exit status is the number of checks over their bound.
+//
+// usage: loc_geo_test
+
+#define TEST_POINTS     20000
+#define TEST_DEG_TO_M   111320.0
+
+static void expectBelow(const char* what, double error, double bound)
+{
+    bool passed = (error <= bound);
+    printf("%-4s %-56s %.3g (bound %.3g)\n", passed ? "ok" : "FAIL", what, error, bound);
+    if (!passed) {
+        testFailures()++;
+    }
+}
+
+// same sequence on every run, so a failure can be reproduced
+static uint32_t sSeed = 1;
+static double uniform(double low, double high)
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return low + (high - low) * ((sSeed >> 8) / 16777216.0);
+}
+
+/* ==== REFERENCE ====================================================================== */
+// the conversion loc_nmea_generate_pos did per fix before loc_geo_convert_datum
+
+static void convert_Lla_to_Ecef(const LocLla& plla, LocEcef& pecef)
+{
+    double r;
+
+    r = MAJA / sqrt(1.0 - ESQR * sin(plla.lat) * sin(plla.lat));
+    pecef.X = (r + plla.alt) * cos(plla.lat) * cos(plla.lon);
+    pecef.Y = (r + plla.alt) * cos(plla.lat) * sin(plla.lon);
+    pecef.Z = (r * OMES + plla.alt) * sin(plla.lat);
+}
+
+static void convert_WGS84_to_PZ90(const LocEcef& pWGS84, LocEcef& pPZ90)
+{
+    double deltaX     = DatumConstFromWGS84[0];
+    double deltaY     = DatumConstFromWGS84[1];
+    double deltaZ     = DatumConstFromWGS84[2];
+    double deltaScale = DatumConstFromWGS84[3];
+    double rotX       = DatumConstFromWGS84[4];
+    double rotY       = DatumConstFromWGS84[5];
+    double rotZ       = DatumConstFromWGS84[6];
+
+    pPZ90.X = deltaX + deltaScale * (pWGS84.X + rotZ * pWGS84.Y - rotY * pWGS84.Z);
+    pPZ90.Y = deltaY + deltaScale * (pWGS84.Y - rotZ * pWGS84.X + rotX * pWGS84.Z);
+    pPZ90.Z = deltaZ + deltaScale * (pWGS84.Z + rotY * pWGS84.X - rotX * pWGS84.Y);
+}
+
+static void convert_Ecef_to_Lla(const LocEcef& pecef, LocLla& plla)
+{
+    double EcefA = C_PZ90A;
+    double EcefB = C_PZ90B;
+    double p = sqrt(pecef.X * pecef.X + pecef.Y * pecef.Y);
+    double r = sqrt(p * p + pecef.Z * pecef.Z);
+    double Ecef1Mf = 1.0 - (EcefA - EcefB) / EcefA;
+    double EcefE2 = 1.0 - (EcefB * EcefB) / (EcefA * EcefA);
+    double Mu;
+
+    if (p > 1.0) {
+        Mu = atan2(pecef.Z * (Ecef1Mf + EcefE2 * EcefA / r), p);
+    } else {
+        Mu = (pecef.Z > 0.0) ? M_PI / 2.0 : -M_PI / 2.0;
+    }
+    double Smu = sin(Mu);
+    double Cmu = cos(Mu);
+    double Phi = atan2(pecef.Z * Ecef1Mf + EcefE2 * EcefA * Smu * Smu * Smu,
+                       Ecef1Mf * (p - EcefE2 * EcefA * Cmu * Cmu * Cmu));
+    double Sphi = sin(Phi);
+    double N = EcefA / sqrt(1.0 - EcefE2 * Sphi * Sphi);
+    plla.alt = p * cos(Phi) + pecef.Z * Sphi - EcefA * EcefA / N;
+    plla.lat = Phi;
+    plla.lon = (p > 1.0) ? atan2(pecef.Y, pecef.X) : 0.0;
+}
+
+// Newton on the latitude until it no longer moves, in degrees and meters
+static void iterativeEcefToLla(const LocGeoEllipsoid& ellipsoid, double x, double y, double z,
+                               double& lat, double& lon, double& alt)
+{
+    double e2 = ellipsoid.f * (2.0 - ellipsoid.f);
+    double p = sqrt(x * x + y * y);
+    double phi = atan2(z, p * (1.0 - e2));
+    double n = ellipsoid.a;
+    for (int i = 0; i < 50; i++) {
+        double s = sin(phi);
+        n = ellipsoid.a / sqrt(1.0 - e2 * s * s);
+        alt = p / cos(phi) - n;
+        phi = atan2(z, p * (1.0 - e2 * n / (n + alt)));
+    }
+    double s = sin(phi);
+    n = ellipsoid.a / sqrt(1.0 - e2 * s * s);
+    // near the poles p / cos(phi) loses its precision, z / sin(phi) does not
+    alt = (fabs(phi) < 1.5) ? p / cos(phi) - n : z / s - n * (1.0 - e2);
+    lat = LOC_GEO_RAD_TO_DEG(phi);
+    lon = LOC_GEO_RAD_TO_DEG(atan2(y, x));
+}
+
+/* ==== DATUM ========================================================================== */
+
+static void randomPoints(std::vector<double>& lat, std::vector<double>& lon,
+                         std::vector<double>& alt, double maxAlt)
+{
+    for (size_t i = 0; i < lat.size(); i++) {
+        lat[i] = uniform(-90.0, 90.0);
+        lon[i] = uniform(-180.0, 180.0);
+        alt[i] = uniform(-500.0, maxAlt);
+    }
+}
+
+static void testConvertDatum()
+{
+    std::vector<double> lat(TEST_POINTS), lon(TEST_POINTS), alt(TEST_POINTS);
+    // up to the altitude of the GLONASS orbits and beyond
+    randomPoints(lat, lon, alt, 40000000.0);
+    std::vector<double> pzLat(lat), pzLon(lon), pzAlt(alt);
+    loc_geo_convert_datum(&loc_geo_wgs84, &loc_geo_wgs84_to_pz90, &loc_geo_pz90,
+                          pzLat.data(), pzLon.data(), pzAlt.data(), TEST_POINTS);
+
+    double maxHorizontal = 0, maxVertical = 0;
+    for (size_t i = 0; i < TEST_POINTS; i++) {
+        LocLla wgs84 = {LOC_GEO_DEG_TO_RAD(lat[i]), LOC_GEO_DEG_TO_RAD(lon[i]), alt[i]};
+        LocEcef ecefWgs84, ecefPz90;
+        LocLla pz90;
+        convert_Lla_to_Ecef(wgs84, ecefWgs84);
+        convert_WGS84_to_PZ90(ecefWgs84, ecefPz90);
+        convert_Ecef_to_Lla(ecefPz90, pz90);
+
+        double dLat = fabs(LOC_GEO_RAD_TO_DEG(pz90.lat) - pzLat[i]) * TEST_DEG_TO_M;
+        double dLon = fabs(remainder(LOC_GEO_RAD_TO_DEG(pz90.lon) - pzLon[i], 360.0)) *
+                      TEST_DEG_TO_M * cos(LOC_GEO_DEG_TO_RAD(lat[i]));
+        maxHorizontal = fmax(maxHorizontal, fmax(dLat, dLon));
+        maxVertical = fmax(maxVertical, fabs(pz90.alt - pzAlt[i]));
+    }
+    expectBelow("WGS84 to PZ-90 vs loc_nmea, horizontal m", maxHorizontal, 1e-6);
+    expectBelow("WGS84 to PZ-90 vs loc_nmea, vertical m", maxVertical, 1e-6);
+}
+
+static void testRoundTrip()
+{
+    std::vector<double> lat(TEST_POINTS), lon(TEST_POINTS), alt(TEST_POINTS);
+    randomPoints(lat, lon, alt, 100000.0);
+    std::vector<double> x(TEST_POINTS), y(TEST_POINTS), z(TEST_POINTS);
+    std::vector<double> lat2(TEST_POINTS), lon2(TEST_POINTS), alt2(TEST_POINTS);
+    loc_geo_lla_to_ecef(&loc_geo_wgs84, lat.data(), lon.data(), alt.data(),
+                        x.data(), y.data(), z.data(), TEST_POINTS);
+    loc_geo_ecef_to_lla(&loc_geo_wgs84, x.data(), y.data(), z.data(),
+                        lat2.data(), lon2.data(), alt2.data(), TEST_POINTS);
+
+    double maxHorizontal = 0, maxVertical = 0, maxIterative = 0;
+    for (size_t i = 0; i < TEST_POINTS; i++) {
+        double dLat = fabs(lat2[i] - lat[i]) * TEST_DEG_TO_M;
+        double dLon = fabs(remainder(lon2[i] - lon[i], 360.0)) * TEST_DEG_TO_M *
+                      cos(LOC_GEO_DEG_TO_RAD(lat[i]));
+        maxHorizontal = fmax(maxHorizontal, fmax(dLat, dLon));
+        maxVertical = fmax(maxVertical, fabs(alt2[i] - alt[i]));
+
+        double iterLat, iterLon, iterAlt;
+        iterativeEcefToLla(loc_geo_wgs84, x[i], y[i], z[i], iterLat, iterLon, iterAlt);
+        maxIterative = fmax(maxIterative, fabs(iterLat - lat2[i]) * TEST_DEG_TO_M);
+        maxIterative = fmax(maxIterative, fabs(iterAlt - alt2[i]));
+    }
+    expectBelow("WGS84 round trip below 100 km, horizontal m", maxHorizontal, 1e-5);
+    expectBelow("WGS84 round trip below 100 km, vertical m", maxVertical, 1e-5);
+    expectBelow("ECEF to WGS84 vs iterative inverse, m", maxIterative, 1e-5);
+}
+
+static void testPolesAndOrigin()
+{
+    double b = loc_geo_wgs84.a * (1.0 - loc_geo_wgs84.f);
+    double x[3] = {0, 0, 0};
+    double y[3] = {0, 0, 0};
+    double z[3] = {b + 10.0, -b - 10.0, 0};
+    double lat[3], lon[3], alt[3];
+    loc_geo_ecef_to_lla(&loc_geo_wgs84, x, y, z, lat, lon, alt, 3);
+
+    expectBelow("north pole latitude error, deg", fabs(lat[0] - 90.0), 1e-9);
+    expectBelow("north pole altitude error, m", fabs(alt[0] - 10.0), 1e-6);
+    expectBelow("south pole latitude error, deg", fabs(lat[1] + 90.0), 1e-9);
+    expectBelow("south pole altitude error, m", fabs(alt[1] - 10.0), 1e-6);
+    // the center of the earth has no position, it only must not be NaN
+    expectTrue("earth center gives finite coordinates",
+               isfinite(lat[2]) && isfinite(lon[2]) && isfinite(alt[2]));
+}
+
+/* ==== DISTANCE AND BEARING =========================================================== */
+
+static double dmsToDeg(int deg, int min, double sec)
+{
+    return deg + min / 60.0 + sec / 3600.0;
+}
+
+static void testVincenty()
+{
+    // the example of Vincenty's paper, on GRS80, which is within a tenth of a
+    // millimeter of WGS84 over this line
+    double flindersLat = -dmsToDeg(37, 57, 3.72030);
+    double flindersLon = dmsToDeg(144, 25, 29.52440);
+    double buninyongLat = -dmsToDeg(37, 39, 10.15610);
+    double buninyongLon = dmsToDeg(143, 55, 35.38390);
+    expectBelow("Vincenty Flinders Peak to Buninyong error, m",
+                fabs(loc_geo_distance_vincenty(flindersLat, flindersLon,
+                                               buninyongLat, buninyongLon) - 54972.271), 1e-3);
+    expectBelow("Vincenty one degree of the equator error, m",
+                fabs(loc_geo_distance_vincenty(0, 0, 0, 1) - 111319.4908), 1e-3);
+    expectBelow("Vincenty pole to pole error, m",
+                fabs(loc_geo_distance_vincenty(90, 0, -90, 0) - 20003931.4586), 1e-3);
+    expectBelow("Vincenty same point, m", fabs(loc_geo_distance_vincenty(10, 10, 10, 10)), 0);
+    // does not converge, falls back to the haversine distance
+    double antipodal = loc_geo_distance_vincenty(0, 0, 0.5, 179.7);
+    expectBelow("Vincenty nearly antipodal vs haversine, relative",
+                fabs(antipodal - loc_geo_distance(0, 0, 0.5, 179.7)) / antipodal, 0.005);
+}
+
+// points around (lat0, lon0): a third across the globe, a third within tens
+// of kilometers and a third within tens of meters, with radii from geofence
+// sizes to larger than the earth
+static void nearAndFarPoints(double lat0, double lon0, std::vector<double>& lat,
+                             std::vector<double>& lon, std::vector<double>& radius)
+{
+    static const double spread[3] = {180.0, 0.5, 0.0005};
+    for (size_t i = 0; i < lat.size(); i++) {
+        double degrees = spread[i % 3];
+        lat[i] = fmax(-90.0, fmin(90.0, lat0 + uniform(-degrees, degrees)));
+        lon[i] = lon0 + 2 * uniform(-degrees, degrees);
+        radius[i] = (0 == i % 7) ? 30000000.0 : uniform(50.0, 20000.0);
+    }
+}
+
+static double textbookBearing(double lat1, double lon1, double lat2, double lon2)
+{
+    double phi1 = LOC_GEO_DEG_TO_RAD(lat1);
+    double phi2 = LOC_GEO_DEG_TO_RAD(lat2);
+    double dLon = LOC_GEO_DEG_TO_RAD(lon2 - lon1);
+    double bearing = LOC_GEO_RAD_TO_DEG(atan2(sin(dLon) * cos(phi2),
+            cos(phi1) * sin(phi2) - sin(phi1) * cos(phi2) * cos(dLon)));
+    return fmod(bearing + 360.0, 360.0);
+}
+
+static void testBatched()
+{
+    const double lat0 = 37.4;
+    const double lon0 = -122.1;
+    std::vector<double> lat(TEST_POINTS), lon(TEST_POINTS), radius(TEST_POINTS);
+    nearAndFarPoints(lat0, lon0, lat, lon, radius);
+    std::vector<double> distance(TEST_POINTS), bearing(TEST_POINTS);
+    std::vector<unsigned char> inside(TEST_POINTS);
+    loc_geo_distance_n(lat0, lon0, lat.data(), lon.data(), distance.data(), TEST_POINTS);
+    loc_geo_bearing_n(lat0, lon0, lat.data(), lon.data(), bearing.data(), TEST_POINTS);
+    size_t insideCount = loc_geo_within_radius(lat0, lon0, lat.data(), lon.data(),
+                                               radius.data(), inside.data(), TEST_POINTS);
+
+    double maxAbsolute = 0, maxRelative = 0, maxBearing = 0, maxScalarBearing = 0;
+    bool inRange = true;
+    size_t expectedInside = 0, mismatches = 0;
+    for (size_t i = 0; i < TEST_POINTS; i++) {
+        double scalar = loc_geo_distance(lat0, lon0, lat[i], lon[i]);
+        double error = fabs(scalar - distance[i]);
+        maxAbsolute = fmax(maxAbsolute, error);
+        if (scalar > 0) {
+            maxRelative = fmax(maxRelative, error / scalar);
+        }
+
+        // the bearing to a point a meter away is noise
+        if (scalar > 1.0) {
+            double expected = textbookBearing(lat0, lon0, lat[i], lon[i]);
+            maxBearing = fmax(maxBearing, fabs(remainder(expected - bearing[i], 360.0)));
+            maxScalarBearing = fmax(maxScalarBearing, fabs(remainder(
+                    expected - loc_geo_bearing(lat0, lon0, lat[i], lon[i]), 360.0)));
+        }
+        inRange = inRange && bearing[i] >= 0 && bearing[i] < 360.0;
+
+        // right on the border either answer is fine
+        bool expected = (scalar <= radius[i]);
+        expectedInside += expected ? 1 : 0;
+        if (expected != (0 != inside[i]) && fabs(scalar - radius[i]) > 1e-6) {
+            mismatches++;
+        }
+    }
+    expectBelow("loc_geo_distance_n vs scalar, m", maxAbsolute, 1e-5);
+    expectBelow("loc_geo_distance_n vs scalar, relative", maxRelative, 1e-7);
+    expectBelow("loc_geo_bearing_n vs textbook formula, deg", maxBearing, 1e-6);
+    expectBelow("loc_geo_bearing vs textbook formula, deg", maxScalarBearing, 1e-6);
+    expectTrue("loc_geo_bearing_n in [0, 360)", inRange);
+    expectBelow("loc_geo_within_radius off the border", mismatches, 0);
+    expectBelow("loc_geo_within_radius count off by",
+                fabs((double)insideCount - (double)expectedInside), mismatches);
+}
+
+int main()
+{
+    testConvertDatum();
+    testRoundTrip();
+    testPolesAndOrigin();
+    testVincenty();
+    testBatched();
+    return testResult();
+}
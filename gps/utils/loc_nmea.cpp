@@ -34,6 +34,7 @@
 #include <log_util.h>
 #include <loc_pla.h>
 #include <loc_cfg.h>
+#include <loc_geo.h>
 
 #define GLONASS_SV_ID_OFFSET 64
 #define QZSS_SV_ID_OFFSET    (-192)
@@ -143,126 +144,6 @@ typedef struct loc_sv_cache_info_s
     float vdop;
 } loc_sv_cache_info;
 
-/*===========================================================================
-FUNCTION    convert_Lla_to_Ecef
-
-DESCRIPTION
-   Convert LLA to ECEF
-
-DEPENDENCIES
-   NONE
-
-RETURN VALUE
-   NONE
-
-SIDE EFFECTS
-   N/A
-
-===========================================================================*/
-static void convert_Lla_to_Ecef(const LocLla& plla, LocEcef& pecef)
-{
-    double r;
-
-    r = MAJA / sqrt(1.0 - ESQR * sin(plla.lat) * sin(plla.lat));
-    pecef.X = (r + plla.alt) * cos(plla.lat) * cos(plla.lon);
-    pecef.Y = (r + plla.alt) * cos(plla.lat) * sin(plla.lon);
-    pecef.Z = (r * OMES + plla.alt) * sin(plla.lat);
-}
-
-/*===========================================================================
-FUNCTION    convert_WGS84_to_PZ90
-
-DESCRIPTION
-   Convert datum from WGS84 to PZ90
-
-DEPENDENCIES
-   NONE
-
-RETURN VALUE
-   NONE
-
-SIDE EFFECTS
-   N/A
-
-===========================================================================*/
-static void convert_WGS84_to_PZ90(const LocEcef& pWGS84, LocEcef& pPZ90)
-{
-    double deltaX     = DatumConstFromWGS84[0];
-    double deltaY     = DatumConstFromWGS84[1];
-    double deltaZ     = DatumConstFromWGS84[2];
-    double deltaScale = DatumConstFromWGS84[3];
-    double rotX       = DatumConstFromWGS84[4];
-    double rotY       = DatumConstFromWGS84[5];
-    double rotZ       = DatumConstFromWGS84[6];
-
-    pPZ90.X = deltaX + deltaScale * (pWGS84.X + rotZ * pWGS84.Y - rotY * pWGS84.Z);
-    pPZ90.Y = deltaY + deltaScale * (pWGS84.Y - rotZ * pWGS84.X + rotX * pWGS84.Z);
-    pPZ90.Z = deltaZ + deltaScale * (pWGS84.Z + rotY * pWGS84.X - rotX * pWGS84.Y);
-}
-
-/*===========================================================================
-FUNCTION    convert_Ecef_to_Lla
-
-DESCRIPTION
-   Convert ECEF to LLA
-
-DEPENDENCIES
-   NONE
-
-RETURN VALUE
-   NONE
-
-SIDE EFFECTS
-   N/A
-
-===========================================================================*/
-static void convert_Ecef_to_Lla(const LocEcef& pecef, LocLla& plla)
-{
-    double p, r;
-    double EcefA = C_PZ90A;
-    double EcefB = C_PZ90B;
-    double Ecef1Mf;
-    double EcefE2;
-    double Mu;
-    double Smu;
-    double Cmu;
-    double Phi;
-    double Sphi;
-    double N;
-
-    p = sqrt(pecef.X * pecef.X + pecef.Y * pecef.Y);
-    r = sqrt(p * p + pecef.Z * pecef.Z);
-    if (r < 1.0) {
-        plla.lat = 1.0;
-        plla.lon = 1.0;
-        plla.alt = 1.0;
-    }
-    Ecef1Mf = 1.0 - (EcefA - EcefB) / EcefA;
-    EcefE2 = 1.0 - (EcefB * EcefB) / (EcefA * EcefA);
-    if (p > 1.0) {
-        Mu = atan2(pecef.Z * (Ecef1Mf + EcefE2 * EcefA / r), p);
-    } else {
-        if (pecef.Z > 0.0) {
-            Mu = M_PI / 2.0;
-        } else {
-            Mu = -M_PI / 2.0;
-        }
-    }
-    Smu = sin(Mu);
-    Cmu = cos(Mu);
-    Phi = atan2(pecef.Z * Ecef1Mf + EcefE2 * EcefA * Smu * Smu * Smu,
-                Ecef1Mf * (p - EcefE2 * EcefA * Cmu * Cmu * Cmu));
-    Sphi = sin(Phi);
-    N = EcefA / sqrt(1.0 - EcefE2 * Sphi * Sphi);
-    plla.alt = p * cos(Phi) + pecef.Z * Sphi - EcefA * EcefA/N;
-    plla.lat = Phi;
-    if ( p > 1.0) {
-        plla.lon = atan2(pecef.Y, pecef.X);
-    } else {
-        plla.lon = 0.0;
-    }
-}
-
 /*===========================================================================
 FUNCTION    convert_signalType_to_signalId
 
@@ -570,6 +451,7 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
                               char* sentence,
                               int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
+                              bool generate_sentence,
                               std::vector<std::string> &nmeaArraystr)
 {
     if (!sentence || bufSize <= 0 || !sv_meta_p)
@@ -605,6 +487,10 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
     if (svUsedCount == 0)
         return 0;
 
+    // the count is still needed for the talker and GGA
+    if (!generate_sentence)
+        return svUsedCount;
+
     if (sv_meta_p->totalSvUsedCount == 0)
         fixType = '1'; // no fix
     else if (sv_meta_p->totalSvUsedCount <= 3)
@@ -1184,6 +1070,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                const LocationSystemInfo &systemInfo,
                                unsigned char generate_nmea,
                                bool custom_gga_fix_quality,
+                               NmeaSentenceTypesMask sentence_mask,
                                std::vector<std::string> &nmeaArraystr)
 {
     ENTRY_LOG();
@@ -1217,9 +1104,6 @@ void loc_nmea_generate_pos(const UlpLocation &location,
     int utcSeconds = pTm->tm_sec;
     int utcMSeconds = (location.gpsLocation.timestamp)%1000;
     int datum_type = loc_get_datum_type();
-    LocEcef ecef_w84;
-    LocEcef ecef_p90;
-    LocLla  lla_w84;
     LocLla  lla_p90;
     LocLla  ref_lla;
     LocLla  local_lla;
@@ -1258,13 +1142,14 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         uint32_t svUsedCount = 0;
         uint32_t count = 0;
         loc_nmea_sv_meta sv_meta;
+        bool generate_gsa = (sentence_mask & LOC_NMEA_MASK_GSA_V02);
         // -------------------
         // ---$GPGSA/$GNGSA---
         // -------------------
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-                        GNSS_SIGNAL_GPS_L1CA, true), nmeaArraystr);
+                        GNSS_SIGNAL_GPS_L1CA, true), generate_gsa, nmeaArraystr);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1278,7 +1163,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-                        GNSS_SIGNAL_GLONASS_G1, true), nmeaArraystr);
+                        GNSS_SIGNAL_GLONASS_G1, true), generate_gsa, nmeaArraystr);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1292,7 +1177,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-                        GNSS_SIGNAL_GALILEO_E1, true), nmeaArraystr);
+                        GNSS_SIGNAL_GALILEO_E1, true), generate_gsa, nmeaArraystr);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1305,7 +1190,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ----------------------------
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaArraystr);
+                        GNSS_SIGNAL_BEIDOU_B1I, true), generate_gsa, nmeaArraystr);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1319,7 +1204,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaArraystr);
+                        GNSS_SIGNAL_QZSS_L1CA, true), generate_gsa, nmeaArraystr);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1337,87 +1222,92 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ------$--VTG-------
         // -------------------
 
-        pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        if (sentence_mask & LOC_NMEA_MASK_VTG_V02) {
+            pMarker = sentence;
+            lengthRemaining = sizeof(sentence);
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
-        {
-            float magTrack = location.gpsLocation.bearing;
-            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
             {
-                float magTrack = location.gpsLocation.bearing - locationExtended.magneticDeviation;
-                if (magTrack < 0.0)
-                    magTrack += 360.0;
-                else if (magTrack > 360.0)
-                    magTrack -= 360.0;
-            }
+                float magTrack = location.gpsLocation.bearing;
+                if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
+                {
+                    float magTrack = location.gpsLocation.bearing - locationExtended.magneticDeviation;
+                    if (magTrack < 0.0)
+                        magTrack += 360.0;
+                    else if (magTrack > 360.0)
+                        magTrack -= 360.0;
+                }
 
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,%.1lf,T,%.1lf,M,", talker, location.gpsLocation.bearing, magTrack);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,,T,,M,", talker);
-        }
+                length = snprintf(pMarker, lengthRemaining, "$%sVTG,%.1lf,T,%.1lf,M,", talker, location.gpsLocation.bearing, magTrack);
+            }
+            else
+            {
+                length = snprintf(pMarker, lengthRemaining, "$%sVTG,,T,,M,", talker);
+            }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
-        {
-            float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            float speedKmPerHour = location.gpsLocation.speed * 3.6;
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
+            {
+                float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
+                float speedKmPerHour = location.gpsLocation.speed * 3.6;
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,N,%.1lf,K,", speedKnots, speedKmPerHour);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",N,,K,");
-        }
+                length = snprintf(pMarker, lengthRemaining, "%.1lf,N,%.1lf,K,", speedKnots, speedKmPerHour);
+            }
+            else
+            {
+                length = snprintf(pMarker, lengthRemaining, ",N,,K,");
+            }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        length = snprintf(pMarker, lengthRemaining, "%c", vtgModeIndicator);
+            length = snprintf(pMarker, lengthRemaining, "%c", vtgModeIndicator);
 
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence));
+            nmeaArraystr.push_back(sentence);
+        }
 
-        memset(&ecef_w84, 0, sizeof(ecef_w84));
-        memset(&ecef_p90, 0, sizeof(ecef_p90));
-        memset(&lla_w84, 0, sizeof(lla_w84));
         memset(&lla_p90, 0, sizeof(lla_p90));
         memset(&ref_lla, 0, sizeof(ref_lla));
         memset(&local_lla, 0, sizeof(local_lla));
-        lla_w84.lat = location.gpsLocation.latitude / 180.0 * M_PI;
-        lla_w84.lon = location.gpsLocation.longitude / 180.0 * M_PI;
-        lla_w84.alt = location.gpsLocation.altitude;
-
-        convert_Lla_to_Ecef(lla_w84, ecef_w84);
-        convert_WGS84_to_PZ90(ecef_w84, ecef_p90);
-        convert_Ecef_to_Lla(ecef_p90, lla_p90);
+        // the PZ-90 position is only needed for DTM, or for the position
+        // sentences when they are in PZ-90
+        bool need_pz90 = (sentence_mask & LOC_NMEA_MASK_GPDTM_V02) ||
+                ((LOC_GNSS_DATUM_PZ90 == datum_type) &&
+                 (sentence_mask & (LOC_NMEA_MASK_RMC_V02 | LOC_NMEA_MASK_GNGNS_V02 |
+                                   LOC_NMEA_MASK_GGA_V02)));
+        if (need_pz90) {
+            lla_p90.lat = location.gpsLocation.latitude;
+            lla_p90.lon = location.gpsLocation.longitude;
+            lla_p90.alt = location.gpsLocation.altitude;
+            loc_geo_convert_datum(&loc_geo_wgs84, &loc_geo_wgs84_to_pz90, &loc_geo_pz90,
+                                  &lla_p90.lat, &lla_p90.lon, &lla_p90.alt, 1);
+        }
 
         switch (datum_type) {
             case LOC_GNSS_DATUM_WGS84:
                 ref_lla.lat = location.gpsLocation.latitude;
                 ref_lla.lon = location.gpsLocation.longitude;
                 ref_lla.alt = location.gpsLocation.altitude;
-                local_lla.lat = lla_p90.lat / M_PI * 180.0;
-                local_lla.lon = lla_p90.lon / M_PI * 180.0;
+                local_lla.lat = lla_p90.lat;
+                local_lla.lon = lla_p90.lon;
                 local_lla.alt = lla_p90.alt;
                 break;
             case LOC_GNSS_DATUM_PZ90:
-                ref_lla.lat = lla_p90.lat / M_PI * 180.0;
-                ref_lla.lon = lla_p90.lon / M_PI * 180.0;
+                ref_lla.lat = lla_p90.lat;
+                ref_lla.lon = lla_p90.lon;
                 ref_lla.alt = lla_p90.alt;
                 local_lla.lat = location.gpsLocation.latitude;
                 local_lla.lon = location.gpsLocation.longitude;
@@ -1430,496 +1320,526 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // -------------------
         // ------$--DTM-------
         // -------------------
-        loc_nmea_generate_DTM(ref_lla, local_lla, talker, sentence_DTM, sizeof(sentence_DTM));
+        if (sentence_mask & LOC_NMEA_MASK_GPDTM_V02) {
+            loc_nmea_generate_DTM(ref_lla, local_lla, talker, sentence_DTM,
+                                  sizeof(sentence_DTM));
+        }
 
         // -------------------
         // ------$--RMC-------
         // -------------------
 
-        pMarker = sentence_RMC;
-        lengthRemaining = sizeof(sentence_RMC);
+        if (sentence_mask & LOC_NMEA_MASK_RMC_V02) {
+            pMarker = sentence_RMC;
+            lengthRemaining = sizeof(sentence_RMC);
 
-        length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A," ,
-                          talker, utcHours, utcMinutes, utcSeconds,utcMSeconds/10);
+            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A," ,
+                              talker, utcHours, utcMinutes, utcSeconds,utcMSeconds/10);
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
             {
-                latHemisphere = 'N';
+                double latitude = ref_lla.lat;
+                double longitude = ref_lla.lon;
+                char latHemisphere;
+                char lonHemisphere;
+                double latMinutes;
+                double lonMinutes;
+
+                if (latitude > 0)
+                {
+                    latHemisphere = 'N';
+                }
+                else
+                {
+                    latHemisphere = 'S';
+                    latitude *= -1.0;
+                }
+
+                if (longitude < 0)
+                {
+                    lonHemisphere = 'W';
+                    longitude *= -1.0;
+                }
+                else
+                {
+                    lonHemisphere = 'E';
+                }
+
+                latMinutes = fmod(latitude * 60.0 , 60.0);
+                lonMinutes = fmod(longitude * 60.0 , 60.0);
+
+                length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
+                                  (uint8_t)floor(latitude), latMinutes, latHemisphere,
+                                  (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
             }
             else
             {
-                latHemisphere = 'S';
-                latitude *= -1.0;
+                length = snprintf(pMarker, lengthRemaining,",,,,");
+            }
+
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
             }
+            pMarker += length;
+            lengthRemaining -= length;
 
-            if (longitude < 0)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
             {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
+                float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
+                length = snprintf(pMarker, lengthRemaining, "%.1lf,", speedKnots);
             }
             else
             {
-                lonHemisphere = 'E';
+                length = snprintf(pMarker, lengthRemaining, ",");
             }
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
-        {
-            float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", speedKnots);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", location.gpsLocation.bearing);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
+            {
+                length = snprintf(pMarker, lengthRemaining, "%.1lf,", location.gpsLocation.bearing);
+            }
+            else
+            {
+                length = snprintf(pMarker, lengthRemaining, ",");
+            }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        length = snprintf(pMarker, lengthRemaining, "%2.2d%2.2d%2.2d,",
-                          utcDay, utcMonth, utcYear);
+            length = snprintf(pMarker, lengthRemaining, "%2.2d%2.2d%2.2d,",
+                              utcDay, utcMonth, utcYear);
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
-        {
-            float magneticVariation = locationExtended.magneticDeviation;
-            char direction;
-            if (magneticVariation < 0.0)
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
             {
-                direction = 'W';
-                magneticVariation *= -1.0;
+                float magneticVariation = locationExtended.magneticDeviation;
+                char direction;
+                if (magneticVariation < 0.0)
+                {
+                    direction = 'W';
+                    magneticVariation *= -1.0;
+                }
+                else
+                {
+                    direction = 'E';
+                }
+
+                length = snprintf(pMarker, lengthRemaining, "%.1lf,%c,",
+                                  magneticVariation, direction);
             }
             else
             {
-                direction = 'E';
+                length = snprintf(pMarker, lengthRemaining, ",,");
             }
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,%c,",
-                              magneticVariation, direction);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        length = snprintf(pMarker, lengthRemaining, "%c", rmcModeIndicator);
-        pMarker += length;
-        lengthRemaining -= length;
+            length = snprintf(pMarker, lengthRemaining, "%c", rmcModeIndicator);
+            pMarker += length;
+            lengthRemaining -= length;
 
-        // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-        pMarker += length;
-        lengthRemaining -= length;
+            // hardcode Navigation Status field to 'V'
+            length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
+            pMarker += length;
+            lengthRemaining -= length;
 
-        length = loc_nmea_put_checksum(sentence_RMC, sizeof(sentence_RMC));
+            length = loc_nmea_put_checksum(sentence_RMC, sizeof(sentence_RMC));
+        }
 
         // -------------------
         // ------$--GNS-------
         // -------------------
 
-        pMarker = sentence_GNS;
-        lengthRemaining = sizeof(sentence_GNS);
+        if (sentence_mask & LOC_NMEA_MASK_GNGNS_V02) {
+            pMarker = sentence_GNS;
+            lengthRemaining = sizeof(sentence_GNS);
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGNS,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+            length = snprintf(pMarker, lengthRemaining, "$%sGNS,%02d%02d%02d.%02d," ,
+                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
             {
-                latHemisphere = 'N';
+                double latitude = ref_lla.lat;
+                double longitude = ref_lla.lon;
+                char latHemisphere;
+                char lonHemisphere;
+                double latMinutes;
+                double lonMinutes;
+
+                if (latitude > 0)
+                {
+                    latHemisphere = 'N';
+                }
+                else
+                {
+                    latHemisphere = 'S';
+                    latitude *= -1.0;
+                }
+
+                if (longitude < 0)
+                {
+                    lonHemisphere = 'W';
+                    longitude *= -1.0;
+                }
+                else
+                {
+                    lonHemisphere = 'E';
+                }
+
+                latMinutes = fmod(latitude * 60.0 , 60.0);
+                lonMinutes = fmod(longitude * 60.0 , 60.0);
+
+                length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
+                                  (uint8_t)floor(latitude), latMinutes, latHemisphere,
+                                  (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
             }
             else
             {
-                latHemisphere = 'S';
-                latitude *= -1.0;
+                length = snprintf(pMarker, lengthRemaining,",,,,");
             }
 
-            if (longitude < 0)
+            if (length < 0 || length >= lengthRemaining)
             {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
             }
+            pMarker += length;
+            lengthRemaining -= length;
+
+            if(!(sv_cache_info.gps_used_mask ? 1 : 0))
+                modeIndicator[0] = 'N';
+            else if (LOC_NAV_MASK_SBAS_CORRECTION_IONO & locationExtended.navSolutionMask)
+                modeIndicator[0] = 'D';
+            else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
+                modeIndicator[0] = 'E';
             else
-            {
-                lonHemisphere = 'E';
+                modeIndicator[0] = 'A';
+            if(!(sv_cache_info.glo_used_mask ? 1 : 0))
+                modeIndicator[1] = 'N';
+            else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
+                modeIndicator[1] = 'E';
+            else
+                modeIndicator[1] = 'A';
+            if(!(sv_cache_info.gal_used_mask ? 1 : 0))
+                modeIndicator[2] = 'N';
+            else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
+                modeIndicator[2] = 'E';
+            else
+                modeIndicator[2] = 'A';
+            if(!(sv_cache_info.bds_used_mask ? 1 : 0))
+                modeIndicator[3] = 'N';
+            else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
+                modeIndicator[3] = 'E';
+            else
+                modeIndicator[3] = 'A';
+            if(!(sv_cache_info.qzss_used_mask ? 1 : 0))
+                modeIndicator[4] = 'N';
+            else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
+                modeIndicator[4] = 'E';
+            else
+                modeIndicator[4] = 'A';
+            if(!(sv_cache_info.navic_used_mask ? 1 : 0))
+                modeIndicator[5] = 'N';
+            else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
+                modeIndicator[5] = 'E';
+            else
+                modeIndicator[5] = 'A';
+            modeIndicator[6] = '\0';
+            for(int index = 5; index > 0 && 'N' == modeIndicator[index]; index--) {
+                modeIndicator[index] = '\0';
             }
+            length = snprintf(pMarker, lengthRemaining,"%s,", modeIndicator);
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
+            pMarker += length;
+            lengthRemaining -= length;
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
+                length = snprintf(pMarker, lengthRemaining, "%02d,%.1f,",
+                                  svUsedCount, locationExtended.hdop);
+            }
+            else {   // no hdop
+                length = snprintf(pMarker, lengthRemaining, "%02d,,",
+                                  svUsedCount);
+            }
 
-        if(!(sv_cache_info.gps_used_mask ? 1 : 0))
-            modeIndicator[0] = 'N';
-        else if (LOC_NAV_MASK_SBAS_CORRECTION_IONO & locationExtended.navSolutionMask)
-            modeIndicator[0] = 'D';
-        else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
-            modeIndicator[0] = 'E';
-        else
-            modeIndicator[0] = 'A';
-        if(!(sv_cache_info.glo_used_mask ? 1 : 0))
-            modeIndicator[1] = 'N';
-        else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
-            modeIndicator[1] = 'E';
-        else
-            modeIndicator[1] = 'A';
-        if(!(sv_cache_info.gal_used_mask ? 1 : 0))
-            modeIndicator[2] = 'N';
-        else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
-            modeIndicator[2] = 'E';
-        else
-            modeIndicator[2] = 'A';
-        if(!(sv_cache_info.bds_used_mask ? 1 : 0))
-            modeIndicator[3] = 'N';
-        else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
-            modeIndicator[3] = 'E';
-        else
-            modeIndicator[3] = 'A';
-        if(!(sv_cache_info.qzss_used_mask ? 1 : 0))
-            modeIndicator[4] = 'N';
-        else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
-            modeIndicator[4] = 'E';
-        else
-            modeIndicator[4] = 'A';
-        if(!(sv_cache_info.navic_used_mask ? 1 : 0))
-            modeIndicator[5] = 'N';
-        else if (LOC_POS_TECH_MASK_SENSORS == locationExtended.tech_mask)
-            modeIndicator[5] = 'E';
-        else
-            modeIndicator[5] = 'A';
-        modeIndicator[6] = '\0';
-        for(int index = 5; index > 0 && 'N' == modeIndicator[index]; index--) {
-            modeIndicator[index] = '\0';
-        }
-        length = snprintf(pMarker, lengthRemaining,"%s,", modeIndicator);
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        pMarker += length;
-        lengthRemaining -= length;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
+            {
+                length = snprintf(pMarker, lengthRemaining, "%.1lf,",
+                                  locationExtended.altitudeMeanSeaLevel);
+            }
+            else
+            {
+                length = snprintf(pMarker, lengthRemaining,",");
+            }
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
-            length = snprintf(pMarker, lengthRemaining, "%02d,%.1f,",
-                              svUsedCount, locationExtended.hdop);
-        }
-        else {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%02d,,",
-                              svUsedCount);
-        }
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
+                (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
+            {
+                length = snprintf(pMarker, lengthRemaining, "%.1lf,,",
+                                  ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            }
+            else
+            {
+                length = snprintf(pMarker, lengthRemaining,",,");
+            }
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",");
-        }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            // hardcode Navigation Status field to 'V'
+            length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
-            (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,");
+            length = loc_nmea_put_checksum(sentence_GNS, sizeof(sentence_GNS));
         }
 
-        pMarker += length;
-        lengthRemaining -= length;
-
-        // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = loc_nmea_put_checksum(sentence_GNS, sizeof(sentence_GNS));
-
 
         // -------------------
         // ------$--GGA-------
         // -------------------
 
-        pMarker = sentence_GGA;
-        lengthRemaining = sizeof(sentence_GGA);
+        if (sentence_mask & LOC_NMEA_MASK_GGA_V02) {
+            pMarker = sentence_GGA;
+            lengthRemaining = sizeof(sentence_GGA);
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+            length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
+                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
+            if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
             {
-                latHemisphere = 'N';
+                double latitude = ref_lla.lat;
+                double longitude = ref_lla.lon;
+                char latHemisphere;
+                char lonHemisphere;
+                double latMinutes;
+                double lonMinutes;
+
+                if (latitude > 0)
+                {
+                    latHemisphere = 'N';
+                }
+                else
+                {
+                    latHemisphere = 'S';
+                    latitude *= -1.0;
+                }
+
+                if (longitude < 0)
+                {
+                    lonHemisphere = 'W';
+                    longitude *= -1.0;
+                }
+                else
+                {
+                    lonHemisphere = 'E';
+                }
+
+                latMinutes = fmod(latitude * 60.0 , 60.0);
+                lonMinutes = fmod(longitude * 60.0 , 60.0);
+
+                length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
+                                  (uint8_t)floor(latitude), latMinutes, latHemisphere,
+                                  (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
             }
             else
             {
-                latHemisphere = 'S';
-                latitude *= -1.0;
+                length = snprintf(pMarker, lengthRemaining,",,,,");
             }
 
-            if (longitude < 0)
+            if (length < 0 || length >= lengthRemaining)
             {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
             }
-            else
+            pMarker += length;
+            lengthRemaining -= length;
+
+            // Number of satellites in use, 00-12
+            if (svUsedCount > MAX_SATELLITES_IN_USE)
+                svUsedCount = MAX_SATELLITES_IN_USE;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
             {
-                lonHemisphere = 'E';
+                length = snprintf(pMarker, lengthRemaining, "%s,%02d,%.1f,",
+                                  ggaGpsQuality, svUsedCount, locationExtended.hdop);
+            }
+            else
+            {   // no hdop
+                length = snprintf(pMarker, lengthRemaining, "%s,%02d,,",
+                                  ggaGpsQuality, svUsedCount);
             }
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        // Number of satellites in use, 00-12
-        if (svUsedCount > MAX_SATELLITES_IN_USE)
-            svUsedCount = MAX_SATELLITES_IN_USE;
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,%.1f,",
-                              ggaGpsQuality, svUsedCount, locationExtended.hdop);
-        }
-        else
-        {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,,",
-                              ggaGpsQuality, svUsedCount);
-        }
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
+            {
+                length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
+                                  locationExtended.altitudeMeanSeaLevel);
+            }
+            else
+            {
+                length = snprintf(pMarker, lengthRemaining,",,");
+            }
 
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,");
-        }
+            if (length < 0 || length >= lengthRemaining)
+            {
+                LOC_LOGE("NMEA Error in string formatting");
+                return;
+            }
+            pMarker += length;
+            lengthRemaining -= length;
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
+                (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
+            {
+                length = snprintf(pMarker, lengthRemaining, "%.1lf,M,,",
+                                  ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            }
+            else
+            {
+                length = snprintf(pMarker, lengthRemaining,",,,");
+            }
 
-        if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
-            (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
-        {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,");
+            length = loc_nmea_put_checksum(sentence_GGA, sizeof(sentence_GGA));
         }
 
-        length = loc_nmea_put_checksum(sentence_GGA, sizeof(sentence_GGA));
-
-        // ------$--DTM-------
-        nmeaArraystr.push_back(sentence_DTM);
-        // ------$--RMC-------
-        nmeaArraystr.push_back(sentence_RMC);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
+        bool generate_dtm = (sentence_mask & LOC_NMEA_MASK_GPDTM_V02);
+        if (generate_dtm) {
             // ------$--DTM-------
             nmeaArraystr.push_back(sentence_DTM);
         }
-        // ------$--GNS-------
-        nmeaArraystr.push_back(sentence_GNS);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
-            // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
+        if (sentence_mask & LOC_NMEA_MASK_RMC_V02) {
+            // ------$--RMC-------
+            nmeaArraystr.push_back(sentence_RMC);
+            if(generate_dtm && LOC_GNSS_DATUM_PZ90 == datum_type) {
+                // ------$--DTM-------
+                nmeaArraystr.push_back(sentence_DTM);
+            }
+        }
+        if (sentence_mask & LOC_NMEA_MASK_GNGNS_V02) {
+            // ------$--GNS-------
+            nmeaArraystr.push_back(sentence_GNS);
+            if(generate_dtm && LOC_GNSS_DATUM_PZ90 == datum_type) {
+                // ------$--DTM-------
+                nmeaArraystr.push_back(sentence_DTM);
+            }
+        }
+        if (sentence_mask & LOC_NMEA_MASK_GGA_V02) {
+            // ------$--GGA-------
+            nmeaArraystr.push_back(sentence_GGA);
         }
-        // ------$--GGA-------
-        nmeaArraystr.push_back(sentence_GGA);
 
     }
     //Send blank NMEA reports for non-final fixes
     else {
-        strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        if (sentence_mask & LOC_NMEA_MASK_GSA_V02) {
+            strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence));
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        if (sentence_mask & LOC_NMEA_MASK_VTG_V02) {
+            strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence));
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPDTM,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        if (sentence_mask & LOC_NMEA_MASK_GPDTM_V02) {
+            strlcpy(sentence, "$GPDTM,,,,,,,,", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence));
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        if (sentence_mask & LOC_NMEA_MASK_RMC_V02) {
+            strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence));
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPGNS,,,,,,N,,,,,,,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        if (sentence_mask & LOC_NMEA_MASK_GNGNS_V02) {
+            strlcpy(sentence, "$GPGNS,,,,,,N,,,,,,,V", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence));
+            nmeaArraystr.push_back(sentence);
+        }
 
-        strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        if (sentence_mask & LOC_NMEA_MASK_GGA_V02) {
+            strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
+            length = loc_nmea_put_checksum(sentence, sizeof(sentence));
+            nmeaArraystr.push_back(sentence);
+        }
     }
 
     EXIT_LOG(%d, 0);
@@ -1944,10 +1864,16 @@ SIDE EFFECTS
 
 ===========================================================================*/
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
+                              NmeaSentenceTypesMask sentence_mask,
                               std::vector<std::string> &nmeaArraystr)
 {
     ENTRY_LOG();
 
+    if (!(sentence_mask & LOC_NMEA_MASK_GSV_V02)) {
+        EXIT_LOG(%d, 0);
+        return;
+    }
+
     char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
     int svCount = svNotify.count;
     int svNumber = 1;
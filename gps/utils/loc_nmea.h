@@ -72,7 +72,14 @@ typedef struct {
     double     Z;
 } LocEcef;
 
+/* The sentences the generator below makes, each selected for all talkers by
+   the bit of its GP form (GN for GNS); the others are not generated */
+#define LOC_NMEA_AP_SUPPORTED_MASK (LOC_NMEA_MASK_GGA_V02 | LOC_NMEA_MASK_RMC_V02 | \
+        LOC_NMEA_MASK_GSV_V02 | LOC_NMEA_MASK_GSA_V02 | LOC_NMEA_MASK_VTG_V02 | \
+        LOC_NMEA_MASK_GNGNS_V02 | LOC_NMEA_MASK_GPDTM_V02)
+
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
+                              NmeaSentenceTypesMask sentence_mask,
                               std::vector<std::string> &nmeaArraystr);
 
 void loc_nmea_generate_pos(const UlpLocation &location,
@@ -80,6 +87,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                const LocationSystemInfo &systemInfo,
                                unsigned char generate_nmea,
                                bool custom_gga_fix_quality,
+                               NmeaSentenceTypesMask sentence_mask,
                                std::vector<std::string> &nmeaArraystr);
 
 #define DEBUG_NMEA_MINSIZE 6
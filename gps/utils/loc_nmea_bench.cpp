@@ -0,0 +1,177 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <loc_nmea.h>
+#include <loc_test_util.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Times the AP NMEA generation of one fix, the position sentences and the
+// GSV of its SV report, for some of the sentence masks gps.conf can set in
+// NMEA_AP_SENTENCE_MASK.
+//
+// usage: loc_nmea_bench [-n fixes] [-s svs]
+//   -n  fixes to generate per mask, 100000 by default
+//   -s  SVs in the SV report, half of them used in the fix, 40 by default
+
+static const GnssSvType sSvTypes[] = {
+    GNSS_SV_TYPE_GPS, GNSS_SV_TYPE_GLONASS, GNSS_SV_TYPE_GALILEO, GNSS_SV_TYPE_BEIDOU
+};
+
+static void makeFix(UlpLocation& ulp, GpsLocationExtended& ext, GnssSvNotification& svNotify,
+                    int svs)
+{
+    memset(&ulp, 0, sizeof(ulp));
+    ulp.size = sizeof(ulp);
+    ulp.gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+            LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+            LOC_GPS_LOCATION_HAS_ACCURACY;
+    ulp.gpsLocation.latitude = 37.4;
+    ulp.gpsLocation.longitude = -122.1;
+    ulp.gpsLocation.altitude = 30;
+    ulp.gpsLocation.speed = 12;
+    ulp.gpsLocation.bearing = 90;
+    ulp.gpsLocation.accuracy = 4;
+    ulp.gpsLocation.timestamp = 1600000000000ULL;
+    ulp.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+
+    memset(&ext, 0, sizeof(ext));
+    ext.flags = GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL |
+            GPS_LOCATION_EXTENDED_HAS_DOP | GPS_LOCATION_EXTENDED_HAS_MAG_DEV |
+            GPS_LOCATION_EXTENDED_HAS_HOR_RELIABILITY |
+            GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA;
+    ext.altitudeMeanSeaLevel = 2;
+    ext.pdop = 1.5f;
+    ext.hdop = 0.9f;
+    ext.vdop = 1.2f;
+    ext.magneticDeviation = 13;
+    ext.horizontal_reliability = LOC_RELIABILITY_HIGH;
+
+    if (svs > GNSS_SV_MAX) {
+        svs = GNSS_SV_MAX;
+    }
+    memset(&svNotify, 0, sizeof(svNotify));
+    svNotify.size = sizeof(svNotify);
+    svNotify.count = svs;
+    for (int i = 0; i < svs; i++) {
+        GnssSv& sv = svNotify.gnssSvs[i];
+        int type = i % (sizeof(sSvTypes) / sizeof(sSvTypes[0]));
+        sv.size = sizeof(sv);
+        sv.type = sSvTypes[type];
+        sv.svId = 1 + i / (sizeof(sSvTypes) / sizeof(sSvTypes[0]));
+        sv.cN0Dbhz = 30 + i % 15;
+        sv.elevation = 10 + i % 70;
+        sv.azimuth = (i * 37) % 360;
+        if (0 == i % 2) {
+            sv.gnssSvOptionsMask = GNSS_SV_OPTIONS_USED_IN_FIX_BIT;
+            uint64_t bit = 1ULL << (sv.svId - 1);
+            switch (sv.type) {
+            case GNSS_SV_TYPE_GPS:
+                ext.gnss_sv_used_ids.gps_sv_used_ids_mask |= bit;
+                break;
+            case GNSS_SV_TYPE_GLONASS:
+                ext.gnss_sv_used_ids.glo_sv_used_ids_mask |= bit;
+                break;
+            case GNSS_SV_TYPE_GALILEO:
+                ext.gnss_sv_used_ids.gal_sv_used_ids_mask |= bit;
+                break;
+            default:
+                ext.gnss_sv_used_ids.bds_sv_used_ids_mask |= bit;
+                break;
+            }
+        }
+    }
+}
+
+static const struct {
+    const char* name;
+    NmeaSentenceTypesMask mask;
+} sMasks[] = {
+    { "all", LOC_NMEA_AP_SUPPORTED_MASK },
+    { "no GNS/DTM", LOC_NMEA_MASK_GGA_V02 | LOC_NMEA_MASK_RMC_V02 | LOC_NMEA_MASK_GSV_V02 |
+            LOC_NMEA_MASK_GSA_V02 | LOC_NMEA_MASK_VTG_V02 },
+    { "GGA+RMC+GSA", LOC_NMEA_MASK_GGA_V02 | LOC_NMEA_MASK_RMC_V02 | LOC_NMEA_MASK_GSA_V02 },
+    { "GGA+RMC", LOC_NMEA_MASK_GGA_V02 | LOC_NMEA_MASK_RMC_V02 },
+    { "GGA", LOC_NMEA_MASK_GGA_V02 },
+};
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-n fixes] [-s svs]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    int fixes = 100000;
+    int svs = 40;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "n:s:"))) {
+        switch (opt) {
+        case 'n':
+            fixes = atoi(optarg);
+            break;
+        case 's':
+            svs = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (fixes <= 0 || svs < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    UlpLocation ulp;
+    GpsLocationExtended ext;
+    GnssSvNotification svNotify;
+    LocationSystemInfo systemInfo = {};
+    makeFix(ulp, ext, svNotify, svs);
+
+    printf("%-12s %8s %10s %10s\n", "mask", "hex", "sentences", "us/fix");
+    for (size_t m = 0; m < sizeof(sMasks) / sizeof(sMasks[0]); m++) {
+        std::vector<std::string> nmeaArraystr;
+        size_t sentences = 0;
+        uint64_t startNs = threadCpuNs();
+        for (int fix = 0; fix < fixes; fix++) {
+            nmeaArraystr.clear();
+            loc_nmea_generate_sv(svNotify, sMasks[m].mask, nmeaArraystr);
+            loc_nmea_generate_pos(ulp, ext, systemInfo, 1, false, sMasks[m].mask,
+                                  nmeaArraystr);
+            sentences = nmeaArraystr.size();
+        }
+        double us = (threadCpuNs() - startNs) / 1e3 / fixes;
+        printf("%-12s %8" PRIx64 " %10zu %10.3f\n", sMasks[m].name,
+               (uint64_t)sMasks[m].mask, sentences, us);
+    }
+    return 0;
+}
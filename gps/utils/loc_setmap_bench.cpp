@@ -0,0 +1,215 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocUnorderedSetMap.h>
+#include <loc_test_util.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace loc_util;
+
+// Times LocBitSetMap against LocUnorderedSetMap on what SystemStatusOsObserver
+// does with its client to data item map, in ns per call: clients changing
+// their subscriptions with update(), unsubscribing part of them with
+// trimOrRemove(), reading them back with getValSet(), and the intersection
+// of two subscriptions.
+//
+// usage: loc_setmap_bench [-c clients] [-n ids] [-r rounds]
+//   -c  subscribed clients, 10 by default
+//   -n  data items per subscription, 8 by default
+//   -r  calls per case, 200000 by default
+
+// MAX_DATA_ITEM_ID_1_1, the size of the data item id sets
+#define BENCH_VALS      27
+
+typedef unordered_set<int> IntSet;
+typedef LocUnorderedSetMap<uintptr_t, int> HashMap;
+typedef LocBitSetMap<uintptr_t, int, BENCH_VALS> BitMap;
+
+// keeps the compiler from dropping what is computed
+static volatile size_t sSink;
+
+typedef enum {
+    BENCH_UPDATE,
+    BENCH_TRIM,
+    BENCH_GET,
+    BENCH_INTERSECT,
+    BENCH_CASE_COUNT
+} BenchCase;
+
+static const char* sCaseNames[BENCH_CASE_COUNT] = {
+    "update", "trimOrRemove", "getValSet", "removeAndReturnInterset"
+};
+
+// the same subscriptions in both forms, picked from in turn
+typedef struct {
+    std::vector<IntSet> sets;
+    std::vector<BitMap::ValSet> bits;
+} Subscriptions;
+
+static double runHash(BenchCase benchCase, const Subscriptions& subs, int clients, int rounds)
+{
+    HashMap map(clients);
+    for (int c = 0; c < clients; c++) {
+        map.add((uintptr_t)c, subs.sets[c]);
+    }
+    size_t sum = 0;
+    size_t count = subs.sets.size();
+    uint64_t startNs = threadCpuNs();
+    for (int round = 0; round < rounds; round++) {
+        uintptr_t client = round % clients;
+        const IntSet& vals = subs.sets[round % count];
+        switch (benchCase) {
+        case BENCH_UPDATE: {
+            IntSet newVals(vals);
+            sum += map.update(client, newVals).size() + newVals.size();
+            break;
+        }
+        case BENCH_TRIM: {
+            IntSet goneVals(0);
+            map.trimOrRemove({client}, vals, nullptr, &goneVals);
+            // put them back, so that the next rounds have something to trim
+            map.add(client, goneVals);
+            sum += goneVals.size();
+            break;
+        }
+        case BENCH_GET:
+            sum += map.getValSet(client).size();
+            break;
+        case BENCH_INTERSECT: {
+            IntSet s1(vals);
+            IntSet s2(subs.sets[(round + 1) % count]);
+            sum += removeAndReturnInterset(s1, s2).size();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    double ns = (double)(threadCpuNs() - startNs) / rounds;
+    sSink = sum;
+    return ns;
+}
+
+static double runBits(BenchCase benchCase, const Subscriptions& subs, int clients, int rounds)
+{
+    BitMap map(clients);
+    for (int c = 0; c < clients; c++) {
+        map.add((uintptr_t)c, subs.bits[c]);
+    }
+    size_t sum = 0;
+    size_t count = subs.bits.size();
+    uint64_t startNs = threadCpuNs();
+    for (int round = 0; round < rounds; round++) {
+        uintptr_t client = round % clients;
+        const BitMap::ValSet& vals = subs.bits[round % count];
+        switch (benchCase) {
+        case BENCH_UPDATE: {
+            BitMap::ValSet newVals(vals);
+            sum += map.update(client, newVals).count() + newVals.count();
+            break;
+        }
+        case BENCH_TRIM: {
+            BitMap::ValSet goneVals;
+            map.trimOrRemove({client}, vals, nullptr, &goneVals);
+            map.add(client, goneVals);
+            sum += goneVals.count();
+            break;
+        }
+        case BENCH_GET:
+            sum += map.getValSet(client).count();
+            break;
+        case BENCH_INTERSECT: {
+            BitMap::ValSet s1(vals);
+            BitMap::ValSet s2(subs.bits[(round + 1) % count]);
+            sum += removeAndReturnInterset(s1, s2).count();
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    double ns = (double)(threadCpuNs() - startNs) / rounds;
+    sSink = sum;
+    return ns;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-c clients] [-n ids] [-r rounds]\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+    int clients = 10;
+    int ids = 8;
+    int rounds = 200000;
+    int opt;
+    while (-1 != (opt = getopt(argc, argv, "c:n:r:"))) {
+        switch (opt) {
+        case 'c':
+            clients = atoi(optarg);
+            break;
+        case 'n':
+            ids = atoi(optarg);
+            break;
+        case 'r':
+            rounds = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (clients <= 0 || ids <= 0 || ids > BENCH_VALS || rounds <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Subscriptions subs;
+    srand(1);
+    for (int i = 0; i < 64 + clients; i++) {
+        IntSet vals(0);
+        while ((int)vals.size() < ids) {
+            vals.insert(rand() % BENCH_VALS);
+        }
+        subs.sets.push_back(vals);
+        subs.bits.push_back(BitMap::toValSet(vals));
+    }
+
+    printf("%-24s %14s %14s\n", "call", "hash set ns", "bitset ns");
+    for (int benchCase = 0; benchCase < BENCH_CASE_COUNT; benchCase++) {
+        double hashNs = runHash((BenchCase)benchCase, subs, clients, rounds);
+        double bitsNs = runBits((BenchCase)benchCase, subs, clients, rounds);
+        printf("%-24s %14.1f %14.1f\n", sCaseNames[benchCase], hashNs, bitsNs);
+    }
+    return 0;
+}
@@ -0,0 +1,250 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocUnorderedSetMap.h>
+#include <loc_test_util.h>
+#include <stdint.h>
+#include <stdio.h>
+
+using namespace loc_util;
+
+// Checks the set helpers and the two set maps of LocUnorderedSetMap.h: the
+// hash set and bitset forms of trimSet and removeAndReturnInterset, what
+// update() returns and leaves in its argument, and, over a random sequence
+// of operations, that LocBitSetMap always holds what LocUnorderedSetMap
+// holds. The exit status is the number of failed checks.
+//
+// usage: loc_setmap_test
+
+// not a multiple of the word size, as MAX_DATA_ITEM_ID_1_1 is not
+#define TEST_VALS       70
+#define TEST_KEYS       12
+#define TEST_STEPS      20000
+
+typedef unordered_set<int> IntSet;
+typedef bitset<TEST_VALS> IntBits;
+typedef LocUnorderedSetMap<int, int> HashMap;
+typedef LocBitSetMap<int, int, TEST_VALS> BitMap;
+
+static uint32_t sSeed = 1;
+static uint32_t nextRandom(uint32_t range)
+{
+    sSeed = sSeed * 1103515245 + 12345;
+    return (sSeed >> 8) % range;
+}
+
+static IntSet randomSet(size_t maxSize)
+{
+    IntSet vals(0);
+    size_t size = nextRandom(maxSize + 1);
+    while (vals.size() < size) {
+        vals.insert(nextRandom(TEST_VALS));
+    }
+    return vals;
+}
+
+static bool sameSet(const IntSet& vals, const IntBits& bits)
+{
+    return BitMap::toUnorderedSet(bits) == vals;
+}
+
+/* ==== SET HELPERS ==================================================================== */
+
+static void testTrimSet()
+{
+    IntSet from({1, 2, 3, 4});
+    IntSet gone(0);
+    trimSet<int>(from, IntSet({2, 4, 9}), &gone);
+    expectTrue("trimSet leaves what is not trimmed", from == IntSet({1, 3}));
+    expectTrue("trimSet records what it trimmed", gone == IntSet({2, 4}));
+    trimSet<int>(from, IntSet({1}), nullptr);
+    expectTrue("trimSet without goneVals", from == IntSet({3}));
+
+    IntBits fromBits(BitMap::toValSet({1, 2, 3, 4, 69}));
+    IntBits goneBits;
+    trimSet<TEST_VALS>(fromBits, BitMap::toValSet({2, 4, 9, 69}), &goneBits);
+    expectTrue("bitset trimSet leaves what is not trimmed", sameSet({1, 3}, fromBits));
+    expectTrue("bitset trimSet records what it trimmed", sameSet({2, 4, 69}, goneBits));
+    trimSet<TEST_VALS>(fromBits, BitMap::toValSet({1}), nullptr);
+    expectTrue("bitset trimSet without goneVals", sameSet({3}, fromBits));
+}
+
+static void testRemoveAndReturnInterset()
+{
+    // s2 is iterated and erased from, so make it large enough to span buckets
+    for (int round = 0; round < 100; round++) {
+        IntSet s1(randomSet(TEST_VALS));
+        IntSet s2(randomSet(TEST_VALS));
+        IntSet expectedCommon(0), expected1(0), expected2(0);
+        for (int val : s1) {
+            (s2.count(val) ? expectedCommon : expected1).insert(val);
+        }
+        for (int val : s2) {
+            if (!s1.count(val)) {
+                expected2.insert(val);
+            }
+        }
+
+        IntBits bits1(BitMap::toValSet(s1));
+        IntBits bits2(BitMap::toValSet(s2));
+        IntSet common = removeAndReturnInterset(s1, s2);
+        IntBits commonBits = removeAndReturnInterset(bits1, bits2);
+        expectTrue("removeAndReturnInterset returns the intersection", common == expectedCommon);
+        expectTrue("removeAndReturnInterset leaves s1 without it", s1 == expected1);
+        expectTrue("removeAndReturnInterset leaves s2 without it", s2 == expected2);
+        expectTrue("bitset removeAndReturnInterset returns the intersection",
+                   sameSet(expectedCommon, commonBits));
+        expectTrue("bitset removeAndReturnInterset leaves s1 without it",
+                   sameSet(expected1, bits1));
+        expectTrue("bitset removeAndReturnInterset leaves s2 without it",
+                   sameSet(expected2, bits2));
+    }
+}
+
+static void testValSetConversions()
+{
+    IntBits bits(BitMap::toValSet({-1, 0, 5, TEST_VALS - 1, TEST_VALS, 1000}));
+    expectTrue("toValSet ignores values out of range", sameSet({0, 5, TEST_VALS - 1}, bits));
+    expectTrue("isValidVal", BitMap::isValidVal(0) && BitMap::isValidVal(TEST_VALS - 1) &&
+               !BitMap::isValidVal(-1) && !BitMap::isValidVal(TEST_VALS));
+}
+
+/* ==== MAPS =========================================================================== */
+
+static void testUpdate()
+{
+    HashMap hashMap;
+    BitMap bitMap;
+    hashMap.add(1, IntSet({1, 2, 3}));
+    bitMap.add(1, BitMap::toValSet({1, 2, 3}));
+
+    // update() returns the VALs dropped from the entry, and leaves in its
+    // argument the VALs that were not in it before
+    IntSet newVals({2, 3, 4});
+    IntBits newBits(BitMap::toValSet(newVals));
+    IntSet gone = hashMap.update(1, newVals);
+    IntBits goneBits = bitMap.update(1, newBits);
+    expectTrue("update returns the dropped VALs", gone == IntSet({1}));
+    expectTrue("update leaves the added VALs", newVals == IntSet({4}));
+    expectTrue("update stores the new VALs", hashMap.getValSet(1) == IntSet({2, 3, 4}));
+    expectTrue("bitset update returns the dropped VALs", sameSet({1}, goneBits));
+    expectTrue("bitset update leaves the added VALs", sameSet({4}, newBits));
+    expectTrue("bitset update stores the new VALs", sameSet({2, 3, 4}, bitMap.getValSet(1)));
+
+    newVals = IntSet({5});
+    newBits = BitMap::toValSet(newVals);
+    gone = hashMap.update(2, newVals);
+    goneBits = bitMap.update(2, newBits);
+    expectTrue("update of a new key drops nothing", gone.empty() && goneBits.none());
+    expectTrue("update of a new key adds all", newVals == IntSet({5}) && sameSet({5}, newBits));
+
+    newVals.clear();
+    newBits.reset();
+    gone = hashMap.update(1, newVals);
+    goneBits = bitMap.update(1, newBits);
+    expectTrue("update to nothing drops all", gone == IntSet({2, 3, 4}));
+    expectTrue("update to nothing removes the entry", nullptr == hashMap.getValSetPtr(1));
+    expectTrue("bitset update to nothing drops all", sameSet({2, 3, 4}, goneBits));
+    expectTrue("bitset update to nothing removes the entry", nullptr == bitMap.getValSetPtr(1));
+}
+
+static void testTrimOrRemove()
+{
+    HashMap hashMap;
+    BitMap bitMap;
+    hashMap.add(1, IntSet({1, 2}));
+    hashMap.add(2, IntSet({2}));
+    bitMap.add(1, BitMap::toValSet({1, 2}));
+    bitMap.add(2, BitMap::toValSet({2}));
+
+    unordered_set<int> goneKeys(0), goneBitKeys(0);
+    IntSet goneVals(0);
+    IntBits goneBits;
+    hashMap.trimOrRemove({1, 2, 3}, IntSet({2}), &goneKeys, &goneVals);
+    bitMap.trimOrRemove({1, 2, 3}, BitMap::toValSet({2}), &goneBitKeys, &goneBits);
+    expectTrue("trimOrRemove removes the emptied entries", goneKeys == unordered_set<int>({2}));
+    expectTrue("trimOrRemove trims the others", hashMap.getValSet(1) == IntSet({1}));
+    expectTrue("trimOrRemove records the trimmed VALs", goneVals == IntSet({2}));
+    expectTrue("bitset trimOrRemove removes the emptied entries", goneBitKeys == goneKeys);
+    expectTrue("bitset trimOrRemove trims the others", sameSet({1}, bitMap.getValSet(1)));
+    expectTrue("bitset trimOrRemove records the trimmed VALs", sameSet({2}, goneBits));
+}
+
+// the same random operations on both maps, which must agree after each
+static void testAgainstHashMap()
+{
+    HashMap hashMap;
+    BitMap bitMap;
+    bool agree = true;
+    for (int step = 0; step < TEST_STEPS && agree; step++) {
+        int key = nextRandom(TEST_KEYS);
+        IntSet vals(randomSet(8));
+        switch (nextRandom(4)) {
+        case 0: {
+            bool added = hashMap.add(key, vals);
+            agree = (added == bitMap.add(key, BitMap::toValSet(vals)));
+            break;
+        }
+        case 1: {
+            IntBits bits(BitMap::toValSet(vals));
+            IntSet gone = hashMap.update(key, vals);
+            agree = sameSet(gone, bitMap.update(key, bits)) && sameSet(vals, bits);
+            break;
+        }
+        case 2: {
+            unordered_set<int> keys({key, (int)nextRandom(TEST_KEYS)});
+            unordered_set<int> goneKeys(0), goneBitKeys(0);
+            IntSet goneVals(0);
+            IntBits goneBits;
+            hashMap.trimOrRemove(keys, vals, &goneKeys, &goneVals);
+            bitMap.trimOrRemove(keys, BitMap::toValSet(vals), &goneBitKeys, &goneBits);
+            agree = (goneKeys == goneBitKeys) && sameSet(goneVals, goneBits);
+            break;
+        }
+        default:
+            agree = (hashMap.remove(key) == bitMap.remove(key));
+            break;
+        }
+        agree = agree && (hashMap.getKeys() == bitMap.getKeys());
+        for (int k = 0; k < TEST_KEYS && agree; k++) {
+            agree = sameSet(hashMap.getValSet(k), bitMap.getValSet(k));
+        }
+    }
+    expectTrue("LocBitSetMap agrees with LocUnorderedSetMap", agree);
+}
+
+int main()
+{
+    testTrimSet();
+    testRemoveAndReturnInterset();
+    testValSetConversions();
+    testUpdate();
+    testTrimOrRemove();
+    testAgainstHashMap();
+    return testResult();
+}
@@ -0,0 +1,87 @@
+/* Copyright (c) 2019 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_TEST_UTIL_H__
+#define __LOC_TEST_UTIL_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// What the *_test and *_bench programs of the tree share: counting failed
+// checks, and the clocks they time with. Not used by any library.
+
+/* ==== CHECKS ========================================================================= */
+
+static inline int& testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+static inline void expectTrue(const char* what, bool passed)
+{
+    if (!passed) {
+        printf("FAIL %s\n", what);
+        testFailures()++;
+    }
+}
+
+// prints the verdict and returns the exit status, the number of failed checks
+static inline int testResult()
+{
+    printf("%s\n", (0 == testFailures()) ? "all passed" : "failed");
+    return testFailures();
+}
+
+/* ==== CLOCKS ========================================================================= */
+
+static inline uint64_t clockNs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// cpu time of the calling thread, so that other threads do not count
+static inline uint64_t threadCpuNs()
+{
+    return clockNs(CLOCK_THREAD_CPUTIME_ID);
+}
+
+static inline uint64_t processCpuNs()
+{
+    return clockNs(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+static inline uint64_t monotonicNs()
+{
+    return clockNs(CLOCK_MONOTONIC);
+}
+
+#endif /* __LOC_TEST_UTIL_H__ */